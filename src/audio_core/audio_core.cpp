@@ -76,6 +76,10 @@ void EnableStretching(bool enable) {
     DSP::HLE::EnableStretching(enable);
 }
 
+void EnableAudioThread(bool enable) {
+    DSP::HLE::EnableAudioThread(enable);
+}
+
 void Shutdown() {
     CoreTiming::UnscheduleEvent(tick_event, 0);
     DSP::HLE::Shutdown();
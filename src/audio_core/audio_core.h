@@ -26,6 +26,9 @@ void SelectSink(std::string sink_id);
 /// Enable/Disable stretching.
 void EnableStretching(bool enable);
 
+/// Enable/Disable generating audio on a dedicated thread.
+void EnableAudioThread(bool enable);
+
 /// Shutdown Audio Core
 void Shutdown();
 
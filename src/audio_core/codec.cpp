@@ -6,6 +6,9 @@
 #include <cstddef>
 #include <cstring>
 #include <vector>
+#ifdef ARCHITECTURE_x86_64
+#include <emmintrin.h>
+#endif
 #include "audio_core/codec.h"
 #include "common/assert.h"
 #include "common/common_types.h"
@@ -13,8 +16,8 @@
 
 namespace Codec {
 
-StereoBuffer16 DecodeADPCM(const u8* const data, const size_t sample_count,
-                           const std::array<s16, 16>& adpcm_coeff, ADPCMState& state) {
+void DecodeADPCM(const u8* const data, const size_t sample_count,
+                 const std::array<s16, 16>& adpcm_coeff, ADPCMState& state, StereoBuffer16& ret) {
     // GC-ADPCM with scale factor and variable coefficients.
     // Frames are 8 bytes long containing 14 samples each.
     // Samples are 4 bits (one nibble) long.
@@ -26,7 +29,7 @@ StereoBuffer16 DecodeADPCM(const u8* const data, const size_t sample_count,
 
     const size_t ret_size =
         sample_count % 2 == 0 ? sample_count : sample_count + 1; // Ensure multiple of two.
-    StereoBuffer16 ret(ret_size);
+    ret.resize(ret_size);
 
     int yn1 = state.yn1, yn2 = state.yn2;
 
@@ -74,8 +77,6 @@ StereoBuffer16 DecodeADPCM(const u8* const data, const size_t sample_count,
 
     state.yn1 = yn1;
     state.yn2 = yn2;
-
-    return ret;
 }
 
 static s16 SignExtendS8(u8 x) {
@@ -84,42 +85,86 @@ static s16 SignExtendS8(u8 x) {
     return static_cast<s16>(static_cast<s8>(x));
 }
 
-StereoBuffer16 DecodePCM8(const unsigned num_channels, const u8* const data,
-                          const size_t sample_count) {
+#ifdef ARCHITECTURE_x86_64
+
+/// Sign extends the low and high 8 bytes of `samples` to two vectors of 8 PCM16 values
+static void SignExtendS8x16(__m128i samples, __m128i& low, __m128i& high) {
+    low = _mm_srai_epi16(_mm_unpacklo_epi8(samples, samples), 8);
+    high = _mm_srai_epi16(_mm_unpackhi_epi8(samples, samples), 8);
+}
+
+#endif // ARCHITECTURE_x86_64
+
+void DecodePCM8(const unsigned num_channels, const u8* const data, const size_t sample_count,
+                StereoBuffer16& ret) {
     ASSERT(num_channels == 1 || num_channels == 2);
 
-    StereoBuffer16 ret(sample_count);
+    ret.resize(sample_count);
+
+    size_t i = 0;
+#ifdef ARCHITECTURE_x86_64
+    auto out = reinterpret_cast<__m128i*>(ret.data());
+    if (num_channels == 1) {
+        // 16 mono samples in, 16 stereo samples out
+        for (; i + 16 <= sample_count; i += 16, out += 4) {
+            __m128i low, high;
+            SignExtendS8x16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i)), low, high);
+            _mm_storeu_si128(out + 0, _mm_unpacklo_epi16(low, low));
+            _mm_storeu_si128(out + 1, _mm_unpackhi_epi16(low, low));
+            _mm_storeu_si128(out + 2, _mm_unpacklo_epi16(high, high));
+            _mm_storeu_si128(out + 3, _mm_unpackhi_epi16(high, high));
+        }
+    } else {
+        // Channels are already interleaved: 8 stereo samples in, 8 stereo samples out
+        for (; i + 8 <= sample_count; i += 8, out += 2) {
+            __m128i low, high;
+            SignExtendS8x16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i * 2)), low,
+                            high);
+            _mm_storeu_si128(out + 0, low);
+            _mm_storeu_si128(out + 1, high);
+        }
+    }
+#endif // ARCHITECTURE_x86_64
 
     if (num_channels == 1) {
-        for (size_t i = 0; i < sample_count; i++) {
+        for (; i < sample_count; i++) {
             ret[i].fill(SignExtendS8(data[i]));
         }
     } else {
-        for (size_t i = 0; i < sample_count; i++) {
+        for (; i < sample_count; i++) {
             ret[i][0] = SignExtendS8(data[i * 2 + 0]);
             ret[i][1] = SignExtendS8(data[i * 2 + 1]);
         }
     }
-
-    return ret;
 }
 
-StereoBuffer16 DecodePCM16(const unsigned num_channels, const u8* const data,
-                           const size_t sample_count) {
+void DecodePCM16(const unsigned num_channels, const u8* const data, const size_t sample_count,
+                 StereoBuffer16& ret) {
     ASSERT(num_channels == 1 || num_channels == 2);
 
-    StereoBuffer16 ret(sample_count);
+    ret.resize(sample_count);
 
-    if (num_channels == 1) {
-        for (size_t i = 0; i < sample_count; i++) {
-            s16 sample;
-            std::memcpy(&sample, data + i * sizeof(s16), sizeof(s16));
-            ret[i].fill(sample);
-        }
-    } else {
+    if (num_channels == 2) {
         std::memcpy(ret.data(), data, sample_count * 2 * sizeof(u16));
+        return;
+    }
+
+    size_t i = 0;
+#ifdef ARCHITECTURE_x86_64
+    // 8 mono samples in, 8 stereo samples out
+    auto out = reinterpret_cast<__m128i*>(ret.data());
+    for (; i + 8 <= sample_count; i += 8, out += 2) {
+        const __m128i samples =
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i * sizeof(s16)));
+        _mm_storeu_si128(out + 0, _mm_unpacklo_epi16(samples, samples));
+        _mm_storeu_si128(out + 1, _mm_unpackhi_epi16(samples, samples));
     }
+#endif // ARCHITECTURE_x86_64
 
-    return ret;
+    for (; i < sample_count; i++) {
+        s16 sample;
+        std::memcpy(&sample, data + i * sizeof(s16), sizeof(s16));
+        ret[i].fill(sample);
+    }
 }
 };
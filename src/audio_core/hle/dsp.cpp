@@ -3,13 +3,19 @@
 // Refer to the license.txt file included.
 
 #include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
 #include <memory>
+#include <mutex>
+#include <thread>
 #include "audio_core/hle/dsp.h"
 #include "audio_core/hle/mixers.h"
 #include "audio_core/hle/pipe.h"
 #include "audio_core/hle/source.h"
 #include "audio_core/sink.h"
 #include "audio_core/time_stretch.h"
+#include "common/thread.h"
 
 namespace DSP {
 namespace HLE {
@@ -52,16 +58,23 @@ static std::array<Source, num_sources> sources = {
 };
 static Mixers mixers;
 
-static StereoFrame16 GenerateCurrentFrame() {
-    SharedMemory& read = ReadRegion();
-    SharedMemory& write = WriteRegion();
+/// Memory of the buffers each source enqueues in a frame, see Source::ResolveBufferMemory
+using BufferMemory = std::array<Source::BufferMemory, num_sources>;
+
+static void ResolveBufferMemory(const SharedMemory& read, BufferMemory& buffer_memory) {
+    for (size_t i = 0; i < num_sources; i++)
+        buffer_memory[i] = Source::ResolveBufferMemory(read.source_configurations.config[i]);
+}
 
+static StereoFrame16 GenerateCurrentFrame(SharedMemory& read, SharedMemory& write,
+                                          const BufferMemory& buffer_memory) {
     std::array<QuadFrame32, 3> intermediate_mixes = {};
 
     // Generate intermediate mixes
     for (size_t i = 0; i < num_sources; i++) {
         write.source_statuses.status[i] =
-            sources[i].Tick(read.source_configurations.config[i], read.adpcm_coefficients.coeff[i]);
+            sources[i].Tick(read.source_configurations.config[i], read.adpcm_coefficients.coeff[i],
+                            buffer_memory[i]);
         for (size_t mix = 0; mix < 3; mix++) {
             sources[i].MixInto(intermediate_mixes[mix], mix);
         }
@@ -116,19 +129,210 @@ static void OutputCurrentFrame(const StereoFrame16& frame) {
     }
 }
 
-void EnableStretching(bool enable) {
-    if (perform_time_stretching == enable)
+// Audio thread
+//
+// When enabled, frames are generated on a dedicated thread instead of the emulation thread. At
+// each tick the emulation thread snapshots the parts of shared memory the application controls,
+// looks up the memory of the buffers they enqueue and hands both over, then carries on while the
+// frame is mixed and output. The audio thread never accesses the page table itself. What the DSP
+// writes back (source statuses, DSP status and final samples) is copied into shared memory at the
+// next tick, so the application sees it one frame later than it would otherwise.
+//
+// Auxiliary sends hand intermediate mixes to the application and expect them back by the next
+// frame, which cannot be done with this latency. Frames are generated synchronously while they are
+// enabled.
+
+/// Copy of the shared memory a frame is generated from, and of what it generates
+struct FrameJob {
+    SharedMemory read;
+    SharedMemory write;
+    BufferMemory buffer_memory;
+    /// Index in g_regions of the region the results belong to
+    size_t write_region = 0;
+    /// Whether the results still need to be copied to shared memory
+    bool results_pending = false;
+};
+
+static bool use_audio_thread = false;
+static std::unique_ptr<std::thread> audio_thread;
+static std::mutex audio_thread_mutex;
+static std::condition_variable audio_thread_cv;
+static bool job_submitted = false; ///< Protected by audio_thread_mutex
+static bool stop_requested = false; ///< Protected by audio_thread_mutex
+
+/// Jobs alternate, so that the results of a frame can be written back while the next is mixed
+static std::array<FrameJob, 2> frame_jobs;
+static size_t current_job = 0;
+
+/// Mirrors the enable state of the auxiliary sends of the mixers, which run on the audio thread
+static std::array<bool, 2> aux_send_enabled = {};
+
+/// Shared memory structures can't be assigned because of their BitField members
+template <typename T>
+static void CopyStruct(T& dest, const T& source) {
+    std::memcpy(static_cast<void*>(&dest), &source, sizeof(T));
+}
+
+static void AudioThreadLoop() {
+    Common::SetCurrentThreadName("AudioThread");
+
+    std::unique_lock<std::mutex> lock(audio_thread_mutex);
+    while (true) {
+        audio_thread_cv.wait(lock, [] { return job_submitted || stop_requested; });
+        if (!job_submitted)
+            return;
+
+        lock.unlock();
+        FrameJob& job = frame_jobs[current_job];
+        OutputCurrentFrame(GenerateCurrentFrame(job.read, job.write, job.buffer_memory));
+        lock.lock();
+
+        job_submitted = false;
+        audio_thread_cv.notify_all();
+    }
+}
+
+static void WaitForAudioThread() {
+    std::unique_lock<std::mutex> lock(audio_thread_mutex);
+    audio_thread_cv.wait(lock, [] { return !job_submitted; });
+}
+
+static void WriteBackResults(FrameJob& job) {
+    if (!job.results_pending)
         return;
 
-    if (!enable) {
-        FlushResidualStretcherAudio();
+    SharedMemory& write = g_regions[job.write_region];
+    CopyStruct(write.source_statuses, job.write.source_statuses);
+    CopyStruct(write.dsp_status, job.write.dsp_status);
+    CopyStruct(write.final_samples, job.write.final_samples);
+    job.results_pending = false;
+}
+
+/// Waits for the frame in flight and copies its results to shared memory
+static void SyncAudioThread() {
+    if (!audio_thread)
+        return;
+
+    WaitForAudioThread();
+    WriteBackResults(frame_jobs[current_job]);
+}
+
+static void StopAudioThread() {
+    if (!audio_thread)
+        return;
+
+    SyncAudioThread();
+    {
+        std::lock_guard<std::mutex> lock(audio_thread_mutex);
+        stop_requested = true;
+    }
+    audio_thread_cv.notify_all();
+    audio_thread->join();
+    audio_thread.reset();
+    stop_requested = false;
+}
+
+static void UpdateAuxSendState(const DspConfiguration& config) {
+    if (config.mixer1_enabled_dirty)
+        aux_send_enabled[0] = config.mixer1_enabled != 0;
+    if (config.mixer2_enabled_dirty)
+        aux_send_enabled[1] = config.mixer2_enabled != 0;
+}
+
+/**
+ * Clears the dirty flags of the configuration in shared memory the way Source::Tick and
+ * Mixers::Tick would, now that the audio thread consumes a copy of it.
+ */
+static void ClearDirtyFlags(SharedMemory& region) {
+    for (auto& config : region.source_configurations.config) {
+        if (!config.dirty_raw)
+            continue;
+        if (config.buffer_queue_dirty)
+            config.buffers_dirty = 0;
+        config.dirty_raw = 0;
     }
-    perform_time_stretching = enable;
+    region.dsp_configuration.dirty_raw = 0;
+}
+
+/// Hands the current frame over to the audio thread, starting it if needed
+static void SubmitCurrentFrame() {
+    if (!audio_thread) {
+        audio_thread = std::make_unique<std::thread>(AudioThreadLoop);
+    }
+
+    WaitForAudioThread();
+    const size_t previous_job = current_job;
+    FrameJob& job = frame_jobs[1 - current_job];
+
+    SharedMemory& read = ReadRegion();
+    CopyStruct(job.read.dsp_configuration, read.dsp_configuration);
+    CopyStruct(job.read.source_configurations, read.source_configurations);
+    CopyStruct(job.read.adpcm_coefficients, read.adpcm_coefficients);
+    ResolveBufferMemory(job.read, job.buffer_memory);
+    job.write_region = 1 - CurrentRegionIndex();
+    job.results_pending = true;
+    ClearDirtyFlags(read);
+
+    {
+        std::lock_guard<std::mutex> lock(audio_thread_mutex);
+        current_job = 1 - current_job;
+        job_submitted = true;
+    }
+    audio_thread_cv.notify_all();
+
+    WriteBackResults(frame_jobs[previous_job]);
+}
+
+// Settings changes
+//
+// The frontend changes settings from its own thread, while the audio thread is started, stopped
+// and synchronized with from the emulation thread. Changes are therefore only recorded here, and
+// applied by Tick on the emulation thread.
+
+static std::atomic<bool> stretching_requested{true};
+static std::atomic<bool> audio_thread_requested{false};
+static std::mutex sink_request_mutex;
+static std::unique_ptr<AudioCore::Sink> requested_sink; ///< Protected by sink_request_mutex
+
+static void ApplyRequestedSettings() {
+    std::unique_ptr<AudioCore::Sink> new_sink;
+    {
+        std::lock_guard<std::mutex> lock(sink_request_mutex);
+        new_sink = std::move(requested_sink);
+    }
+    if (new_sink) {
+        SyncAudioThread();
+        sink = std::move(new_sink);
+        time_stretcher.SetOutputSampleRate(sink->GetNativeSampleRate());
+    }
+
+    const bool enable_stretching = stretching_requested;
+    if (perform_time_stretching != enable_stretching) {
+        SyncAudioThread();
+        if (!enable_stretching && sink) {
+            FlushResidualStretcherAudio();
+        }
+        perform_time_stretching = enable_stretching;
+    }
+
+    use_audio_thread = audio_thread_requested;
+    if (!use_audio_thread) {
+        StopAudioThread();
+    }
+}
+
+void EnableStretching(bool enable) {
+    stretching_requested = enable;
+}
+
+void EnableAudioThread(bool enable) {
+    audio_thread_requested = enable;
 }
 
 // Public Interface
 
 void Init() {
+    StopAudioThread();
     DSP::HLE::ResetPipes();
 
     for (auto& source : sources) {
@@ -136,6 +340,7 @@ void Init() {
     }
 
     mixers.Reset();
+    aux_send_enabled = {};
 
     time_stretcher.Reset();
     if (sink) {
@@ -144,17 +349,31 @@ void Init() {
 }
 
 void Shutdown() {
-    if (perform_time_stretching) {
+    StopAudioThread();
+    if (perform_time_stretching && sink) {
         FlushResidualStretcherAudio();
     }
 }
 
 bool Tick() {
-    StereoFrame16 current_frame = {};
-
     // TODO: Check dsp::DSP semaphore (which indicates emulated application has finished writing to
     // shared memory region)
-    current_frame = GenerateCurrentFrame();
+
+    ApplyRequestedSettings();
+
+    UpdateAuxSendState(ReadRegion().dsp_configuration);
+    if (use_audio_thread && !aux_send_enabled[0] && !aux_send_enabled[1]) {
+        SubmitCurrentFrame();
+        return true;
+    }
+
+    // Any frame still in flight on the audio thread comes before this one
+    SyncAudioThread();
+
+    BufferMemory buffer_memory;
+    SharedMemory& read = ReadRegion();
+    ResolveBufferMemory(read, buffer_memory);
+    StereoFrame16 current_frame = GenerateCurrentFrame(read, WriteRegion(), buffer_memory);
 
     OutputCurrentFrame(current_frame);
 
@@ -162,8 +381,8 @@ bool Tick() {
 }
 
 void SetSink(std::unique_ptr<AudioCore::Sink> sink_) {
-    sink = std::move(sink_);
-    time_stretcher.SetOutputSampleRate(sink->GetNativeSampleRate());
+    std::lock_guard<std::mutex> lock(sink_request_mutex);
+    requested_sink = std::move(sink_);
 }
 
 } // namespace HLE
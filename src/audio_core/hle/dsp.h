@@ -563,7 +563,8 @@ void Shutdown();
 bool Tick();
 
 /**
- * Set the output sink. This must be called before calling Tick().
+ * Set the output sink. This must be called before the first call to Tick(). May be called from
+ * any thread, the sink is switched at the next Tick().
  * @param sink The sink to which audio will be output to.
  */
 void SetSink(std::unique_ptr<AudioCore::Sink> sink);
@@ -572,9 +573,19 @@ void SetSink(std::unique_ptr<AudioCore::Sink> sink);
  * Enables/Disables audio-stretching.
  * Audio stretching is an enhancement that stretches audio to match emulation
  * speed to prevent stuttering at the cost of some audio latency.
+ * May be called from any thread, the change takes effect at the next Tick().
  * @param enable true to enable, false to disable.
  */
 void EnableStretching(bool enable);
 
+/**
+ * Enables/Disables the audio thread.
+ * When enabled, frames are mixed and output on a dedicated thread rather than during Tick(), and
+ * what the DSP writes to shared memory becomes visible to the application one frame later.
+ * May be called from any thread, the thread is started or stopped at the next Tick().
+ * @param enable true to enable, false to disable.
+ */
+void EnableAudioThread(bool enable);
+
 } // namespace HLE
 } // namespace DSP
@@ -4,6 +4,10 @@
 
 #include <array>
 #include <cstddef>
+#include <cstring>
+#ifdef ARCHITECTURE_x86_64
+#include <emmintrin.h>
+#endif
 #include "audio_core/hle/common.h"
 #include "audio_core/hle/dsp.h"
 #include "audio_core/hle/filter.h"
@@ -44,7 +48,7 @@ void SourceFilters::ProcessFrame(StereoFrame16& frame) {
     }
 
     if (biquad_filter_enabled) {
-        FilterFrame(frame, biquad_filter);
+        biquad_filter.ProcessFrame(frame);
     }
 }
 
@@ -113,5 +117,51 @@ std::array<s16, 2> SourceFilters::BiquadFilter::ProcessSample(const std::array<s
     return y0;
 }
 
+void SourceFilters::BiquadFilter::ProcessFrame(StereoFrame16& frame) {
+#ifdef ARCHITECTURE_x86_64
+    // The filter is recursive, so the samples are processed in order, with both channels in the
+    // same vector. The history of each channel is kept as x1 x2 y1 y2, so that the products with
+    // the coefficients can be summed in pairs by pmaddwd. All coefficients fit into 16 bits.
+    const auto coeff = [](s32 value) { return static_cast<s16>(value); };
+    const __m128i history_coeffs = _mm_setr_epi16(coeff(b1), coeff(b2), coeff(a1), coeff(a2),
+                                                  coeff(b1), coeff(b2), coeff(a1), coeff(a2));
+    const __m128i input_coeffs = _mm_setr_epi16(coeff(b0), 0, coeff(b0), 0, 0, 0, 0, 0);
+    const __m128i zero = _mm_setzero_si128();
+
+    __m128i history = _mm_setr_epi16(x1[0], x2[0], y1[0], y2[0], x1[1], x2[1], y1[1], y2[1]);
+    for (auto& sample : frame) {
+        s32 packed_x0;
+        std::memcpy(&packed_x0, sample.data(), sizeof(packed_x0));
+        const __m128i x0 = _mm_cvtsi32_si128(packed_x0);
+
+        // b0 * x0 for both channels, in the low two lanes
+        const __m128i input_products = _mm_madd_epi16(_mm_unpacklo_epi16(x0, zero), input_coeffs);
+        // b1 * x1 + b2 * x2 and a1 * y1 + a2 * y2 for both channels
+        const __m128i history_products = _mm_madd_epi16(history, history_coeffs);
+        const __m128i sums = _mm_add_epi32(
+            input_products,
+            _mm_add_epi32(_mm_shuffle_epi32(history_products, _MM_SHUFFLE(3, 3, 2, 0)),
+                          _mm_shuffle_epi32(history_products, _MM_SHUFFLE(3, 3, 3, 1))));
+        const __m128i y0 = _mm_packs_epi32(_mm_srai_epi32(sums, 14), zero);
+
+        const s32 packed_y0 = _mm_cvtsi128_si32(y0);
+        std::memcpy(sample.data(), &packed_y0, sizeof(packed_y0));
+
+        // x1 x2 y1 y2 becomes x0 x1 y0 y1
+        history = _mm_or_si128(_mm_slli_epi32(history, 16),
+                               _mm_unpacklo_epi16(_mm_unpacklo_epi16(x0, y0), zero));
+    }
+
+    alignas(16) std::array<s16, 8> final_history;
+    _mm_store_si128(reinterpret_cast<__m128i*>(final_history.data()), history);
+    x1 = {final_history[0], final_history[4]};
+    x2 = {final_history[1], final_history[5]};
+    y1 = {final_history[2], final_history[6]};
+    y2 = {final_history[3], final_history[7]};
+#else
+    FilterFrame(frame, *this);
+#endif // ARCHITECTURE_x86_64
+}
+
 } // namespace HLE
 } // namespace DSP
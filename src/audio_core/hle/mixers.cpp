@@ -3,6 +3,9 @@
 // Refer to the license.txt file included.
 
 #include <cstddef>
+#ifdef ARCHITECTURE_x86_64
+#include <emmintrin.h>
+#endif
 
 #include "audio_core/hle/common.h"
 #include "audio_core/hle/dsp.h"
@@ -88,6 +91,22 @@ void Mixers::ParseConfig(DspConfiguration& config) {
     config.dirty_raw = 0;
 }
 
+#ifdef ARCHITECTURE_x86_64
+
+/// Loads a quadraphonic sample and applies the gain to it
+static __m128 LoadQuadSample(const std::array<s32, 4>& sample, __m128 gain) {
+    return _mm_mul_ps(
+        _mm_cvtepi32_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(sample.data()))), gain);
+}
+
+/// Adds four stereo samples to the frame, saturating to the PCM16 range
+static void MixIntoFrame(std::array<s16, 2>* dest, __m128i samples) {
+    const auto dest_vector = reinterpret_cast<__m128i*>(dest);
+    _mm_storeu_si128(dest_vector, _mm_adds_epi16(_mm_loadu_si128(dest_vector), samples));
+}
+
+#else
+
 static s16 ClampToS16(s32 value) {
     return static_cast<s16>(MathUtil::Clamp(value, -32768, 32767));
 }
@@ -98,11 +117,34 @@ static std::array<s16, 2> AddAndClampToS16(const std::array<s16, 2>& a,
             ClampToS16(static_cast<s32>(a[1]) + static_cast<s32>(b[1]))};
 }
 
+#endif // ARCHITECTURE_x86_64
+
 void Mixers::DownmixAndMixIntoCurrentFrame(float gain, const QuadFrame32& samples) {
     // TODO(merry): Limiter. (Currently we're performing final mixing assuming a disabled limiter.)
 
+    // The vectorized paths perform the same floating point operations in the same order as the
+    // scalar ones, four samples at a time, so their results are identical.
     switch (state.output_format) {
-    case OutputFormat::Mono:
+    case OutputFormat::Mono: {
+#ifdef ARCHITECTURE_x86_64
+        const __m128 v_gain = _mm_set1_ps(gain);
+        const __m128 half = _mm_set1_ps(0.5f);
+        for (size_t i = 0; i < samples_per_frame; i += 4) {
+            __m128 channel0 = LoadQuadSample(samples[i + 0], v_gain);
+            __m128 channel1 = LoadQuadSample(samples[i + 1], v_gain);
+            __m128 channel2 = LoadQuadSample(samples[i + 2], v_gain);
+            __m128 channel3 = LoadQuadSample(samples[i + 3], v_gain);
+            _MM_TRANSPOSE4_PS(channel0, channel1, channel2, channel3);
+
+            // Downmix to mono
+            const __m128 sum =
+                _mm_add_ps(_mm_add_ps(_mm_add_ps(channel0, channel1), channel2), channel3);
+            const __m128i mono = _mm_cvttps_epi32(_mm_mul_ps(sum, half));
+            const __m128i mono16 = _mm_packs_epi32(mono, mono);
+            // Mix into current frame
+            MixIntoFrame(&current_frame[i], _mm_unpacklo_epi16(mono16, mono16));
+        }
+#else
         std::transform(
             current_frame.begin(), current_frame.end(), samples.begin(), current_frame.begin(),
             [gain](const std::array<s16, 2>& accumulator,
@@ -114,13 +156,35 @@ void Mixers::DownmixAndMixIntoCurrentFrame(float gain, const QuadFrame32& sample
                 // Mix into current frame
                 return AddAndClampToS16(accumulator, {mono, mono});
             });
+#endif // ARCHITECTURE_x86_64
         return;
+    }
 
     case OutputFormat::Surround:
     // TODO(merry): Implement surround sound.
     // fallthrough
 
-    case OutputFormat::Stereo:
+    case OutputFormat::Stereo: {
+#ifdef ARCHITECTURE_x86_64
+        const __m128 v_gain = _mm_set1_ps(gain);
+        for (size_t i = 0; i < samples_per_frame; i += 4) {
+            const __m128 sample0 = LoadQuadSample(samples[i + 0], v_gain);
+            const __m128 sample1 = LoadQuadSample(samples[i + 1], v_gain);
+            const __m128 sample2 = LoadQuadSample(samples[i + 2], v_gain);
+            const __m128 sample3 = LoadQuadSample(samples[i + 3], v_gain);
+
+            // Downmix to stereo: channels 0 and 2 go left, channels 1 and 3 go right
+            const __m128 stereo01 =
+                _mm_add_ps(_mm_shuffle_ps(sample0, sample1, _MM_SHUFFLE(1, 0, 1, 0)),
+                           _mm_shuffle_ps(sample0, sample1, _MM_SHUFFLE(3, 2, 3, 2)));
+            const __m128 stereo23 =
+                _mm_add_ps(_mm_shuffle_ps(sample2, sample3, _MM_SHUFFLE(1, 0, 1, 0)),
+                           _mm_shuffle_ps(sample2, sample3, _MM_SHUFFLE(3, 2, 3, 2)));
+            // Mix into current frame
+            MixIntoFrame(&current_frame[i], _mm_packs_epi32(_mm_cvttps_epi32(stereo01),
+                                                            _mm_cvttps_epi32(stereo23)));
+        }
+#else
         std::transform(
             current_frame.begin(), current_frame.end(), samples.begin(), current_frame.begin(),
             [gain](const std::array<s16, 2>& accumulator,
@@ -131,8 +195,10 @@ void Mixers::DownmixAndMixIntoCurrentFrame(float gain, const QuadFrame32& sample
                 // Mix into current frame
                 return AddAndClampToS16(accumulator, {left, right});
             });
+#endif // ARCHITECTURE_x86_64
         return;
     }
+    }
 
     UNREACHABLE_MSG("Invalid output_format %zu", static_cast<size_t>(state.output_format));
 }
@@ -4,6 +4,10 @@
 
 #include <algorithm>
 #include <array>
+#include <cstring>
+#ifdef ARCHITECTURE_x86_64
+#include <emmintrin.h>
+#endif
 #include "audio_core/codec.h"
 #include "audio_core/hle/common.h"
 #include "audio_core/hle/source.h"
@@ -15,9 +19,26 @@
 namespace DSP {
 namespace HLE {
 
+Source::BufferMemory Source::ResolveBufferMemory(
+    const SourceConfiguration::Configuration& config) {
+    BufferMemory buffer_memory;
+    if (config.embedded_buffer_dirty)
+        buffer_memory.embedded = Memory::GetPhysicalPointer(config.physical_address);
+    if (config.buffer_queue_dirty) {
+        for (size_t i = 0; i < 4; i++) {
+            if (config.buffers_dirty & (1 << i)) {
+                buffer_memory.queued[i] =
+                    Memory::GetPhysicalPointer(config.buffers[i].physical_address);
+            }
+        }
+    }
+    return buffer_memory;
+}
+
 SourceStatus::Status Source::Tick(SourceConfiguration::Configuration& config,
-                                  const s16_le (&adpcm_coeffs)[16]) {
-    ParseConfig(config, adpcm_coeffs);
+                                  const s16_le (&adpcm_coeffs)[16],
+                                  const BufferMemory& buffer_memory) {
+    ParseConfig(config, adpcm_coeffs, buffer_memory);
 
     if (state.enabled) {
         GenerateFrame();
@@ -31,6 +52,21 @@ void Source::MixInto(QuadFrame32& dest, size_t intermediate_mix_id) const {
         return;
 
     const std::array<float, 4>& gains = state.gain.at(intermediate_mix_id);
+#ifdef ARCHITECTURE_x86_64
+    const __m128 v_gains = _mm_loadu_ps(gains.data());
+    for (size_t samplei = 0; samplei < samples_per_frame; samplei++) {
+        s32 packed;
+        std::memcpy(&packed, current_frame[samplei].data(), sizeof(packed));
+        // Sign extend to L R, then conversion from stereo to quadraphonic: L R L R
+        const __m128i stereo = _mm_srai_epi32(
+            _mm_unpacklo_epi16(_mm_cvtsi32_si128(packed), _mm_cvtsi32_si128(packed)), 16);
+        const __m128i quad = _mm_shuffle_epi32(stereo, _MM_SHUFFLE(1, 0, 1, 0));
+        const __m128i mixed = _mm_cvttps_epi32(_mm_mul_ps(_mm_cvtepi32_ps(quad), v_gains));
+
+        const auto dest_sample = reinterpret_cast<__m128i*>(dest[samplei].data());
+        _mm_storeu_si128(dest_sample, _mm_add_epi32(_mm_loadu_si128(dest_sample), mixed));
+    }
+#else
     for (size_t samplei = 0; samplei < samples_per_frame; samplei++) {
         // Conversion from stereo (current_frame) to quadraphonic (dest) occurs here.
         dest[samplei][0] += static_cast<s32>(gains[0] * current_frame[samplei][0]);
@@ -38,6 +74,7 @@ void Source::MixInto(QuadFrame32& dest, size_t intermediate_mix_id) const {
         dest[samplei][2] += static_cast<s32>(gains[2] * current_frame[samplei][0]);
         dest[samplei][3] += static_cast<s32>(gains[3] * current_frame[samplei][1]);
     }
+#endif // ARCHITECTURE_x86_64
 }
 
 void Source::Reset() {
@@ -46,7 +83,7 @@ void Source::Reset() {
 }
 
 void Source::ParseConfig(SourceConfiguration::Configuration& config,
-                         const s16_le (&adpcm_coeffs)[16]) {
+                         const s16_le (&adpcm_coeffs)[16], const BufferMemory& buffer_memory) {
     if (!config.dirty_raw) {
         return;
     }
@@ -162,6 +199,7 @@ void Source::ParseConfig(SourceConfiguration::Configuration& config,
         config.embedded_buffer_dirty.Assign(0);
         state.input_queue.emplace(Buffer{
             config.physical_address,
+            buffer_memory.embedded,
             config.length,
             static_cast<u8>(config.adpcm_ps),
             {config.adpcm_yn[0], config.adpcm_yn[1]},
@@ -183,6 +221,7 @@ void Source::ParseConfig(SourceConfiguration::Configuration& config,
                 const auto& b = config.buffers[i];
                 state.input_queue.emplace(Buffer{
                     b.physical_address,
+                    buffer_memory.queued[i],
                     b.length,
                     static_cast<u8>(b.adpcm_ps),
                     {b.adpcm_yn[0], b.adpcm_yn[1]},
@@ -210,7 +249,7 @@ void Source::ParseConfig(SourceConfiguration::Configuration& config,
 void Source::GenerateFrame() {
     current_frame.fill({});
 
-    if (state.current_buffer.empty() && !DequeueBuffer()) {
+    if (state.current_buffer_remaining == 0 && !DequeueBuffer()) {
         state.enabled = false;
         state.buffer_update = true;
         state.current_buffer_id = 0;
@@ -221,17 +260,18 @@ void Source::GenerateFrame() {
 
     state.current_sample_number = state.next_sample_number;
     while (frame_position < current_frame.size()) {
-        if (state.current_buffer.empty() && !DequeueBuffer()) {
+        if (state.current_buffer_remaining == 0 && !DequeueBuffer()) {
             break;
         }
 
         const size_t size_to_copy =
-            std::min(state.current_buffer.size(), current_frame.size() - frame_position);
+            std::min(state.current_buffer_remaining, current_frame.size() - frame_position);
 
-        std::copy(state.current_buffer.begin(), state.current_buffer.begin() + size_to_copy,
-                  current_frame.begin() + frame_position);
-        state.current_buffer.erase(state.current_buffer.begin(),
-                                   state.current_buffer.begin() + size_to_copy);
+        // Consumed samples are skipped over rather than erased, the storage is reused by the next
+        // buffer
+        const auto source = current_buffer.end() - state.current_buffer_remaining;
+        std::copy(source, source + size_to_copy, current_frame.begin() + frame_position);
+        state.current_buffer_remaining -= size_to_copy;
 
         frame_position += size_to_copy;
         state.next_sample_number += static_cast<u32>(size_to_copy);
@@ -241,7 +281,7 @@ void Source::GenerateFrame() {
 }
 
 bool Source::DequeueBuffer() {
-    ASSERT_MSG(state.current_buffer.empty(),
+    ASSERT_MSG(state.current_buffer_remaining == 0,
                "Shouldn't dequeue; we still have data in current_buffer");
 
     if (state.input_queue.empty())
@@ -259,60 +299,66 @@ bool Source::DequeueBuffer() {
         LOG_ERROR(Audio_DSP, "Looped buffers are unimplemented at the moment");
     }
 
-    const u8* const memory = Memory::GetPhysicalPointer(buf.physical_address);
+    const u8* const memory = buf.memory;
     if (memory) {
         const unsigned num_channels = buf.mono_or_stereo == MonoOrStereo::Stereo ? 2 : 1;
         switch (buf.format) {
         case Format::PCM8:
-            state.current_buffer = Codec::DecodePCM8(num_channels, memory, buf.length);
+            Codec::DecodePCM8(num_channels, memory, buf.length, decoded_buffer);
             break;
         case Format::PCM16:
-            state.current_buffer = Codec::DecodePCM16(num_channels, memory, buf.length);
+            Codec::DecodePCM16(num_channels, memory, buf.length, decoded_buffer);
             break;
         case Format::ADPCM:
             DEBUG_ASSERT(num_channels == 1);
-            state.current_buffer =
-                Codec::DecodeADPCM(memory, buf.length, state.adpcm_coeffs, state.adpcm_state);
+            Codec::DecodeADPCM(memory, buf.length, state.adpcm_coeffs, state.adpcm_state,
+                               decoded_buffer);
             break;
         default:
             UNIMPLEMENTED();
+            decoded_buffer.clear();
             break;
         }
     } else {
         LOG_WARNING(Audio_DSP,
                     "source_id=%zu buffer_id=%hu length=%u: Invalid physical address 0x%08X",
                     source_id, buf.buffer_id, buf.length, buf.physical_address);
-        state.current_buffer.clear();
+        current_buffer.clear();
+        state.current_buffer_remaining = 0;
         return true;
     }
 
     switch (state.interpolation_mode) {
     case InterpolationMode::None:
-        state.current_buffer =
-            AudioInterp::None(state.interp_state, state.current_buffer, state.rate_multiplier);
+        AudioInterp::None(state.interp_state, decoded_buffer, state.rate_multiplier,
+                          current_buffer);
         break;
     case InterpolationMode::Linear:
-        state.current_buffer =
-            AudioInterp::Linear(state.interp_state, state.current_buffer, state.rate_multiplier);
+        AudioInterp::Linear(state.interp_state, decoded_buffer, state.rate_multiplier,
+                            current_buffer);
         break;
     case InterpolationMode::Polyphase:
         // TODO(merry): Implement polyphase interpolation
-        state.current_buffer =
-            AudioInterp::Linear(state.interp_state, state.current_buffer, state.rate_multiplier);
+        // The filter used by the DSP firmware is unknown. This approximates it with Catmull-Rom
+        // interpolation, which sounds different from the linear interpolation used before.
+        AudioInterp::Polyphase(state.interp_state, decoded_buffer, state.rate_multiplier,
+                               current_buffer);
         break;
     default:
         UNIMPLEMENTED();
+        current_buffer.assign(decoded_buffer.begin(), decoded_buffer.end());
         break;
     }
 
     state.current_sample_number = 0;
     state.next_sample_number = 0;
+    state.current_buffer_remaining = current_buffer.size();
     state.current_buffer_id = buf.buffer_id;
     state.buffer_update = buf.from_queue;
 
     LOG_TRACE(Audio_DSP, "source_id=%zu buffer_id=%hu from_queue=%s current_buffer.size()=%zu",
               source_id, buf.buffer_id, buf.from_queue ? "true" : "false",
-              state.current_buffer.size());
+              current_buffer.size());
     return true;
 }
 
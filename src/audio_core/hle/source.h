@@ -29,9 +29,24 @@ namespace HLE {
 class Source final {
 public:
     explicit Source(size_t source_id_) : source_id(source_id_) {
+        decoded_buffer.reserve(preallocated_samples);
+        current_buffer.reserve(preallocated_samples);
         Reset();
     }
 
+    /**
+     * Host memory of the buffers a configuration enqueues, nullptr for buffers it doesn't enqueue
+     * or whose address is invalid. The page table may only be accessed from the emulation thread,
+     * so this is resolved there even when the frame is generated elsewhere.
+     */
+    struct BufferMemory {
+        const u8* embedded = nullptr;
+        std::array<const u8*, 4> queued = {};
+    };
+
+    /// Looks up the memory of the buffers `config` enqueues. Call from the emulation thread.
+    static BufferMemory ResolveBufferMemory(const SourceConfiguration::Configuration& config);
+
     /// Resets internal state.
     void Reset();
 
@@ -40,11 +55,12 @@ public:
      * @param config The new configuration we've got for this Source from the application.
      * @param adpcm_coeffs ADPCM coefficients to use if config tells us to use them (may contain
      * invalid values otherwise).
+     * @param buffer_memory Memory of the buffers config enqueues, see ResolveBufferMemory.
      * @return The current status of this Source. This is given back to the emulated application via
      * SharedMemory.
      */
     SourceStatus::Status Tick(SourceConfiguration::Configuration& config,
-                              const s16_le (&adpcm_coeffs)[16]);
+                              const s16_le (&adpcm_coeffs)[16], const BufferMemory& buffer_memory);
 
     /**
      * Mix this source's output into dest, using the gains for the `intermediate_mix_id`-th
@@ -55,9 +71,19 @@ public:
     void MixInto(QuadFrame32& dest, size_t intermediate_mix_id) const;
 
 private:
+    /// Number of samples the sample buffers have room for up front. They only grow if a buffer
+    /// longer than this is queued, and keep their storage afterwards.
+    static constexpr size_t preallocated_samples = 4096;
+
     const size_t source_id;
     StereoFrame16 current_frame;
 
+    /// Samples of the current buffer after decoding. Only used while dequeuing a buffer.
+    Codec::StereoBuffer16 decoded_buffer;
+    /// Samples of the current buffer after resampling. The last state.current_buffer_remaining
+    /// samples haven't been output yet.
+    AudioInterp::StereoBuffer16 current_buffer;
+
     using Format = SourceConfiguration::Configuration::Format;
     using InterpolationMode = SourceConfiguration::Configuration::InterpolationMode;
     using MonoOrStereo = SourceConfiguration::Configuration::MonoOrStereo;
@@ -65,6 +91,8 @@ private:
     /// Internal representation of a buffer for our buffer queue
     struct Buffer {
         PAddr physical_address;
+        /// Host memory at physical_address, nullptr if the address is invalid
+        const u8* memory;
         u32 length;
         u8 adpcm_ps;
         std::array<u16, 2> adpcm_yn;
@@ -106,7 +134,7 @@ private:
 
         u32 current_sample_number = 0;
         u32 next_sample_number = 0;
-        std::vector<std::array<s16, 2>> current_buffer;
+        size_t current_buffer_remaining = 0;
 
         // buffer_id state
 
@@ -133,11 +161,12 @@ private:
     // Internal functions
 
     /// INTERNAL: Update our internal state based on the current config.
-    void ParseConfig(SourceConfiguration::Configuration& config, const s16_le (&adpcm_coeffs)[16]);
+    void ParseConfig(SourceConfiguration::Configuration& config, const s16_le (&adpcm_coeffs)[16],
+                     const BufferMemory& buffer_memory);
     /// INTERNAL: Generate the current audio output for this frame based on our internal state.
     void GenerateFrame();
     /// INTERNAL: Dequeues a buffer and does preprocessing on it (decoding, resampling). Puts it
-    /// into current_buffer.
+    /// into current_buffer, reusing its storage.
     bool DequeueBuffer();
     /// INTERNAL: Generates a SourceStatus::Status based on our internal state.
     SourceStatus::Status GetCurrentStatus();
@@ -2,85 +2,272 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#ifdef ARCHITECTURE_x86_64
+#include <emmintrin.h>
+#endif
 #include "audio_core/interpolate.h"
 #include "common/assert.h"
 #include "common/math_util.h"
 
 namespace AudioInterp {
 
+using Sample = StereoBuffer16::value_type;
+
 // Calculations are done in fixed point with 24 fractional bits.
 // (This is not verified. This was chosen for minimal error.)
 constexpr u64 scale_factor = 1 << 24;
 constexpr u64 scale_mask = scale_factor - 1;
 
-/// Here we step over the input in steps of rate_multiplier, until we consume all of the input.
-/// Three adjacent samples are passed to fn each step.
-template <typename Function>
-static StereoBuffer16 StepOverSamples(State& state, const StereoBuffer16& input,
-                                      float rate_multiplier, Function fn) {
+/**
+ * Steps over the given number of output positions, starting at fposition, calling
+ * Kernel::Interpolate with the four input samples surrounding each of them. This is the fallback
+ * for kernels without a vectorized implementation.
+ * @param input Input samples. Every position must be at least 3 samples into it.
+ */
+template <typename Kernel>
+static void InterpolateRangeScalar(const Sample* input, Sample* output, size_t count,
+                                   u64 fposition, u64 step_size) {
+    for (size_t i = 0; i < count; ++i, fposition += step_size) {
+        const size_t index = static_cast<size_t>(fposition / scale_factor);
+        output[i] = Kernel::Interpolate(fposition & scale_mask, input[index - 3],
+                                        input[index - 2], input[index - 1], input[index]);
+    }
+}
+
+/**
+ * Here we step over the input in steps of rate_multiplier, until we consume all of the input.
+ * Four adjacent samples are passed to the kernel each step, and the output lies between the second
+ * and the third of them. The first few steps use samples from the previous input as well.
+ */
+template <typename Kernel>
+static void StepOverSamples(State& state, const StereoBuffer16& input, float rate_multiplier,
+                            StereoBuffer16& output) {
     ASSERT(rate_multiplier > 0);
 
+    output.clear();
     if (input.size() < 2)
-        return {};
+        return;
 
-    StereoBuffer16 output;
-    output.reserve(static_cast<size_t>(input.size() / rate_multiplier));
+    const u64 step_size = std::max<u64>(static_cast<u64>(rate_multiplier * scale_factor), 1);
+    const u64 max_fposition = input.size() * scale_factor;
 
-    u64 step_size = static_cast<u64>(rate_multiplier * scale_factor);
+    // Samples are output at every multiple of step_size below max_fposition
+    output.resize(static_cast<size_t>((max_fposition + step_size - 1) / step_size));
+
+    // Until the position is 3 samples into the input, the four samples surrounding it include
+    // samples from the previous input
+    const std::array<Sample, 6> head{{state.xn3, state.xn2, state.xn1, input[0], input[1],
+                                      input.size() > 2 ? input[2] : Sample{}}};
+    const u64 head_end = std::min(3 * scale_factor, max_fposition);
 
     u64 fposition = 0;
-    const u64 max_fposition = input.size() * scale_factor;
+    size_t i = 0;
+    for (; fposition < head_end; fposition += step_size, ++i) {
+        const size_t index = static_cast<size_t>(fposition / scale_factor);
+        output[i] = Kernel::Interpolate(fposition & scale_mask, head[index], head[index + 1],
+                                        head[index + 2], head[index + 3]);
+    }
 
-    while (fposition < 1 * scale_factor) {
-        u64 fraction = fposition & scale_mask;
+    Kernel::InterpolateRange(input.data(), output.data() + i, output.size() - i, fposition,
+                             step_size);
 
-        output.push_back(fn(fraction, state.xn2, state.xn1, input[0]));
+    state.xn3 = input.size() > 2 ? input[input.size() - 3] : state.xn1;
+    state.xn2 = input[input.size() - 2];
+    state.xn1 = input[input.size() - 1];
+}
 
-        fposition += step_size;
+struct NoneKernel {
+    static Sample Interpolate(u64 fraction, const Sample& xm1, const Sample& x0, const Sample& x1,
+                              const Sample& x2) {
+        return x0;
     }
 
-    while (fposition < 2 * scale_factor) {
-        u64 fraction = fposition & scale_mask;
+    static void InterpolateRange(const Sample* input, Sample* output, size_t count,
+                                 u64 fposition, u64 step_size) {
+        InterpolateRangeScalar<NoneKernel>(input, output, count, fposition, step_size);
+    }
+};
 
-        output.push_back(fn(fraction, state.xn1, input[0], input[1]));
+struct LinearKernel {
+    static Sample Interpolate(u64 fraction, const Sample& xm1, const Sample& x0, const Sample& x1,
+                              const Sample& x2) {
+        // This is a saturated subtraction. (Verified by black-box fuzzing.)
+        s64 delta0 = MathUtil::Clamp<s64>(x1[0] - x0[0], -32768, 32767);
+        s64 delta1 = MathUtil::Clamp<s64>(x1[1] - x0[1], -32768, 32767);
 
-        fposition += step_size;
+        // Note that the unsigned arithmetic makes the division round towards negative infinity
+        return Sample{
+            static_cast<s16>(x0[0] + fraction * delta0 / scale_factor),
+            static_cast<s16>(x0[1] + fraction * delta1 / scale_factor),
+        };
     }
 
-    while (fposition < max_fposition) {
-        u64 fraction = fposition & scale_mask;
+    static void InterpolateRange(const Sample* input, Sample* output, size_t count,
+                                 u64 fposition, u64 step_size) {
+        size_t i = 0;
+#ifdef ARCHITECTURE_x86_64
+        // Four stereo samples at a time. With the fraction split into f = fh * 2^9 + fl, where
+        // fh and fl fit into 16 bits, floor(f * delta / 2^24) is equal to
+        // (fh * delta + ((fl * delta) >> 9)) >> 15 without needing 64-bit products.
+        for (; i + 4 <= count; i += 4) {
+            u32 x0[4], x1[4];
+            s16 fraction_high[4], fraction_low[4];
+            for (size_t j = 0; j < 4; ++j, fposition += step_size) {
+                const size_t index = static_cast<size_t>(fposition / scale_factor);
+                std::memcpy(&x0[j], &input[index - 2], sizeof(u32));
+                std::memcpy(&x1[j], &input[index - 1], sizeof(u32));
+                fraction_high[j] = static_cast<s16>((fposition & scale_mask) >> 9);
+                fraction_low[j] = static_cast<s16>(fposition & 0x1FF);
+            }
+
+            const __m128i v_x0 = _mm_setr_epi32(static_cast<int>(x0[0]), static_cast<int>(x0[1]),
+                                                static_cast<int>(x0[2]), static_cast<int>(x0[3]));
+            const __m128i v_x1 = _mm_setr_epi32(static_cast<int>(x1[0]), static_cast<int>(x1[1]),
+                                                static_cast<int>(x1[2]), static_cast<int>(x1[3]));
+            const __m128i delta = _mm_subs_epi16(v_x1, v_x0);
 
-        size_t index = static_cast<size_t>(fposition / scale_factor);
-        output.push_back(fn(fraction, input[index - 2], input[index - 1], input[index]));
+            // Both channels of a sample share its fraction
+            const __m128i v_fraction_high =
+                _mm_setr_epi16(fraction_high[0], fraction_high[0], fraction_high[1],
+                               fraction_high[1], fraction_high[2], fraction_high[2],
+                               fraction_high[3], fraction_high[3]);
+            const __m128i v_fraction_low =
+                _mm_setr_epi16(fraction_low[0], fraction_low[0], fraction_low[1], fraction_low[1],
+                               fraction_low[2], fraction_low[2], fraction_low[3], fraction_low[3]);
 
-        fposition += step_size;
+            const __m128i high_lo = _mm_mullo_epi16(delta, v_fraction_high);
+            const __m128i high_hi = _mm_mulhi_epi16(delta, v_fraction_high);
+            const __m128i low_lo = _mm_mullo_epi16(delta, v_fraction_low);
+            const __m128i low_hi = _mm_mulhi_epi16(delta, v_fraction_low);
+
+            const __m128i step0 = _mm_srai_epi32(
+                _mm_add_epi32(_mm_unpacklo_epi16(high_lo, high_hi),
+                              _mm_srai_epi32(_mm_unpacklo_epi16(low_lo, low_hi), 9)),
+                15);
+            const __m128i step1 = _mm_srai_epi32(
+                _mm_add_epi32(_mm_unpackhi_epi16(high_lo, high_hi),
+                              _mm_srai_epi32(_mm_unpackhi_epi16(low_lo, low_hi), 9)),
+                15);
+
+            // The result lies between x0 and x0 + delta, so saturation never kicks in here
+            const __m128i result = _mm_add_epi16(v_x0, _mm_packs_epi32(step0, step1));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(output + i), result);
+        }
+#endif // ARCHITECTURE_x86_64
+
+        InterpolateRangeScalar<LinearKernel>(input, output + i, count - i, fposition, step_size);
     }
+};
 
-    state.xn2 = input[input.size() - 2];
-    state.xn1 = input[input.size() - 1];
+/// Number of phases, i.e. distinct fractional positions, of the polyphase filter
+constexpr size_t polyphase_phase_bits = 8;
+constexpr size_t polyphase_num_phases = 1 << polyphase_phase_bits;
+
+/**
+ * Coefficients of the polyphase filter in 1.14 fixed point, for each phase. Each phase holds the
+ * four taps twice, so that both channels can be filtered at once.
+ */
+using PolyphaseTable = std::array<std::array<s16, 8>, polyphase_num_phases>;
+
+/// Builds the polyphase filter coefficients by sampling the Catmull-Rom spline at each phase
+static PolyphaseTable MakePolyphaseTable() {
+    PolyphaseTable table;
+    for (size_t phase = 0; phase < polyphase_num_phases; ++phase) {
+        const double t = static_cast<double>(phase) / polyphase_num_phases;
+        const double t2 = t * t;
+        const double t3 = t2 * t;
+        const std::array<double, 4> weights{{
+            (-t3 + 2 * t2 - t) / 2, (3 * t3 - 5 * t2 + 2) / 2, (-3 * t3 + 4 * t2 + t) / 2,
+            (t3 - t2) / 2,
+        }};
 
-    return output;
+        std::array<s16, 4> taps;
+        for (size_t tap = 0; tap < 4; ++tap)
+            taps[tap] = static_cast<s16>(std::lround(weights[tap] * (1 << 14)));
+        // Keep the DC gain at exactly one despite the rounding
+        taps[1] += static_cast<s16>((1 << 14) - (taps[0] + taps[1] + taps[2] + taps[3]));
+
+        for (size_t tap = 0; tap < 4; ++tap) {
+            table[phase][tap] = taps[tap];
+            table[phase][tap + 4] = taps[tap];
+        }
+    }
+    return table;
 }
 
-StereoBuffer16 None(State& state, const StereoBuffer16& input, float rate_multiplier) {
-    return StepOverSamples(
-        state, input, rate_multiplier,
-        [](u64 fraction, const auto& x0, const auto& x1, const auto& x2) { return x0; });
+static const PolyphaseTable& GetPolyphaseTable() {
+    static const PolyphaseTable table = MakePolyphaseTable();
+    return table;
 }
 
-StereoBuffer16 Linear(State& state, const StereoBuffer16& input, float rate_multiplier) {
+struct PolyphaseKernel {
+    static Sample Interpolate(u64 fraction, const Sample& xm1, const Sample& x0, const Sample& x1,
+                              const Sample& x2) {
+        const auto& taps = GetPolyphaseTable()[fraction >> (24 - polyphase_phase_bits)];
+        Sample result;
+        for (size_t channel = 0; channel < 2; ++channel) {
+            const s32 sum = taps[0] * xm1[channel] + taps[1] * x0[channel] +
+                            taps[2] * x1[channel] + taps[3] * x2[channel];
+            result[channel] =
+                static_cast<s16>(MathUtil::Clamp((sum + (1 << 13)) >> 14, -32768, 32767));
+        }
+        return result;
+    }
+
+    static void InterpolateRange(const Sample* input, Sample* output, size_t count,
+                                 u64 fposition, u64 step_size) {
+        size_t i = 0;
+#ifdef ARCHITECTURE_x86_64
+        const auto& table = GetPolyphaseTable();
+        const __m128i rounding = _mm_set1_epi32(1 << 13);
+        for (; i < count; ++i, fposition += step_size) {
+            const size_t index = static_cast<size_t>(fposition / scale_factor);
+            const auto& taps = table[(fposition & scale_mask) >> (24 - polyphase_phase_bits)];
+
+            // Deinterleave the four samples to L L L L R R R R
+            __m128i samples =
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(&input[index - 3]));
+            samples = _mm_shufflelo_epi16(samples, _MM_SHUFFLE(3, 1, 2, 0));
+            samples = _mm_shufflehi_epi16(samples, _MM_SHUFFLE(3, 1, 2, 0));
+            samples = _mm_shuffle_epi32(samples, _MM_SHUFFLE(3, 1, 2, 0));
+
+            // Pairwise products, then add the pairs up to one sum per channel in the low lanes
+            const __m128i products = _mm_madd_epi16(
+                samples, _mm_loadu_si128(reinterpret_cast<const __m128i*>(taps.data())));
+            const __m128i sums =
+                _mm_add_epi32(_mm_shuffle_epi32(products, _MM_SHUFFLE(3, 3, 2, 0)),
+                              _mm_shuffle_epi32(products, _MM_SHUFFLE(3, 3, 3, 1)));
+            const __m128i result = _mm_packs_epi32(
+                _mm_srai_epi32(_mm_add_epi32(sums, rounding), 14), _mm_setzero_si128());
+
+            const u32 packed = static_cast<u32>(_mm_cvtsi128_si32(result));
+            std::memcpy(&output[i], &packed, sizeof(packed));
+        }
+#endif // ARCHITECTURE_x86_64
+
+        InterpolateRangeScalar<PolyphaseKernel>(input, output + i, count - i, fposition,
+                                                step_size);
+    }
+};
+
+void None(State& state, const StereoBuffer16& input, float rate_multiplier,
+          StereoBuffer16& output) {
+    StepOverSamples<NoneKernel>(state, input, rate_multiplier, output);
+}
+
+void Linear(State& state, const StereoBuffer16& input, float rate_multiplier,
+            StereoBuffer16& output) {
     // Note on accuracy: Some values that this produces are +/- 1 from the actual firmware.
-    return StepOverSamples(state, input, rate_multiplier,
-                           [](u64 fraction, const auto& x0, const auto& x1, const auto& x2) {
-                               // This is a saturated subtraction. (Verified by black-box fuzzing.)
-                               s64 delta0 = MathUtil::Clamp<s64>(x1[0] - x0[0], -32768, 32767);
-                               s64 delta1 = MathUtil::Clamp<s64>(x1[1] - x0[1], -32768, 32767);
-
-                               return std::array<s16, 2>{
-                                   static_cast<s16>(x0[0] + fraction * delta0 / scale_factor),
-                                   static_cast<s16>(x0[1] + fraction * delta1 / scale_factor),
-                               };
-                           });
+    StepOverSamples<LinearKernel>(state, input, rate_multiplier, output);
+}
+
+void Polyphase(State& state, const StereoBuffer16& input, float rate_multiplier,
+               StereoBuffer16& output) {
+    StepOverSamples<PolyphaseKernel>(state, input, rate_multiplier, output);
 }
 
 } // namespace AudioInterp
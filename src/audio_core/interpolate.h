@@ -14,9 +14,10 @@ namespace AudioInterp {
 using StereoBuffer16 = std::vector<std::array<s16, 2>>;
 
 struct State {
-    // Two historical samples.
+    // Three historical samples.
     std::array<s16, 2> xn1 = {}; ///< x[n-1]
     std::array<s16, 2> xn2 = {}; ///< x[n-2]
+    std::array<s16, 2> xn3 = {}; ///< x[n-3]
 };
 
 /**
@@ -25,9 +26,10 @@ struct State {
  * @param rate_multiplier Stretch factor. Must be a positive non-zero value.
  *                        rate_multiplier > 1.0 performs decimation and rate_multipler < 1.0
  *                        performs upsampling.
- * @return The resampled audio buffer.
+ * @param output Receives the resampled audio. Its storage is reused if it is large enough.
  */
-StereoBuffer16 None(State& state, const StereoBuffer16& input, float rate_multiplier);
+void None(State& state, const StereoBuffer16& input, float rate_multiplier,
+          StereoBuffer16& output);
 
 /**
  * Linear interpolation. This is equivalent to a first-order hold. There is a two-sample predelay.
@@ -35,8 +37,22 @@ StereoBuffer16 None(State& state, const StereoBuffer16& input, float rate_multip
  * @param rate_multiplier Stretch factor. Must be a positive non-zero value.
  *                        rate_multiplier > 1.0 performs decimation and rate_multipler < 1.0
  *                        performs upsampling.
- * @return The resampled audio buffer.
+ * @param output Receives the resampled audio. Its storage is reused if it is large enough.
  */
-StereoBuffer16 Linear(State& state, const StereoBuffer16& input, float rate_multiplier);
+void Linear(State& state, const StereoBuffer16& input, float rate_multiplier,
+            StereoBuffer16& output);
+
+/**
+ * Polyphase interpolation, using a four-tap filter whose coefficients sample a Catmull-Rom spline
+ * at 256 phases. This is smoother than linear interpolation. There is a two-sample predelay, like
+ * the other modes, so buffer positions don't depend on the interpolation mode.
+ * @param input Input buffer.
+ * @param rate_multiplier Stretch factor. Must be a positive non-zero value.
+ *                        rate_multiplier > 1.0 performs decimation and rate_multipler < 1.0
+ *                        performs upsampling.
+ * @param output Receives the resampled audio. Its storage is reused if it is large enough.
+ */
+void Polyphase(State& state, const StereoBuffer16& input, float rate_multiplier,
+               StereoBuffer16& output);
 
 } // namespace AudioInterp
@@ -0,0 +1,36 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <random>
+#include <string>
+#include <vector>
+#include <catch.hpp>
+#include "audio_core/codec.h"
+#include "benchmarks/benchmark.h"
+
+namespace Codec {
+
+TEST_CASE("Codec - PCM decoding", "[audio_core]") {
+    constexpr size_t samples_per_frame = 160;
+
+    std::mt19937 rng(1234);
+    std::uniform_int_distribution<int> byte(0, 255);
+    std::vector<u8> data(4 * samples_per_frame);
+    for (auto& value : data)
+        value = static_cast<u8>(byte(rng));
+
+    StereoBuffer16 buffer;
+    for (unsigned num_channels = 1; num_channels <= 2; num_channels++) {
+        const double pcm8_ns = Benchmark::Measure(
+            10000, [&] { DecodePCM8(num_channels, data.data(), samples_per_frame, buffer); });
+        const double pcm16_ns = Benchmark::Measure(
+            10000, [&] { DecodePCM16(num_channels, data.data(), samples_per_frame, buffer); });
+
+        const std::string channels = num_channels == 1 ? "mono" : "stereo";
+        Benchmark::Report("Codec - PCM8 " + channels, pcm8_ns, "ns/frame");
+        Benchmark::Report("Codec - PCM16 " + channels, pcm16_ns, "ns/frame");
+    }
+}
+
+} // namespace Codec
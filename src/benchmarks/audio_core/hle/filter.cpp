@@ -0,0 +1,36 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <random>
+#include <catch.hpp>
+#include "audio_core/hle/common.h"
+#include "audio_core/hle/filter.h"
+#include "benchmarks/benchmark.h"
+
+namespace DSP {
+namespace HLE {
+
+TEST_CASE("SourceFilters - Biquad filter", "[audio_core]") {
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int> value(-32768, 32767);
+    StereoFrame16 frame;
+    for (auto& sample : frame)
+        sample = {static_cast<s16>(value(rng)), static_cast<s16>(value(rng))};
+
+    SourceConfiguration::Configuration::BiquadFilter config;
+    config.a2 = -0x2b3c;
+    config.a1 = 0x6a7e;
+    config.b2 = 0x0160;
+    config.b1 = 0x02c0;
+    config.b0 = 0x0160;
+
+    SourceFilters filters;
+    filters.Enable(false, true);
+    filters.Configure(config);
+    const double ns = Benchmark::Measure(20000, [&] { filters.ProcessFrame(frame); });
+    Benchmark::Report("SourceFilters - Biquad filter", ns, "ns/frame");
+}
+
+} // namespace HLE
+} // namespace DSP
@@ -0,0 +1,57 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <cstring>
+#include <memory>
+#include <random>
+#include <catch.hpp>
+#include "audio_core/hle/common.h"
+#include "audio_core/hle/dsp.h"
+#include "audio_core/hle/mixers.h"
+#include "benchmarks/benchmark.h"
+
+namespace DSP {
+namespace HLE {
+
+using OutputFormat = DspConfiguration::OutputFormat;
+
+TEST_CASE("Mixers - Final mix", "[audio_core]") {
+    // Large enough to saturate when mixed
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<s32> value(-60000, 60000);
+    std::array<QuadFrame32, 3> input;
+    for (auto& frame : input)
+        for (auto& sample : frame)
+            for (auto& channel : sample)
+                channel = value(rng);
+
+    // The shared memory structures are too large for the stack
+    auto config = std::make_unique<DspConfiguration>();
+    auto aux_samples = std::make_unique<IntermediateMixSamples>();
+    std::memset(aux_samples.get(), 0, sizeof(IntermediateMixSamples));
+
+    Mixers mixers;
+    for (OutputFormat format : {OutputFormat::Mono, OutputFormat::Stereo}) {
+        std::memset(config.get(), 0, sizeof(DspConfiguration));
+        config->volume_0_dirty.Assign(1);
+        config->volume_1_dirty.Assign(1);
+        config->volume_2_dirty.Assign(1);
+        config->output_format_dirty.Assign(1);
+        config->volume[0] = 1.0f;
+        config->volume[1] = 0.5f;
+        config->volume[2] = 0.25f;
+        config->output_format = format;
+
+        // Includes the per-frame configuration check in Tick
+        const double ns = Benchmark::Measure(5000, [&] {
+            mixers.Tick(*config, *aux_samples, *aux_samples, input);
+        });
+        Benchmark::Report(format == OutputFormat::Mono ? "Mixers - Final mix, mono"
+                                                       : "Mixers - Final mix, stereo",
+                          ns, "ns/frame");
+    }
+}
+
+} // namespace HLE
+} // namespace DSP
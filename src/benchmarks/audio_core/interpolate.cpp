@@ -0,0 +1,35 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <random>
+#include <string>
+#include <catch.hpp>
+#include "audio_core/interpolate.h"
+#include "benchmarks/benchmark.h"
+
+namespace AudioInterp {
+
+TEST_CASE("AudioInterp - Resampling", "[audio_core]") {
+    // Roughly one frame's worth of output for each rate
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int> value(-32768, 32767);
+    StereoBuffer16 input(160);
+    for (auto& sample : input)
+        sample = {static_cast<s16>(value(rng)), static_cast<s16>(value(rng))};
+
+    StereoBuffer16 output;
+    for (float rate_multiplier : {0.5f, 1.0f, 1.5f}) {
+        State state;
+        const double linear_ns =
+            Benchmark::Measure(5000, [&] { Linear(state, input, rate_multiplier, output); });
+        const double polyphase_ns =
+            Benchmark::Measure(5000, [&] { Polyphase(state, input, rate_multiplier, output); });
+
+        const std::string rate = " at rate " + std::to_string(rate_multiplier).substr(0, 3);
+        Benchmark::Report("AudioInterp - Linear" + rate, linear_ns, "ns/frame");
+        Benchmark::Report("AudioInterp - Polyphase" + rate, polyphase_ns, "ns/frame");
+    }
+}
+
+} // namespace AudioInterp
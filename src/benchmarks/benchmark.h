@@ -0,0 +1,40 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <limits>
+#include <string>
+
+namespace Benchmark {
+
+/// Number of times each measurement is repeated. Only the fastest repetition is reported, which
+/// filters out most of the noise caused by other processes.
+constexpr int NUM_RUNS = 5;
+
+/**
+ * Measures how long a call to a function takes.
+ * @param iterations Number of calls timed together in each repetition
+ * @param func Function to measure
+ * @returns Average duration of a call in nanoseconds, taken from the fastest repetition
+ */
+template <typename Func>
+double Measure(int iterations, Func&& func) {
+    double best = std::numeric_limits<double>::infinity();
+    for (int run = 0; run < NUM_RUNS; ++run) {
+        const auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; ++i)
+            func();
+        const auto end = std::chrono::steady_clock::now();
+        best = std::min(best, std::chrono::duration<double, std::nano>(end - start).count());
+    }
+    return best / iterations;
+}
+
+/// Prints a single result, e.g. Report("Morton - RGBA8 untile", 812.5, "Mpx/s")
+void Report(const std::string& name, double value, const char* unit);
+
+} // namespace Benchmark
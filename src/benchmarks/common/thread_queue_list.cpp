@@ -0,0 +1,41 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <array>
+#include <random>
+#include <catch.hpp>
+#include "benchmarks/benchmark.h"
+#include "common/thread_queue_list.h"
+
+namespace {
+
+struct Element {
+    Common::ThreadQueueListNode<Element> node;
+};
+
+using Queue = Common::ThreadQueueList<Element, 64, &Element::node>;
+
+} // Anonymous namespace
+
+TEST_CASE("ThreadQueueList - Reschedule", "[common]") {
+    Queue queue;
+    std::array<Element, 64> elements;
+    std::mt19937 random(1234);
+    for (auto& element : elements)
+        queue.push_back(random() % 64, &element);
+
+    // Mimic a reschedule: pick the best thread, run it and queue it again, while other threads
+    // get woken up or put to sleep
+    const double ns = Benchmark::Measure(1000000, [&] {
+        Element* thread = queue.pop_first();
+        Element* other = &elements[random() % elements.size()];
+        const Queue::Priority priority = queue.contains(other);
+        if (priority != static_cast<Queue::Priority>(-1))
+            queue.remove(priority, other);
+        queue.push_back(random() % 64, thread);
+        if (other != thread && !other->node.queued)
+            queue.push_back(random() % 64, other);
+    });
+    Benchmark::Report("ThreadQueueList - Reschedule", ns, "ns");
+}
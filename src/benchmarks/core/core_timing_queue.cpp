@@ -0,0 +1,88 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <list>
+#include <random>
+#include <string>
+#include <catch.hpp>
+#include "benchmarks/benchmark.h"
+#include "core/core_timing_queue.h"
+
+namespace CoreTiming {
+
+/// Sorted linked list, scheduling events the way CoreTiming did before EventQueue was introduced
+class ListEventQueue {
+public:
+    const EventQueue::Event& Top() const {
+        return events.front();
+    }
+
+    void Push(s64 time, int type, u64 userdata) {
+        auto it = events.begin();
+        while (it != events.end() && !(time < it->time))
+            ++it;
+        events.insert(it, {time, userdata, type});
+    }
+
+    void Pop() {
+        events.pop_front();
+    }
+
+    bool Remove(int type, u64 userdata, s64& last_time) {
+        bool removed = false;
+        for (auto it = events.begin(); it != events.end();) {
+            if (it->type == type && it->userdata == userdata) {
+                last_time = it->time;
+                removed = true;
+                it = events.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        return removed;
+    }
+
+private:
+    std::list<EventQueue::Event> events;
+};
+
+/**
+ * Simulates a scheduler with a fixed number of pending periodic timers: each step fires the next
+ * event, reschedules it and cancels/reschedules another timer, like thread wakeups do.
+ * @returns Average duration of a step in nanoseconds
+ */
+template <typename Queue>
+static double MeasureQueue(int num_timers) {
+    constexpr int NUM_STEPS = 100000;
+
+    std::mt19937 rng(1);
+    std::uniform_int_distribution<s64> period(1000, 100000);
+    std::uniform_int_distribution<int> timer(0, num_timers - 1);
+
+    Queue queue;
+    for (int i = 0; i < num_timers; ++i)
+        queue.Push(period(rng), i, i);
+
+    return Benchmark::Measure(NUM_STEPS, [&] {
+        const EventQueue::Event event = queue.Top();
+        queue.Pop();
+        queue.Push(event.time + period(rng), event.type, event.userdata);
+
+        const int cancelled = timer(rng);
+        s64 time;
+        if (queue.Remove(cancelled, cancelled, time))
+            queue.Push(event.time + period(rng), cancelled, cancelled);
+    });
+}
+
+TEST_CASE("EventQueue - Timer workload against sorted list", "[core]") {
+    for (int num_timers : {4, 16, 64, 256, 1024}) {
+        const std::string name = "EventQueue - " + std::to_string(num_timers) + " pending events";
+        Benchmark::Report(name + ", sorted list", MeasureQueue<ListEventQueue>(num_timers),
+                          "ns/step");
+        Benchmark::Report(name + ", heap", MeasureQueue<EventQueue>(num_timers), "ns/step");
+    }
+}
+
+} // namespace CoreTiming
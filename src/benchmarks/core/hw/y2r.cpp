@@ -0,0 +1,81 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <cstring>
+#include <string>
+#include <vector>
+#include <catch.hpp>
+#include "benchmarks/benchmark.h"
+#include "core/hle/service/y2r_u.h"
+#include "core/hw/y2r.h"
+#include "core/memory.h"
+#include "core/memory_setup.h"
+#include "core/settings.h"
+
+namespace HW {
+namespace Y2R {
+
+using namespace Service::Y2R;
+
+/// Sets up a YUV420 conversion reading from the start of VRAM and writing after its input
+static ConversionConfiguration MakeConversion(OutputFormat output_format, u16 width, u16 lines) {
+    ConversionConfiguration cvt;
+    std::memset(&cvt, 0, sizeof(cvt));
+    cvt.input_format = InputFormat::YUV420_Indiv8;
+    cvt.output_format = output_format;
+    cvt.rotation = Rotation::None;
+    cvt.block_alignment = BlockAlignment::Linear;
+    cvt.input_line_width = width;
+    cvt.input_lines = lines;
+    cvt.alpha = 0xFF;
+    cvt.coefficients = {{0x100, 0x166, 0xB6, 0x58, 0x1C5, -0x166F, 0x10EE, -0x1C5B}};
+
+    const u32 base = Memory::VRAM_VADDR;
+    cvt.src_Y = {base, static_cast<u32>(width * lines), width, 0};
+    cvt.src_U = {base + 0x100000, static_cast<u32>(width / 2 * lines / 2),
+                 static_cast<u16>(width / 2), 0};
+    cvt.src_V = {base + 0x180000, static_cast<u32>(width / 2 * lines / 2),
+                 static_cast<u16>(width / 2), 0};
+
+    const u16 bytes_per_pixel = output_format == OutputFormat::RGBA8 ? 4 : 2;
+    const u16 output_line = static_cast<u16>(width * bytes_per_pixel);
+    cvt.dst = {base + 0x200000, static_cast<u32>(output_line * lines), output_line, 0};
+    return cvt;
+}
+
+TEST_CASE("Y2R - Conversion", "[core]") {
+    std::vector<u8> memory(Memory::VRAM_SIZE, 0x80);
+    Memory::InitMemoryMap();
+    Memory::MapMemoryRegion(Memory::VRAM_VADDR, Memory::VRAM_SIZE, memory.data());
+
+    struct Size {
+        u16 width;
+        u16 lines;
+    };
+    for (const Size size : {Size{400, 240}, Size{1024, 512}}) {
+        for (OutputFormat output_format : {OutputFormat::RGBA8, OutputFormat::RGB565}) {
+            const ConversionConfiguration cvt =
+                MakeConversion(output_format, size.width, size.lines);
+            const std::string name = "Y2R - " + std::to_string(size.width) + "x" +
+                                     std::to_string(size.lines) + " to " +
+                                     (output_format == OutputFormat::RGBA8 ? "RGBA8" : "RGB565");
+
+            // 0 uses one thread per CPU core
+            for (int num_threads : {1, 0}) {
+                Settings::values.y2r_threads = num_threads;
+                const double ns = Benchmark::Measure(20, [&] {
+                    ConversionConfiguration copy = cvt;
+                    PerformConversion(copy);
+                });
+                Benchmark::Report(name + (num_threads == 1 ? ", 1 thread" : ", all cores"),
+                                  ns / 1000, "us/frame");
+            }
+        }
+    }
+
+    Memory::UnmapRegion(Memory::VRAM_VADDR, Memory::VRAM_SIZE);
+}
+
+} // namespace Y2R
+} // namespace HW
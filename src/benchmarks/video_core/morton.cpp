@@ -0,0 +1,54 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <string>
+#include <vector>
+#include <catch.hpp>
+#include "benchmarks/benchmark.h"
+#include "video_core/morton.h"
+
+namespace VideoCore {
+
+TEST_CASE("Morton - Throughput per format", "[video_core]") {
+    constexpr u32 width = 512;
+    constexpr u32 height = 512;
+
+    enum class Format { Plain, D24S8, D24 };
+    struct Case {
+        const char* name;
+        Format format;
+        u32 bytes_per_pixel;
+    };
+    const Case cases[] = {
+        {"I8/A8", Format::Plain, 1}, {"RGB565/RGBA4/D16", Format::Plain, 2},
+        {"RGB8", Format::Plain, 3},  {"RGBA8", Format::Plain, 4},
+        {"D24", Format::D24, 3},     {"D24S8", Format::D24S8, 4},
+    };
+
+    for (const Case& test_case : cases) {
+        const u32 linear_bytes_per_pixel =
+            test_case.format == Format::D24 ? 4 : test_case.bytes_per_pixel;
+        std::vector<u8> tiled(width * height * test_case.bytes_per_pixel, 0x55);
+        std::vector<u8> linear(width * height * linear_bytes_per_pixel, 0xAA);
+        const ptrdiff_t stride = width * linear_bytes_per_pixel;
+
+        for (bool to_linear : {true, false}) {
+            const double ns = Benchmark::Measure(20, [&] {
+                if (test_case.format == Format::D24S8) {
+                    MortonCopyD24S8(width, height, tiled.data(), linear.data(), stride, to_linear);
+                } else if (test_case.format == Format::D24) {
+                    MortonCopyD24(width, height, tiled.data(), linear.data(), stride, to_linear);
+                } else {
+                    MortonCopy(test_case.bytes_per_pixel, width, height, tiled.data(),
+                               linear.data(), stride, to_linear);
+                }
+            });
+            Benchmark::Report(std::string("Morton - ") + test_case.name +
+                                  (to_linear ? " untile" : " tile"),
+                              double(width) * height / ns * 1e3, "Mpx/s");
+        }
+    }
+}
+
+} // namespace VideoCore
@@ -0,0 +1,161 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <cstring>
+#include <random>
+#include <vector>
+#include <catch.hpp>
+#include "benchmarks/benchmark.h"
+#include "core/memory.h"
+#include "core/memory_setup.h"
+#include "video_core/pica.h"
+#include "video_core/pica_state.h"
+#include "video_core/shader/shader.h"
+#include "video_core/swrasterizer.h"
+#include "video_core/video_core.h"
+
+namespace VideoCore {
+
+using Pica::float24;
+using Pica::Regs;
+using Pica::Shader::OutputVertex;
+using Source = Regs::TevStageConfig::Source;
+using Operation = Regs::TevStageConfig::Operation;
+
+static constexpr PAddr COLOR_BUFFER_ADDR = Memory::VRAM_PADDR;
+static constexpr PAddr DEPTH_BUFFER_ADDR = Memory::VRAM_PADDR + 0x100000;
+
+/// Sets up a 256x256 RGBA8 render target with a D24S8 depth buffer and a depth test
+static void SetupRegisters() {
+    Pica::g_state.Reset();
+    auto& regs = Pica::g_state.regs;
+
+    regs.viewport_size_x.Assign(0x460000);      // 128.0f
+    regs.viewport_size_y.Assign(0x460000);      // 128.0f
+    regs.viewport_depth_range.Assign(0xBF0000); // -1.0f
+    regs.depthmap_enable.Assign(Regs::DepthBuffering::ZBuffering);
+
+    regs.framebuffer.color_buffer_address = COLOR_BUFFER_ADDR / 8;
+    regs.framebuffer.depth_buffer_address = DEPTH_BUFFER_ADDR / 8;
+    regs.framebuffer.color_format.Assign(Regs::ColorFormat::RGBA8);
+    regs.framebuffer.depth_format = Regs::DepthFormat::D24S8;
+    regs.framebuffer.width.Assign(256);
+    regs.framebuffer.height.Assign(256);
+    regs.framebuffer.allow_color_write.Assign(0xF);
+    regs.framebuffer.allow_depth_stencil_write.Assign(0x3);
+
+    auto& output_merger = regs.output_merger;
+    output_merger.depth_test_enable.Assign(1);
+    output_merger.depth_test_func.Assign(Regs::CompareFunc::GreaterThanOrEqual);
+    output_merger.depth_write_enable.Assign(1);
+    output_merger.red_enable.Assign(1);
+    output_merger.green_enable.Assign(1);
+    output_merger.blue_enable.Assign(1);
+    output_merger.alpha_enable.Assign(1);
+}
+
+/// Makes the first `num_stages` combiner stages modulate the previous result with a constant
+static void SetupCombiners(unsigned num_stages) {
+    auto& regs = Pica::g_state.regs;
+    Regs::TevStageConfig* stages[] = {&regs.tev_stage0, &regs.tev_stage1, &regs.tev_stage2,
+                                      &regs.tev_stage3, &regs.tev_stage4, &regs.tev_stage5};
+    for (unsigned i = 0; i < 6; ++i) {
+        auto& stage = *stages[i];
+        stage.sources_raw = 0;
+        stage.modifiers_raw = 0;
+        stage.ops_raw = 0;
+        stage.scales_raw = 0;
+        stage.const_color = 0xFFE0C080;
+        if (i >= num_stages) {
+            stage.color_source1.Assign(Source::Previous);
+            stage.alpha_source1.Assign(Source::Previous);
+            continue;
+        }
+        stage.color_source1.Assign(i == 0 ? Source::PrimaryColor : Source::Previous);
+        stage.color_source2.Assign(Source::Constant);
+        stage.color_op.Assign(Operation::Modulate);
+        stage.alpha_source1.Assign(Source::PrimaryColor);
+    }
+}
+
+static void SetupBlending() {
+    auto& output_merger = Pica::g_state.regs.output_merger;
+    output_merger.alphablend_enable.Assign(1);
+    output_merger.alpha_blending.factor_source_rgb.Assign(Regs::BlendFactor::SourceAlpha);
+    output_merger.alpha_blending.factor_dest_rgb.Assign(Regs::BlendFactor::OneMinusSourceAlpha);
+    output_merger.alpha_blending.factor_source_a.Assign(Regs::BlendFactor::One);
+    output_merger.alpha_blending.factor_dest_a.Assign(Regs::BlendFactor::Zero);
+}
+
+static void SetupStencil() {
+    auto& stencil_test = Pica::g_state.regs.output_merger.stencil_test;
+    stencil_test.enable.Assign(1);
+    stencil_test.func.Assign(Regs::CompareFunc::Always);
+    stencil_test.write_mask.Assign(0xFF);
+    stencil_test.action_depth_pass.Assign(Regs::StencilAction::IncrementWrap);
+}
+
+static std::vector<OutputVertex> GenerateVertices(size_t count) {
+    std::mt19937 rng(1234);
+    std::uniform_real_distribution<float> position(-1.25f, 1.25f);
+    std::uniform_real_distribution<float> depth(-1.0f, 0.0f);
+    std::uniform_real_distribution<float> color(0.0f, 1.0f);
+
+    std::vector<OutputVertex> vertices(count);
+    for (auto& vertex : vertices) {
+        std::memset(&vertex, 0, sizeof(vertex));
+        vertex.pos = Math::MakeVec(float24::FromFloat32(position(rng)),
+                                   float24::FromFloat32(position(rng)),
+                                   float24::FromFloat32(depth(rng)), float24::FromFloat32(1.0f));
+        vertex.color = Math::MakeVec(
+            float24::FromFloat32(color(rng)), float24::FromFloat32(color(rng)),
+            float24::FromFloat32(color(rng)), float24::FromFloat32(color(rng)));
+    }
+    return vertices;
+}
+
+TEST_CASE("SWRasterizer - Frame time per pixel pipeline configuration", "[video_core]") {
+    std::vector<u8> vram(Memory::VRAM_SIZE);
+    Memory::InitMemoryMap();
+    Memory::MapMemoryRegion(Memory::VRAM_VADDR, Memory::VRAM_SIZE, vram.data());
+    g_sw_rasterizer_threads = 1;
+
+    const auto vertices = GenerateVertices(3 * 200);
+
+    struct Case {
+        const char* name;
+        unsigned num_stages;
+        bool blending;
+        bool stencil;
+    };
+    const Case cases[] = {
+        {"1 combiner stage", 1, false, false},
+        {"3 combiner stages, blending", 3, true, false},
+        {"6 combiner stages, blending", 6, true, false},
+        {"3 combiner stages, blending, stencil", 3, true, true},
+    };
+
+    for (const Case& test_case : cases) {
+        SetupRegisters();
+        SetupCombiners(test_case.num_stages);
+        if (test_case.blending)
+            SetupBlending();
+        if (test_case.stencil)
+            SetupStencil();
+
+        const double ns = Benchmark::Measure(1, [&] {
+            std::fill(vram.begin(), vram.end(), 0);
+            SWRasterizer rasterizer;
+            for (size_t i = 0; i + 2 < vertices.size(); i += 3)
+                rasterizer.AddTriangle(vertices[i], vertices[i + 1], vertices[i + 2]);
+            rasterizer.DrawTriangles();
+        });
+        Benchmark::Report(std::string("SWRasterizer - 200 triangles, ") + test_case.name,
+                          ns / 1e6, "ms");
+    }
+
+    Memory::UnmapRegion(Memory::VRAM_VADDR, Memory::VRAM_SIZE);
+}
+
+} // namespace VideoCore
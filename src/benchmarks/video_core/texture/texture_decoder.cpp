@@ -0,0 +1,71 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <random>
+#include <string>
+#include <vector>
+#include <catch.hpp>
+#include "benchmarks/benchmark.h"
+#include "common/vector_math.h"
+#include "video_core/debug_utils/debug_utils.h"
+#include "video_core/pica.h"
+#include "video_core/texture/texture_decoder.h"
+
+namespace Pica {
+namespace Texture {
+
+using TextureFormat = Regs::TextureFormat;
+
+TEST_CASE("TextureDecoder - Throughput per format", "[video_core]") {
+    constexpr int width = 256;
+    constexpr int height = 256;
+
+    struct Case {
+        const char* name;
+        TextureFormat format;
+    };
+    const Case cases[] = {
+        {"RGBA8", TextureFormat::RGBA8},   {"RGB8", TextureFormat::RGB8},
+        {"RGB5A1", TextureFormat::RGB5A1}, {"RGB565", TextureFormat::RGB565},
+        {"RGBA4", TextureFormat::RGBA4},   {"IA8", TextureFormat::IA8},
+        {"RG8", TextureFormat::RG8},       {"I8", TextureFormat::I8},
+        {"A8", TextureFormat::A8},         {"IA4", TextureFormat::IA4},
+        {"I4", TextureFormat::I4},         {"A4", TextureFormat::A4},
+        {"ETC1", TextureFormat::ETC1},     {"ETC1A4", TextureFormat::ETC1A4},
+    };
+
+    std::mt19937 rng(0);
+    std::uniform_int_distribution<int> byte(0, 255);
+
+    for (const Case& test_case : cases) {
+        DebugUtils::TextureInfo info;
+        info.physical_address = 0;
+        info.width = width;
+        info.height = height;
+        info.format = test_case.format;
+        info.stride = Regs::NibblesPerPixel(test_case.format) * width / 2;
+
+        std::vector<u8> data(GetTileSize(info.format) * (width / 8) * (height / 8));
+        for (auto& value : data)
+            value = static_cast<u8>(byte(rng));
+        std::vector<Math::Vec4<u8>> decoded(width * height);
+
+        const double per_texel_ns = Benchmark::Measure(5, [&] {
+            for (int y = 0; y < height; ++y) {
+                for (int x = 0; x < width; ++x)
+                    decoded[y * width + x] = DebugUtils::LookupTexture(data.data(), x, y, info);
+            }
+        });
+        const double bulk_ns =
+            Benchmark::Measure(5, [&] { DecodeTexture(info, data.data(), decoded.data(), width); });
+
+        const std::string name = std::string("TextureDecoder - ") + test_case.name;
+        const double texels = double(width) * height;
+        Benchmark::Report(name + ", LookupTexture", texels / per_texel_ns * 1e3, "Mtexel/s");
+        Benchmark::Report(name + ", DecodeTexture", texels / bulk_ns * 1e3, "Mtexel/s");
+    }
+}
+
+} // namespace Texture
+} // namespace Pica
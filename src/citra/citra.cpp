@@ -23,6 +23,8 @@
 
 #include "citra/config.h"
 #include "citra/emu_window/emu_window_sdl2.h"
+#include "common/common_paths.h"
+#include "common/file_util.h"
 #include "common/logging/backend.h"
 #include "common/logging/filter.h"
 #include "common/logging/log.h"
@@ -110,6 +112,9 @@ int main(int argc, char** argv) {
 
     Log::Filter log_filter(Log::Level::Debug);
     Log::SetFilter(&log_filter);
+    Log::AddSink(std::make_unique<Log::ColorConsoleSink>());
+    FileUtil::CreateFullPath(FileUtil::GetUserPath(D_LOGS_IDX));
+    Log::AddSink(std::make_unique<Log::FileSink>(FileUtil::GetUserPath(D_LOGS_IDX) + LOG_FILE));
 
     MicroProfileOnThreadCreate("EmuThread");
     SCOPE_EXIT({ MicroProfileShutdown(); });
@@ -147,5 +152,17 @@ int main(int argc, char** argv) {
         system.RunLoop();
     }
 
+    using Stage = Core::PerfStats::Stage;
+    const auto frame_times = system.perf_stats.GetAverageFrameTimes();
+    const auto emulation_99th = system.perf_stats.GetPercentile(Stage::Emulation, 0.99);
+    LOG_INFO(Frontend,
+             "Average frame times over the last %u frames: emulation %lld us, present %lld us, "
+             "wait %lld us (99th percentile of emulation: %lld us)",
+             static_cast<unsigned>(system.perf_stats.GetNumFrames()),
+             static_cast<long long>(frame_times[static_cast<size_t>(Stage::Emulation)].count()),
+             static_cast<long long>(frame_times[static_cast<size_t>(Stage::Present)].count()),
+             static_cast<long long>(frame_times[static_cast<size_t>(Stage::Wait)].count()),
+             static_cast<long long>(emulation_99th.count()));
+
     return 0;
 }
@@ -59,15 +59,24 @@ void Config::ReadValues() {
 
     // Core
     Settings::values.use_cpu_jit = sdl2_config->GetBoolean("Core", "use_cpu_jit", true);
+    Settings::values.y2r_threads = sdl2_config->GetInteger("Core", "y2r_threads", 1);
 
     // Renderer
     Settings::values.use_hw_renderer = sdl2_config->GetBoolean("Renderer", "use_hw_renderer", true);
     Settings::values.use_shader_jit = sdl2_config->GetBoolean("Renderer", "use_shader_jit", true);
+    Settings::values.sw_rasterizer_threads =
+        sdl2_config->GetInteger("Renderer", "sw_rasterizer_threads", 1);
+    Settings::values.vertex_shader_threads =
+        sdl2_config->GetInteger("Renderer", "vertex_shader_threads", 1);
+    Settings::values.sw_texture_cache_size =
+        sdl2_config->GetInteger("Renderer", "sw_texture_cache_size", 32);
     Settings::values.resolution_factor =
         (float)sdl2_config->GetReal("Renderer", "resolution_factor", 1.0);
     Settings::values.use_vsync = sdl2_config->GetBoolean("Renderer", "use_vsync", false);
     Settings::values.toggle_framelimit =
         sdl2_config->GetBoolean("Renderer", "toggle_framelimit", true);
+    Settings::values.frame_limit =
+        static_cast<u16>(sdl2_config->GetInteger("Renderer", "frame_limit", 100));
 
     Settings::values.bg_red = (float)sdl2_config->GetReal("Renderer", "bg_red", 1.0);
     Settings::values.bg_green = (float)sdl2_config->GetReal("Renderer", "bg_green", 1.0);
@@ -82,6 +91,8 @@ void Config::ReadValues() {
     Settings::values.sink_id = sdl2_config->Get("Audio", "output_engine", "auto");
     Settings::values.enable_audio_stretching =
         sdl2_config->GetBoolean("Audio", "enable_audio_stretching", true);
+    Settings::values.enable_audio_thread =
+        sdl2_config->GetBoolean("Audio", "enable_audio_thread", false);
 
     // Data Storage
     Settings::values.use_virtual_sd =
@@ -42,6 +42,11 @@ pad_circle_modifier_scale =
 # 0: Interpreter (slow), 1 (default): JIT (fast)
 use_cpu_jit =
 
+# Number of threads used to convert the strips of a Y2R (YUV to RGB) conversion. Output is
+# identical regardless of the thread count.
+# 0: One per CPU core, 1 (default): Single-threaded, Otherwise the number of threads
+y2r_threads =
+
 [Renderer]
 # Whether to use software or hardware rendering.
 # 0: Software, 1 (default): Hardware
@@ -51,6 +56,21 @@ use_hw_renderer =
 # 0: Interpreter (slow), 1 (default): JIT (fast)
 use_shader_jit =
 
+# Number of threads the software renderer uses to rasterize triangles. Only used if
+# use_hw_renderer is 0. Output is identical regardless of the thread count.
+# 0: One per CPU core, 1 (default): Single-threaded, Otherwise the number of threads
+sw_rasterizer_threads =
+
+# Number of threads used to shade the vertices of large draws. Output is identical regardless of
+# the thread count.
+# 0: One per CPU core, 1 (default): Single-threaded, Otherwise the number of threads
+vertex_shader_threads =
+
+# Memory in MiB the software renderer may use to keep decoded textures around. Only used if
+# use_hw_renderer is 0.
+# 0: Decode textures again for every draw, 32 (default), Otherwise the budget in MiB
+sw_texture_cache_size =
+
 # Resolution scale factor
 # 0: Auto (scales resolution to window size), 1: Native 3DS screen resolution, Otherwise a scale
 # factor for the 3DS resolution
@@ -75,6 +95,10 @@ layout_option =
 # 0: Off , 1  (default): On
 toggle_framelimit =
 
+# Target emulation speed when the frame limiter is on, in percent of native speed.
+# 0: Unlimited, 50: Half speed, 100 (default): Native speed, 200: Double speed
+frame_limit =
+
 # Swaps the prominent screen with the other screen.
 # For example, if Single Screen is chosen, setting this to 1 will display the bottom screen instead of the top screen.
 # 0 (default): Top Screen is prominent, 1: Bottom Screen is prominent
@@ -91,6 +115,12 @@ output_engine =
 # 0: No, 1 (default): Yes
 enable_audio_stretching =
 
+# Whether or not to mix and output audio on a dedicated thread.
+# This takes audio processing off the emulation thread, at the cost of the emulated application
+# seeing the DSP status one audio frame late.
+# 0 (default): No, 1: Yes
+enable_audio_thread =
+
 [Data Storage]
 # Whether to create a virtual SD card.
 # 1 (default): Yes, 0: No
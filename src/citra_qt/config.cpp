@@ -39,14 +39,20 @@ void Config::ReadValues() {
 
     qt_config->beginGroup("Core");
     Settings::values.use_cpu_jit = qt_config->value("use_cpu_jit", true).toBool();
+    Settings::values.y2r_threads = qt_config->value("y2r_threads", 1).toInt();
     qt_config->endGroup();
 
     qt_config->beginGroup("Renderer");
     Settings::values.use_hw_renderer = qt_config->value("use_hw_renderer", true).toBool();
     Settings::values.use_shader_jit = qt_config->value("use_shader_jit", true).toBool();
+    Settings::values.sw_rasterizer_threads = qt_config->value("sw_rasterizer_threads", 1).toInt();
+    Settings::values.vertex_shader_threads = qt_config->value("vertex_shader_threads", 1).toInt();
+    Settings::values.sw_texture_cache_size =
+        qt_config->value("sw_texture_cache_size", 32).toInt();
     Settings::values.resolution_factor = qt_config->value("resolution_factor", 1.0).toFloat();
     Settings::values.use_vsync = qt_config->value("use_vsync", false).toBool();
     Settings::values.toggle_framelimit = qt_config->value("toggle_framelimit", true).toBool();
+    Settings::values.frame_limit = qt_config->value("frame_limit", 100).toInt();
 
     Settings::values.bg_red = qt_config->value("bg_red", 1.0).toFloat();
     Settings::values.bg_green = qt_config->value("bg_green", 1.0).toFloat();
@@ -63,6 +69,7 @@ void Config::ReadValues() {
     Settings::values.sink_id = qt_config->value("output_engine", "auto").toString().toStdString();
     Settings::values.enable_audio_stretching =
         qt_config->value("enable_audio_stretching", true).toBool();
+    Settings::values.enable_audio_thread = qt_config->value("enable_audio_thread", false).toBool();
     qt_config->endGroup();
 
     qt_config->beginGroup("Data Storage");
@@ -146,14 +153,19 @@ void Config::SaveValues() {
 
     qt_config->beginGroup("Core");
     qt_config->setValue("use_cpu_jit", Settings::values.use_cpu_jit);
+    qt_config->setValue("y2r_threads", Settings::values.y2r_threads);
     qt_config->endGroup();
 
     qt_config->beginGroup("Renderer");
     qt_config->setValue("use_hw_renderer", Settings::values.use_hw_renderer);
     qt_config->setValue("use_shader_jit", Settings::values.use_shader_jit);
+    qt_config->setValue("sw_rasterizer_threads", Settings::values.sw_rasterizer_threads);
+    qt_config->setValue("vertex_shader_threads", Settings::values.vertex_shader_threads);
+    qt_config->setValue("sw_texture_cache_size", Settings::values.sw_texture_cache_size);
     qt_config->setValue("resolution_factor", (double)Settings::values.resolution_factor);
     qt_config->setValue("use_vsync", Settings::values.use_vsync);
     qt_config->setValue("toggle_framelimit", Settings::values.toggle_framelimit);
+    qt_config->setValue("frame_limit", Settings::values.frame_limit);
 
     // Cast to double because Qt's written float values are not human-readable
     qt_config->setValue("bg_red", (double)Settings::values.bg_red);
@@ -169,6 +181,7 @@ void Config::SaveValues() {
     qt_config->beginGroup("Audio");
     qt_config->setValue("output_engine", QString::fromStdString(Settings::values.sink_id));
     qt_config->setValue("enable_audio_stretching", Settings::values.enable_audio_stretching);
+    qt_config->setValue("enable_audio_thread", Settings::values.enable_audio_thread);
     qt_config->endGroup();
 
     qt_config->beginGroup("Data Storage");
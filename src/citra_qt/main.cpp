@@ -10,6 +10,7 @@
 #define QT_NO_OPENGL
 #include <QDesktopWidget>
 #include <QFileDialog>
+#include <QLabel>
 #include <QMessageBox>
 #include <QtGui>
 #include "citra_qt/bootmanager.h"
@@ -31,6 +32,8 @@
 #include "citra_qt/hotkeys.h"
 #include "citra_qt/main.h"
 #include "citra_qt/ui_settings.h"
+#include "common/common_paths.h"
+#include "common/file_util.h"
 #include "common/logging/backend.h"
 #include "common/logging/filter.h"
 #include "common/logging/log.h"
@@ -139,6 +142,12 @@ void GMainWindow::InitializeWidgets() {
     waitTreeWidget = new WaitTreeWidget(this);
     addDockWidget(Qt::LeftDockWidgetArea, waitTreeWidget);
     waitTreeWidget->hide();
+
+    // Create status bar
+    frame_time_label = new QLabel();
+    frame_time_label->setToolTip(tr("Average time spent emulating, presenting and waiting per "
+                                    "frame, and the 99th percentile of the emulation time"));
+    statusBar()->addPermanentWidget(frame_time_label);
 }
 
 void GMainWindow::InitializeDebugMenuActions() {
@@ -235,6 +244,7 @@ void GMainWindow::ConnectWidgetEvents() {
     connect(ui.action_Pause, SIGNAL(triggered()), this, SLOT(OnPauseGame()));
     connect(ui.action_Stop, SIGNAL(triggered()), this, SLOT(OnStopGame()));
     connect(ui.action_Single_Window_Mode, SIGNAL(triggered(bool)), this, SLOT(ToggleWindowMode()));
+    connect(&status_bar_update_timer, SIGNAL(timeout()), this, SLOT(UpdateStatusBar()));
 
     connect(this, SIGNAL(EmulationStarting(EmuThread*)), disasmWidget,
             SLOT(OnEmulationStarting(EmuThread*)));
@@ -378,6 +388,10 @@ void GMainWindow::BootGame(const std::string& filename) {
     render_window->show();
     render_window->setFocus();
 
+    frame_time_label->clear();
+    statusBar()->show();
+    status_bar_update_timer.start(2000);
+
     emulation_running = true;
     OnStartGame();
 }
@@ -409,6 +423,9 @@ void GMainWindow::ShutdownGame() {
     render_window->hide();
     game_list->show();
 
+    status_bar_update_timer.stop();
+    statusBar()->hide();
+
     emulation_running = false;
 }
 
@@ -582,6 +599,24 @@ void GMainWindow::OnCreateGraphicsSurfaceViewer() {
     graphicsSurfaceViewerWidget->show();
 }
 
+void GMainWindow::UpdateStatusBar() {
+    using Stage = Core::PerfStats::Stage;
+    const auto& perf_stats = Core::System::GetInstance().perf_stats;
+    if (perf_stats.GetNumFrames() == 0) {
+        frame_time_label->clear();
+        return;
+    }
+
+    const auto frame_times = perf_stats.GetAverageFrameTimes();
+    const auto to_ms = [](std::chrono::microseconds duration) { return duration.count() / 1000.0; };
+    frame_time_label->setText(
+        tr("Frame: %1 ms emulation, %2 ms present, %3 ms wait (99%: %4 ms)")
+            .arg(to_ms(frame_times[static_cast<size_t>(Stage::Emulation)]), 0, 'f', 2)
+            .arg(to_ms(frame_times[static_cast<size_t>(Stage::Present)]), 0, 'f', 2)
+            .arg(to_ms(frame_times[static_cast<size_t>(Stage::Wait)]), 0, 'f', 2)
+            .arg(to_ms(perf_stats.GetPercentile(Stage::Emulation, 0.99)), 0, 'f', 2));
+}
+
 bool GMainWindow::ConfirmClose() {
     if (emu_thread == nullptr || !UISettings::values.confirm_before_closing)
         return true;
@@ -628,6 +663,9 @@ void GMainWindow::closeEvent(QCloseEvent* event) {
 int main(int argc, char* argv[]) {
     Log::Filter log_filter(Log::Level::Info);
     Log::SetFilter(&log_filter);
+    Log::AddSink(std::make_unique<Log::ColorConsoleSink>());
+    FileUtil::CreateFullPath(FileUtil::GetUserPath(D_LOGS_IDX));
+    Log::AddSink(std::make_unique<Log::FileSink>(FileUtil::GetUserPath(D_LOGS_IDX) + LOG_FILE));
 
     MicroProfileOnThreadCreate("Frontend");
     SCOPE_EXIT({ MicroProfileShutdown(); });
@@ -7,6 +7,7 @@
 
 #include <memory>
 #include <QMainWindow>
+#include <QTimer>
 #include "ui_main.h"
 
 class CallstackWidget;
@@ -22,6 +23,7 @@ class GraphicsTracingWidget;
 class GraphicsVertexShaderWidget;
 class GRenderWindow;
 class MicroProfileDialog;
+class QLabel;
 class ProfilerWidget;
 class RegistersWidget;
 class WaitTreeWidget;
@@ -129,6 +131,7 @@ private slots:
     void OnDisplayTitleBars(bool);
     void ToggleWindowMode();
     void OnCreateGraphicsSurfaceViewer();
+    void UpdateStatusBar();
 
 private:
     Ui::MainWindow ui;
@@ -136,6 +139,10 @@ private:
     GRenderWindow* render_window;
     GameList* game_list;
 
+    // Status bar elements
+    QLabel* frame_time_label = nullptr;
+    QTimer status_bar_update_timer;
+
     std::unique_ptr<Config> config;
 
     // Whether emulation is currently running in Citra.
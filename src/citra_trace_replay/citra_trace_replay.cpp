@@ -0,0 +1,466 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+// This needs to be included before getopt.h because the latter #defines symbols used by it
+#include "common/microprofile.h"
+
+#ifdef _MSC_VER
+#include <getopt.h>
+#else
+#include <getopt.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+#include <SDL.h>
+#include <glad/glad.h>
+#include "common/hash.h"
+#include "common/logging/backend.h"
+#include "common/logging/filter.h"
+#include "common/logging/log.h"
+#include "common/scm_rev.h"
+#include "common/scope_exit.h"
+#include "common/string_util.h"
+#include "core/hle/kernel/memory.h"
+#include "core/hle/kernel/process.h"
+#include "core/hw/gpu.h"
+#include "core/hw/hw.h"
+#include "core/hw/lcd.h"
+#include "core/memory.h"
+#include "core/perf_stats.h"
+#include "core/tracer/reader.h"
+#include "video_core/command_processor.h"
+#include "video_core/pica.h"
+#include "video_core/pica_state.h"
+#include "video_core/rasterizer_interface.h"
+#include "video_core/renderer_base.h"
+#include "video_core/video_core.h"
+
+using std::chrono::duration_cast;
+using Clock = std::chrono::steady_clock;
+
+/// Renderer which doesn't present frames, so that traces can be replayed without a window
+class HeadlessRenderer final : public RendererBase {
+public:
+    void SwapBuffers() override {
+        // Switch to the configured rasterizer if necessary
+        RefreshRasterizerSetting();
+        m_current_frame++;
+    }
+
+    void SetWindow(EmuWindow* window) override {}
+
+    bool Init() override {
+        RefreshRasterizerSetting();
+        return true;
+    }
+
+    void ShutDown() override {}
+};
+
+/// Hidden SDL2 window providing the OpenGL context for the hardware rasterizer
+class HiddenGLWindow {
+public:
+    ~HiddenGLWindow() {
+        if (gl_context != nullptr)
+            SDL_GL_DeleteContext(gl_context);
+        if (window != nullptr)
+            SDL_DestroyWindow(window);
+        SDL_Quit();
+    }
+
+    bool Create() {
+        SDL_SetMainReady();
+        if (SDL_Init(SDL_INIT_VIDEO) < 0) {
+            LOG_CRITICAL(Frontend, "Failed to initialize SDL2: %s", SDL_GetError());
+            return false;
+        }
+
+        SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
+        SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 3);
+        SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
+
+        window = SDL_CreateWindow("citra-trace-replay", SDL_WINDOWPOS_UNDEFINED,
+                                  SDL_WINDOWPOS_UNDEFINED, VideoCore::kScreenTopWidth,
+                                  VideoCore::kScreenTopHeight,
+                                  SDL_WINDOW_OPENGL | SDL_WINDOW_HIDDEN);
+        if (window == nullptr) {
+            LOG_CRITICAL(Frontend, "Failed to create SDL2 window: %s", SDL_GetError());
+            return false;
+        }
+
+        gl_context = SDL_GL_CreateContext(window);
+        if (gl_context == nullptr) {
+            LOG_CRITICAL(Frontend, "Failed to create SDL2 GL context: %s", SDL_GetError());
+            return false;
+        }
+
+        if (!gladLoadGLLoader(static_cast<GLADloadproc>(SDL_GL_GetProcAddress))) {
+            LOG_CRITICAL(Frontend, "Failed to initialize GL functions");
+            return false;
+        }
+        return true;
+    }
+
+private:
+    SDL_Window* window = nullptr;
+    SDL_GLContext gl_context = nullptr;
+};
+
+static void PrintHelp(const char* argv0) {
+    std::cout << "Usage: " << argv0
+              << " [options] <filename>\n"
+                 "Replays a CiTrace (.ctf) file and reports how long each frame took to render.\n"
+                 "-r, --renderer=NAME   Rasterizer to use: sw (default) or gl\n"
+                 "-i, --interpreter     Run shaders in the interpreter instead of the JIT\n"
+                 "-t, --threads=NUMBER  Number of software rasterizer and vertex shader threads\n"
+                 "-c, --texture-cache=MIB\n"
+                 "                      Memory the software rasterizer may keep decoded textures\n"
+                 "                      in, 0 to decode them for every draw (default: 32)\n"
+                 "-q, --quiet           Only print the summary, not every frame\n"
+                 "-h, --help            Display this help and exit\n"
+                 "-v, --version         Output version information and exit\n";
+}
+
+static void PrintVersion() {
+    std::cout << "Citra " << Common::g_scm_branch << " " << Common::g_scm_desc << std::endl;
+}
+
+/// Maps the memory which traces can load data into
+static void InitMemory() {
+    Memory::Init();
+
+    // Physical to virtual address translation of FCRAM goes through the current process
+    Kernel::g_current_process = Kernel::Process::Create(Kernel::CodeSet::Create("CiTrace", 0));
+    auto fcram = std::make_shared<std::vector<u8>>(Memory::FCRAM_SIZE);
+    Kernel::g_current_process->vm_manager
+        .MapMemoryBlock(Kernel::g_current_process->GetLinearHeapAreaAddress(), std::move(fcram), 0,
+                        Memory::FCRAM_SIZE, Kernel::MemoryState::Continuous)
+        .Unwrap();
+}
+
+template <typename T>
+static void CopyWords(T& dest, const std::vector<u32>& words) {
+    std::memcpy(static_cast<void*>(&dest), words.data(),
+                std::min(sizeof(T), words.size() * sizeof(u32)));
+}
+
+static void LoadInitialState(const CiTrace::Reader::InitialState& state) {
+    CopyWords(GPU::g_regs, state.gpu_registers);
+    CopyWords(LCD::g_regs, state.lcd_registers);
+
+    auto& regs = Pica::g_state.regs;
+    CopyWords(regs, state.pica_registers);
+    CopyWords(Pica::g_state.vs.program_code, state.vs_program_binary);
+    CopyWords(Pica::g_state.vs.swizzle_data, state.vs_swizzle_data);
+
+    for (size_t i = 0; i < state.default_attributes.size() && i < 4 * 16; ++i) {
+        Pica::g_state.vs_default_attributes[i / 4][i % 4] =
+            Pica::float24::FromRaw(state.default_attributes[i]);
+    }
+    for (size_t i = 0; i < state.vs_float_uniforms.size() && i < 4 * 96; ++i) {
+        Pica::g_state.vs.uniforms.f[i / 4][i % 4] =
+            Pica::float24::FromRaw(state.vs_float_uniforms[i]);
+    }
+
+    // The boolean and integer uniforms are derived from registers when those are written
+    for (unsigned i = 0; i < 16; ++i)
+        Pica::g_state.vs.uniforms.b[i] = (regs.vs.bool_uniforms.Value() & (1 << i)) != 0;
+    for (unsigned i = 0; i < 4; ++i) {
+        const auto& values = regs.vs.int_uniforms[i];
+        Pica::g_state.vs.uniforms.i[i] = Math::Vec4<u8>(values.x, values.y, values.z, values.w);
+    }
+
+    // Let the rasterizer pick up the initial register state
+    for (u32 id = 0; id < Pica::Regs::NumIds(); ++id)
+        VideoCore::g_renderer->Rasterizer()->NotifyPicaRegisterChanged(id);
+}
+
+static void ReplayMemoryLoad(const CiTrace::Reader& reader, const CiTrace::CTMemoryLoad& load) {
+    u8* dest = Memory::GetPhysicalPointer(load.physical_address);
+    if (dest == nullptr || !Memory::IsValidPhysicalAddress(load.physical_address + load.size - 1)) {
+        LOG_WARNING(HW_GPU, "Skipping memory load to unmapped address 0x%08X",
+                    load.physical_address);
+        return;
+    }
+
+    VideoCore::g_renderer->Rasterizer()->FlushAndInvalidateRegion(load.physical_address,
+                                                                  load.size);
+    std::memcpy(dest, reader.GetMemoryData(load), load.size);
+}
+
+static void ReplayRegisterWrite(const CiTrace::CTRegisterWrite& write) {
+    const VAddr addr = Memory::PhysicalToVirtualAddress(write.physical_address);
+
+    switch (write.size) {
+    case CiTrace::CTRegisterWrite::SIZE_8:
+        HW::Write<u8>(addr, static_cast<u8>(write.value));
+        break;
+    case CiTrace::CTRegisterWrite::SIZE_16:
+        HW::Write<u16>(addr, static_cast<u16>(write.value));
+        break;
+    case CiTrace::CTRegisterWrite::SIZE_32:
+        HW::Write<u32>(addr, static_cast<u32>(write.value));
+        break;
+    case CiTrace::CTRegisterWrite::SIZE_64:
+        HW::Write<u64>(addr, write.value);
+        break;
+    default:
+        LOG_WARNING(HW_GPU, "Skipping register write of unknown size %u",
+                    static_cast<u32>(write.size));
+        break;
+    }
+}
+
+/// Returns a hash of the framebuffer which is currently displayed on a screen
+static u64 HashFramebuffer(const GPU::Regs::FramebufferConfig& config) {
+    const PAddr addr = config.second_fb_active ? config.address_left2 : config.address_left1;
+    const u32 size = config.stride * config.height;
+    if (addr == 0 || size == 0 || !Memory::IsValidPhysicalAddress(addr) ||
+        !Memory::IsValidPhysicalAddress(addr + size - 1)) {
+        return 0;
+    }
+    return Common::ComputeHash64(Memory::GetPhysicalPointer(addr), size);
+}
+
+static double ToMilliseconds(std::chrono::nanoseconds duration) {
+    return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+static double ToMicroseconds(std::chrono::nanoseconds duration) {
+    return std::chrono::duration<double, std::micro>(duration).count();
+}
+
+/// Application entry point
+int main(int argc, char** argv) {
+    int option_index = 0;
+    bool use_gl = false;
+    bool use_shader_jit = true;
+    int num_threads = 1;
+    int texture_cache_size = 32;
+    bool quiet = false;
+    char* endarg;
+#ifdef _WIN32
+    int argc_w;
+    auto argv_w = CommandLineToArgvW(GetCommandLineW(), &argc_w);
+
+    if (argv_w == nullptr) {
+        LOG_CRITICAL(Frontend, "Failed to get command line arguments");
+        return -1;
+    }
+#endif
+    std::string filepath;
+
+    static struct option long_options[] = {
+        {"renderer", required_argument, 0, 'r'},
+        {"interpreter", no_argument, 0, 'i'},
+        {"threads", required_argument, 0, 't'},
+        {"texture-cache", required_argument, 0, 'c'},
+        {"quiet", no_argument, 0, 'q'},
+        {"help", no_argument, 0, 'h'},
+        {"version", no_argument, 0, 'v'},
+        {0, 0, 0, 0},
+    };
+
+    while (optind < argc) {
+        char arg = getopt_long(argc, argv, "r:it:c:qhv", long_options, &option_index);
+        if (arg != -1) {
+            switch (arg) {
+            case 'r':
+                if (std::string(optarg) == "gl") {
+                    use_gl = true;
+                } else if (std::string(optarg) != "sw") {
+                    std::cerr << "--renderer: expected sw or gl" << std::endl;
+                    exit(1);
+                }
+                break;
+            case 'i':
+                use_shader_jit = false;
+                break;
+            case 't':
+                errno = 0;
+                num_threads = strtol(optarg, &endarg, 0);
+                if (endarg == optarg || num_threads < 1)
+                    errno = EINVAL;
+                if (errno != 0) {
+                    perror("--threads");
+                    exit(1);
+                }
+                break;
+            case 'c':
+                errno = 0;
+                texture_cache_size = strtol(optarg, &endarg, 0);
+                if (endarg == optarg || texture_cache_size < 0)
+                    errno = EINVAL;
+                if (errno != 0) {
+                    perror("--texture-cache");
+                    exit(1);
+                }
+                break;
+            case 'q':
+                quiet = true;
+                break;
+            case 'h':
+                PrintHelp(argv[0]);
+                return 0;
+            case 'v':
+                PrintVersion();
+                return 0;
+            }
+        } else {
+#ifdef _WIN32
+            filepath = Common::UTF16ToUTF8(argv_w[optind]);
+#else
+            filepath = argv[optind];
+#endif
+            optind++;
+        }
+    }
+
+#ifdef _WIN32
+    LocalFree(argv_w);
+#endif
+
+    Log::Filter log_filter(Log::Level::Info);
+    Log::SetFilter(&log_filter);
+    Log::AddSink(std::make_unique<Log::ColorConsoleSink>());
+
+    MicroProfileOnThreadCreate("EmuThread");
+    SCOPE_EXIT({ MicroProfileShutdown(); });
+
+    if (filepath.empty()) {
+        LOG_CRITICAL(Frontend, "No CiTrace file specified");
+        return -1;
+    }
+
+    CiTrace::Reader reader;
+    if (!reader.Load(filepath)) {
+        LOG_CRITICAL(Frontend, "Failed to load CiTrace file %s", filepath.c_str());
+        return -1;
+    }
+
+    std::unique_ptr<HiddenGLWindow> gl_window;
+    if (use_gl) {
+        gl_window = std::make_unique<HiddenGLWindow>();
+        if (!gl_window->Create())
+            return -1;
+    }
+
+    VideoCore::g_hw_renderer_enabled = use_gl;
+    VideoCore::g_shader_jit_enabled = use_shader_jit;
+    VideoCore::g_sw_rasterizer_threads = num_threads;
+    VideoCore::g_vertex_shader_threads = num_threads;
+    VideoCore::g_sw_texture_cache_size = texture_cache_size;
+
+    InitMemory();
+    Pica::Init();
+    VideoCore::g_renderer = std::make_unique<HeadlessRenderer>();
+    VideoCore::g_renderer->Init();
+    SCOPE_EXIT({
+        VideoCore::g_renderer.reset();
+        Pica::Shutdown();
+        Kernel::g_current_process = nullptr;
+    });
+
+    LoadInitialState(reader.GetInitialState());
+    Pica::CommandProcessor::EnableDrawStats(true);
+    Pica::CommandProcessor::ResetDrawStats();
+
+    Core::PerfStats perf_stats;
+    u32 num_frames = 0;
+    u64 top_hash = 0;
+    u64 bottom_hash = 0;
+    Clock::duration total_time = Clock::duration::zero();
+    Pica::CommandProcessor::DrawStats frame_start_draws{};
+    Clock::time_point frame_start = Clock::now();
+
+    for (const auto& element : reader.GetStream()) {
+        switch (element.type) {
+        case CiTrace::MemoryLoad:
+            ReplayMemoryLoad(reader, element.memory_load);
+            break;
+
+        case CiTrace::RegisterWrite:
+            ReplayRegisterWrite(element.register_write);
+            break;
+
+        case CiTrace::FrameMarker: {
+            const Clock::time_point replay_end = Clock::now();
+
+            // Write rendered data back to emulated memory, so that it can be hashed
+            VideoCore::g_renderer->Rasterizer()->FlushAll();
+            const Clock::time_point frame_end = Clock::now();
+
+            top_hash = HashFramebuffer(GPU::g_regs.framebuffer_config[0]);
+            bottom_hash = HashFramebuffer(GPU::g_regs.framebuffer_config[1]);
+            VideoCore::g_renderer->SwapBuffers();
+
+            const Clock::duration replay_time = replay_end - frame_start;
+            const Clock::duration flush_time = frame_end - replay_end;
+            perf_stats.AddFrame({{duration_cast<std::chrono::microseconds>(replay_time),
+                                  duration_cast<std::chrono::microseconds>(flush_time),
+                                  std::chrono::microseconds::zero()}});
+            total_time += frame_end - frame_start;
+
+            const auto draws = Pica::CommandProcessor::GetDrawStats();
+            const u64 frame_draws = draws.num_draws - frame_start_draws.num_draws;
+            const auto frame_draw_time = draws.total_time - frame_start_draws.total_time;
+            if (!quiet) {
+                std::printf("Frame %u: %.3f ms replay, %.3f ms flush, %llu draws (%.2f us per "
+                            "draw), top %016llx, bottom %016llx\n",
+                            num_frames, ToMilliseconds(replay_time), ToMilliseconds(flush_time),
+                            static_cast<unsigned long long>(frame_draws),
+                            frame_draws == 0 ? 0.0 : ToMicroseconds(frame_draw_time) / frame_draws,
+                            static_cast<unsigned long long>(top_hash),
+                            static_cast<unsigned long long>(bottom_hash));
+            }
+
+            num_frames++;
+            frame_start_draws = draws;
+            frame_start = Clock::now();
+            break;
+        }
+
+        default:
+            LOG_WARNING(HW_GPU, "Skipping unknown stream element type 0x%X",
+                        static_cast<u32>(element.type));
+            break;
+        }
+    }
+
+    if (num_frames == 0) {
+        LOG_CRITICAL(Frontend, "CiTrace file does not contain any complete frames");
+        return -1;
+    }
+
+    using Stage = Core::PerfStats::Stage;
+    const auto draws = Pica::CommandProcessor::GetDrawStats();
+    const auto vertex_cache = Pica::CommandProcessor::GetVertexCacheStats();
+    std::printf("Replayed %u frames with the %s rasterizer in %.3f ms (%.3f ms per frame)\n",
+                num_frames, use_gl ? "OpenGL" : "software", ToMilliseconds(total_time),
+                ToMilliseconds(total_time) / num_frames);
+    std::printf("Replay time per frame over the last %u frames: 99th percentile %.3f ms\n",
+                static_cast<unsigned>(perf_stats.GetNumFrames()),
+                perf_stats.GetPercentile(Stage::Emulation, 0.99).count() / 1000.0);
+    std::printf("Draws: %llu (%.2f us per draw), vertex cache hit rate %.1f%%\n",
+                static_cast<unsigned long long>(draws.num_draws),
+                draws.num_draws == 0 ? 0.0 : ToMicroseconds(draws.total_time) / draws.num_draws,
+                vertex_cache.GetHitRate() * 100.0);
+    std::printf("Final framebuffers: top %016llx, bottom %016llx\n",
+                static_cast<unsigned long long>(top_hash),
+                static_cast<unsigned long long>(bottom_hash));
+    return 0;
+}
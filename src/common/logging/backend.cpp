@@ -4,13 +4,19 @@
 
 #include <algorithm>
 #include <array>
+#include <atomic>
+#include <condition_variable>
 #include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <thread>
 #include "common/assert.h"
 #include "common/common_funcs.h" // snprintf compatibility define
 #include "common/logging/backend.h"
 #include "common/logging/filter.h"
 #include "common/logging/log.h"
 #include "common/logging/text_formatter.h"
+#include "common/thread.h"
 
 namespace Log {
 
@@ -105,28 +111,303 @@ const char* GetLevelName(Level log_level) {
 #undef LVL
 }
 
-Entry CreateEntry(Class log_class, Level log_level, const char* filename, unsigned int line_nr,
-                  const char* function, const char* format, va_list args) {
+/// Returns the time elapsed since the first log entry was created
+static std::chrono::microseconds GetTimestamp() {
     using std::chrono::steady_clock;
     using std::chrono::duration_cast;
 
     static steady_clock::time_point time_origin = steady_clock::now();
 
-    std::array<char, 4 * 1024> formatting_buffer;
+    return duration_cast<std::chrono::microseconds>(steady_clock::now() - time_origin);
+}
 
-    Entry entry;
-    entry.timestamp = duration_cast<std::chrono::microseconds>(steady_clock::now() - time_origin);
+void FormatEntry(Entry& entry, Class log_class, Level log_level, const char* filename,
+                 unsigned int line_nr, const char* function, const char* format, va_list args) {
+    entry.timestamp = GetTimestamp();
     entry.log_class = log_class;
     entry.log_level = log_level;
 
-    snprintf(formatting_buffer.data(), formatting_buffer.size(), "%s:%s:%u", filename, function,
-             line_nr);
-    entry.location = std::string(formatting_buffer.data());
+    snprintf(entry.location.data(), entry.location.size(), "%s:%s:%u", TrimSourcePath(filename),
+             function, line_nr);
+    vsnprintf(entry.message.data(), entry.message.size(), format, args);
+}
+
+void ColorConsoleSink::Write(const Entry& entry) {
+    PrintColoredMessage(entry);
+}
+
+FileSink::FileSink(const std::string& filename) : file(filename, "w") {}
+
+void FileSink::Write(const Entry& entry) {
+    if (!file.IsOpen())
+        return;
+
+    std::array<char, Entry::MAX_LOCATION_LENGTH + Entry::MAX_MESSAGE_LENGTH + 64> format_buffer;
+    FormatLogMessage(entry, format_buffer.data(), format_buffer.size());
+    file.WriteBytes(format_buffer.data(), std::strlen(format_buffer.data()));
+    file.WriteBytes("\n", 1);
+}
+
+void FileSink::Flush() {
+    if (file.IsOpen())
+        file.Flush();
+}
 
-    vsnprintf(formatting_buffer.data(), formatting_buffer.size(), format, args);
-    entry.message = std::string(formatting_buffer.data());
+void MemorySink::Write(const Entry& entry) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (entries.size() < max_entries) {
+        entries.push_back(entry);
+    } else {
+        entries[next] = entry;
+        next = (next + 1) % max_entries;
+    }
+}
 
-    return entry;
+std::vector<Entry> MemorySink::GetEntries() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::vector<Entry> result;
+    result.reserve(entries.size());
+    result.insert(result.end(), entries.begin() + next, entries.end());
+    result.insert(result.end(), entries.begin(), entries.begin() + next);
+    return result;
+}
+
+void MemorySink::Clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+    entries.clear();
+    next = 0;
+}
+
+/**
+ * Hands log entries from the logging threads to the sinks, which are written on a dedicated
+ * writer thread so that slow outputs (like a Windows console) don't stall emulation.
+ *
+ * Entries are formatted directly into a bounded multi-producer, single-consumer ring buffer. Each
+ * slot carries a sequence number that tells whether it's free for the producer claiming position
+ * `pos` (sequence == pos) or holds a finished entry for the consumer (sequence == pos + 1).
+ * Producers claim positions with a compare-exchange and never wait: if the ring is full, the entry
+ * is dropped and counted instead.
+ */
+class Backend {
+public:
+    static constexpr size_t RING_SIZE = 1024;
+    static_assert((RING_SIZE & (RING_SIZE - 1)) == 0, "RING_SIZE must be a power of two");
+
+    Backend() : slots(new Slot[RING_SIZE]) {
+        for (size_t i = 0; i < RING_SIZE; ++i)
+            slots[i].sequence.store(i, std::memory_order_relaxed);
+        writer_thread = std::thread([this] { WriterLoop(); });
+    }
+
+    ~Backend() {
+        stop.store(true, std::memory_order_release);
+        WakeWriter();
+        writer_thread.join();
+    }
+
+    void Push(Class log_class, Level log_level, const char* filename, unsigned int line_nr,
+              const char* function, const char* format, va_list args) {
+        size_t pos = write_pos.load(std::memory_order_relaxed);
+        Slot* slot;
+        for (;;) {
+            slot = &slots[pos & (RING_SIZE - 1)];
+            const size_t sequence = slot->sequence.load(std::memory_order_acquire);
+            const ptrdiff_t diff = static_cast<ptrdiff_t>(sequence - pos);
+            if (diff == 0) {
+                if (write_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            } else if (diff < 0) {
+                // The writer hasn't consumed the entry RING_SIZE positions back yet
+                dropped_count.fetch_add(1, std::memory_order_relaxed);
+                return;
+            } else {
+                pos = write_pos.load(std::memory_order_relaxed);
+            }
+        }
+
+        FormatEntry(slot->entry, log_class, log_level, filename, line_nr, function, format, args);
+        slot->sequence.store(pos + 1, std::memory_order_release);
+
+        if (writer_sleeping.load(std::memory_order_seq_cst))
+            WakeWriter();
+    }
+
+    void Flush() {
+        if (std::this_thread::get_id() == writer_thread.get_id())
+            return;
+
+        // Entries up to the target may still be being formatted; the writer keeps notifying until
+        // it has written all of them
+        const size_t target = write_pos.load(std::memory_order_acquire);
+        std::unique_lock<std::mutex> lock(flush_mutex);
+        flush_target = std::max(flush_target, target);
+        flush_requested = true;
+        WakeWriter();
+        flush_done.wait(lock, [this, target] {
+            return written_pos >= target || stop.load(std::memory_order_acquire);
+        });
+    }
+
+    void AddSink(std::unique_ptr<Sink> sink) {
+        std::lock_guard<std::mutex> lock(sinks_mutex);
+        sinks.push_back(std::move(sink));
+    }
+
+    void RemoveSink(const Sink* sink) {
+        std::lock_guard<std::mutex> lock(sinks_mutex);
+        sinks.erase(std::remove_if(sinks.begin(), sinks.end(),
+                                   [sink](const auto& other) { return other.get() == sink; }),
+                    sinks.end());
+    }
+
+    u64 GetDroppedCount() const {
+        return dropped_count.load(std::memory_order_relaxed);
+    }
+
+private:
+    struct Slot {
+        std::atomic<size_t> sequence;
+        Entry entry;
+    };
+
+    /// Polling interval of the writer, in case an entry is still being formatted when it sleeps
+    static constexpr std::chrono::milliseconds WRITER_TIMEOUT{50};
+
+    void WakeWriter() {
+        {
+            std::lock_guard<std::mutex> lock(wakeup_mutex);
+            wakeup_requested = true;
+        }
+        wakeup.notify_one();
+    }
+
+    /**
+     * Outputs an entry to all registered sinks. Until a frontend registers its first sink, entries
+     * are printed to the console instead, so that nothing logged at startup or by tools without
+     * sinks of their own is lost.
+     */
+    void WriteToSinks(const Entry& entry) {
+        if (sinks.empty()) {
+            fallback_sink.Write(entry);
+            return;
+        }
+        for (auto& sink : sinks)
+            sink->Write(entry);
+    }
+
+    /// Writes all finished entries to the sinks. Returns false if there were none.
+    bool WriteEntries() {
+        std::lock_guard<std::mutex> lock(sinks_mutex);
+        bool written = false;
+        for (;;) {
+            Slot& slot = slots[read_pos & (RING_SIZE - 1)];
+            if (slot.sequence.load(std::memory_order_acquire) != read_pos + 1)
+                break;
+            WriteToSinks(slot.entry);
+            slot.sequence.store(read_pos + RING_SIZE, std::memory_order_release);
+            ++read_pos;
+            written = true;
+        }
+
+        const u64 dropped = dropped_count.load(std::memory_order_relaxed);
+        if (dropped != reported_dropped_count) {
+            Entry& entry = dropped_entry;
+            entry.timestamp = GetTimestamp();
+            entry.log_class = Class::Log;
+            entry.log_level = Level::Warning;
+            snprintf(entry.location.data(), entry.location.size(), "%s", "common/logging");
+            snprintf(entry.message.data(), entry.message.size(),
+                     "Dropped %llu log entries because the log buffer was full",
+                     static_cast<unsigned long long>(dropped - reported_dropped_count));
+            WriteToSinks(entry);
+            reported_dropped_count = dropped;
+            written = true;
+        }
+
+        if (written) {
+            for (auto& sink : sinks)
+                sink->Flush();
+        }
+        return written;
+    }
+
+    void WriterLoop() {
+        Common::SetCurrentThreadName("LogWriter");
+        for (;;) {
+            const bool stopping = stop.load(std::memory_order_acquire);
+            const bool written = WriteEntries();
+
+            bool flush;
+            {
+                std::lock_guard<std::mutex> lock(flush_mutex);
+                written_pos = read_pos;
+                flush = flush_requested;
+                if (written_pos >= flush_target)
+                    flush_requested = false;
+            }
+            if (flush || stopping)
+                flush_done.notify_all();
+
+            if (stopping)
+                break;
+            if (written)
+                continue;
+
+            // Producers only notify when this flag is set, keeping the common path syscall-free.
+            // Wakeups are recorded under wakeup_mutex, so none is lost between the check and the
+            // wait.
+            writer_sleeping.store(true, std::memory_order_seq_cst);
+            {
+                std::unique_lock<std::mutex> lock(wakeup_mutex);
+                if (!wakeup_requested && !HasPendingEntries() &&
+                    !stop.load(std::memory_order_acquire)) {
+                    wakeup.wait_for(lock, WRITER_TIMEOUT);
+                }
+                wakeup_requested = false;
+            }
+            writer_sleeping.store(false, std::memory_order_relaxed);
+        }
+    }
+
+    bool HasPendingEntries() const {
+        const Slot& slot = slots[read_pos & (RING_SIZE - 1)];
+        return slot.sequence.load(std::memory_order_acquire) == read_pos + 1;
+    }
+
+    std::unique_ptr<Slot[]> slots;
+    std::atomic<size_t> write_pos{0};
+    /// Position of the next entry to be written, only accessed by the writer thread
+    size_t read_pos = 0;
+
+    std::atomic<u64> dropped_count{0};
+    u64 reported_dropped_count = 0;
+    Entry dropped_entry{};
+
+    std::mutex sinks_mutex;
+    std::vector<std::unique_ptr<Sink>> sinks;
+    ColorConsoleSink fallback_sink;
+
+    std::atomic<bool> stop{false};
+    std::atomic<bool> writer_sleeping{false};
+    std::mutex wakeup_mutex;
+    std::condition_variable wakeup;
+    bool wakeup_requested = false;
+
+    std::mutex flush_mutex;
+    std::condition_variable flush_done;
+    /// Set while a Flush call waits for entries up to flush_target to be written
+    bool flush_requested = false;
+    size_t flush_target = 0;
+    size_t written_pos = 0;
+
+    std::thread writer_thread;
+};
+
+constexpr std::chrono::milliseconds Backend::WRITER_TIMEOUT;
+
+static Backend& GetBackend() {
+    static Backend backend;
+    return backend;
 }
 
 static Filter* filter = nullptr;
@@ -135,16 +416,36 @@ void SetFilter(Filter* new_filter) {
     filter = new_filter;
 }
 
+void AddSink(std::unique_ptr<Sink> sink) {
+    GetBackend().AddSink(std::move(sink));
+}
+
+void RemoveSink(const Sink* sink) {
+    GetBackend().RemoveSink(sink);
+}
+
+void Flush() {
+    GetBackend().Flush();
+}
+
+u64 GetDroppedEntryCount() {
+    return GetBackend().GetDroppedCount();
+}
+
 void LogMessage(Class log_class, Level log_level, const char* filename, unsigned int line_nr,
                 const char* function, const char* format, ...) {
     if (filter != nullptr && !filter->CheckMessage(log_class, log_level))
         return;
 
+    Backend& backend = GetBackend();
+
     va_list args;
     va_start(args, format);
-    Entry entry = CreateEntry(log_class, log_level, filename, line_nr, function, format, args);
+    backend.Push(log_class, log_level, filename, line_nr, function, format, args);
     va_end(args);
 
-    PrintColoredMessage(entry);
-}
+    // Critical messages usually precede a crash, make sure they're not lost in the buffer
+    if (log_level == Level::Critical)
+        backend.Flush();
 }
+} // namespace Log
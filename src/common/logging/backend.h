@@ -4,10 +4,15 @@
 
 #pragma once
 
+#include <array>
 #include <chrono>
 #include <cstdarg>
+#include <cstddef>
+#include <memory>
+#include <mutex>
 #include <string>
-#include <utility>
+#include <vector>
+#include "common/file_util.h"
 #include "common/logging/log.h"
 
 namespace Log {
@@ -17,18 +22,74 @@ class Filter;
 /**
  * A log entry. Log entries are store in a structured format to permit more varied output
  * formatting on different frontends, as well as facilitating filtering and aggregation.
+ *
+ * Entries are formatted directly into fixed-size buffers in the backend's ring buffer, so that
+ * logging a message doesn't allocate. Longer locations and messages are truncated.
  */
 struct Entry {
+    static constexpr size_t MAX_LOCATION_LENGTH = 256;
+    static constexpr size_t MAX_MESSAGE_LENGTH = 2048;
+
     std::chrono::microseconds timestamp;
     Class log_class;
     Level log_level;
-    std::string location;
-    std::string message;
+    std::array<char, MAX_LOCATION_LENGTH> location;
+    std::array<char, MAX_MESSAGE_LENGTH> message;
+};
+
+/**
+ * Interface for the outputs of the logging backend. All sinks are written to from the backend's
+ * writer thread, so implementations don't need to be thread-safe unless they expose their data
+ * to other threads.
+ */
+class Sink {
+public:
+    virtual ~Sink() = default;
+
+    /// Outputs a single log entry
+    virtual void Write(const Entry& entry) = 0;
+
+    /// Called after a batch of entries has been written, or when a flush was requested
+    virtual void Flush() {}
+};
+
+/// Prints entries to stderr, colored according to their severity level.
+class ColorConsoleSink : public Sink {
+public:
+    void Write(const Entry& entry) override;
+};
+
+/// Appends formatted entries to a text file.
+class FileSink : public Sink {
+public:
+    explicit FileSink(const std::string& filename);
+
+    void Write(const Entry& entry) override;
+    void Flush() override;
+
+private:
+    FileUtil::IOFile file;
+};
 
-    Entry() = default;
-    Entry(Entry&& o) = default;
+/// Keeps the most recent entries in memory, e.g. for displaying them in a frontend.
+class MemorySink : public Sink {
+public:
+    explicit MemorySink(size_t max_entries) : max_entries(max_entries) {}
 
-    Entry& operator=(Entry&& o) = default;
+    void Write(const Entry& entry) override;
+
+    /// Returns the stored entries, oldest first. May be called from any thread.
+    std::vector<Entry> GetEntries() const;
+
+    /// Removes all stored entries. May be called from any thread.
+    void Clear();
+
+private:
+    const size_t max_entries;
+    mutable std::mutex mutex;
+    /// Circular buffer of entries, `next` being the position of the oldest one once it's full
+    std::vector<Entry> entries;
+    size_t next = 0;
 };
 
 /**
@@ -42,9 +103,32 @@ const char* GetLogClassName(Class log_class);
  */
 const char* GetLevelName(Level log_level);
 
-/// Creates a log entry by formatting the given source location, and message.
-Entry CreateEntry(Class log_class, Level log_level, const char* filename, unsigned int line_nr,
-                  const char* function, const char* format, va_list args);
+/// Fills in a log entry by formatting the given source location, and message.
+void FormatEntry(Entry& entry, Class log_class, Level log_level, const char* filename,
+                 unsigned int line_nr, const char* function, const char* format, va_list args);
 
 void SetFilter(Filter* filter);
-}
+
+/**
+ * Registers a sink that all subsequently written entries are output to. Ownership is transferred
+ * to the backend; the sink stays alive until it's removed with RemoveSink. While no sink is
+ * registered, entries are printed to the console.
+ */
+void AddSink(std::unique_ptr<Sink> sink);
+
+/// Unregisters and destroys a sink previously passed to AddSink.
+void RemoveSink(const Sink* sink);
+
+/**
+ * Blocks until all entries logged before the call have been written to the sinks, and the sinks
+ * have been flushed. Critical messages are flushed automatically.
+ */
+void Flush();
+
+/**
+ * Returns the number of entries that were dropped so far because the ring buffer was full. A
+ * warning with the number of dropped entries is also written to the sinks when that happens.
+ */
+u64 GetDroppedEntryCount();
+
+} // namespace Log
@@ -50,7 +50,7 @@ void FormatLogMessage(const Entry& entry, char* out_text, size_t text_len) {
     const char* level_name = GetLevelName(entry.log_level);
 
     snprintf(out_text, text_len, "[%4u.%06u] %s <%s> %s: %s", time_seconds, time_fractional,
-             class_name, level_name, TrimSourcePath(entry.location.c_str()), entry.message.c_str());
+             class_name, level_name, entry.location.data(), entry.message.data());
 }
 
 void PrintMessage(const Entry& entry) {
@@ -0,0 +1,72 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <atomic>
+#include <utility>
+#include "common/common_types.h"
+
+namespace Common {
+
+/**
+ * Unbounded lock-free queue with any number of producer threads and a single consumer thread.
+ *
+ * Push is wait-free: a producer swaps its node in as the new head of the list with a single atomic
+ * exchange and then links it to its predecessor. The consumer walks the list from the other end.
+ * Values pushed by one thread are popped in the order they were pushed. A value whose producer is
+ * between the exchange and the link is not visible to Pop yet, and neither are the values pushed
+ * after it; they become visible once the producer finishes its Push.
+ */
+template <typename T>
+class MPSCQueue : NonCopyable {
+public:
+    MPSCQueue() : tail(new Node) {
+        head.store(tail, std::memory_order_relaxed);
+    }
+
+    ~MPSCQueue() {
+        T value;
+        while (Pop(value)) {
+        }
+        delete tail;
+    }
+
+    /// Appends a value to the queue. May be called from any thread.
+    void Push(T value) {
+        Node* node = new Node;
+        node->value = std::move(value);
+        Node* prev = head.exchange(node, std::memory_order_acq_rel);
+        prev->next.store(node, std::memory_order_release);
+    }
+
+    /**
+     * Removes the oldest value from the queue. Must only be called from the consumer thread.
+     * @returns False if no value was available
+     */
+    bool Pop(T& value) {
+        Node* next = tail->next.load(std::memory_order_acquire);
+        if (next == nullptr)
+            return false;
+
+        // `next` becomes the new sentinel node; its value is no longer needed by the queue
+        value = std::move(next->value);
+        delete tail;
+        tail = next;
+        return true;
+    }
+
+private:
+    struct Node {
+        std::atomic<Node*> next{nullptr};
+        T value;
+    };
+
+    /// Most recently pushed node, shared between the producers
+    std::atomic<Node*> head;
+    /// Sentinel node preceding the oldest value, only accessed by the consumer
+    Node* tail;
+};
+
+} // namespace Common
@@ -0,0 +1,95 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include "common/thread.h"
+#include "common/thread_pool.h"
+
+namespace Common {
+
+ThreadPool::ThreadPool(size_t num_workers) {
+    workers.reserve(num_workers);
+    for (size_t i = 0; i < num_workers; ++i) {
+        workers.emplace_back([this] { WorkerLoop(); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        shutting_down = true;
+    }
+    work_available.notify_all();
+
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+void ThreadPool::ParallelFor(size_t num_jobs, const std::function<void(size_t)>& job) {
+    if (num_jobs == 0)
+        return;
+
+    // Waking up the workers isn't worth it if there's nothing to share
+    if (workers.empty() || num_jobs == 1) {
+        for (size_t i = 0; i < num_jobs; ++i)
+            job(i);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        current_job = &job;
+        current_num_jobs = num_jobs;
+        next_job_index = 0;
+        pending_workers = workers.size();
+        ++generation;
+    }
+    work_available.notify_all();
+
+    RunJobs(job, num_jobs);
+
+    // Every worker has to acknowledge the batch before returning, since `job` goes out of scope
+    // afterwards and a late worker must not pick it up.
+    std::unique_lock<std::mutex> lock(mutex);
+    work_done.wait(lock, [this] { return pending_workers == 0; });
+    current_job = nullptr;
+}
+
+void ThreadPool::WorkerLoop() {
+    SetCurrentThreadName("ThreadPoolWorker");
+
+    u64 last_generation = 0;
+    while (true) {
+        const std::function<void(size_t)>* job;
+        size_t num_jobs;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            work_available.wait(
+                lock, [&] { return shutting_down || generation != last_generation; });
+            if (shutting_down)
+                return;
+
+            last_generation = generation;
+            job = current_job;
+            num_jobs = current_num_jobs;
+        }
+
+        RunJobs(*job, num_jobs);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (--pending_workers == 0)
+                work_done.notify_one();
+        }
+    }
+}
+
+void ThreadPool::RunJobs(const std::function<void(size_t)>& job, size_t num_jobs) {
+    size_t index;
+    while ((index = next_job_index.fetch_add(1)) < num_jobs) {
+        job(index);
+    }
+}
+
+} // namespace Common
@@ -0,0 +1,62 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "common/common_types.h"
+
+namespace Common {
+
+/**
+ * A fixed set of worker threads used to split CPU-bound work into independent jobs. The thread
+ * calling ParallelFor takes part in processing as well, so a pool constructed with N workers runs
+ * jobs on N + 1 threads.
+ */
+class ThreadPool : NonCopyable {
+public:
+    explicit ThreadPool(size_t num_workers);
+    ~ThreadPool();
+
+    /// Returns the number of threads that process jobs, including the calling thread
+    size_t GetNumThreads() const {
+        return workers.size() + 1;
+    }
+
+    /**
+     * Calls `job(i)` for every i in [0, num_jobs), spread over the worker threads and the calling
+     * thread. Jobs are handed out in increasing order of i, but may complete in any order. Returns
+     * once all jobs have completed.
+     * @note Jobs must not call ParallelFor on the same pool.
+     */
+    void ParallelFor(size_t num_jobs, const std::function<void(size_t)>& job);
+
+private:
+    void WorkerLoop();
+    void RunJobs(const std::function<void(size_t)>& job, size_t num_jobs);
+
+    std::vector<std::thread> workers;
+
+    std::mutex mutex;
+    std::condition_variable work_available;
+    std::condition_variable work_done;
+
+    const std::function<void(size_t)>* current_job = nullptr;
+    size_t current_num_jobs = 0;
+    std::atomic<size_t> next_job_index{0};
+
+    /// Number of workers that have not yet finished the current batch of jobs
+    size_t pending_workers = 0;
+    /// Incremented each time a new batch of jobs is submitted
+    u64 generation = 0;
+    bool shutting_down = false;
+};
+
+} // namespace Common
@@ -5,156 +5,181 @@
 #pragma once
 
 #include <array>
-#include <deque>
-#include <boost/range/algorithm_ext/erase.hpp>
+#include "common/assert.h"
+#include "common/bit_set.h"
+#include "common/common_types.h"
 
 namespace Common {
 
-template <class T, unsigned int N>
+/**
+ * Links embedded into each element of a ThreadQueueList. Since every element carries its own
+ * links, it can be queued and removed without searching or allocating.
+ */
+template <class T>
+struct ThreadQueueListNode {
+    T* prev = nullptr;
+    T* next = nullptr;
+    /// Priority level the element is queued at, only valid while queued is set
+    unsigned int priority = 0;
+    bool queued = false;
+};
+
+/**
+ * Queue of elements ordered by priority, with FIFO order within each priority level. Lower
+ * priority values are served first. A bitmap of the non-empty levels is kept next to one
+ * intrusive list per level, so that finding the best element, queueing and removing specific
+ * elements all take constant time.
+ * @tparam T Type of the queued elements, which are referred to by pointer
+ * @tparam N Number of priority levels
+ * @tparam node Member of T holding its links; an element can only be queued once at a time
+ */
+template <class T, unsigned int N, ThreadQueueListNode<T> T::*node>
 struct ThreadQueueList {
-    // TODO(yuriks): If performance proves to be a problem, the std::deques can be replaced with
-    //               (dynamically resizable) circular buffers to remove their overhead when
-    //               inserting and popping.
+    static_assert(N <= 64, "Non-empty priority levels are tracked in a 64-bit mask");
 
     typedef unsigned int Priority;
 
     // Number of priority levels. (Valid levels are [0..NUM_QUEUES).)
     static const Priority NUM_QUEUES = N;
 
-    ThreadQueueList() {
-        first = nullptr;
+    // Only for debugging, returns priority level.
+    Priority contains(T* thread) const {
+        const ThreadQueueListNode<T>& links = thread->*node;
+        return links.queued ? links.priority : -1;
     }
 
-    // Only for debugging, returns priority level.
-    Priority contains(const T& uid) {
-        for (Priority i = 0; i < NUM_QUEUES; ++i) {
-            Queue& cur = queues[i];
-            if (std::find(cur.data.cbegin(), cur.data.cend(), uid) != cur.data.cend()) {
-                return i;
-            }
-        }
+    T* get_first() const {
+        if (non_empty == 0)
+            return nullptr;
 
-        return -1;
+        return queues[LeastSignificantSetBit(non_empty)].head;
     }
 
-    T get_first() {
-        Queue* cur = first;
-        while (cur != nullptr) {
-            if (!cur->data.empty()) {
-                return cur->data.front();
-            }
-            cur = cur->next_nonempty;
-        }
+    T* pop_first() {
+        if (non_empty == 0)
+            return nullptr;
 
-        return T();
+        return pop_front(LeastSignificantSetBit(non_empty));
     }
 
-    T pop_first() {
-        Queue* cur = first;
-        while (cur != nullptr) {
-            if (!cur->data.empty()) {
-                auto tmp = std::move(cur->data.front());
-                cur->data.pop_front();
-                return tmp;
-            }
-            cur = cur->next_nonempty;
-        }
+    T* pop_first_better(Priority priority) {
+        // Only consider the levels above the given one
+        const u64 better = non_empty & ((u64(1) << priority) - 1);
+        if (better == 0)
+            return nullptr;
 
-        return T();
+        return pop_front(LeastSignificantSetBit(better));
     }
 
-    T pop_first_better(Priority priority) {
-        Queue* cur = first;
-        Queue* stop = &queues[priority];
-        while (cur < stop) {
-            if (!cur->data.empty()) {
-                auto tmp = std::move(cur->data.front());
-                cur->data.pop_front();
-                return tmp;
-            }
-            cur = cur->next_nonempty;
-        }
+    void push_front(Priority priority, T* thread) {
+        ThreadQueueListNode<T>& links = Link(priority, thread);
+        Queue& cur = queues[priority];
 
-        return T();
+        links.next = cur.head;
+        if (cur.head != nullptr) {
+            (cur.head->*node).prev = thread;
+        } else {
+            cur.tail = thread;
+        }
+        cur.head = thread;
     }
 
-    void push_front(Priority priority, const T& thread_id) {
-        Queue* cur = &queues[priority];
-        cur->data.push_front(thread_id);
-    }
+    void push_back(Priority priority, T* thread) {
+        ThreadQueueListNode<T>& links = Link(priority, thread);
+        Queue& cur = queues[priority];
 
-    void push_back(Priority priority, const T& thread_id) {
-        Queue* cur = &queues[priority];
-        cur->data.push_back(thread_id);
+        links.prev = cur.tail;
+        if (cur.tail != nullptr) {
+            (cur.tail->*node).next = thread;
+        } else {
+            cur.head = thread;
+        }
+        cur.tail = thread;
     }
 
-    void move(const T& thread_id, Priority old_priority, Priority new_priority) {
-        remove(old_priority, thread_id);
-        prepare(new_priority);
-        push_back(new_priority, thread_id);
+    void move(T* thread, Priority old_priority, Priority new_priority) {
+        remove(old_priority, thread);
+        push_back(new_priority, thread);
     }
 
-    void remove(Priority priority, const T& thread_id) {
-        Queue* cur = &queues[priority];
-        boost::remove_erase(cur->data, thread_id);
+    /// Removes the given element from the queue, if it is queued at the given priority level
+    void remove(Priority priority, T* thread) {
+        ThreadQueueListNode<T>& links = thread->*node;
+        if (!links.queued)
+            return;
+        DEBUG_ASSERT_MSG(links.priority == priority, "Element is queued at a different priority");
+
+        Queue& cur = queues[links.priority];
+        if (links.prev != nullptr) {
+            (links.prev->*node).next = links.next;
+        } else {
+            cur.head = links.next;
+        }
+        if (links.next != nullptr) {
+            (links.next->*node).prev = links.prev;
+        } else {
+            cur.tail = links.prev;
+        }
+
+        if (cur.head == nullptr)
+            non_empty &= ~(u64(1) << links.priority);
+
+        links = ThreadQueueListNode<T>();
     }
 
     void rotate(Priority priority) {
-        Queue* cur = &queues[priority];
+        Queue& cur = queues[priority];
 
-        if (cur->data.size() > 1) {
-            cur->data.push_back(std::move(cur->data.front()));
-            cur->data.pop_front();
+        if (cur.head != cur.tail) {
+            T* front = cur.head;
+            remove(priority, front);
+            push_back(priority, front);
         }
     }
 
     void clear() {
-        queues.fill(Queue());
-        first = nullptr;
+        for (Queue& cur : queues) {
+            for (T* thread = cur.head; thread != nullptr;) {
+                T* next = (thread->*node).next;
+                thread->*node = ThreadQueueListNode<T>();
+                thread = next;
+            }
+            cur = Queue();
+        }
+        non_empty = 0;
     }
 
     bool empty(Priority priority) const {
-        const Queue* cur = &queues[priority];
-        return cur->data.empty();
-    }
-
-    void prepare(Priority priority) {
-        Queue* cur = &queues[priority];
-        if (cur->next_nonempty == UnlinkedTag())
-            link(priority);
+        return queues[priority].head == nullptr;
     }
 
 private:
     struct Queue {
-        // Points to the next active priority, skipping over ones that have never been used.
-        Queue* next_nonempty = UnlinkedTag();
-        // Double-ended queue of threads in this priority level
-        std::deque<T> data;
+        T* head = nullptr;
+        T* tail = nullptr;
     };
 
-    /// Special tag used to mark priority levels that have never been used.
-    static Queue* UnlinkedTag() {
-        return reinterpret_cast<Queue*>(1);
-    }
-
-    void link(Priority priority) {
-        Queue* cur = &queues[priority];
+    /// Marks the element as queued at the given priority level, without linking it yet
+    ThreadQueueListNode<T>& Link(Priority priority, T* thread) {
+        ThreadQueueListNode<T>& links = thread->*node;
+        DEBUG_ASSERT_MSG(!links.queued, "Element is already queued");
 
-        for (int i = priority - 1; i >= 0; --i) {
-            if (queues[i].next_nonempty != UnlinkedTag()) {
-                cur->next_nonempty = queues[i].next_nonempty;
-                queues[i].next_nonempty = cur;
-                return;
-            }
-        }
+        links = ThreadQueueListNode<T>();
+        links.priority = priority;
+        links.queued = true;
+        non_empty |= u64(1) << priority;
+        return links;
+    }
 
-        cur->next_nonempty = first;
-        first = cur;
+    T* pop_front(Priority priority) {
+        T* thread = queues[priority].head;
+        remove(priority, thread);
+        return thread;
     }
 
-    // The first queue that's ever been used.
-    Queue* first;
-    // The priority level queues of thread ids.
+    // Bit i is set if priority level i has queued elements
+    u64 non_empty = 0;
+    // The priority level queues of elements.
     std::array<Queue, NUM_QUEUES> queues;
 };
 
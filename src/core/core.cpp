@@ -105,6 +105,12 @@ System::ResultStatus System::Load(EmuWindow* emu_window, const std::string& file
             return ResultStatus::ErrorLoader;
         }
     }
+
+    // Warm up the shader cache, so that shaders seen in earlier runs don't need to be compiled
+    u64 program_id = 0;
+    if (app_loader->ReadProgramId(program_id) == Loader::ResultStatus::Success) {
+        VideoCore::LoadShaderCache(program_id);
+    }
     return ResultStatus::Success;
 }
 
@@ -146,6 +152,9 @@ System::ResultStatus System::Init(EmuWindow* emu_window, u32 system_mode) {
         return ResultStatus::ErrorVideoCore;
     }
 
+    perf_stats.Reset();
+    frame_limiter.Reset();
+
     LOG_DEBUG(Core, "Initialized OK");
 
     return ResultStatus::Success;
@@ -9,6 +9,7 @@
 
 #include "common/common_types.h"
 #include "core/memory.h"
+#include "core/perf_stats.h"
 
 class EmuWindow;
 class ARM_Interface;
@@ -91,6 +92,12 @@ public:
         return *cpu_core;
     }
 
+    /// Timings of the most recent frames
+    PerfStats perf_stats;
+
+    /// Paces emulation to the configured speed
+    FrameLimiter frame_limiter;
+
 private:
     /**
      * Initialize the emulated system.
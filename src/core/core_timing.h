@@ -94,6 +94,10 @@ void UnregisterAllEvents();
  */
 void ScheduleEvent(s64 cycles_into_future, int event_type, u64 userdata = 0);
 
+/**
+ * Schedules an event from any thread. The event is moved into the CPU thread's queue on the next
+ * Advance; scheduling never blocks on other threads.
+ */
 void ScheduleEvent_Threadsafe(s64 cycles_into_future, int event_type, u64 userdata = 0);
 void ScheduleEvent_Threadsafe_Immediate(int event_type, u64 userdata = 0);
 
@@ -105,6 +109,8 @@ void ScheduleEvent_Threadsafe_Immediate(int event_type, u64 userdata = 0);
  */
 s64 UnscheduleEvent(int event_type, u64 userdata);
 
+/// Unschedules events scheduled with ScheduleEvent_Threadsafe that have not been moved yet.
+/// This must be run ONLY from within the cpu thread.
 s64 UnscheduleThreadsafeEvent(int event_type, u64 userdata);
 
 void RemoveEvent(int event_type);
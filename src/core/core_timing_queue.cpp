@@ -0,0 +1,192 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <utility>
+#include "common/assert.h"
+#include "core/core_timing_queue.h"
+
+namespace CoreTiming {
+
+constexpr u32 EventQueue::INVALID_SLOT;
+
+bool EventQueue::FiresBefore(u32 a, u32 b) const {
+    const Slot& slot_a = slots[a];
+    const Slot& slot_b = slots[b];
+    if (slot_a.event.time != slot_b.event.time)
+        return slot_a.event.time < slot_b.event.time;
+    return slot_a.order < slot_b.order;
+}
+
+void EventQueue::Swap(size_t a, size_t b) {
+    std::swap(heap[a], heap[b]);
+    slots[heap[a]].heap_index = a;
+    slots[heap[b]].heap_index = b;
+}
+
+void EventQueue::SiftUp(size_t index) {
+    while (index > 0) {
+        const size_t parent = (index - 1) / 2;
+        if (!FiresBefore(heap[index], heap[parent]))
+            break;
+        Swap(index, parent);
+        index = parent;
+    }
+}
+
+void EventQueue::SiftDown(size_t index) {
+    for (;;) {
+        const size_t left = 2 * index + 1;
+        const size_t right = left + 1;
+        size_t smallest = index;
+        if (left < heap.size() && FiresBefore(heap[left], heap[smallest]))
+            smallest = left;
+        if (right < heap.size() && FiresBefore(heap[right], heap[smallest]))
+            smallest = right;
+        if (smallest == index)
+            break;
+        Swap(index, smallest);
+        index = smallest;
+    }
+}
+
+size_t EventQueue::BucketIndex(int type, u64 userdata) const {
+    const u64 key = userdata ^ (static_cast<u64>(static_cast<u32>(type)) << 32);
+    return static_cast<size_t>((key * 0x9E3779B97F4A7C15) >> 32) & (buckets.size() - 1);
+}
+
+u32 EventQueue::FindSlot(int type, u64 userdata) const {
+    if (buckets.empty())
+        return INVALID_SLOT;
+
+    u32 slot = buckets[BucketIndex(type, userdata)];
+    while (slot != INVALID_SLOT) {
+        const Event& event = slots[slot].event;
+        if (event.type == type && event.userdata == userdata)
+            break;
+        slot = slots[slot].next_in_bucket;
+    }
+    return slot;
+}
+
+void EventQueue::LinkSlot(u32 slot) {
+    const Event& event = slots[slot].event;
+    u32& head = buckets[BucketIndex(event.type, event.userdata)];
+    slots[slot].next_in_bucket = head;
+    head = slot;
+}
+
+void EventQueue::UnlinkSlot(u32 slot) {
+    const Event& event = slots[slot].event;
+    u32* link = &buckets[BucketIndex(event.type, event.userdata)];
+    while (*link != slot)
+        link = &slots[*link].next_in_bucket;
+    *link = slots[slot].next_in_bucket;
+}
+
+void EventQueue::Rehash() {
+    size_t size = std::max<size_t>(buckets.size(), 16);
+    while (size < slots.size())
+        size *= 2;
+    buckets.assign(size, INVALID_SLOT);
+    for (u32 slot : heap)
+        LinkSlot(slot);
+}
+
+void EventQueue::Push(s64 time, int type, u64 userdata) {
+    u32 slot;
+    if (free_slots.empty()) {
+        slot = static_cast<u32>(slots.size());
+        slots.emplace_back();
+        if (slots.size() > buckets.size())
+            Rehash();
+    } else {
+        slot = free_slots.back();
+        free_slots.pop_back();
+    }
+
+    slots[slot].event = {time, userdata, type};
+    slots[slot].order = next_order++;
+    slots[slot].heap_index = heap.size();
+    heap.push_back(slot);
+    SiftUp(heap.size() - 1);
+
+    LinkSlot(slot);
+}
+
+void EventQueue::RemoveSlot(u32 slot) {
+    UnlinkSlot(slot);
+
+    // Move the last heap entry into the vacated position and restore the heap property
+    const size_t index = slots[slot].heap_index;
+    const size_t last = heap.size() - 1;
+    if (index != last) {
+        Swap(index, last);
+        heap.pop_back();
+        SiftDown(index);
+        SiftUp(index);
+    } else {
+        heap.pop_back();
+    }
+
+    free_slots.push_back(slot);
+}
+
+void EventQueue::Pop() {
+    ASSERT(!heap.empty());
+    RemoveSlot(heap.front());
+}
+
+bool EventQueue::Remove(int type, u64 userdata, s64& last_time) {
+    u32 slot = FindSlot(type, userdata);
+    if (slot == INVALID_SLOT)
+        return false;
+
+    // Events scheduled for the same time fire in push order, so the event firing last is one of
+    // those with the latest time
+    last_time = slots[slot].event.time;
+    do {
+        last_time = std::max(last_time, slots[slot].event.time);
+        RemoveSlot(slot);
+        slot = FindSlot(type, userdata);
+    } while (slot != INVALID_SLOT);
+    return true;
+}
+
+void EventQueue::RemoveType(int type) {
+    std::vector<u32> removed;
+    for (u32 slot : heap) {
+        if (slots[slot].event.type == type)
+            removed.push_back(slot);
+    }
+
+    for (u32 slot : removed)
+        RemoveSlot(slot);
+}
+
+bool EventQueue::ContainsType(int type) const {
+    return std::any_of(heap.begin(), heap.end(),
+                       [this, type](u32 slot) { return slots[slot].event.type == type; });
+}
+
+void EventQueue::Clear() {
+    slots.clear();
+    free_slots.clear();
+    heap.clear();
+    std::fill(buckets.begin(), buckets.end(), INVALID_SLOT);
+}
+
+std::vector<EventQueue::Event> EventQueue::GetSortedEvents() const {
+    std::vector<u32> sorted_slots = heap;
+    std::sort(sorted_slots.begin(), sorted_slots.end(),
+              [this](u32 a, u32 b) { return FiresBefore(a, b); });
+
+    std::vector<Event> events;
+    events.reserve(sorted_slots.size());
+    for (u32 slot : sorted_slots)
+        events.push_back(slots[slot].event);
+    return events;
+}
+
+} // namespace CoreTiming
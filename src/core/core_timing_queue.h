@@ -0,0 +1,110 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+#include "common/common_types.h"
+
+namespace CoreTiming {
+
+/**
+ * Priority queue of scheduled CoreTiming events, implemented as a binary min-heap.
+ *
+ * Events fire in order of their time; events scheduled for the same time fire in the order they
+ * were pushed. Insertion and removal of the next event take O(log n), and events can be looked up
+ * by their (type, userdata) pair in O(1) for cancellation. The lookup table is chained through the
+ * event slots themselves, so once the queue has grown to its working size, scheduling and
+ * cancelling events doesn't allocate memory.
+ */
+class EventQueue {
+public:
+    struct Event {
+        s64 time;
+        u64 userdata;
+        int type;
+    };
+
+    bool Empty() const {
+        return heap.empty();
+    }
+
+    size_t Size() const {
+        return heap.size();
+    }
+
+    /// Returns the event that fires next. The queue must not be empty.
+    const Event& Top() const {
+        return slots[heap.front()].event;
+    }
+
+    /// Schedules an event of the given type to fire at the given time
+    void Push(s64 time, int type, u64 userdata);
+
+    /// Removes the event returned by Top(). The queue must not be empty.
+    void Pop();
+
+    /**
+     * Removes all events with the given type and userdata.
+     * @param last_time Set to the time of the removed event that would have fired last
+     * @returns True if any event was removed
+     */
+    bool Remove(int type, u64 userdata, s64& last_time);
+
+    /// Removes all events of the given type
+    void RemoveType(int type);
+
+    /// Returns true if any event of the given type is scheduled
+    bool ContainsType(int type) const;
+
+    /// Removes all events
+    void Clear();
+
+    /// Returns all scheduled events in the order they will fire
+    std::vector<Event> GetSortedEvents() const;
+
+private:
+    static constexpr u32 INVALID_SLOT = 0xFFFFFFFF;
+
+    struct Slot {
+        Event event;
+        /// Push counter value, used to fire events scheduled for the same time in FIFO order
+        u64 order;
+        /// Position of this slot in the heap
+        size_t heap_index;
+        /// Next slot in the same lookup bucket, or INVALID_SLOT
+        u32 next_in_bucket;
+    };
+
+    bool FiresBefore(u32 a, u32 b) const;
+    void SiftUp(size_t index);
+    void SiftDown(size_t index);
+    void Swap(size_t a, size_t b);
+
+    size_t BucketIndex(int type, u64 userdata) const;
+    /// Returns a slot holding an event with the given type and userdata, or INVALID_SLOT
+    u32 FindSlot(int type, u64 userdata) const;
+    void LinkSlot(u32 slot);
+    void UnlinkSlot(u32 slot);
+    /// Grows the lookup table to at least the number of slots and relinks the scheduled events
+    void Rehash();
+
+    /// Removes the slot from the heap and the lookup table and frees it
+    void RemoveSlot(u32 slot);
+
+    /// Event storage, indexed by the values in `heap`
+    std::vector<Slot> slots;
+    std::vector<u32> free_slots;
+
+    /// Indices into `slots`, ordered as a binary min-heap by (time, order)
+    std::vector<u32> heap;
+
+    /// First slot of each lookup chain, by hash of (type, userdata). The size is a power of two.
+    std::vector<u32> buckets;
+
+    u64 next_order = 0;
+};
+
+} // namespace CoreTiming
@@ -10,6 +10,7 @@
 #include <boost/container/flat_map.hpp>
 #include <boost/container/flat_set.hpp>
 #include "common/common_types.h"
+#include "common/thread_queue_list.h"
 #include "core/arm/arm_interface.h"
 #include "core/core.h"
 #include "core/hle/kernel/kernel.h"
@@ -177,6 +178,9 @@ public:
     s32 nominal_priority; ///< Nominal thread priority, as set by the emulated application
     s32 current_priority; ///< Current thread priority, can be temporarily changed
 
+    /// Links of this thread in the scheduler's ready queue
+    Common::ThreadQueueListNode<Thread> ready_queue_node;
+
     u64 last_running_ticks; ///< CPU tick when thread was last running
 
     s32 processor_id;
@@ -8,11 +8,9 @@
 #include "common/color.h"
 #include "common/common_types.h"
 #include "common/logging/log.h"
-#include "common/math_util.h"
 #include "common/microprofile.h"
-#include "common/thread.h"
-#include "common/timer.h"
 #include "common/vector_math.h"
+#include "core/core.h"
 #include "core/core_timing.h"
 #include "core/hle/service/gsp_gpu.h"
 #include "core/hw/gpu.h"
@@ -22,6 +20,7 @@
 #include "core/tracer/recorder.h"
 #include "video_core/command_processor.h"
 #include "video_core/debug_utils/debug_utils.h"
+#include "video_core/morton.h"
 #include "video_core/rasterizer_interface.h"
 #include "video_core/renderer_base.h"
 #include "video_core/utils.h"
@@ -37,14 +36,6 @@ const u64 frame_ticks = BASE_CLOCK_RATE_ARM11 / 60;
 static int vblank_event;
 /// Total number of frames drawn
 static u64 frame_count;
-/// Start clock for frame limiter
-static u32 time_point;
-/// Total delay caused by slow frames
-static float time_delay;
-constexpr float FIXED_FRAME_TIME = 1000.0f / 60;
-// Max lag caused by slow frames. Can be adjusted to compensate for too many slow frames. Higher
-// values increases time needed to limit frame rate after spikes
-constexpr float MAX_LAG_TIME = 18;
 
 template <typename T>
 inline void Read(T& var, const u32 raw_addr) {
@@ -214,6 +205,24 @@ static void DisplayTransfer(const Regs::DisplayTransferConfig& config) {
     Memory::RasterizerFlushRegion(config.GetPhysicalInputAddress(), input_size);
     Memory::RasterizerFlushAndInvalidateRegion(config.GetPhysicalOutputAddress(), output_size);
 
+    if (config.input_format == config.output_format && config.scaling == config.NoScale &&
+        !config.dont_swizzle && (config.input_linear || config.input_width == output_width)) {
+        // Plain tiling or untiling, which can be done a tile at a time without decoding pixels
+        const u32 bytes_per_pixel = GPU::Regs::BytesPerPixel(config.input_format);
+        u8* linear = config.input_linear ? src_pointer : dst_pointer;
+        u8* tiled = config.input_linear ? dst_pointer : src_pointer;
+        ptrdiff_t linear_stride =
+            (config.input_linear ? config.input_width.Value() : output_width) * bytes_per_pixel;
+        if (config.flip_vertically) {
+            linear += (output_height - 1) * linear_stride;
+            linear_stride = -linear_stride;
+        }
+
+        VideoCore::MortonCopy(bytes_per_pixel, output_width, output_height, tiled, linear,
+                              linear_stride, !config.input_linear);
+        return;
+    }
+
     for (u32 y = 0; y < output_height; ++y) {
         for (u32 x = 0; x < output_width; ++x) {
             Math::Vec4<u8> src_color;
@@ -522,25 +531,14 @@ template void Write<u32>(u32 addr, const u32 data);
 template void Write<u16>(u32 addr, const u16 data);
 template void Write<u8>(u32 addr, const u8 data);
 
-static void FrameLimiter() {
-    time_delay += FIXED_FRAME_TIME;
-    time_delay = MathUtil::Clamp(time_delay, -MAX_LAG_TIME, MAX_LAG_TIME);
-    s32 desired_time = static_cast<s32>(time_delay);
-    s32 elapsed_time = static_cast<s32>(Common::Timer::GetTimeMs() - time_point);
-
-    if (elapsed_time < desired_time) {
-        Common::SleepCurrentThread(desired_time - elapsed_time);
-    }
-
-    u32 frame_time = Common::Timer::GetTimeMs() - time_point;
-
-    time_delay -= frame_time;
-}
-
 /// Update hardware
 static void VBlankCallback(u64 userdata, int cycles_late) {
+    auto& system = Core::System::GetInstance();
+    system.perf_stats.EndStage(Core::PerfStats::Stage::Emulation);
+
     frame_count++;
     VideoCore::g_renderer->SwapBuffers();
+    system.perf_stats.EndStage(Core::PerfStats::Stage::Present);
 
     // Signal to GSP that GPU interrupt has occurred
     // TODO(yuriks): hwtest to determine if PDC0 is for the Top screen and PDC1 for the Sub
@@ -550,11 +548,13 @@ static void VBlankCallback(u64 userdata, int cycles_late) {
     Service::GSP::SignalInterrupt(Service::GSP::InterruptId::PDC0);
     Service::GSP::SignalInterrupt(Service::GSP::InterruptId::PDC1);
 
+    // A speed of 0 disables the limiter and lets it start over once it is enabled again
+    double speed = 0.0;
     if (!Settings::values.use_vsync && Settings::values.toggle_framelimit) {
-        FrameLimiter();
+        speed = Settings::values.frame_limit / 100.0;
     }
-
-    time_point = Common::Timer::GetTimeMs();
+    system.frame_limiter.DoFrameLimiting(speed);
+    system.perf_stats.EndStage(Core::PerfStats::Stage::Wait);
 
     // Reschedule recurrent event
     CoreTiming::ScheduleEvent(frame_ticks - cycles_late, vblank_event);
@@ -591,7 +591,6 @@ void Init() {
     framebuffer_sub.active_fb = 0;
 
     frame_count = 0;
-    time_point = Common::Timer::GetTimeMs();
 
     vblank_event = CoreTiming::RegisterEvent("GPU::VBlankCallback", VBlankCallback);
     CoreTiming::ScheduleEvent(frame_ticks, vblank_event);
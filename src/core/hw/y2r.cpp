@@ -5,15 +5,25 @@
 #include <algorithm>
 #include <array>
 #include <cstddef>
+#include <cstring>
 #include <memory>
+#include <thread>
+#include <vector>
+#include "common/alignment.h"
 #include "common/assert.h"
 #include "common/color.h"
 #include "common/common_types.h"
 #include "common/math_util.h"
+#include "common/thread_pool.h"
 #include "common/vector_math.h"
 #include "core/hle/service/y2r_u.h"
 #include "core/hw/y2r.h"
 #include "core/memory.h"
+#include "core/settings.h"
+
+#ifdef ARCHITECTURE_x86_64
+#include <emmintrin.h>
+#endif
 
 namespace HW {
 namespace Y2R {
@@ -24,57 +34,219 @@ static const size_t MAX_TILES = 1024 / 8;
 static const size_t TILE_SIZE = 8 * 8;
 using ImageTile = std::array<u32, TILE_SIZE>;
 
-/// Converts a image strip from the source YUV format into individual 8x8 RGB32 tiles.
-static void ConvertYUVToRGB(InputFormat input_format, const u8* input_Y, const u8* input_U,
-                            const u8* input_V, ImageTile output[], unsigned int width,
-                            unsigned int height, const CoefficientSet& coefficients) {
+/// Maximum number of strips received before they are converted and sent together
+static const size_t MAX_STRIPS_PER_BATCH = 16;
+
+/// Pool converting the strips of a batch in parallel, sized after Settings::values.y2r_threads
+static std::unique_ptr<Common::ThreadPool> thread_pool;
+
+// Buffers reused across conversions, see PerformConversion
+static std::vector<u8> input_buffer;
+static std::vector<u8> output_buffer;
+static std::vector<u32> rgb_buffer;
+static std::vector<ImageTile> tile_buffer;
+
+/// Reads the YUV components of the pixel at (x, y) in a strip.
+template <InputFormat input_format>
+static void ReadYUV(const u8* input_Y, const u8* input_U, const u8* input_V, unsigned int width,
+                    unsigned int x, unsigned int y, s32& Y, s32& U, s32& V) {
+    switch (input_format) {
+    case InputFormat::YUV422_Indiv8:
+    case InputFormat::YUV422_Indiv16:
+        Y = input_Y[y * width + x];
+        U = input_U[(y * width + x) / 2];
+        V = input_V[(y * width + x) / 2];
+        break;
+    case InputFormat::YUV420_Indiv8:
+    case InputFormat::YUV420_Indiv16:
+        Y = input_Y[y * width + x];
+        U = input_U[((y / 2) * width + x) / 2];
+        V = input_V[((y / 2) * width + x) / 2];
+        break;
+    case InputFormat::YUYV422_Interleaved:
+        Y = input_Y[(y * width + x) * 2];
+        U = input_Y[(y * width + (x / 2) * 2) * 2 + 1];
+        V = input_Y[(y * width + (x / 2) * 2) * 2 + 3];
+        break;
+    }
+}
 
-    for (unsigned int y = 0; y < height; ++y) {
-        for (unsigned int x = 0; x < width; ++x) {
-            s32 Y = 0;
-            s32 U = 0;
-            s32 V = 0;
-            switch (input_format) {
-            case InputFormat::YUV422_Indiv8:
-            case InputFormat::YUV422_Indiv16:
-                Y = input_Y[y * width + x];
-                U = input_U[(y * width + x) / 2];
-                V = input_V[(y * width + x) / 2];
-                break;
-            case InputFormat::YUV420_Indiv8:
-            case InputFormat::YUV420_Indiv16:
-                Y = input_Y[y * width + x];
-                U = input_U[((y / 2) * width + x) / 2];
-                V = input_V[((y / 2) * width + x) / 2];
-                break;
-            case InputFormat::YUYV422_Interleaved:
-                Y = input_Y[(y * width + x) * 2];
-                U = input_Y[(y * width + (x / 2) * 2) * 2 + 1];
-                V = input_Y[(y * width + (x / 2) * 2) * 2 + 3];
-                break;
-            }
+#ifdef ARCHITECTURE_x86_64
+
+/// Conversion coefficients laid out for use with _mm_madd_epi16
+struct VectorCoefficients {
+    explicit VectorCoefficients(const CoefficientSet& c)
+        : y_v_for_r(_mm_set_epi16(c[1], c[0], c[1], c[0], c[1], c[0], c[1], c[0])),
+          y_u_for_b(_mm_set_epi16(c[4], c[0], c[4], c[0], c[4], c[0], c[4], c[0])),
+          y_only(_mm_set_epi16(0, c[0], 0, c[0], 0, c[0], 0, c[0])),
+          v_u_for_g(_mm_set_epi16(c[3], c[2], c[3], c[2], c[3], c[2], c[3], c[2])),
+          offset_r(_mm_set1_epi32(c[5] + 0x18)), offset_g(_mm_set1_epi32(c[6] + 0x18)),
+          offset_b(_mm_set1_epi32(c[7] + 0x18)) {}
+
+    __m128i y_v_for_r;
+    __m128i y_u_for_b;
+    __m128i y_only;
+    __m128i v_u_for_g;
+    __m128i offset_r;
+    __m128i offset_g;
+    __m128i offset_b;
+};
+
+/// Zero-extends 8 bytes into 16-bit lanes
+static __m128i LoadBytes8(const u8* bytes) {
+    return _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(bytes)),
+                             _mm_setzero_si128());
+}
+
+/// Zero-extends 4 bytes into 16-bit lanes, each of them repeated twice
+static __m128i LoadChroma4(const u8* bytes) {
+    u32 chroma;
+    std::memcpy(&chroma, bytes, sizeof(chroma));
+    const __m128i chroma8 = _mm_cvtsi32_si128(static_cast<int>(chroma));
+    return _mm_unpacklo_epi8(_mm_unpacklo_epi8(chroma8, chroma8), _mm_setzero_si128());
+}
+
+/// Reads the YUV components of the 8 pixels starting at (x, y) into 16-bit lanes.
+template <InputFormat input_format>
+static void ReadYUV8(const u8* input_Y, const u8* input_U, const u8* input_V, unsigned int width,
+                     unsigned int x, unsigned int y, __m128i& Y, __m128i& U, __m128i& V) {
+    switch (input_format) {
+    case InputFormat::YUV422_Indiv8:
+    case InputFormat::YUV422_Indiv16:
+        Y = LoadBytes8(&input_Y[y * width + x]);
+        U = LoadChroma4(&input_U[(y * width + x) / 2]);
+        V = LoadChroma4(&input_V[(y * width + x) / 2]);
+        break;
+    case InputFormat::YUV420_Indiv8:
+    case InputFormat::YUV420_Indiv16:
+        Y = LoadBytes8(&input_Y[y * width + x]);
+        U = LoadChroma4(&input_U[((y / 2) * width + x) / 2]);
+        V = LoadChroma4(&input_V[((y / 2) * width + x) / 2]);
+        break;
+    case InputFormat::YUYV422_Interleaved: {
+        // Y0 U0 Y1 V0 Y2 U1 Y3 V1 ...
+        const __m128i yuyv =
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(&input_Y[(y * width + x) * 2]));
+        const __m128i uv = _mm_srli_epi16(yuyv, 8);
+        Y = _mm_and_si128(yuyv, _mm_set1_epi16(0xFF));
+        U = _mm_shufflehi_epi16(_mm_shufflelo_epi16(uv, _MM_SHUFFLE(2, 2, 0, 0)),
+                                _MM_SHUFFLE(2, 2, 0, 0));
+        V = _mm_shufflehi_epi16(_mm_shufflelo_epi16(uv, _MM_SHUFFLE(3, 3, 1, 1)),
+                                _MM_SHUFFLE(3, 3, 1, 1));
+        break;
+    }
+    }
+}
 
-            // This conversion process is bit-exact with hardware, as far as could be tested.
-            auto& c = coefficients;
-            s32 cY = c[0] * Y;
+/// Finishes the conversion of a colour channel of 4 pixels, see ConvertYUVToRGB.
+static __m128i ScaleChannel(__m128i value, __m128i offset) {
+    return _mm_srai_epi32(_mm_add_epi32(_mm_srai_epi32(value, 3), offset), 5);
+}
 
-            s32 r = cY + c[1] * V;
-            s32 g = cY - c[2] * V - c[3] * U;
-            s32 b = cY + c[4] * U;
+/// Converts 8 pixels, writing them as RGB32. Bit-exact with the scalar conversion.
+template <InputFormat input_format>
+static void ConvertPixels8(const u8* input_Y, const u8* input_U, const u8* input_V,
+                           unsigned int width, unsigned int x, unsigned int y,
+                           const VectorCoefficients& c, u32* out) {
+    __m128i Y, U, V;
+    ReadYUV8<input_format>(input_Y, input_U, input_V, width, x, y, Y, U, V);
+
+    // Each half holds 4 pixels as 32-bit lanes
+    __m128i channels[3][2];
+    for (int half = 0; half < 2; ++half) {
+        const __m128i yv = half == 0 ? _mm_unpacklo_epi16(Y, V) : _mm_unpackhi_epi16(Y, V);
+        const __m128i yu = half == 0 ? _mm_unpacklo_epi16(Y, U) : _mm_unpackhi_epi16(Y, U);
+        const __m128i vu = half == 0 ? _mm_unpacklo_epi16(V, U) : _mm_unpackhi_epi16(V, U);
+
+        const __m128i r = _mm_madd_epi16(yv, c.y_v_for_r);
+        const __m128i g =
+            _mm_sub_epi32(_mm_madd_epi16(yv, c.y_only), _mm_madd_epi16(vu, c.v_u_for_g));
+        const __m128i b = _mm_madd_epi16(yu, c.y_u_for_b);
+
+        channels[0][half] = ScaleChannel(r, c.offset_r);
+        channels[1][half] = ScaleChannel(g, c.offset_g);
+        channels[2][half] = ScaleChannel(b, c.offset_b);
+    }
 
-            const s32 rounding_offset = 0x18;
-            r = (r >> 3) + c[5] + rounding_offset;
-            g = (g >> 3) + c[6] + rounding_offset;
-            b = (b >> 3) + c[7] + rounding_offset;
+    // Saturating to 16 and then 8 bits clamps to [0, 0xFF] like the scalar code
+    const auto pack = [](const __m128i(&channel)[2]) {
+        const __m128i words = _mm_packs_epi32(channel[0], channel[1]);
+        return _mm_packus_epi16(words, words);
+    };
+    const __m128i r = pack(channels[0]);
+    const __m128i g = pack(channels[1]);
+    const __m128i b = pack(channels[2]);
+
+    const __m128i zero_b = _mm_unpacklo_epi8(_mm_setzero_si128(), b);
+    const __m128i g_r = _mm_unpacklo_epi8(g, r);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm_unpacklo_epi16(zero_b, g_r));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 4), _mm_unpackhi_epi16(zero_b, g_r));
+}
 
-            unsigned int tile = x / 8;
-            unsigned int tile_x = x % 8;
-            u32* out = &output[tile][y * 8 + tile_x];
+#endif // ARCHITECTURE_x86_64
 
-            using MathUtil::Clamp;
-            *out = ((u32)Clamp(r >> 5, 0, 0xFF) << 24) | ((u32)Clamp(g >> 5, 0, 0xFF) << 16) |
-                   ((u32)Clamp(b >> 5, 0, 0xFF) << 8);
-        }
+/**
+ * Converts a line of a strip from the source YUV format to RGB32, a 0xRRGGBB00 word per pixel.
+ * @param output Receives `width` pixels, or 8 pixels every `tile_stride` words if not 8
+ */
+template <InputFormat input_format>
+static void ConvertLineToRGB(const u8* input_Y, const u8* input_U, const u8* input_V,
+                             unsigned int width, unsigned int y,
+                             const CoefficientSet& coefficients, u32* output,
+                             size_t tile_stride) {
+#ifdef ARCHITECTURE_x86_64
+    const VectorCoefficients vector_coefficients(coefficients);
+    for (unsigned int x = 0; x < width; x += 8) {
+        ConvertPixels8<input_format>(input_Y, input_U, input_V, width, x, y, vector_coefficients,
+                                     output + (x / 8) * tile_stride);
+    }
+#else
+    for (unsigned int x = 0; x < width; ++x) {
+        s32 Y = 0;
+        s32 U = 0;
+        s32 V = 0;
+        ReadYUV<input_format>(input_Y, input_U, input_V, width, x, y, Y, U, V);
+
+        // This conversion process is bit-exact with hardware, as far as could be tested.
+        auto& c = coefficients;
+        s32 cY = c[0] * Y;
+
+        s32 r = cY + c[1] * V;
+        s32 g = cY - c[2] * V - c[3] * U;
+        s32 b = cY + c[4] * U;
+
+        const s32 rounding_offset = 0x18;
+        r = (r >> 3) + c[5] + rounding_offset;
+        g = (g >> 3) + c[6] + rounding_offset;
+        b = (b >> 3) + c[7] + rounding_offset;
+
+        using MathUtil::Clamp;
+        output[(x / 8) * tile_stride + x % 8] = ((u32)Clamp(r >> 5, 0, 0xFF) << 24) |
+                                                ((u32)Clamp(g >> 5, 0, 0xFF) << 16) |
+                                                ((u32)Clamp(b >> 5, 0, 0xFF) << 8);
+    }
+#endif
+}
+
+/// Converts a image strip from the source YUV format into individual 8x8 RGB32 tiles.
+template <InputFormat input_format>
+static void ConvertYUVToRGB(const u8* input_Y, const u8* input_U, const u8* input_V,
+                            ImageTile output[], unsigned int width, unsigned int height,
+                            const CoefficientSet& coefficients) {
+    for (unsigned int y = 0; y < height; ++y) {
+        ConvertLineToRGB<input_format>(input_Y, input_U, input_V, width, y, coefficients,
+                                       &output[0][y * 8], TILE_SIZE);
+    }
+}
+
+/// Converts a image strip from the source YUV format into linear RGB32 lines.
+template <InputFormat input_format>
+static void ConvertYUVToLinearRGB(const u8* input_Y, const u8* input_U, const u8* input_V,
+                                  u32* output, unsigned int width, unsigned int height,
+                                  const CoefficientSet& coefficients) {
+    for (unsigned int y = 0; y < height; ++y) {
+        ConvertLineToRGB<input_format>(input_Y, input_U, input_V, width, y, coefficients,
+                                       output + y * width, 8);
     }
 }
 
@@ -88,8 +260,12 @@ static void ReceiveData(u8* output, ConversionBuffer& buf, size_t amount_of_data
     ASSERT(amount_of_data % output_unit == 0);
 
     while (amount_of_data > 0) {
-        for (size_t i = 0; i < output_unit; ++i) {
-            output[i] = input[i * N];
+        if (N == 1) {
+            std::memcpy(output, input, output_unit);
+        } else {
+            for (size_t i = 0; i < output_unit; ++i) {
+                output[i] = input[i * N];
+            }
         }
 
         output += output_unit;
@@ -101,44 +277,107 @@ static void ReceiveData(u8* output, ConversionBuffer& buf, size_t amount_of_data
     }
 }
 
-/// Convert intermediate RGB32 format to the final output format while simulating an outgoing CDMA
-/// transfer.
-static void SendData(const u32* input, ConversionBuffer& buf, int amount_of_data,
-                     OutputFormat output_format, u8 alpha) {
+/// Encodes RGB32 pixels to the output format.
+template <OutputFormat output_format>
+static void EncodePixels(const u32* input, u8* output, size_t num_pixels, u8 alpha) {
+    size_t i = 0;
+#ifdef ARCHITECTURE_x86_64
+    if (output_format != OutputFormat::RGB8) {
+        const __m128i alpha_vector = _mm_set1_epi32(alpha);
+        for (; i + 8 <= num_pixels; i += 8) {
+            __m128i colors[2];
+            for (int half = 0; half < 2; ++half) {
+                const __m128i color =
+                    _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i + half * 4));
+                const __m128i r = _mm_srli_epi32(color, 24);
+                const __m128i g = _mm_and_si128(_mm_srli_epi32(color, 16), _mm_set1_epi32(0xFF));
+                const __m128i b = _mm_and_si128(_mm_srli_epi32(color, 8), _mm_set1_epi32(0xFF));
+                switch (output_format) {
+                case OutputFormat::RGBA8:
+                    colors[half] = _mm_or_si128(color, alpha_vector);
+                    break;
+                case OutputFormat::RGB5A1:
+                    colors[half] = _mm_or_si128(
+                        _mm_or_si128(_mm_slli_epi32(_mm_srli_epi32(r, 3), 11),
+                                     _mm_slli_epi32(_mm_srli_epi32(g, 3), 6)),
+                        _mm_or_si128(_mm_slli_epi32(_mm_srli_epi32(b, 3), 1),
+                                     _mm_srli_epi32(alpha_vector, 7)));
+                    break;
+                case OutputFormat::RGB565:
+                    colors[half] = _mm_or_si128(
+                        _mm_or_si128(_mm_slli_epi32(_mm_srli_epi32(r, 3), 11),
+                                     _mm_slli_epi32(_mm_srli_epi32(g, 2), 5)),
+                        _mm_srli_epi32(b, 3));
+                    break;
+                default:
+                    UNREACHABLE();
+                }
+            }
+
+            if (output_format == OutputFormat::RGBA8) {
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(output + i * 4), colors[0]);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(output + i * 4 + 16), colors[1]);
+            } else {
+                // Sign-extend the 16-bit values so that packing doesn't saturate them
+                const auto sign_extend = [](__m128i v) {
+                    return _mm_srai_epi32(_mm_slli_epi32(v, 16), 16);
+                };
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(output + i * 2),
+                                 _mm_packs_epi32(sign_extend(colors[0]), sign_extend(colors[1])));
+            }
+        }
+    }
+#endif
+
+    for (; i < num_pixels; ++i) {
+        u32 color = input[i];
+        Math::Vec4<u8> col_vec{(u8)(color >> 24), (u8)(color >> 16), (u8)(color >> 8), alpha};
+
+        switch (output_format) {
+        case OutputFormat::RGBA8:
+            Color::EncodeRGBA8(col_vec, output + i * 4);
+            break;
+        case OutputFormat::RGB8:
+            Color::EncodeRGB8(col_vec, output + i * 3);
+            break;
+        case OutputFormat::RGB5A1:
+            Color::EncodeRGB5A1(col_vec, output + i * 2);
+            break;
+        case OutputFormat::RGB565:
+            Color::EncodeRGB565(col_vec, output + i * 2);
+            break;
+        }
+    }
+}
+
+static size_t GetOutputBytesPerPixel(OutputFormat output_format) {
+    switch (output_format) {
+    case OutputFormat::RGBA8:
+        return 4;
+    case OutputFormat::RGB8:
+        return 3;
+    case OutputFormat::RGB5A1:
+    case OutputFormat::RGB565:
+        return 2;
+    }
+    UNREACHABLE();
+}
 
+/// Simulates an outgoing CDMA transfer of data already converted to the output format. Whole
+/// transfer units are always sent, so `input` must be padded to a multiple of the unit size.
+static void SendData(const u8* input, ConversionBuffer& buf, size_t amount_of_data) {
+    ASSERT(buf.transfer_unit != 0);
     u8* output = Memory::GetPointer(buf.address);
 
     while (amount_of_data > 0) {
-        u8* unit_end = output + buf.transfer_unit;
-        while (output < unit_end) {
-            u32 color = *input++;
-            Math::Vec4<u8> col_vec{(u8)(color >> 24), (u8)(color >> 16), (u8)(color >> 8), alpha};
-
-            switch (output_format) {
-            case OutputFormat::RGBA8:
-                Color::EncodeRGBA8(col_vec, output);
-                output += 4;
-                break;
-            case OutputFormat::RGB8:
-                Color::EncodeRGB8(col_vec, output);
-                output += 3;
-                break;
-            case OutputFormat::RGB5A1:
-                Color::EncodeRGB5A1(col_vec, output);
-                output += 2;
-                break;
-            case OutputFormat::RGB565:
-                Color::EncodeRGB565(col_vec, output);
-                output += 2;
-                break;
-            }
+        std::memcpy(output, input, buf.transfer_unit);
 
-            amount_of_data -= 1;
-        }
+        input += buf.transfer_unit;
+        output += buf.transfer_unit + buf.gap;
 
-        output += buf.gap;
         buf.address += buf.transfer_unit + buf.gap;
         buf.image_size -= buf.transfer_unit;
+        amount_of_data -= std::min<size_t>(amount_of_data, buf.transfer_unit);
     }
 }
 
@@ -211,6 +450,183 @@ static void WriteTileToOutput(u32* output, const ImageTile& tile, int height, in
     }
 }
 
+/// Data of a strip that has been received and is waiting for conversion
+struct Strip {
+    const u8* input_Y;
+    const u8* input_U;
+    const u8* input_V;
+    unsigned int height;
+};
+
+/**
+ * Converts a strip to RGB32, rotating it and arranging it in the output order.
+ * @param tiles Scratch space for the tiles of the strip
+ */
+template <InputFormat input_format>
+static void ConvertStrip(const ConversionConfiguration& cvt, const Strip& strip, u32* output,
+                         ImageTile tiles[]) {
+    const unsigned int width = cvt.input_line_width;
+    const unsigned int row_height = strip.height;
+
+    if (cvt.rotation == Rotation::None && cvt.block_alignment == BlockAlignment::Linear) {
+        // The tiles would be written back out line by line, so skip them
+        ConvertYUVToLinearRGB<input_format>(strip.input_Y, strip.input_U, strip.input_V, output,
+                                            width, row_height, cvt.coefficients);
+        return;
+    }
+
+    ConvertYUVToRGB<input_format>(strip.input_Y, strip.input_U, strip.input_V, tiles, width,
+                                  row_height, cvt.coefficients);
+
+    // LUT used to remap writes to a tile. Used to allow linear or swizzled output without
+    // requiring two different code paths.
+    const u8* tile_remap = nullptr;
+    switch (cvt.block_alignment) {
+    case BlockAlignment::Linear:
+        tile_remap = linear_lut;
+        break;
+    case BlockAlignment::Block8x8:
+        tile_remap = morton_lut;
+        break;
+    }
+
+    const size_t num_tiles = width / 8;
+    ImageTile tmp_tile;
+    for (size_t i = 0; i < num_tiles; ++i) {
+        int image_strip_width = 0;
+        int output_stride = 0;
+
+        switch (cvt.rotation) {
+        case Rotation::None:
+            RotateTile0(tiles[i], tmp_tile, row_height, tile_remap);
+            image_strip_width = width;
+            output_stride = 8;
+            break;
+        case Rotation::Clockwise_90:
+            RotateTile90(tiles[i], tmp_tile, row_height, tile_remap);
+            image_strip_width = 8;
+            output_stride = 8 * row_height;
+            break;
+        case Rotation::Clockwise_180:
+            // For 180 and 270 degree rotations we also invert the order of tiles in the strip,
+            // since the rotates are done individually on each tile.
+            RotateTile180(tiles[num_tiles - i - 1], tmp_tile, row_height, tile_remap);
+            image_strip_width = width;
+            output_stride = 8;
+            break;
+        case Rotation::Clockwise_270:
+            RotateTile270(tiles[num_tiles - i - 1], tmp_tile, row_height, tile_remap);
+            image_strip_width = 8;
+            output_stride = 8 * row_height;
+            break;
+        }
+
+        switch (cvt.block_alignment) {
+        case BlockAlignment::Linear:
+            WriteTileToOutput(output, tmp_tile, row_height, image_strip_width);
+            output += output_stride;
+            break;
+        case BlockAlignment::Block8x8:
+            WriteTileToOutput(output, tmp_tile, 8, 8);
+            output += TILE_SIZE;
+            break;
+        }
+    }
+}
+
+using ConvertStripFunc = void (*)(const ConversionConfiguration&, const Strip&, u32*, ImageTile[]);
+using EncodePixelsFunc = void (*)(const u32*, u8*, size_t, u8);
+
+static ConvertStripFunc GetConvertStripFunc(InputFormat input_format) {
+    switch (input_format) {
+    case InputFormat::YUV422_Indiv8:
+        return ConvertStrip<InputFormat::YUV422_Indiv8>;
+    case InputFormat::YUV420_Indiv8:
+        return ConvertStrip<InputFormat::YUV420_Indiv8>;
+    case InputFormat::YUV422_Indiv16:
+        return ConvertStrip<InputFormat::YUV422_Indiv16>;
+    case InputFormat::YUV420_Indiv16:
+        return ConvertStrip<InputFormat::YUV420_Indiv16>;
+    case InputFormat::YUYV422_Interleaved:
+        return ConvertStrip<InputFormat::YUYV422_Interleaved>;
+    }
+    UNREACHABLE();
+}
+
+static EncodePixelsFunc GetEncodePixelsFunc(OutputFormat output_format) {
+    switch (output_format) {
+    case OutputFormat::RGBA8:
+        return EncodePixels<OutputFormat::RGBA8>;
+    case OutputFormat::RGB8:
+        return EncodePixels<OutputFormat::RGB8>;
+    case OutputFormat::RGB5A1:
+        return EncodePixels<OutputFormat::RGB5A1>;
+    case OutputFormat::RGB565:
+        return EncodePixels<OutputFormat::RGB565>;
+    }
+    UNREACHABLE();
+}
+
+/// Receives the input data of a strip of `row_height` lines into `buffer`.
+static Strip ReceiveStrip(ConversionConfiguration& cvt, u8* buffer, unsigned int row_height) {
+    // Total size in pixels of incoming data required for this strip.
+    const size_t row_data_size = row_height * cvt.input_line_width;
+
+    u8* input_Y = buffer;
+    u8* input_U = input_Y + 8 * cvt.input_line_width;
+    u8* input_V = input_U + 8 * cvt.input_line_width / 2;
+
+    switch (cvt.input_format) {
+    case InputFormat::YUV422_Indiv8:
+        ReceiveData<1>(input_Y, cvt.src_Y, row_data_size);
+        ReceiveData<1>(input_U, cvt.src_U, row_data_size / 2);
+        ReceiveData<1>(input_V, cvt.src_V, row_data_size / 2);
+        break;
+    case InputFormat::YUV420_Indiv8:
+        ReceiveData<1>(input_Y, cvt.src_Y, row_data_size);
+        ReceiveData<1>(input_U, cvt.src_U, row_data_size / 4);
+        ReceiveData<1>(input_V, cvt.src_V, row_data_size / 4);
+        break;
+    case InputFormat::YUV422_Indiv16:
+        ReceiveData<2>(input_Y, cvt.src_Y, row_data_size);
+        ReceiveData<2>(input_U, cvt.src_U, row_data_size / 2);
+        ReceiveData<2>(input_V, cvt.src_V, row_data_size / 2);
+        break;
+    case InputFormat::YUV420_Indiv16:
+        ReceiveData<2>(input_Y, cvt.src_Y, row_data_size);
+        ReceiveData<2>(input_U, cvt.src_U, row_data_size / 4);
+        ReceiveData<2>(input_V, cvt.src_V, row_data_size / 4);
+        break;
+    case InputFormat::YUYV422_Interleaved:
+        input_U = nullptr;
+        input_V = nullptr;
+        ReceiveData<1>(input_Y, cvt.src_YUYV, row_data_size * 2);
+        break;
+    }
+
+    return {input_Y, input_U, input_V, row_height};
+}
+
+/// Returns whether the memory left to transfer from or to two buffers might overlap.
+static bool TransfersOverlap(const ConversionBuffer& a, const ConversionBuffer& b) {
+    if (a.transfer_unit == 0 || b.transfer_unit == 0)
+        return true;
+
+    const auto end = [](const ConversionBuffer& buf) {
+        const u64 num_transfers = buf.image_size / buf.transfer_unit;
+        return u64{buf.address} + buf.image_size + num_transfers * buf.gap;
+    };
+    return a.address < end(b) && b.address < end(a);
+}
+
+/// Returns the number of threads conversions may use, as configured by the user
+static size_t GetNumThreads() {
+    int num_threads = Settings::values.y2r_threads;
+    if (num_threads <= 0)
+        num_threads = static_cast<int>(std::thread::hardware_concurrency());
+    return static_cast<size_t>(std::max(num_threads, 1));
+}
+
 /**
  * Performs a Y2R colorspace conversion.
  *
@@ -247,7 +663,8 @@ static void WriteTileToOutput(u32* output, const ImageTile& tile, int height, in
  * In this implementation, to avoid the combinatorial explosion of parameter combinations, common
  * intermediate formats are used and where possible tables or parameters are used instead of
  * diverging code paths to keep the amount of branches in check. Some steps are also merged to
- * increase efficiency.
+ * increase efficiency. Strips are received in batches, which are then converted in parallel and
+ * sent in order.
  *
  * Output for all valid settings combinations matches hardware, however output in some edge-cases
  * differs:
@@ -264,118 +681,73 @@ static void WriteTileToOutput(u32* output, const ImageTile& tile, int height, in
 void PerformConversion(ConversionConfiguration& cvt) {
     ASSERT(cvt.input_line_width % 8 == 0);
     ASSERT(cvt.block_alignment != BlockAlignment::Block8x8 || cvt.input_lines % 8 == 0);
+    ASSERT(cvt.dst.transfer_unit != 0);
     // Tiles per row
     size_t num_tiles = cvt.input_line_width / 8;
     ASSERT(num_tiles <= MAX_TILES);
 
-    // Buffer used as a CDMA source/target.
-    std::unique_ptr<u8[]> data_buffer(new u8[cvt.input_line_width * 8 * 4]);
-    // Intermediate storage for decoded 8x8 image tiles. Always stored as RGB32.
-    std::unique_ptr<ImageTile[]> tiles(new ImageTile[num_tiles]);
-    ImageTile tmp_tile;
-
-    // LUT used to remap writes to a tile. Used to allow linear or swizzled output without
-    // requiring two different code paths.
-    const u8* tile_remap = nullptr;
-    switch (cvt.block_alignment) {
-    case BlockAlignment::Linear:
-        tile_remap = linear_lut;
-        break;
-    case BlockAlignment::Block8x8:
-        tile_remap = morton_lut;
-        break;
+    const ConvertStripFunc convert_strip = GetConvertStripFunc(cvt.input_format);
+    const EncodePixelsFunc encode_pixels = GetEncodePixelsFunc(cvt.output_format);
+    const size_t bytes_per_pixel = GetOutputBytesPerPixel(cvt.output_format);
+
+    // Strips must be converted one at a time if the output could overwrite input data that hasn't
+    // been received yet.
+    bool output_overlaps_input = false;
+    if (cvt.input_format == InputFormat::YUYV422_Interleaved) {
+        output_overlaps_input = TransfersOverlap(cvt.dst, cvt.src_YUYV);
+    } else {
+        output_overlaps_input = TransfersOverlap(cvt.dst, cvt.src_Y) ||
+                                TransfersOverlap(cvt.dst, cvt.src_U) ||
+                                TransfersOverlap(cvt.dst, cvt.src_V);
     }
-
-    for (unsigned int y = 0; y < cvt.input_lines; y += 8) {
-        unsigned int row_height = std::min(cvt.input_lines - y, 8u);
-
-        // Total size in pixels of incoming data required for this strip.
-        const size_t row_data_size = row_height * cvt.input_line_width;
-
-        u8* input_Y = data_buffer.get();
-        u8* input_U = input_Y + 8 * cvt.input_line_width;
-        u8* input_V = input_U + 8 * cvt.input_line_width / 2;
-
-        switch (cvt.input_format) {
-        case InputFormat::YUV422_Indiv8:
-            ReceiveData<1>(input_Y, cvt.src_Y, row_data_size);
-            ReceiveData<1>(input_U, cvt.src_U, row_data_size / 2);
-            ReceiveData<1>(input_V, cvt.src_V, row_data_size / 2);
-            break;
-        case InputFormat::YUV420_Indiv8:
-            ReceiveData<1>(input_Y, cvt.src_Y, row_data_size);
-            ReceiveData<1>(input_U, cvt.src_U, row_data_size / 4);
-            ReceiveData<1>(input_V, cvt.src_V, row_data_size / 4);
-            break;
-        case InputFormat::YUV422_Indiv16:
-            ReceiveData<2>(input_Y, cvt.src_Y, row_data_size);
-            ReceiveData<2>(input_U, cvt.src_U, row_data_size / 2);
-            ReceiveData<2>(input_V, cvt.src_V, row_data_size / 2);
-            break;
-        case InputFormat::YUV420_Indiv16:
-            ReceiveData<2>(input_Y, cvt.src_Y, row_data_size);
-            ReceiveData<2>(input_U, cvt.src_U, row_data_size / 4);
-            ReceiveData<2>(input_V, cvt.src_V, row_data_size / 4);
-            break;
-        case InputFormat::YUYV422_Interleaved:
-            input_U = nullptr;
-            input_V = nullptr;
-            ReceiveData<1>(input_Y, cvt.src_YUYV, row_data_size * 2);
-            break;
+    const size_t num_strips = (cvt.input_lines + 7) / 8;
+    const size_t batch_size =
+        output_overlaps_input ? 1 : std::min(num_strips, MAX_STRIPS_PER_BATCH);
+
+    // Buffers used as CDMA sources/targets, one per strip of a batch. The input always fits in 2
+    // bytes per pixel. The output is padded to a whole number of transfer units.
+    const size_t strip_pixels = cvt.input_line_width * 8;
+    const size_t input_size = strip_pixels * 2;
+    const size_t output_size =
+        Common::AlignUp(strip_pixels * bytes_per_pixel, cvt.dst.transfer_unit);
+    input_buffer.resize(batch_size * input_size);
+    output_buffer.resize(batch_size * output_size);
+    // Intermediate storage for decoded image strips. Always stored as RGB32.
+    rgb_buffer.resize(batch_size * strip_pixels);
+    tile_buffer.resize(batch_size * num_tiles);
+
+    std::array<Strip, MAX_STRIPS_PER_BATCH> strips;
+    for (unsigned int y = 0; y < cvt.input_lines; y += batch_size * 8) {
+        const size_t num_batch_strips = std::min<size_t>(batch_size, (cvt.input_lines - y + 7) / 8);
+
+        for (size_t i = 0; i < num_batch_strips; ++i) {
+            const unsigned int row_height = std::min<unsigned int>(cvt.input_lines - y - i * 8, 8);
+            strips[i] = ReceiveStrip(cvt, &input_buffer[i * input_size], row_height);
         }
 
-        // Note(yuriks): If additional optimization is required, input_format can be moved to a
-        // template parameter, so that its dispatch can be moved to outside the inner loop.
-        ConvertYUVToRGB(cvt.input_format, input_Y, input_U, input_V, tiles.get(),
-                        cvt.input_line_width, row_height, cvt.coefficients);
-
-        u32* output_buffer = reinterpret_cast<u32*>(data_buffer.get());
-
-        for (size_t i = 0; i < num_tiles; ++i) {
-            int image_strip_width = 0;
-            int output_stride = 0;
-
-            switch (cvt.rotation) {
-            case Rotation::None:
-                RotateTile0(tiles[i], tmp_tile, row_height, tile_remap);
-                image_strip_width = cvt.input_line_width;
-                output_stride = 8;
-                break;
-            case Rotation::Clockwise_90:
-                RotateTile90(tiles[i], tmp_tile, row_height, tile_remap);
-                image_strip_width = 8;
-                output_stride = 8 * row_height;
-                break;
-            case Rotation::Clockwise_180:
-                // For 180 and 270 degree rotations we also invert the order of tiles in the strip,
-                // since the rotates are done individually on each tile.
-                RotateTile180(tiles[num_tiles - i - 1], tmp_tile, row_height, tile_remap);
-                image_strip_width = cvt.input_line_width;
-                output_stride = 8;
-                break;
-            case Rotation::Clockwise_270:
-                RotateTile270(tiles[num_tiles - i - 1], tmp_tile, row_height, tile_remap);
-                image_strip_width = 8;
-                output_stride = 8 * row_height;
-                break;
-            }
-
-            switch (cvt.block_alignment) {
-            case BlockAlignment::Linear:
-                WriteTileToOutput(output_buffer, tmp_tile, row_height, image_strip_width);
-                output_buffer += output_stride;
-                break;
-            case BlockAlignment::Block8x8:
-                WriteTileToOutput(output_buffer, tmp_tile, 8, 8);
-                output_buffer += TILE_SIZE;
-                break;
-            }
+        const auto convert = [&](size_t i) {
+            u32* rgb = &rgb_buffer[i * strip_pixels];
+            u8* output = &output_buffer[i * output_size];
+            const size_t row_data_size = strips[i].height * cvt.input_line_width;
+
+            convert_strip(cvt, strips[i], rgb, &tile_buffer[i * num_tiles]);
+            encode_pixels(rgb, output, row_data_size, static_cast<u8>(cvt.alpha));
+            std::fill(output + row_data_size * bytes_per_pixel, output + output_size, 0);
+        };
+        const size_t num_threads = GetNumThreads();
+        if (num_threads > 1 && num_batch_strips > 1) {
+            if (thread_pool == nullptr || thread_pool->GetNumThreads() != num_threads)
+                thread_pool = std::make_unique<Common::ThreadPool>(num_threads - 1);
+            thread_pool->ParallelFor(num_batch_strips, convert);
+        } else {
+            for (size_t i = 0; i < num_batch_strips; ++i)
+                convert(i);
         }
 
-        // Note(yuriks): If additional optimization is required, output_format can be moved to a
-        // template parameter, so that its dispatch can be moved to outside the inner loop.
-        SendData(reinterpret_cast<u32*>(data_buffer.get()), cvt.dst, (int)row_data_size,
-                 cvt.output_format, (u8)cvt.alpha);
+        for (size_t i = 0; i < num_batch_strips; ++i) {
+            const size_t row_data_size = strips[i].height * cvt.input_line_width;
+            SendData(&output_buffer[i * output_size], cvt.dst, row_data_size * bytes_per_pixel);
+        }
     }
 }
 }
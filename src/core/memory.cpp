@@ -3,6 +3,7 @@
 // Refer to the license.txt file included.
 
 #include <array>
+#include <bitset>
 #include <cstring>
 #include "common/assert.h"
 #include "common/common_types.h"
@@ -68,6 +69,18 @@ struct PageTable {
      * flushed before the memory is accessed
      */
     std::array<u8, PAGE_TABLE_NUM_ENTRIES> cached_res_count;
+
+    /**
+     * Memory backing pages of type `RasterizerCachedMemory`. Their entries in `pointers` are null
+     * so that accesses take the slow path, but this avoids looking up the VMA on every access.
+     */
+    std::array<u8*, PAGE_TABLE_NUM_ENTRIES> cached_pointers;
+
+    /**
+     * Rasterizer cached pages that the rasterizer may have written to since they were last
+     * flushed. CPU reads of other cached pages don't need to flush the rasterizer cache.
+     */
+    std::bitset<PAGE_TABLE_NUM_ENTRIES> flush_pending;
 };
 
 /// Singular page table used for the singleton process
@@ -99,6 +112,8 @@ static void MapPages(u32 base, u32 size, u8* memory, PageType type) {
         current_page_table->attributes[base] = type;
         current_page_table->pointers[base] = memory;
         current_page_table->cached_res_count[base] = 0;
+        current_page_table->cached_pointers[base] = nullptr;
+        current_page_table->flush_pending[base] = false;
 
         base += 1;
         if (memory != nullptr)
@@ -110,6 +125,8 @@ void InitMemoryMap() {
     main_page_table.pointers.fill(nullptr);
     main_page_table.attributes.fill(PageType::Unmapped);
     main_page_table.cached_res_count.fill(0);
+    main_page_table.cached_pointers.fill(nullptr);
+    main_page_table.flush_pending.reset();
 }
 
 void MapMemoryRegion(VAddr base, u32 size, u8* target) {
@@ -132,28 +149,6 @@ void UnmapRegion(VAddr base, u32 size) {
     MapPages(base / PAGE_SIZE, size / PAGE_SIZE, nullptr, PageType::Unmapped);
 }
 
-/**
- * Gets a pointer to the exact memory at the virtual address (i.e. not page aligned)
- * using a VMA from the current process
- */
-static u8* GetPointerFromVMA(VAddr vaddr) {
-    u8* direct_pointer = nullptr;
-
-    auto& vma = Kernel::g_current_process->vm_manager.FindVMA(vaddr)->second;
-    switch (vma.type) {
-    case Kernel::VMAType::AllocatedMemoryBlock:
-        direct_pointer = vma.backing_block->data() + vma.offset;
-        break;
-    case Kernel::VMAType::BackingMemory:
-        direct_pointer = vma.backing_memory;
-        break;
-    default:
-        UNREACHABLE();
-    }
-
-    return direct_pointer + (vaddr - vma.base);
-}
-
 /**
  * This function should only be called for virtual addreses with attribute `PageType::Special`.
  */
@@ -167,6 +162,29 @@ static MMIORegionPointer GetMMIOHandler(VAddr vaddr) {
     return nullptr; // Should never happen
 }
 
+/**
+ * Prepares a rasterizer cached page for being read by the CPU. The rasterizer cache is only
+ * flushed if the rasterizer may have written to the page since it was last flushed.
+ */
+static void FlushCachedPage(size_t page_index) {
+    if (!current_page_table->flush_pending[page_index])
+        return;
+
+    current_page_table->flush_pending[page_index] = false;
+    RasterizerFlushRegion(VirtualToPhysicalAddress(static_cast<VAddr>(page_index << PAGE_BITS)),
+                          PAGE_SIZE);
+}
+
+/**
+ * Prepares a rasterizer cached page for being written by the CPU. All cached resources touching
+ * the page are flushed and invalidated at once, so that the page usually turns back into regular
+ * memory and further writes to it take the fast path.
+ */
+static void InvalidateCachedPage(size_t page_index) {
+    RasterizerFlushAndInvalidateRegion(
+        VirtualToPhysicalAddress(static_cast<VAddr>(page_index << PAGE_BITS)), PAGE_SIZE);
+}
+
 template <typename T>
 T ReadMMIO(MMIORegionPointer mmio_handler, VAddr addr);
 
@@ -189,16 +207,18 @@ T Read(const VAddr vaddr) {
         ASSERT_MSG(false, "Mapped memory page without a pointer @ %08X", vaddr);
         break;
     case PageType::RasterizerCachedMemory: {
-        RasterizerFlushRegion(VirtualToPhysicalAddress(vaddr), sizeof(T));
+        FlushCachedPage(vaddr >> PAGE_BITS);
 
         T value;
-        std::memcpy(&value, GetPointerFromVMA(vaddr), sizeof(T));
+        std::memcpy(&value,
+                    &current_page_table->cached_pointers[vaddr >> PAGE_BITS][vaddr & PAGE_MASK],
+                    sizeof(T));
         return value;
     }
     case PageType::Special:
         return ReadMMIO<T>(GetMMIOHandler(vaddr), vaddr);
     case PageType::RasterizerCachedSpecial: {
-        RasterizerFlushRegion(VirtualToPhysicalAddress(vaddr), sizeof(T));
+        FlushCachedPage(vaddr >> PAGE_BITS);
 
         return ReadMMIO<T>(GetMMIOHandler(vaddr), vaddr);
     }
@@ -229,16 +249,17 @@ void Write(const VAddr vaddr, const T data) {
         ASSERT_MSG(false, "Mapped memory page without a pointer @ %08X", vaddr);
         break;
     case PageType::RasterizerCachedMemory: {
-        RasterizerFlushAndInvalidateRegion(VirtualToPhysicalAddress(vaddr), sizeof(T));
+        u8* cached_pointer = current_page_table->cached_pointers[vaddr >> PAGE_BITS];
+        InvalidateCachedPage(vaddr >> PAGE_BITS);
 
-        std::memcpy(GetPointerFromVMA(vaddr), &data, sizeof(T));
+        std::memcpy(&cached_pointer[vaddr & PAGE_MASK], &data, sizeof(T));
         break;
     }
     case PageType::Special:
         WriteMMIO<T>(GetMMIOHandler(vaddr), vaddr, data);
         break;
     case PageType::RasterizerCachedSpecial: {
-        RasterizerFlushAndInvalidateRegion(VirtualToPhysicalAddress(vaddr), sizeof(T));
+        InvalidateCachedPage(vaddr >> PAGE_BITS);
 
         WriteMMIO<T>(GetMMIOHandler(vaddr), vaddr, data);
         break;
@@ -278,7 +299,7 @@ u8* GetPointer(const VAddr vaddr) {
     }
 
     if (current_page_table->attributes[vaddr >> PAGE_BITS] == PageType::RasterizerCachedMemory) {
-        return GetPointerFromVMA(vaddr);
+        return current_page_table->cached_pointers[vaddr >> PAGE_BITS] + (vaddr & PAGE_MASK);
     }
 
     LOG_ERROR(HW_Memory, "unknown GetPointer @ 0x%08x", vaddr);
@@ -325,6 +346,8 @@ void RasterizerMarkRegionCached(PAddr start, u32 size, int count_delta) {
             switch (page_type) {
             case PageType::Memory:
                 page_type = PageType::RasterizerCachedMemory;
+                current_page_table->cached_pointers[vaddr >> PAGE_BITS] =
+                    current_page_table->pointers[vaddr >> PAGE_BITS];
                 current_page_table->pointers[vaddr >> PAGE_BITS] = nullptr;
                 break;
             case PageType::Special:
@@ -344,7 +367,8 @@ void RasterizerMarkRegionCached(PAddr start, u32 size, int count_delta) {
             case PageType::RasterizerCachedMemory:
                 page_type = PageType::Memory;
                 current_page_table->pointers[vaddr >> PAGE_BITS] =
-                    GetPointerFromVMA(vaddr & ~PAGE_MASK);
+                    current_page_table->cached_pointers[vaddr >> PAGE_BITS];
+                current_page_table->cached_pointers[vaddr >> PAGE_BITS] = nullptr;
                 break;
             case PageType::RasterizerCachedSpecial:
                 page_type = PageType::Special;
@@ -352,11 +376,28 @@ void RasterizerMarkRegionCached(PAddr start, u32 size, int count_delta) {
             default:
                 UNREACHABLE();
             }
+            current_page_table->flush_pending[vaddr >> PAGE_BITS] = false;
         }
         paddr += PAGE_SIZE;
     }
 }
 
+void RasterizerMarkRegionDirty(PAddr start, u32 size) {
+    if (start == 0 || size == 0) {
+        return;
+    }
+
+    u32 num_pages = ((start + size - 1) >> PAGE_BITS) - (start >> PAGE_BITS) + 1;
+    PAddr paddr = start;
+
+    for (unsigned i = 0; i < num_pages; ++i) {
+        VAddr vaddr = PhysicalToVirtualAddress(paddr);
+        if (current_page_table->cached_res_count[vaddr >> PAGE_BITS] != 0)
+            current_page_table->flush_pending[vaddr >> PAGE_BITS] = true;
+        paddr += PAGE_SIZE;
+    }
+}
+
 void RasterizerFlushRegion(PAddr start, u32 size) {
     if (VideoCore::g_renderer != nullptr) {
         VideoCore::g_renderer->Rasterizer()->FlushRegion(start, size);
@@ -385,13 +426,30 @@ u64 Read64(const VAddr addr) {
     return Read<u64_le>(addr);
 }
 
+/**
+ * Returns how many bytes, up to max_size, starting at the given offset into a page of type
+ * `Memory` are backed by contiguous host memory. This lets block operations handle ranges
+ * spanning many pages with a single memcpy.
+ */
+static size_t GetContiguousMemorySize(size_t page_index, size_t page_offset, size_t max_size) {
+    const u8* next_pointer = current_page_table->pointers[page_index] + PAGE_SIZE;
+    size_t size = PAGE_SIZE - page_offset;
+
+    while (size < max_size && ++page_index < PAGE_TABLE_NUM_ENTRIES &&
+           current_page_table->pointers[page_index] == next_pointer) {
+        size += PAGE_SIZE;
+        next_pointer += PAGE_SIZE;
+    }
+    return std::min(size, max_size);
+}
+
 void ReadBlock(const VAddr src_addr, void* dest_buffer, const size_t size) {
     size_t remaining_size = size;
     size_t page_index = src_addr >> PAGE_BITS;
     size_t page_offset = src_addr & PAGE_MASK;
 
     while (remaining_size > 0) {
-        const size_t copy_amount = std::min(PAGE_SIZE - page_offset, remaining_size);
+        size_t copy_amount = std::min(PAGE_SIZE - page_offset, remaining_size);
         const VAddr current_vaddr = (page_index << PAGE_BITS) + page_offset;
 
         switch (current_page_table->attributes[page_index]) {
@@ -404,6 +462,7 @@ void ReadBlock(const VAddr src_addr, void* dest_buffer, const size_t size) {
         case PageType::Memory: {
             DEBUG_ASSERT(current_page_table->pointers[page_index]);
 
+            copy_amount = GetContiguousMemorySize(page_index, page_offset, remaining_size);
             const u8* src_ptr = current_page_table->pointers[page_index] + page_offset;
             std::memcpy(dest_buffer, src_ptr, copy_amount);
             break;
@@ -415,15 +474,16 @@ void ReadBlock(const VAddr src_addr, void* dest_buffer, const size_t size) {
             break;
         }
         case PageType::RasterizerCachedMemory: {
-            RasterizerFlushRegion(VirtualToPhysicalAddress(current_vaddr), copy_amount);
+            FlushCachedPage(page_index);
 
-            std::memcpy(dest_buffer, GetPointerFromVMA(current_vaddr), copy_amount);
+            const u8* src_ptr = current_page_table->cached_pointers[page_index] + page_offset;
+            std::memcpy(dest_buffer, src_ptr, copy_amount);
             break;
         }
         case PageType::RasterizerCachedSpecial: {
             DEBUG_ASSERT(GetMMIOHandler(current_vaddr));
 
-            RasterizerFlushRegion(VirtualToPhysicalAddress(current_vaddr), copy_amount);
+            FlushCachedPage(page_index);
 
             GetMMIOHandler(current_vaddr)->ReadBlock(current_vaddr, dest_buffer, copy_amount);
             break;
@@ -432,8 +492,9 @@ void ReadBlock(const VAddr src_addr, void* dest_buffer, const size_t size) {
             UNREACHABLE();
         }
 
-        page_index++;
-        page_offset = 0;
+        page_offset += copy_amount;
+        page_index += page_offset >> PAGE_BITS;
+        page_offset &= PAGE_MASK;
         dest_buffer = static_cast<u8*>(dest_buffer) + copy_amount;
         remaining_size -= copy_amount;
     }
@@ -461,7 +522,7 @@ void WriteBlock(const VAddr dest_addr, const void* src_buffer, const size_t size
     size_t page_offset = dest_addr & PAGE_MASK;
 
     while (remaining_size > 0) {
-        const size_t copy_amount = std::min(PAGE_SIZE - page_offset, remaining_size);
+        size_t copy_amount = std::min(PAGE_SIZE - page_offset, remaining_size);
         const VAddr current_vaddr = (page_index << PAGE_BITS) + page_offset;
 
         switch (current_page_table->attributes[page_index]) {
@@ -474,6 +535,7 @@ void WriteBlock(const VAddr dest_addr, const void* src_buffer, const size_t size
         case PageType::Memory: {
             DEBUG_ASSERT(current_page_table->pointers[page_index]);
 
+            copy_amount = GetContiguousMemorySize(page_index, page_offset, remaining_size);
             u8* dest_ptr = current_page_table->pointers[page_index] + page_offset;
             std::memcpy(dest_ptr, src_buffer, copy_amount);
             break;
@@ -485,17 +547,16 @@ void WriteBlock(const VAddr dest_addr, const void* src_buffer, const size_t size
             break;
         }
         case PageType::RasterizerCachedMemory: {
-            RasterizerFlushAndInvalidateRegion(VirtualToPhysicalAddress(current_vaddr),
-                                               copy_amount);
+            u8* dest_ptr = current_page_table->cached_pointers[page_index] + page_offset;
+            InvalidateCachedPage(page_index);
 
-            std::memcpy(GetPointerFromVMA(current_vaddr), src_buffer, copy_amount);
+            std::memcpy(dest_ptr, src_buffer, copy_amount);
             break;
         }
         case PageType::RasterizerCachedSpecial: {
             DEBUG_ASSERT(GetMMIOHandler(current_vaddr));
 
-            RasterizerFlushAndInvalidateRegion(VirtualToPhysicalAddress(current_vaddr),
-                                               copy_amount);
+            InvalidateCachedPage(page_index);
 
             GetMMIOHandler(current_vaddr)->WriteBlock(current_vaddr, src_buffer, copy_amount);
             break;
@@ -504,8 +565,9 @@ void WriteBlock(const VAddr dest_addr, const void* src_buffer, const size_t size
             UNREACHABLE();
         }
 
-        page_index++;
-        page_offset = 0;
+        page_offset += copy_amount;
+        page_index += page_offset >> PAGE_BITS;
+        page_offset &= PAGE_MASK;
         src_buffer = static_cast<const u8*>(src_buffer) + copy_amount;
         remaining_size -= copy_amount;
     }
@@ -519,7 +581,7 @@ void ZeroBlock(const VAddr dest_addr, const size_t size) {
     static const std::array<u8, PAGE_SIZE> zeros = {};
 
     while (remaining_size > 0) {
-        const size_t copy_amount = std::min(PAGE_SIZE - page_offset, remaining_size);
+        size_t copy_amount = std::min(PAGE_SIZE - page_offset, remaining_size);
         const VAddr current_vaddr = (page_index << PAGE_BITS) + page_offset;
 
         switch (current_page_table->attributes[page_index]) {
@@ -531,6 +593,7 @@ void ZeroBlock(const VAddr dest_addr, const size_t size) {
         case PageType::Memory: {
             DEBUG_ASSERT(current_page_table->pointers[page_index]);
 
+            copy_amount = GetContiguousMemorySize(page_index, page_offset, remaining_size);
             u8* dest_ptr = current_page_table->pointers[page_index] + page_offset;
             std::memset(dest_ptr, 0, copy_amount);
             break;
@@ -542,17 +605,16 @@ void ZeroBlock(const VAddr dest_addr, const size_t size) {
             break;
         }
         case PageType::RasterizerCachedMemory: {
-            RasterizerFlushAndInvalidateRegion(VirtualToPhysicalAddress(current_vaddr),
-                                               copy_amount);
+            u8* dest_ptr = current_page_table->cached_pointers[page_index] + page_offset;
+            InvalidateCachedPage(page_index);
 
-            std::memset(GetPointerFromVMA(current_vaddr), 0, copy_amount);
+            std::memset(dest_ptr, 0, copy_amount);
             break;
         }
         case PageType::RasterizerCachedSpecial: {
             DEBUG_ASSERT(GetMMIOHandler(current_vaddr));
 
-            RasterizerFlushAndInvalidateRegion(VirtualToPhysicalAddress(current_vaddr),
-                                               copy_amount);
+            InvalidateCachedPage(page_index);
 
             GetMMIOHandler(current_vaddr)->WriteBlock(current_vaddr, zeros.data(), copy_amount);
             break;
@@ -561,8 +623,9 @@ void ZeroBlock(const VAddr dest_addr, const size_t size) {
             UNREACHABLE();
         }
 
-        page_index++;
-        page_offset = 0;
+        page_offset += copy_amount;
+        page_index += page_offset >> PAGE_BITS;
+        page_offset &= PAGE_MASK;
         remaining_size -= copy_amount;
     }
 }
@@ -573,7 +636,7 @@ void CopyBlock(VAddr dest_addr, VAddr src_addr, const size_t size) {
     size_t page_offset = src_addr & PAGE_MASK;
 
     while (remaining_size > 0) {
-        const size_t copy_amount = std::min(PAGE_SIZE - page_offset, remaining_size);
+        size_t copy_amount = std::min(PAGE_SIZE - page_offset, remaining_size);
         const VAddr current_vaddr = (page_index << PAGE_BITS) + page_offset;
 
         switch (current_page_table->attributes[page_index]) {
@@ -585,6 +648,7 @@ void CopyBlock(VAddr dest_addr, VAddr src_addr, const size_t size) {
         }
         case PageType::Memory: {
             DEBUG_ASSERT(current_page_table->pointers[page_index]);
+            copy_amount = GetContiguousMemorySize(page_index, page_offset, remaining_size);
             const u8* src_ptr = current_page_table->pointers[page_index] + page_offset;
             WriteBlock(dest_addr, src_ptr, copy_amount);
             break;
@@ -598,15 +662,16 @@ void CopyBlock(VAddr dest_addr, VAddr src_addr, const size_t size) {
             break;
         }
         case PageType::RasterizerCachedMemory: {
-            RasterizerFlushRegion(VirtualToPhysicalAddress(current_vaddr), copy_amount);
+            FlushCachedPage(page_index);
 
-            WriteBlock(dest_addr, GetPointerFromVMA(current_vaddr), copy_amount);
+            const u8* src_ptr = current_page_table->cached_pointers[page_index] + page_offset;
+            WriteBlock(dest_addr, src_ptr, copy_amount);
             break;
         }
         case PageType::RasterizerCachedSpecial: {
             DEBUG_ASSERT(GetMMIOHandler(current_vaddr));
 
-            RasterizerFlushRegion(VirtualToPhysicalAddress(current_vaddr), copy_amount);
+            FlushCachedPage(page_index);
 
             std::vector<u8> buffer(copy_amount);
             GetMMIOHandler(current_vaddr)->ReadBlock(current_vaddr, buffer.data(), buffer.size());
@@ -617,8 +682,9 @@ void CopyBlock(VAddr dest_addr, VAddr src_addr, const size_t size) {
             UNREACHABLE();
         }
 
-        page_index++;
-        page_offset = 0;
+        page_offset += copy_amount;
+        page_index += page_offset >> PAGE_BITS;
+        page_offset &= PAGE_MASK;
         dest_addr += copy_amount;
         src_addr += copy_amount;
         remaining_size -= copy_amount;
@@ -159,6 +159,12 @@ u8* GetPhysicalPointer(PAddr address);
  */
 void RasterizerMarkRegionCached(PAddr start, u32 size, int count_delta);
 
+/**
+ * Notifies the memory system that the rasterizer has written to cached resources touching the
+ * region, so that the next CPU read of each affected page flushes them first.
+ */
+void RasterizerMarkRegionDirty(PAddr start, u32 size);
+
 /**
  * Flushes any externally cached rasterizer resources touching the given region.
  */
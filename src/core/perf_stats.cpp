@@ -0,0 +1,147 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <cmath>
+#include <thread>
+#include "core/perf_stats.h"
+
+using std::chrono::duration_cast;
+using std::chrono::microseconds;
+
+namespace Core {
+
+constexpr size_t PerfStats::NUM_STAGES;
+constexpr size_t PerfStats::HISTORY_SIZE;
+constexpr size_t PerfStats::NUM_BUCKETS;
+constexpr microseconds PerfStats::BUCKET_WIDTH;
+
+constexpr std::chrono::nanoseconds FrameLimiter::NATIVE_FRAME_TIME;
+constexpr std::chrono::milliseconds FrameLimiter::MAX_LAG_TIME;
+constexpr std::chrono::milliseconds FrameLimiter::SPIN_TIME;
+
+PerfStats::PerfStats() {
+    Reset();
+}
+
+void PerfStats::Reset() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        next_frame = 0;
+        num_frames = 0;
+        for (auto& histogram : histograms)
+            histogram.fill(0);
+        totals.fill(microseconds::zero());
+    }
+
+    current_frame.fill(microseconds::zero());
+    stage_start = Clock::now();
+}
+
+void PerfStats::EndStage(Stage stage) {
+    const Clock::time_point now = Clock::now();
+    current_frame[static_cast<size_t>(stage)] = duration_cast<microseconds>(now - stage_start);
+    stage_start = now;
+
+    if (stage == Stage::Wait) {
+        AddFrame(current_frame);
+        current_frame.fill(microseconds::zero());
+    }
+}
+
+size_t PerfStats::GetBucket(microseconds duration) {
+    if (duration <= microseconds::zero())
+        return 0;
+    return std::min<size_t>(duration / BUCKET_WIDTH, NUM_BUCKETS - 1);
+}
+
+void PerfStats::AddFrame(const FrameTimes& times) {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    // Update the histograms incrementally, dropping the oldest frame once the window is full
+    FrameTimes& slot = history[next_frame];
+    for (size_t stage = 0; stage < NUM_STAGES; ++stage) {
+        if (num_frames == HISTORY_SIZE) {
+            histograms[stage][GetBucket(slot[stage])]--;
+            totals[stage] -= slot[stage];
+        }
+        histograms[stage][GetBucket(times[stage])]++;
+        totals[stage] += times[stage];
+    }
+
+    slot = times;
+    next_frame = (next_frame + 1) % HISTORY_SIZE;
+    num_frames = std::min(num_frames + 1, HISTORY_SIZE);
+}
+
+size_t PerfStats::GetNumFrames() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return num_frames;
+}
+
+PerfStats::Histogram PerfStats::GetHistogram(Stage stage) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return histograms[static_cast<size_t>(stage)];
+}
+
+PerfStats::FrameTimes PerfStats::GetAverageFrameTimes() const {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    FrameTimes averages{};
+    if (num_frames == 0)
+        return averages;
+
+    for (size_t stage = 0; stage < NUM_STAGES; ++stage)
+        averages[stage] = totals[stage] / static_cast<microseconds::rep>(num_frames);
+    return averages;
+}
+
+microseconds PerfStats::GetPercentile(Stage stage, double fraction) const {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    if (num_frames == 0)
+        return microseconds::zero();
+
+    const size_t target = std::max<size_t>(
+        1, static_cast<size_t>(std::ceil(std::min(std::max(fraction, 0.0), 1.0) * num_frames)));
+    const Histogram& histogram = histograms[static_cast<size_t>(stage)];
+
+    size_t count = 0;
+    for (size_t bucket = 0; bucket < NUM_BUCKETS; ++bucket) {
+        count += histogram[bucket];
+        if (count >= target)
+            return BUCKET_WIDTH * static_cast<microseconds::rep>(bucket + 1);
+    }
+    return BUCKET_WIDTH * static_cast<microseconds::rep>(NUM_BUCKETS);
+}
+
+void FrameLimiter::DoFrameLimiting(double speed) {
+    if (speed <= 0.0) {
+        Reset();
+        return;
+    }
+
+    const Clock::time_point now = Clock::now();
+    if (!has_deadline) {
+        frame_deadline = now;
+        has_deadline = true;
+    }
+
+    frame_deadline += duration_cast<Clock::duration>(NATIVE_FRAME_TIME / speed);
+
+    // Don't try to catch up on more than MAX_LAG_TIME of slow frames by running unthrottled
+    frame_deadline = std::max(frame_deadline, now - MAX_LAG_TIME);
+
+    if (frame_deadline - now > SPIN_TIME)
+        std::this_thread::sleep_until(frame_deadline - SPIN_TIME);
+
+    while (Clock::now() < frame_deadline)
+        std::this_thread::yield();
+}
+
+void FrameLimiter::Reset() {
+    has_deadline = false;
+}
+
+} // namespace Core
@@ -0,0 +1,122 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <mutex>
+#include "common/common_types.h"
+
+namespace Core {
+
+/**
+ * Keeps track of how long the stages of the most recent emulated frames took. Timings are kept in
+ * a rolling window of HISTORY_SIZE frames and summarized as histograms, which may be queried from
+ * any thread while the emulation thread keeps adding frames.
+ */
+class PerfStats {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    /// Stages of a frame, in the order in which they happen
+    enum class Stage : size_t {
+        Emulation, ///< Emulating the frame up to the VBlank
+        Present,   ///< Presenting the frame to the host window
+        Wait,      ///< Waiting in the frame limiter
+    };
+    static constexpr size_t NUM_STAGES = 3;
+
+    /// Number of frames in the rolling window
+    static constexpr size_t HISTORY_SIZE = 256;
+    /// Number of histogram buckets. The last one also counts all durations beyond it.
+    static constexpr size_t NUM_BUCKETS = 64;
+    /// Range of durations counted by each histogram bucket
+    static constexpr std::chrono::microseconds BUCKET_WIDTH{500};
+
+    using FrameTimes = std::array<std::chrono::microseconds, NUM_STAGES>;
+    using Histogram = std::array<u32, NUM_BUCKETS>;
+
+    PerfStats();
+
+    /// Discards all recorded frames and starts timing a new frame
+    void Reset();
+
+    /**
+     * Marks the end of a stage of the current frame. Each stage is timed from the end of the
+     * previous one, and ending the Wait stage completes the frame and starts the next one.
+     */
+    void EndStage(Stage stage);
+
+    /// Adds the stage durations of a complete frame to the window
+    void AddFrame(const FrameTimes& times);
+
+    /// Returns the number of frames currently in the window
+    size_t GetNumFrames() const;
+
+    /// Returns the histogram of the durations of a stage over the window
+    Histogram GetHistogram(Stage stage) const;
+
+    /// Returns the average duration of each stage over the window
+    FrameTimes GetAverageFrameTimes() const;
+
+    /**
+     * Returns the duration which the given fraction of the frames in the window did not exceed in
+     * a stage, rounded up to a bucket boundary.
+     * @param fraction Fraction of frames in [0, 1], e.g. 0.99 for the 99th percentile.
+     */
+    std::chrono::microseconds GetPercentile(Stage stage, double fraction) const;
+
+private:
+    static size_t GetBucket(std::chrono::microseconds duration);
+
+    mutable std::mutex mutex;
+
+    std::array<FrameTimes, HISTORY_SIZE> history;
+    /// Index in history where the next frame will be written
+    size_t next_frame = 0;
+    size_t num_frames = 0;
+    std::array<Histogram, NUM_STAGES> histograms;
+    /// Sums of the stage durations over the window, for the averages
+    FrameTimes totals;
+
+    // Only accessed by the thread timing the frames
+    Clock::time_point stage_start;
+    FrameTimes current_frame;
+};
+
+/**
+ * Paces emulation to a target speed. Waits sleep until shortly before the end of a frame and spin
+ * for the remainder, as the host scheduler may oversleep by a few milliseconds.
+ */
+class FrameLimiter {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    /// Duration of a frame when running at native speed
+    static constexpr std::chrono::nanoseconds NATIVE_FRAME_TIME{1000000000 / 60};
+    /**
+     * How far emulation may fall behind before lost time stops being caught up. Higher values
+     * increase the time needed to return to the target frame rate after slow frames.
+     */
+    static constexpr std::chrono::milliseconds MAX_LAG_TIME{18};
+    /// Time before the end of a frame at which the limiter stops sleeping and starts spinning
+    static constexpr std::chrono::milliseconds SPIN_TIME{2};
+
+    /**
+     * Waits until the current frame has lasted long enough to run at the given speed.
+     * @param speed Target speed as a fraction of native speed. Values <= 0 disable limiting.
+     */
+    void DoFrameLimiting(double speed);
+
+    /// Forgets the current frame deadline, so that the next frame is not paced against it
+    void Reset();
+
+private:
+    Clock::time_point frame_deadline;
+    bool has_deadline = false;
+};
+
+} // namespace Core
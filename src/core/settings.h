@@ -78,6 +78,7 @@ struct Values {
 
     // Core
     bool use_cpu_jit;
+    int y2r_threads;
 
     // Data Storage
     bool use_virtual_sd;
@@ -88,9 +89,13 @@ struct Values {
     // Renderer
     bool use_hw_renderer;
     bool use_shader_jit;
+    int sw_rasterizer_threads;
+    int vertex_shader_threads;
+    int sw_texture_cache_size;
     float resolution_factor;
     bool use_vsync;
     bool toggle_framelimit;
+    u16 frame_limit; ///< Target emulation speed in percent of native speed, 0 for unlimited
 
     LayoutOption layout_option;
     bool swap_screen;
@@ -104,6 +109,7 @@ struct Values {
     // Audio
     std::string sink_id;
     bool enable_audio_stretching;
+    bool enable_audio_thread;
 
     // Debugging
     bool use_gdbstub;
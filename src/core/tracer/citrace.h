@@ -10,6 +10,14 @@ namespace CiTrace {
 
 // NOTE: Things are stored in little-endian
 
+// File layout (version 2):
+// - CTHeader
+// - Initial state, at the offsets given in the header
+// - Command stream, starting at stream_offset and consisting of chunks. Each chunk is a
+//   CTStreamChunk, followed by data_size bytes of memory contents and num_elements
+//   CTStreamElements. Memory loads may refer to memory contents stored in any earlier chunk.
+//   The chunks continue until the end of the file and contain stream_size elements in total.
+
 #pragma pack(1)
 
 struct CTHeader {
@@ -18,7 +26,7 @@ struct CTHeader {
     }
 
     static u32 ExpectedVersion() {
-        return 1;
+        return 2;
     }
 
     char magic[4];
@@ -67,7 +75,7 @@ enum CTStreamElementType : u32 {
 };
 
 struct CTMemoryLoad {
-    u32 file_offset;
+    u32 file_offset; ///< Absolute offset of the memory contents within the file
     u32 size;
     u32 physical_address;
     u32 pad;
@@ -87,6 +95,11 @@ struct CTRegisterWrite {
     u64 value;
 };
 
+struct CTStreamChunk {
+    u32 data_size;
+    u32 num_elements;
+};
+
 struct CTStreamElement {
     CTStreamElementType type;
 
@@ -0,0 +1,154 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <cstring>
+#include "common/file_util.h"
+#include "common/logging/log.h"
+#include "core/tracer/reader.h"
+
+namespace CiTrace {
+
+bool Reader::Load(const std::string& filename) {
+    stream.clear();
+    initial_state = {};
+
+    FileUtil::IOFile file(filename, "rb");
+    if (!file.IsOpen()) {
+        LOG_ERROR(HW_GPU, "Could not open CiTrace file %s", filename.c_str());
+        return false;
+    }
+
+    file_data.resize(file.GetSize());
+    if (file.ReadBytes(file_data.data(), file_data.size()) != file_data.size()) {
+        LOG_ERROR(HW_GPU, "Could not read CiTrace file %s", filename.c_str());
+        return false;
+    }
+
+    if (file_data.size() < sizeof(CTHeader)) {
+        LOG_ERROR(HW_GPU, "CiTrace file is too small");
+        return false;
+    }
+    std::memcpy(&header, file_data.data(), sizeof(CTHeader));
+
+    if (std::memcmp(header.magic, CTHeader::ExpectedMagicWord(), 4) != 0) {
+        LOG_ERROR(HW_GPU, "Not a CiTrace file");
+        return false;
+    }
+    if (header.version == 0 || header.version > CTHeader::ExpectedVersion()) {
+        LOG_ERROR(HW_GPU, "Unsupported CiTrace version %u", header.version);
+        return false;
+    }
+    if (header.header_size != sizeof(CTHeader)) {
+        LOG_ERROR(HW_GPU, "Unexpected CiTrace header size %u", header.header_size);
+        return false;
+    }
+
+    return LoadInitialState() && LoadStream();
+}
+
+bool Reader::ReadWords(std::vector<u32>& out, u32 offset, u32 size) const {
+    const u64 end = offset + static_cast<u64>(size) * sizeof(u32);
+    if (end > file_data.size())
+        return false;
+
+    out.resize(size);
+    std::memcpy(out.data(), file_data.data() + offset, size * sizeof(u32));
+    return true;
+}
+
+bool Reader::LoadInitialState() {
+    const auto& offsets = header.initial_state_offsets;
+    const bool success =
+        ReadWords(initial_state.gpu_registers, offsets.gpu_registers,
+                  offsets.gpu_registers_size) &&
+        ReadWords(initial_state.lcd_registers, offsets.lcd_registers,
+                  offsets.lcd_registers_size) &&
+        ReadWords(initial_state.pica_registers, offsets.pica_registers,
+                  offsets.pica_registers_size) &&
+        ReadWords(initial_state.default_attributes, offsets.default_attributes,
+                  offsets.default_attributes_size) &&
+        ReadWords(initial_state.vs_program_binary, offsets.vs_program_binary,
+                  offsets.vs_program_binary_size) &&
+        ReadWords(initial_state.vs_swizzle_data, offsets.vs_swizzle_data,
+                  offsets.vs_swizzle_data_size) &&
+        ReadWords(initial_state.vs_float_uniforms, offsets.vs_float_uniforms,
+                  offsets.vs_float_uniforms_size) &&
+        ReadWords(initial_state.gs_program_binary, offsets.gs_program_binary,
+                  offsets.gs_program_binary_size) &&
+        ReadWords(initial_state.gs_swizzle_data, offsets.gs_swizzle_data,
+                  offsets.gs_swizzle_data_size) &&
+        ReadWords(initial_state.gs_float_uniforms, offsets.gs_float_uniforms,
+                  offsets.gs_float_uniforms_size);
+
+    if (!success)
+        LOG_ERROR(HW_GPU, "CiTrace initial state exceeds the end of the file");
+    return success;
+}
+
+bool Reader::LoadStream() {
+    if (header.version >= 2) {
+        if (!LoadChunkedStream())
+            return false;
+    } else {
+        // The whole stream is stored in one piece at the end of the file
+        const u64 end =
+            header.stream_offset + static_cast<u64>(header.stream_size) * sizeof(CTStreamElement);
+        if (end > file_data.size()) {
+            LOG_ERROR(HW_GPU, "CiTrace stream exceeds the end of the file");
+            return false;
+        }
+        stream.resize(header.stream_size);
+        std::memcpy(stream.data(), file_data.data() + header.stream_offset,
+                    stream.size() * sizeof(CTStreamElement));
+    }
+
+    // Make sure that replaying never reads outside of the file
+    for (const auto& element : stream) {
+        if (element.type != MemoryLoad)
+            continue;
+
+        const u64 end =
+            static_cast<u64>(element.memory_load.file_offset) + element.memory_load.size;
+        if (end > file_data.size()) {
+            LOG_ERROR(HW_GPU, "CiTrace memory load exceeds the end of the file");
+            return false;
+        }
+    }
+    return true;
+}
+
+bool Reader::LoadChunkedStream() {
+    stream.reserve(header.stream_size);
+
+    u64 offset = header.stream_offset;
+    while (offset < file_data.size()) {
+        CTStreamChunk chunk;
+        if (offset + sizeof(chunk) > file_data.size()) {
+            LOG_ERROR(HW_GPU, "CiTrace stream chunk header exceeds the end of the file");
+            return false;
+        }
+        std::memcpy(&chunk, file_data.data() + offset, sizeof(chunk));
+        offset += sizeof(chunk) + chunk.data_size;
+
+        const u64 elements_size = static_cast<u64>(chunk.num_elements) * sizeof(CTStreamElement);
+        if (offset + elements_size > file_data.size()) {
+            LOG_ERROR(HW_GPU, "CiTrace stream chunk exceeds the end of the file");
+            return false;
+        }
+
+        const size_t first = stream.size();
+        stream.resize(first + chunk.num_elements);
+        std::memcpy(stream.data() + first, file_data.data() + offset, elements_size);
+        offset += elements_size;
+    }
+
+    if (stream.size() != header.stream_size) {
+        LOG_ERROR(HW_GPU, "CiTrace stream has %zu elements, but the header expects %u",
+                  stream.size(), header.stream_size);
+        return false;
+    }
+    return true;
+}
+
+} // namespace CiTrace
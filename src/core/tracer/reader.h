@@ -0,0 +1,62 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include "citrace.h"
+#include "common/common_types.h"
+#include "core/tracer/recorder.h"
+
+namespace CiTrace {
+
+/**
+ * Loads a CiTrace file for replaying. Both the original layout (version 1) and the chunked
+ * layout written by the streaming Recorder (version 2) are supported.
+ */
+class Reader {
+public:
+    using InitialState = Recorder::InitialState;
+
+    /**
+     * Loads the given CiTrace file, validating its header, its initial state and the memory
+     * contents referenced by its command stream.
+     * @return True on success, false if the file could not be read or is malformed
+     */
+    bool Load(const std::string& filename);
+
+    const CTHeader& GetHeader() const {
+        return header;
+    }
+
+    const InitialState& GetInitialState() const {
+        return initial_state;
+    }
+
+    /// Returns the command stream, with the elements of all chunks in recording order
+    const std::vector<CTStreamElement>& GetStream() const {
+        return stream;
+    }
+
+    /// Returns the memory contents loaded by a MemoryLoad element of the stream
+    const u8* GetMemoryData(const CTMemoryLoad& memory_load) const {
+        return file_data.data() + memory_load.file_offset;
+    }
+
+private:
+    bool LoadInitialState();
+    bool LoadStream();
+    bool LoadChunkedStream();
+
+    /// Copies size u32 values at the given file offset to the given vector
+    bool ReadWords(std::vector<u32>& out, u32 offset, u32 size) const;
+
+    std::vector<u8> file_data;
+    CTHeader header;
+    InitialState initial_state;
+    std::vector<CTStreamElement> stream;
+};
+
+} // namespace CiTrace
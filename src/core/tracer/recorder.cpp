@@ -2,19 +2,43 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <cstdio>
 #include <cstring>
+#include <limits>
 #include "common/assert.h"
 #include "common/file_util.h"
+#include "common/hash.h"
 #include "common/logging/log.h"
 #include "recorder.h"
 
 namespace CiTrace {
 
-Recorder::Recorder(const InitialState& initial_state) : initial_state(initial_state) {}
+constexpr size_t Recorder::MAX_CHUNK_DATA_SIZE;
+constexpr size_t Recorder::MAX_CHUNK_ELEMENTS;
 
-void Recorder::Finish(const std::string& filename) {
+Recorder::Recorder(const InitialState& initial_state, const std::string& filename)
+    : filename(filename), file(filename, "w+b") {
+    if (!file.IsOpen()) {
+        LOG_ERROR(HW_GPU, "Could not create CiTrace file %s", filename.c_str());
+        return;
+    }
+
+    if (!WriteInitialState(initial_state))
+        return;
+
+    chunk_data_offset = header.stream_offset + sizeof(CTStreamChunk);
+}
+
+Recorder::~Recorder() {
+    if (!finished) {
+        // Recording was aborted, don't leave an incomplete file behind
+        file.Close();
+        FileUtil::Delete(filename);
+    }
+}
+
+bool Recorder::WriteInitialState(const InitialState& initial_state) {
     // Setup CiTrace header
-    CTHeader header;
     std::memcpy(header.magic, CTHeader::ExpectedMagicWord(), 4);
     header.version = CTHeader::ExpectedVersion();
     header.header_size = sizeof(CTHeader);
@@ -32,12 +56,13 @@ void Recorder::Finish(const std::string& filename) {
     initial.gs_program_binary_size = static_cast<u32>(initial_state.gs_program_binary.size());
     initial.gs_swizzle_data_size = static_cast<u32>(initial_state.gs_swizzle_data.size());
     initial.gs_float_uniforms_size = static_cast<u32>(initial_state.gs_float_uniforms.size());
-    header.stream_size = static_cast<u32>(stream.size());
+
+    // The number of stream elements is only known once recording has finished
+    header.stream_size = 0;
 
     initial.gpu_registers = sizeof(header);
     initial.lcd_registers = initial.gpu_registers + initial.gpu_registers_size * sizeof(u32);
     initial.pica_registers = initial.lcd_registers + initial.lcd_registers_size * sizeof(u32);
-    ;
     initial.default_attributes = initial.pica_registers + initial.pica_registers_size * sizeof(u32);
     initial.vs_program_binary =
         initial.default_attributes + initial.default_attributes_size * sizeof(u32);
@@ -53,29 +78,8 @@ void Recorder::Finish(const std::string& filename) {
         initial.gs_swizzle_data + initial.gs_swizzle_data_size * sizeof(u32);
     header.stream_offset = initial.gs_float_uniforms + initial.gs_float_uniforms_size * sizeof(u32);
 
-    // Iterate through stream elements, update relevant stream element data
-    for (auto& stream_element : stream) {
-        switch (stream_element.data.type) {
-        case MemoryLoad: {
-            auto& file_offset = memory_regions[stream_element.hash];
-            if (!stream_element.uses_existing_data) {
-                file_offset = header.stream_offset;
-            }
-            stream_element.data.memory_load.file_offset = file_offset;
-            break;
-        }
-
-        default:
-            // Other commands don't use any extra data
-            DEBUG_ASSERT(stream_element.extra_data.size() == 0);
-            break;
-        }
-        header.stream_offset += static_cast<u32>(stream_element.extra_data.size());
-    }
-
     try {
-        // Open file and write header
-        FileUtil::IOFile file(filename, "wb");
+        // Write header
         size_t written = file.WriteObject(header);
         if (written != 1 || file.Tell() != initial.gpu_registers)
             throw "Failed to write header";
@@ -136,69 +140,141 @@ void Recorder::Finish(const std::string& filename) {
         written = file.WriteArray(initial_state.gs_float_uniforms.data(),
                                   initial_state.gs_float_uniforms.size());
         if (written != initial_state.gs_float_uniforms.size() ||
-            file.Tell() != initial.gs_float_uniforms + sizeof(u32) * initial.gs_float_uniforms_size)
+            file.Tell() != header.stream_offset)
             throw "Failed to write geometry shader float uniforms";
+    } catch (const char* str) {
+        Fail(str);
+        return false;
+    }
+    return true;
+}
 
-        // Iterate through stream elements, write "extra data"
-        for (const auto& stream_element : stream) {
-            if (stream_element.extra_data.size() == 0)
-                continue;
+void Recorder::Finish() {
+    FlushChunk();
+    if (!file.IsOpen())
+        return;
 
-            written =
-                file.WriteBytes(stream_element.extra_data.data(), stream_element.extra_data.size());
-            if (written != stream_element.extra_data.size())
-                throw "Failed to write extra data";
-        }
+    // Now that the stream is complete, fill in its size
+    header.stream_size = num_elements;
+    if (!file.Seek(0, SEEK_SET) || file.WriteObject(header) != 1) {
+        Fail("Failed to update header");
+        return;
+    }
+
+    file.Close();
+    finished = true;
+}
 
-        if (file.Tell() != header.stream_offset)
-            throw "Unexpected end of extra data";
+void Recorder::Fail(const char* message) {
+    LOG_ERROR(HW_GPU, "Writing CiTrace file failed: %s", message);
+    file.Close();
+}
 
-        // Write actual stream elements
-        for (const auto& stream_element : stream) {
-            if (1 != file.WriteObject(stream_element.data))
-                throw "Failed to write stream element";
-        }
-    } catch (const char* str) {
-        LOG_ERROR(HW_GPU, "Writing CiTrace file failed: %s", str);
+void Recorder::AddElement(const CTStreamElement& element) {
+    chunk_elements.push_back(element);
+
+    if (chunk_data.size() >= MAX_CHUNK_DATA_SIZE || chunk_elements.size() >= MAX_CHUNK_ELEMENTS)
+        FlushChunk();
+}
+
+void Recorder::FlushChunk() {
+    if (!file.IsOpen() || chunk_elements.empty())
+        return;
+
+    CTStreamChunk chunk;
+    chunk.data_size = static_cast<u32>(chunk_data.size());
+    chunk.num_elements = static_cast<u32>(chunk_elements.size());
+
+    if (file.WriteObject(chunk) != 1 ||
+        file.WriteBytes(chunk_data.data(), chunk_data.size()) != chunk_data.size() ||
+        file.WriteArray(chunk_elements.data(), chunk_elements.size()) != chunk_elements.size()) {
+        Fail("Failed to write stream chunk");
+        return;
     }
+
+    num_elements += chunk.num_elements;
+    chunk_data.clear();
+    chunk_elements.clear();
+    chunk_data_offset = file.Tell() + sizeof(CTStreamChunk);
 }
 
 void Recorder::FrameFinished() {
-    stream.push_back({{FrameMarker}});
+    if (!file.IsOpen())
+        return;
+
+    CTStreamElement element{};
+    element.type = FrameMarker;
+    AddElement(element);
 }
 
 void Recorder::MemoryAccessed(const u8* data, u32 size, u32 physical_address) {
-    StreamElement element = {{MemoryLoad}};
-    element.data.memory_load.size = size;
-    element.data.memory_load.physical_address = physical_address;
-
-    // Compute hash over given memory region to check if the contents are already stored internally
-    boost::crc_32_type result;
-    result.process_bytes(data, size);
-    element.hash = result.checksum();
-
-    element.uses_existing_data = (memory_regions.find(element.hash) != memory_regions.end());
-    if (!element.uses_existing_data) {
-        element.extra_data.resize(size);
-        memcpy(element.extra_data.data(), data, size);
-        memory_regions.insert({element.hash, 0}); // file offset will be initialized in Finish()
+    if (!file.IsOpen())
+        return;
+
+    CTStreamElement element{};
+    element.type = MemoryLoad;
+    element.memory_load.size = size;
+    element.memory_load.physical_address = physical_address;
+
+    // Compute hash over given memory region to check if the contents have been stored before
+    const u64 hash = Common::ComputeHash64(data, size);
+    auto it = memory_regions.find(hash);
+    const bool stored = it != memory_regions.end() && IsStored(it->second, data, size);
+    if (!file.IsOpen())
+        return;
+
+    if (stored) {
+        element.memory_load.file_offset = it->second.file_offset;
+    } else {
+        const u64 file_offset = chunk_data_offset + chunk_data.size();
+        if (file_offset + size > std::numeric_limits<u32>::max()) {
+            Fail("Recording exceeds the maximum file size");
+            return;
+        }
+
+        chunk_data.insert(chunk_data.end(), data, data + size);
+        memory_regions[hash] = {static_cast<u32>(file_offset), size};
+        element.memory_load.file_offset = static_cast<u32>(file_offset);
+    }
+
+    AddElement(element);
+}
+
+bool Recorder::IsStored(const MemoryRegion& region, const u8* data, u32 size) {
+    if (region.size != size)
+        return false;
+
+    if (region.file_offset >= chunk_data_offset) {
+        const u8* stored = chunk_data.data() + (region.file_offset - chunk_data_offset);
+        return std::memcmp(stored, data, size) == 0;
     }
 
-    stream.push_back(element);
+    // The contents were part of a chunk that has already been written, read them back
+    compare_buffer.resize(size);
+    if (!file.Seek(region.file_offset, SEEK_SET) ||
+        file.ReadBytes(compare_buffer.data(), size) != size || !file.Seek(0, SEEK_END)) {
+        Fail("Failed to read back stored memory contents");
+        return false;
+    }
+    return std::memcmp(compare_buffer.data(), data, size) == 0;
 }
 
 template <typename T>
 void Recorder::RegisterWritten(u32 physical_address, T value) {
-    StreamElement element = {{RegisterWrite}};
-    element.data.register_write.size =
+    if (!file.IsOpen())
+        return;
+
+    CTStreamElement element{};
+    element.type = RegisterWrite;
+    element.register_write.size =
         (sizeof(T) == 1) ? CTRegisterWrite::SIZE_8
                          : (sizeof(T) == 2) ? CTRegisterWrite::SIZE_16
                                             : (sizeof(T) == 4) ? CTRegisterWrite::SIZE_32
                                                                : CTRegisterWrite::SIZE_64;
-    element.data.register_write.physical_address = physical_address;
-    element.data.register_write.value = value;
+    element.register_write.physical_address = physical_address;
+    element.register_write.value = value;
 
-    stream.push_back(element);
+    AddElement(element);
 }
 
 template void Recorder::RegisterWritten(u32, u8);
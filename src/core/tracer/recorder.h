@@ -7,9 +7,9 @@
 #include <string>
 #include <unordered_map>
 #include <vector>
-#include <boost/crc.hpp>
 #include "citrace.h"
 #include "common/common_types.h"
+#include "common/file_util.h"
 
 namespace CiTrace {
 
@@ -29,13 +29,16 @@ public:
     };
 
     /**
-     * Recorder constructor
+     * Recorder constructor. The recording is streamed to the given file, which is only complete
+     * once Finish has been called; recordings which are never finished are deleted again.
      * @param initial_state Initial recorder state
+     * @param filename Path of the CiTrace file to create
      */
-    Recorder(const InitialState& initial_state);
+    Recorder(const InitialState& initial_state, const std::string& filename);
+    ~Recorder();
 
-    /// Finish recording of this Citrace and save it using the given filename.
-    void Finish(const std::string& filename);
+    /// Finish recording of this Citrace, writing all pending data to the file.
+    void Finish();
 
     /// Mark end of a frame
     void FrameFinished();
@@ -55,33 +58,53 @@ public:
     void RegisterWritten(u32 physical_address, T value);
 
 private:
-    // Initial state of recording start
-    InitialState initial_state;
+    /// Maximum amount of memory contents buffered before they are written to the file
+    static constexpr size_t MAX_CHUNK_DATA_SIZE = 4 * 1024 * 1024;
+    /// Maximum number of stream elements buffered before they are written to the file
+    static constexpr size_t MAX_CHUNK_ELEMENTS = 64 * 1024;
 
-    // Command stream
-    struct StreamElement {
-        CTStreamElement data;
+    /// Writes the header and the initial state, returning false on failure
+    bool WriteInitialState(const InitialState& initial_state);
 
-        /**
-          * Extra data to store along "core" data.
-          * This is e.g. used for data used in MemoryUpdates.
-          */
-        std::vector<u8> extra_data;
+    /// Appends an element to the current chunk, writing the chunk out once it is full
+    void AddElement(const CTStreamElement& element);
 
-        /// Optional CRC hash (e.g. for hashing memory regions)
-        boost::crc_32_type::value_type hash;
+    /// Writes the buffered chunk to the file
+    void FlushChunk();
 
-        /// If true, refer to data already written to the output file instead of extra_data
-        bool uses_existing_data;
+    /// Closes the file after a write error, so that further recording is skipped
+    void Fail(const char* message);
+
+    struct MemoryRegion {
+        u32 file_offset;
+        u32 size;
     };
 
-    std::vector<StreamElement> stream;
+    /// Returns whether the given region stores exactly the given memory contents
+    bool IsStored(const MemoryRegion& region, const u8* data, u32 size);
+
+    std::string filename;
+    FileUtil::IOFile file;
+    CTHeader header;
+    bool finished = false;
+
+    /// Number of stream elements in the chunks written so far
+    u32 num_elements = 0;
+
+    /// Memory contents and stream elements of the chunk that is currently being recorded
+    std::vector<u8> chunk_data;
+    std::vector<CTStreamElement> chunk_elements;
+    /// File offset at which the memory contents of the current chunk will be stored
+    u64 chunk_data_offset = 0;
 
     /**
-     * Internal cache which maps hashes of memory contents to file offsets at which those memory
-     * contents are stored.
+     * Maps hashes of memory contents to the file offsets at which those contents are stored, so
+     * that each distinct memory region is only stored once per recording. The contents are
+     * compared before reusing a region, in case two of them have the same hash.
      */
-    std::unordered_map<boost::crc_32_type::value_type /*hash*/, u32 /*file_offset*/> memory_regions;
+    std::unordered_map<u64 /*hash*/, MemoryRegion> memory_regions;
+    /// Contents of a region read back from the file for comparison
+    std::vector<u8> compare_buffer;
 };
 
 } // namespace
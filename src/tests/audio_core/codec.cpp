@@ -0,0 +1,69 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <cstring>
+#include <random>
+#include <vector>
+#include <catch.hpp>
+#include "audio_core/codec.h"
+
+namespace Codec {
+
+/// Decodes PCM8 one sample at a time, as DecodePCM8 did before it was vectorized
+static StereoBuffer16 ReferenceDecodePCM8(unsigned num_channels, const u8* data,
+                                          size_t sample_count) {
+    StereoBuffer16 ret(sample_count);
+    for (size_t i = 0; i < sample_count; i++) {
+        if (num_channels == 1) {
+            ret[i].fill(static_cast<s8>(data[i]));
+        } else {
+            ret[i][0] = static_cast<s8>(data[i * 2 + 0]);
+            ret[i][1] = static_cast<s8>(data[i * 2 + 1]);
+        }
+    }
+    return ret;
+}
+
+/// Decodes PCM16 one sample at a time, as DecodePCM16 did before it was vectorized
+static StereoBuffer16 ReferenceDecodePCM16(unsigned num_channels, const u8* data,
+                                           size_t sample_count) {
+    StereoBuffer16 ret(sample_count);
+    for (size_t i = 0; i < sample_count; i++) {
+        for (unsigned channel = 0; channel < 2; channel++) {
+            std::memcpy(&ret[i][channel],
+                        data + (i * num_channels + channel % num_channels) * sizeof(s16),
+                        sizeof(s16));
+        }
+    }
+    return ret;
+}
+
+static std::vector<u8> MakeRandomData(size_t size) {
+    std::mt19937 rng(1234);
+    std::uniform_int_distribution<int> byte(0, 255);
+    std::vector<u8> data(size);
+    for (auto& value : data)
+        value = static_cast<u8>(byte(rng));
+    return data;
+}
+
+TEST_CASE("Codec - PCM decoding matches per-sample decoding", "[audio_core]") {
+    const std::vector<u8> data = MakeRandomData(4 * 1000);
+
+    StereoBuffer16 buffer;
+    // Odd lengths exercise the tails after the vectorized loops
+    for (size_t sample_count : {0, 1, 7, 8, 15, 16, 17, 160, 999}) {
+        for (unsigned num_channels = 1; num_channels <= 2; num_channels++) {
+            INFO("sample_count " << sample_count << " num_channels " << num_channels);
+
+            DecodePCM8(num_channels, data.data(), sample_count, buffer);
+            REQUIRE(buffer == ReferenceDecodePCM8(num_channels, data.data(), sample_count));
+
+            DecodePCM16(num_channels, data.data(), sample_count, buffer);
+            REQUIRE(buffer == ReferenceDecodePCM16(num_channels, data.data(), sample_count));
+        }
+    }
+}
+
+} // namespace Codec
@@ -0,0 +1,107 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <catch.hpp>
+#include "audio_core/hle/common.h"
+#include "audio_core/hle/dsp.h"
+#include "audio_core/hle/mixers.h"
+
+namespace DSP {
+namespace HLE {
+
+using OutputFormat = DspConfiguration::OutputFormat;
+
+static s16 ClampToS16(s32 value) {
+    return static_cast<s16>(std::min(std::max(value, -32768), 32767));
+}
+
+/// Final mix of the intermediate mixes, one sample at a time as Mixers did before it was vectorized
+static StereoFrame16 ReferenceMix(const std::array<float, 3>& volumes, OutputFormat format,
+                                  const std::array<QuadFrame32, 3>& input) {
+    StereoFrame16 frame{};
+    for (size_t mix = 0; mix < 3; mix++) {
+        const float gain = volumes[mix];
+        for (size_t i = 0; i < samples_per_frame; i++) {
+            const auto& sample = input[mix][i];
+            s16 left, right;
+            if (format == OutputFormat::Mono) {
+                left = right = ClampToS16(static_cast<s32>(
+                    (gain * sample[0] + gain * sample[1] + gain * sample[2] + gain * sample[3]) /
+                    2));
+            } else {
+                left = ClampToS16(static_cast<s32>(gain * sample[0] + gain * sample[2]));
+                right = ClampToS16(static_cast<s32>(gain * sample[1] + gain * sample[3]));
+            }
+            frame[i][0] = ClampToS16(frame[i][0] + left);
+            frame[i][1] = ClampToS16(frame[i][1] + right);
+        }
+    }
+    return frame;
+}
+
+/// Holds the shared memory structures the mixers read from and write to
+struct MixerSharedMemory {
+    MixerSharedMemory() {
+        std::memset(&config, 0, sizeof(config));
+        std::memset(&aux_samples, 0, sizeof(aux_samples));
+    }
+
+    DspConfiguration config;
+    IntermediateMixSamples aux_samples;
+};
+
+/// Runs the mixers for one frame with the auxiliary mixes disabled
+static StereoFrame16 Mix(Mixers& mixers, MixerSharedMemory& memory,
+                         const std::array<QuadFrame32, 3>& input) {
+    mixers.Tick(memory.config, memory.aux_samples, memory.aux_samples, input);
+    return mixers.GetOutput();
+}
+
+/// Configures the mixers on the next call to Mix
+static void Configure(MixerSharedMemory& memory, const std::array<float, 3>& volumes,
+                      OutputFormat format) {
+    auto& config = memory.config;
+    config.volume_0_dirty.Assign(1);
+    config.volume_1_dirty.Assign(1);
+    config.volume_2_dirty.Assign(1);
+    config.output_format_dirty.Assign(1);
+    for (size_t mix = 0; mix < 3; mix++)
+        config.volume[mix] = volumes[mix];
+    config.output_format = format;
+}
+
+static std::array<QuadFrame32, 3> MakeRandomInput(std::mt19937& rng) {
+    // Large enough to saturate when mixed
+    std::uniform_int_distribution<s32> value(-60000, 60000);
+    std::array<QuadFrame32, 3> input;
+    for (auto& frame : input)
+        for (auto& sample : frame)
+            for (auto& channel : sample)
+                channel = value(rng);
+    return input;
+}
+
+TEST_CASE("Mixers - Final mix matches per-sample mixing", "[audio_core]") {
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> volume(0.0f, 1.5f);
+
+    Mixers mixers;
+    auto memory = std::make_unique<MixerSharedMemory>();
+    for (OutputFormat format : {OutputFormat::Mono, OutputFormat::Stereo, OutputFormat::Surround}) {
+        for (int i = 0; i < 10; ++i) {
+            INFO("format " << static_cast<int>(format) << " iteration " << i);
+            const std::array<float, 3> volumes{{volume(rng), volume(rng), volume(rng)}};
+            const auto input = MakeRandomInput(rng);
+            Configure(*memory, volumes, format);
+            REQUIRE(Mix(mixers, *memory, input) == ReferenceMix(volumes, format, input));
+        }
+    }
+}
+
+} // namespace HLE
+} // namespace DSP
@@ -0,0 +1,114 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <random>
+#include <catch.hpp>
+#include "audio_core/interpolate.h"
+
+namespace AudioInterp {
+
+using Sample = StereoBuffer16::value_type;
+
+/// Linear interpolation as it was implemented before it was vectorized
+static StereoBuffer16 ReferenceLinear(State& state, const StereoBuffer16& input,
+                                      float rate_multiplier) {
+    constexpr u64 scale_factor = 1 << 24;
+    constexpr u64 scale_mask = scale_factor - 1;
+
+    if (input.size() < 2)
+        return {};
+
+    const auto interpolate = [](u64 fraction, const Sample& x0, const Sample& x1) {
+        s64 delta0 = std::min<s64>(std::max<s64>(x1[0] - x0[0], -32768), 32767);
+        s64 delta1 = std::min<s64>(std::max<s64>(x1[1] - x0[1], -32768), 32767);
+        return Sample{
+            static_cast<s16>(x0[0] + fraction * delta0 / scale_factor),
+            static_cast<s16>(x0[1] + fraction * delta1 / scale_factor),
+        };
+    };
+
+    StereoBuffer16 output;
+    const u64 step_size = static_cast<u64>(rate_multiplier * scale_factor);
+    const u64 max_fposition = input.size() * scale_factor;
+    u64 fposition = 0;
+    for (; fposition < 1 * scale_factor; fposition += step_size)
+        output.push_back(interpolate(fposition & scale_mask, state.xn2, state.xn1));
+    for (; fposition < 2 * scale_factor; fposition += step_size)
+        output.push_back(interpolate(fposition & scale_mask, state.xn1, input[0]));
+    for (; fposition < max_fposition; fposition += step_size) {
+        const size_t index = static_cast<size_t>(fposition / scale_factor);
+        output.push_back(interpolate(fposition & scale_mask, input[index - 2], input[index - 1]));
+    }
+
+    state.xn2 = input[input.size() - 2];
+    state.xn1 = input[input.size() - 1];
+    return output;
+}
+
+static StereoBuffer16 MakeRandomBuffer(std::mt19937& rng, size_t size) {
+    std::uniform_int_distribution<int> value(-32768, 32767);
+    StereoBuffer16 buffer(size);
+    for (auto& sample : buffer)
+        sample = {static_cast<s16>(value(rng)), static_cast<s16>(value(rng))};
+    return buffer;
+}
+
+TEST_CASE("AudioInterp - Linear matches per-sample interpolation", "[audio_core]") {
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<size_t> buffer_size(0, 400);
+    std::uniform_real_distribution<float> rate(0.1f, 4.0f);
+
+    State state, reference_state;
+    StereoBuffer16 output;
+    for (int i = 0; i < 200; ++i) {
+        const StereoBuffer16 input = MakeRandomBuffer(rng, buffer_size(rng));
+        const float rate_multiplier = i % 10 == 0 ? 1.0f : rate(rng);
+        INFO("buffer " << i << " size " << input.size() << " rate " << rate_multiplier);
+
+        Linear(state, input, rate_multiplier, output);
+        REQUIRE(output == ReferenceLinear(reference_state, input, rate_multiplier));
+        REQUIRE(state.xn1 == reference_state.xn1);
+        REQUIRE(state.xn2 == reference_state.xn2);
+    }
+}
+
+TEST_CASE("AudioInterp - Polyphase", "[audio_core]") {
+    std::mt19937 rng(42);
+
+    SECTION("passes samples through at the native rate") {
+        State state, none_state;
+        StereoBuffer16 output, none_output;
+        for (size_t size : {1, 2, 3, 5, 160, 333}) {
+            const StereoBuffer16 input = MakeRandomBuffer(rng, size);
+            Polyphase(state, input, 1.0f, output);
+            None(none_state, input, 1.0f, none_output);
+            REQUIRE(output == none_output);
+        }
+    }
+
+    SECTION("keeps a constant signal constant") {
+        State state;
+        const StereoBuffer16 input(500, Sample{{1234, -32768}});
+        StereoBuffer16 output;
+        Polyphase(state, input, 1.0f, output);
+        Polyphase(state, input, 0.37f, output);
+        REQUIRE(!output.empty());
+        REQUIRE(std::all_of(output.begin(), output.end(),
+                            [&](const Sample& sample) { return sample == input[0]; }));
+    }
+
+    SECTION("produces as many samples as linear interpolation") {
+        State state, linear_state;
+        StereoBuffer16 output, linear_output;
+        const StereoBuffer16 input = MakeRandomBuffer(rng, 321);
+        for (float rate_multiplier : {0.25f, 0.9f, 1.5f, 3.0f}) {
+            Polyphase(state, input, rate_multiplier, output);
+            Linear(linear_state, input, rate_multiplier, linear_output);
+            REQUIRE(output.size() == linear_output.size());
+        }
+    }
+}
+
+} // namespace AudioInterp
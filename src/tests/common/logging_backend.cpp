@@ -0,0 +1,137 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <condition_variable>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <catch.hpp>
+#include "common/logging/backend.h"
+#include "common/logging/log.h"
+
+TEST_CASE("Logging - Entries reach the sinks in order", "[common]") {
+    auto sink = std::make_unique<Log::MemorySink>(16);
+    Log::MemorySink* memory_sink = sink.get();
+    Log::AddSink(std::move(sink));
+
+    for (int i = 0; i < 10; ++i)
+        LOG_INFO(Log, "message %d", i);
+    Log::Flush();
+
+    const auto entries = memory_sink->GetEntries();
+    REQUIRE(entries.size() == 10);
+    for (int i = 0; i < 10; ++i) {
+        REQUIRE(entries[i].log_class == Log::Class::Log);
+        REQUIRE(entries[i].log_level == Log::Level::Info);
+        REQUIRE(std::string(entries[i].message.data()) == "message " + std::to_string(i));
+        REQUIRE(std::strstr(entries[i].location.data(), "logging_backend.cpp") != nullptr);
+    }
+
+    Log::RemoveSink(memory_sink);
+}
+
+TEST_CASE("Logging - MemorySink keeps the most recent entries", "[common]") {
+    Log::MemorySink sink(4);
+    Log::Entry entry{};
+    for (int i = 0; i < 10; ++i) {
+        entry.timestamp = std::chrono::microseconds(i);
+        sink.Write(entry);
+    }
+
+    const auto entries = sink.GetEntries();
+    REQUIRE(entries.size() == 4);
+    for (int i = 0; i < 4; ++i)
+        REQUIRE(entries[i].timestamp.count() == 6 + i);
+}
+
+/// Sink that stalls the writer thread on its first entry until released
+class BlockingSink : public Log::Sink {
+public:
+    void Write(const Log::Entry& entry) override {
+        std::unique_lock<std::mutex> lock(mutex);
+        blocked = true;
+        condvar.notify_all();
+        condvar.wait(lock, [this] { return released; });
+    }
+
+    void WaitUntilBlocked() {
+        std::unique_lock<std::mutex> lock(mutex);
+        condvar.wait(lock, [this] { return blocked; });
+    }
+
+    void Release() {
+        std::lock_guard<std::mutex> lock(mutex);
+        released = true;
+        condvar.notify_all();
+    }
+
+private:
+    std::mutex mutex;
+    std::condition_variable condvar;
+    bool blocked = false;
+    bool released = false;
+};
+
+TEST_CASE("Logging - Entries are dropped instead of blocking when the buffer is full", "[common]") {
+    auto blocking = std::make_unique<BlockingSink>();
+    BlockingSink* blocking_sink = blocking.get();
+    auto memory = std::make_unique<Log::MemorySink>(100000);
+    Log::MemorySink* memory_sink = memory.get();
+    Log::AddSink(std::move(blocking));
+    Log::AddSink(std::move(memory));
+
+    const u64 dropped_before = Log::GetDroppedEntryCount();
+    LOG_INFO(Log, "first");
+    blocking_sink->WaitUntilBlocked();
+
+    // The writer is stuck on the first entry, so these can't all fit in the ring buffer
+    constexpr int num_messages = 10000;
+    for (int i = 0; i < num_messages; ++i)
+        LOG_INFO(Log, "message %d", i);
+
+    const u64 dropped = Log::GetDroppedEntryCount() - dropped_before;
+    REQUIRE(dropped > 0);
+
+    blocking_sink->Release();
+    Log::Flush();
+
+    // All entries that weren't dropped arrive in order, followed by a warning about the others
+    const auto entries = memory_sink->GetEntries();
+    REQUIRE(entries.size() == 1 + num_messages - dropped + 1);
+    REQUIRE(std::string(entries.front().message.data()) == "first");
+    for (size_t i = 1; i + 1 < entries.size(); ++i)
+        REQUIRE(std::string(entries[i].message.data()) == "message " + std::to_string(i - 1));
+    REQUIRE(entries.back().log_level == Log::Level::Warning);
+
+    Log::RemoveSink(memory_sink);
+    Log::RemoveSink(blocking_sink);
+}
+
+TEST_CASE("Logging - Flush returns while other threads are logging", "[common]") {
+    auto sink = std::make_unique<Log::MemorySink>(16);
+    Log::MemorySink* memory_sink = sink.get();
+    Log::AddSink(std::move(sink));
+
+    // Flush has to wait for entries other threads are still formatting; it used to miss their
+    // completion and block forever
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([t] {
+            for (int i = 0; i < 2000; ++i) {
+                LOG_INFO(Log, "thread %d message %d", t, i);
+                Log::Flush();
+            }
+        });
+    }
+    for (auto& thread : threads)
+        thread.join();
+
+    const auto entries = memory_sink->GetEntries();
+    REQUIRE(!entries.empty());
+
+    Log::RemoveSink(memory_sink);
+}
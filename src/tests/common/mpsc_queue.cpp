@@ -0,0 +1,56 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <thread>
+#include <vector>
+#include <catch.hpp>
+#include "common/mpsc_queue.h"
+
+TEST_CASE("MPSCQueue - Single thread", "[common]") {
+    Common::MPSCQueue<int> queue;
+    int value;
+    REQUIRE(!queue.Pop(value));
+
+    for (int i = 0; i < 10; ++i)
+        queue.Push(i);
+    for (int i = 0; i < 10; ++i) {
+        REQUIRE(queue.Pop(value));
+        REQUIRE(value == i);
+    }
+    REQUIRE(!queue.Pop(value));
+}
+
+TEST_CASE("MPSCQueue - Multiple producers", "[common]") {
+    constexpr u32 num_producers = 4;
+    constexpr u32 values_per_producer = 100000;
+
+    // Values encode producer index and sequence number, so that per-producer order can be checked
+    Common::MPSCQueue<u32> queue;
+    std::vector<std::thread> producers;
+    for (u32 producer = 0; producer < num_producers; ++producer) {
+        producers.emplace_back([&queue, producer] {
+            for (u32 i = 0; i < values_per_producer; ++i)
+                queue.Push(producer * values_per_producer + i);
+        });
+    }
+
+    std::vector<u32> next_expected(num_producers, 0);
+    u32 num_popped = 0;
+    while (num_popped < num_producers * values_per_producer) {
+        u32 value;
+        if (!queue.Pop(value))
+            continue;
+        const u32 producer = value / values_per_producer;
+        REQUIRE(producer < num_producers);
+        REQUIRE(value % values_per_producer == next_expected[producer]);
+        ++next_expected[producer];
+        ++num_popped;
+    }
+
+    for (auto& thread : producers)
+        thread.join();
+
+    u32 value;
+    REQUIRE(!queue.Pop(value));
+}
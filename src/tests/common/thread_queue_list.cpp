@@ -0,0 +1,87 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <array>
+#include <catch.hpp>
+#include "common/thread_queue_list.h"
+
+namespace {
+
+struct Element {
+    Common::ThreadQueueListNode<Element> node;
+};
+
+using Queue = Common::ThreadQueueList<Element, 64, &Element::node>;
+
+} // Anonymous namespace
+
+TEST_CASE("ThreadQueueList - Orders by priority, then FIFO", "[common]") {
+    Queue queue;
+    std::array<Element, 6> elements;
+    REQUIRE(queue.get_first() == nullptr);
+    REQUIRE(queue.pop_first() == nullptr);
+
+    queue.push_back(48, &elements[0]);
+    queue.push_back(48, &elements[1]);
+    queue.push_back(63, &elements[2]);
+    queue.push_back(0, &elements[3]);
+    queue.push_front(48, &elements[4]);
+    queue.push_back(24, &elements[5]);
+
+    REQUIRE(queue.contains(&elements[2]) == 63);
+    REQUIRE(queue.get_first() == &elements[3]);
+    REQUIRE(queue.pop_first() == &elements[3]);
+    REQUIRE(queue.contains(&elements[3]) == static_cast<Queue::Priority>(-1));
+
+    // Only levels above the given one are considered
+    REQUIRE(queue.pop_first_better(24) == nullptr);
+    REQUIRE(queue.pop_first_better(25) == &elements[5]);
+
+    REQUIRE(queue.pop_first() == &elements[4]);
+    REQUIRE(queue.pop_first() == &elements[0]);
+    REQUIRE(queue.pop_first() == &elements[1]);
+    REQUIRE(!queue.empty(63));
+    REQUIRE(queue.pop_first() == &elements[2]);
+    REQUIRE(queue.empty(63));
+    REQUIRE(queue.pop_first() == nullptr);
+}
+
+TEST_CASE("ThreadQueueList - Removes, moves and rotates elements", "[common]") {
+    Queue queue;
+    std::array<Element, 4> elements;
+    for (auto& element : elements)
+        queue.push_back(10, &element);
+
+    // Remove from the middle, the front and the back
+    queue.remove(10, &elements[1]);
+    queue.remove(10, &elements[0]);
+    queue.remove(10, &elements[3]);
+    REQUIRE(queue.get_first() == &elements[2]);
+
+    // Removing elements which aren't queued does nothing
+    queue.remove(10, &elements[1]);
+    REQUIRE(queue.get_first() == &elements[2]);
+
+    queue.push_back(10, &elements[0]);
+    queue.push_back(10, &elements[1]);
+    queue.rotate(10);
+    REQUIRE(queue.get_first() == &elements[0]);
+
+    queue.move(&elements[1], 10, 5);
+    REQUIRE(queue.contains(&elements[1]) == 5);
+    REQUIRE(queue.pop_first() == &elements[1]);
+    REQUIRE(queue.pop_first() == &elements[0]);
+    REQUIRE(queue.pop_first() == &elements[2]);
+    REQUIRE(queue.empty(10));
+
+    queue.push_back(3, &elements[0]);
+    queue.push_back(3, &elements[1]);
+    queue.clear();
+    REQUIRE(queue.get_first() == nullptr);
+    REQUIRE(queue.contains(&elements[0]) == static_cast<Queue::Priority>(-1));
+
+    // Cleared elements can be queued again
+    queue.push_back(7, &elements[0]);
+    REQUIRE(queue.pop_first() == &elements[0]);
+}
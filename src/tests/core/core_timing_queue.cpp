@@ -0,0 +1,122 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <list>
+#include <random>
+#include <catch.hpp>
+#include "core/core_timing_queue.h"
+
+namespace CoreTiming {
+
+/// Sorted linked list, scheduling events the way CoreTiming did before EventQueue was introduced
+class ListEventQueue {
+public:
+    bool Empty() const {
+        return events.empty();
+    }
+
+    const EventQueue::Event& Top() const {
+        return events.front();
+    }
+
+    void Push(s64 time, int type, u64 userdata) {
+        auto it = events.begin();
+        while (it != events.end() && !(time < it->time))
+            ++it;
+        events.insert(it, {time, userdata, type});
+    }
+
+    void Pop() {
+        events.pop_front();
+    }
+
+    bool Remove(int type, u64 userdata, s64& last_time) {
+        bool removed = false;
+        for (auto it = events.begin(); it != events.end();) {
+            if (it->type == type && it->userdata == userdata) {
+                last_time = it->time;
+                removed = true;
+                it = events.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        return removed;
+    }
+
+private:
+    std::list<EventQueue::Event> events;
+};
+
+static bool operator==(const EventQueue::Event& a, const EventQueue::Event& b) {
+    return a.time == b.time && a.userdata == b.userdata && a.type == b.type;
+}
+
+TEST_CASE("EventQueue - Fires events in the same order as a sorted list", "[core]") {
+    std::mt19937 rng(42);
+    // Few distinct times and userdata values, so that ties and duplicates are common
+    std::uniform_int_distribution<s64> time(0, 64);
+    std::uniform_int_distribution<int> type(0, 3);
+    std::uniform_int_distribution<u64> userdata(0, 7);
+    std::uniform_int_distribution<int> operation(0, 9);
+
+    EventQueue queue;
+    ListEventQueue reference;
+    s64 now = 0;
+
+    for (int i = 0; i < 20000; ++i) {
+        const int op = operation(rng);
+        if (op < 5) {
+            const s64 event_time = now + time(rng);
+            const int event_type = type(rng);
+            const u64 event_userdata = userdata(rng);
+            queue.Push(event_time, event_type, event_userdata);
+            reference.Push(event_time, event_type, event_userdata);
+        } else if (op < 8) {
+            REQUIRE(queue.Empty() == reference.Empty());
+            if (!queue.Empty()) {
+                REQUIRE(queue.Top() == reference.Top());
+                now = queue.Top().time;
+                queue.Pop();
+                reference.Pop();
+            }
+        } else {
+            const int event_type = type(rng);
+            const u64 event_userdata = userdata(rng);
+            s64 queue_time = 0;
+            s64 reference_time = 0;
+            REQUIRE(queue.Remove(event_type, event_userdata, queue_time) ==
+                    reference.Remove(event_type, event_userdata, reference_time));
+            REQUIRE(queue_time == reference_time);
+        }
+    }
+
+    while (!reference.Empty()) {
+        REQUIRE(!queue.Empty());
+        REQUIRE(queue.Top() == reference.Top());
+        queue.Pop();
+        reference.Pop();
+    }
+    REQUIRE(queue.Empty());
+}
+
+TEST_CASE("EventQueue - RemoveType and ContainsType", "[core]") {
+    EventQueue queue;
+    queue.Push(30, 1, 0);
+    queue.Push(10, 2, 0);
+    queue.Push(20, 1, 1);
+    queue.Push(20, 3, 0);
+
+    REQUIRE(queue.ContainsType(1));
+    queue.RemoveType(1);
+    REQUIRE(!queue.ContainsType(1));
+    REQUIRE(queue.Size() == 2);
+
+    const auto events = queue.GetSortedEvents();
+    REQUIRE(events.size() == 2);
+    REQUIRE(events[0].type == 2);
+    REQUIRE(events[1].type == 3);
+}
+
+} // namespace CoreTiming
@@ -0,0 +1,381 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <random>
+#include <vector>
+#include <catch.hpp>
+#include "common/color.h"
+#include "common/math_util.h"
+#include "core/hle/service/y2r_u.h"
+#include "core/hw/y2r.h"
+#include "core/memory.h"
+#include "core/memory_setup.h"
+#include "core/settings.h"
+
+namespace HW {
+namespace Y2R {
+
+using namespace Service::Y2R;
+
+/// Area of VRAM the tests transfer from and to
+static constexpr VAddr BASE_ADDRESS = Memory::VRAM_VADDR;
+static constexpr u32 MEMORY_SIZE = Memory::VRAM_SIZE;
+
+namespace Reference {
+
+using ImageTile = std::array<u32, 64>;
+
+static const u8 linear_lut[64] = {
+    0,  1,  2,  3,  4,  5,  6,  7,  8,  9,  10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20, 21,
+    22, 23, 24, 25, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35, 36, 37, 38, 39, 40, 41, 42, 43,
+    44, 45, 46, 47, 48, 49, 50, 51, 52, 53, 54, 55, 56, 57, 58, 59, 60, 61, 62, 63,
+};
+
+static const u8 morton_lut[64] = {
+    0,  1,  4,  5,  16, 17, 20, 21, 2,  3,  6,  7,  18, 19, 22, 23, 8,  9,  12, 13, 24, 25,
+    28, 29, 10, 11, 14, 15, 26, 27, 30, 31, 32, 33, 36, 37, 48, 49, 52, 53, 34, 35, 38, 39,
+    50, 51, 54, 55, 40, 41, 44, 45, 56, 57, 60, 61, 42, 43, 46, 47, 58, 59, 62, 63,
+};
+
+/// The per-pixel conversion PerformConversion used before it was vectorized
+static void ConvertYUVToRGB(InputFormat input_format, const u8* input_Y, const u8* input_U,
+                            const u8* input_V, ImageTile output[], unsigned int width,
+                            unsigned int height, const CoefficientSet& c) {
+    for (unsigned int y = 0; y < height; ++y) {
+        for (unsigned int x = 0; x < width; ++x) {
+            s32 Y = 0, U = 0, V = 0;
+            switch (input_format) {
+            case InputFormat::YUV422_Indiv8:
+            case InputFormat::YUV422_Indiv16:
+                Y = input_Y[y * width + x];
+                U = input_U[(y * width + x) / 2];
+                V = input_V[(y * width + x) / 2];
+                break;
+            case InputFormat::YUV420_Indiv8:
+            case InputFormat::YUV420_Indiv16:
+                Y = input_Y[y * width + x];
+                U = input_U[((y / 2) * width + x) / 2];
+                V = input_V[((y / 2) * width + x) / 2];
+                break;
+            case InputFormat::YUYV422_Interleaved:
+                Y = input_Y[(y * width + x) * 2];
+                U = input_Y[(y * width + (x / 2) * 2) * 2 + 1];
+                V = input_Y[(y * width + (x / 2) * 2) * 2 + 3];
+                break;
+            }
+
+            s32 cY = c[0] * Y;
+            s32 r = ((cY + c[1] * V) >> 3) + c[5] + 0x18;
+            s32 g = ((cY - c[2] * V - c[3] * U) >> 3) + c[6] + 0x18;
+            s32 b = ((cY + c[4] * U) >> 3) + c[7] + 0x18;
+
+            using MathUtil::Clamp;
+            output[x / 8][y * 8 + x % 8] = ((u32)Clamp(r >> 5, 0, 0xFF) << 24) |
+                                           ((u32)Clamp(g >> 5, 0, 0xFF) << 16) |
+                                           ((u32)Clamp(b >> 5, 0, 0xFF) << 8);
+        }
+    }
+}
+
+template <size_t N>
+static void ReceiveData(u8* output, ConversionBuffer& buf, size_t amount_of_data) {
+    const u8* input = Memory::GetPointer(buf.address);
+    size_t output_unit = buf.transfer_unit / N;
+    while (amount_of_data > 0) {
+        for (size_t i = 0; i < output_unit; ++i)
+            output[i] = input[i * N];
+        output += output_unit;
+        input += buf.transfer_unit + buf.gap;
+        buf.address += buf.transfer_unit + buf.gap;
+        buf.image_size -= buf.transfer_unit;
+        amount_of_data -= output_unit;
+    }
+}
+
+static void SendData(const u32* input, ConversionBuffer& buf, int amount_of_data,
+                     OutputFormat output_format, u8 alpha) {
+    u8* output = Memory::GetPointer(buf.address);
+    while (amount_of_data > 0) {
+        u8* unit_end = output + buf.transfer_unit;
+        while (output < unit_end) {
+            u32 color = *input++;
+            Math::Vec4<u8> col_vec{(u8)(color >> 24), (u8)(color >> 16), (u8)(color >> 8), alpha};
+            switch (output_format) {
+            case OutputFormat::RGBA8:
+                Color::EncodeRGBA8(col_vec, output);
+                output += 4;
+                break;
+            case OutputFormat::RGB8:
+                Color::EncodeRGB8(col_vec, output);
+                output += 3;
+                break;
+            case OutputFormat::RGB5A1:
+                Color::EncodeRGB5A1(col_vec, output);
+                output += 2;
+                break;
+            case OutputFormat::RGB565:
+                Color::EncodeRGB565(col_vec, output);
+                output += 2;
+                break;
+            }
+            amount_of_data -= 1;
+        }
+        output += buf.gap;
+        buf.address += buf.transfer_unit + buf.gap;
+        buf.image_size -= buf.transfer_unit;
+    }
+}
+
+static void RotateTile(Rotation rotation, const ImageTile& input, ImageTile& output, int height,
+                       const u8 out_map[64]) {
+    int out_i = 0;
+    switch (rotation) {
+    case Rotation::None:
+        for (int i = 0; i < height * 8; ++i)
+            output[out_map[i]] = input[i];
+        break;
+    case Rotation::Clockwise_90:
+        for (int x = 0; x < 8; ++x)
+            for (int y = height - 1; y >= 0; --y)
+                output[out_map[out_i++]] = input[y * 8 + x];
+        break;
+    case Rotation::Clockwise_180:
+        for (int i = height * 8 - 1; i >= 0; --i)
+            output[out_map[out_i++]] = input[i];
+        break;
+    case Rotation::Clockwise_270:
+        for (int x = 8 - 1; x >= 0; --x)
+            for (int y = 0; y < height; ++y)
+                output[out_map[out_i++]] = input[y * 8 + x];
+        break;
+    }
+}
+
+static void WriteTileToOutput(u32* output, const ImageTile& tile, int height, int line_stride) {
+    for (int y = 0; y < height; ++y)
+        for (int x = 0; x < 8; ++x)
+            output[y * line_stride + x] = tile[y * 8 + x];
+}
+
+static void PerformConversion(ConversionConfiguration& cvt) {
+    size_t num_tiles = cvt.input_line_width / 8;
+    std::vector<u8> data_buffer(cvt.input_line_width * 8 * 4);
+    std::vector<ImageTile> tiles(num_tiles);
+    ImageTile tmp_tile;
+    const u8* tile_remap =
+        cvt.block_alignment == BlockAlignment::Linear ? linear_lut : morton_lut;
+
+    for (unsigned int y = 0; y < cvt.input_lines; y += 8) {
+        unsigned int row_height = std::min(cvt.input_lines - y, 8u);
+        const size_t row_data_size = row_height * cvt.input_line_width;
+
+        u8* input_Y = data_buffer.data();
+        u8* input_U = input_Y + 8 * cvt.input_line_width;
+        u8* input_V = input_U + 8 * cvt.input_line_width / 2;
+
+        switch (cvt.input_format) {
+        case InputFormat::YUV422_Indiv8:
+            ReceiveData<1>(input_Y, cvt.src_Y, row_data_size);
+            ReceiveData<1>(input_U, cvt.src_U, row_data_size / 2);
+            ReceiveData<1>(input_V, cvt.src_V, row_data_size / 2);
+            break;
+        case InputFormat::YUV420_Indiv8:
+            ReceiveData<1>(input_Y, cvt.src_Y, row_data_size);
+            ReceiveData<1>(input_U, cvt.src_U, row_data_size / 4);
+            ReceiveData<1>(input_V, cvt.src_V, row_data_size / 4);
+            break;
+        case InputFormat::YUV422_Indiv16:
+            ReceiveData<2>(input_Y, cvt.src_Y, row_data_size);
+            ReceiveData<2>(input_U, cvt.src_U, row_data_size / 2);
+            ReceiveData<2>(input_V, cvt.src_V, row_data_size / 2);
+            break;
+        case InputFormat::YUV420_Indiv16:
+            ReceiveData<2>(input_Y, cvt.src_Y, row_data_size);
+            ReceiveData<2>(input_U, cvt.src_U, row_data_size / 4);
+            ReceiveData<2>(input_V, cvt.src_V, row_data_size / 4);
+            break;
+        case InputFormat::YUYV422_Interleaved:
+            ReceiveData<1>(input_Y, cvt.src_YUYV, row_data_size * 2);
+            break;
+        }
+
+        ConvertYUVToRGB(cvt.input_format, input_Y, input_U, input_V, tiles.data(),
+                        cvt.input_line_width, row_height, cvt.coefficients);
+
+        u32* output_buffer = reinterpret_cast<u32*>(data_buffer.data());
+        for (size_t i = 0; i < num_tiles; ++i) {
+            const bool sideways = cvt.rotation == Rotation::Clockwise_90 ||
+                                  cvt.rotation == Rotation::Clockwise_270;
+            const bool reversed = cvt.rotation == Rotation::Clockwise_180 ||
+                                  cvt.rotation == Rotation::Clockwise_270;
+            RotateTile(cvt.rotation, tiles[reversed ? num_tiles - i - 1 : i], tmp_tile, row_height,
+                       tile_remap);
+
+            if (cvt.block_alignment == BlockAlignment::Linear) {
+                WriteTileToOutput(output_buffer, tmp_tile, row_height,
+                                  sideways ? 8 : cvt.input_line_width);
+                output_buffer += sideways ? 8 * row_height : 8;
+            } else {
+                WriteTileToOutput(output_buffer, tmp_tile, 8, 8);
+                output_buffer += 64;
+            }
+        }
+
+        SendData(reinterpret_cast<u32*>(data_buffer.data()), cvt.dst, (int)row_data_size,
+                 cvt.output_format, (u8)cvt.alpha);
+    }
+}
+
+} // namespace Reference
+
+static size_t GetBytesPerPixel(OutputFormat format) {
+    return format == OutputFormat::RGBA8 ? 4 : format == OutputFormat::RGB8 ? 3 : 2;
+}
+
+static ConversionBuffer MakeBuffer(u32 offset, u32 image_size, u16 transfer_unit, u16 gap) {
+    return {BASE_ADDRESS + offset, image_size, transfer_unit, gap};
+}
+
+/**
+ * Sets up a conversion reading its input planes from separate areas of memory and writing its
+ * output after them, with a gap after every line of each.
+ */
+static ConversionConfiguration MakeConversion(InputFormat input_format, OutputFormat output_format,
+                                              Rotation rotation, BlockAlignment alignment,
+                                              u16 width, u16 lines) {
+    ConversionConfiguration cvt;
+    std::memset(&cvt, 0, sizeof(cvt));
+    cvt.input_format = input_format;
+    cvt.output_format = output_format;
+    cvt.rotation = rotation;
+    cvt.block_alignment = alignment;
+    cvt.input_line_width = width;
+    cvt.input_lines = lines;
+    cvt.alpha = 0xA5;
+
+    const bool is_16bit = input_format == InputFormat::YUV422_Indiv16 ||
+                          input_format == InputFormat::YUV420_Indiv16;
+    const bool is_420 = input_format == InputFormat::YUV420_Indiv8 ||
+                        input_format == InputFormat::YUV420_Indiv16;
+    const u16 sample_size = is_16bit ? 2 : 1;
+    const u32 chroma_lines = is_420 ? lines / 2 : lines;
+    const u16 gap = 12;
+
+    cvt.src_Y = MakeBuffer(0, width * lines * sample_size, width * sample_size, gap);
+    cvt.src_U = MakeBuffer(0x100000, width / 2 * chroma_lines * sample_size,
+                           width / 2 * sample_size, gap);
+    cvt.src_V = MakeBuffer(0x180000, width / 2 * chroma_lines * sample_size,
+                           width / 2 * sample_size, gap);
+    cvt.src_YUYV = MakeBuffer(0, width * lines * 2, width * 2, gap);
+
+    const u16 output_line = static_cast<u16>(width * GetBytesPerPixel(output_format));
+    const u16 output_unit = alignment == BlockAlignment::Block8x8 ? output_line * 8 : output_line;
+    cvt.dst = MakeBuffer(0x200000, output_line * lines, output_unit, 20);
+    return cvt;
+}
+
+static bool SameBuffer(const ConversionBuffer& a, const ConversionBuffer& b) {
+    return a.address == b.address && a.image_size == b.image_size;
+}
+
+/// Runs both implementations over the same memory and compares the results
+static void CheckConversion(std::vector<u8>& memory, const ConversionConfiguration& cvt) {
+    const std::vector<u8> initial_memory = memory;
+
+    ConversionConfiguration expected = cvt;
+    Reference::PerformConversion(expected);
+    const std::vector<u8> expected_memory = memory;
+
+    memory = initial_memory;
+    ConversionConfiguration result = cvt;
+    PerformConversion(result);
+
+    REQUIRE(memory == expected_memory);
+    REQUIRE(SameBuffer(result.src_Y, expected.src_Y));
+    REQUIRE(SameBuffer(result.src_U, expected.src_U));
+    REQUIRE(SameBuffer(result.src_V, expected.src_V));
+    REQUIRE(SameBuffer(result.src_YUYV, expected.src_YUYV));
+    REQUIRE(SameBuffer(result.dst, expected.dst));
+}
+
+static std::vector<u8> MakeRandomMemory() {
+    std::mt19937 rng(1234);
+    std::uniform_int_distribution<int> byte(0, 255);
+    std::vector<u8> memory(MEMORY_SIZE);
+    for (auto& value : memory)
+        value = static_cast<u8>(byte(rng));
+    return memory;
+}
+
+TEST_CASE("Y2R - Matches per-pixel conversion", "[core][y2r]") {
+    std::vector<u8> memory = MakeRandomMemory();
+    Memory::InitMemoryMap();
+    Memory::MapMemoryRegion(BASE_ADDRESS, MEMORY_SIZE, memory.data());
+
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int> small_coefficient(-0x200, 0x200);
+    std::uniform_int_distribution<int> any_coefficient(-0x8000, 0x7FFF);
+
+    const InputFormat input_formats[] = {
+        InputFormat::YUV422_Indiv8, InputFormat::YUV420_Indiv8, InputFormat::YUV422_Indiv16,
+        InputFormat::YUV420_Indiv16, InputFormat::YUYV422_Interleaved,
+    };
+    const OutputFormat output_formats[] = {
+        OutputFormat::RGBA8, OutputFormat::RGB8, OutputFormat::RGB5A1, OutputFormat::RGB565,
+    };
+    const Rotation rotations[] = {
+        Rotation::None, Rotation::Clockwise_90, Rotation::Clockwise_180, Rotation::Clockwise_270,
+    };
+
+    const BlockAlignment alignments[] = {BlockAlignment::Linear, BlockAlignment::Block8x8};
+
+    // Batches are split across threads when configured, which must not change the output. The
+    // test case runs once for each section.
+    SECTION("single-threaded") {
+        Settings::values.y2r_threads = 1;
+    }
+    SECTION("multi-threaded") {
+        Settings::values.y2r_threads = 4;
+    }
+
+    for (InputFormat input_format : input_formats) {
+        for (OutputFormat output_format : output_formats) {
+            for (Rotation rotation : rotations) {
+                for (BlockAlignment alignment : alignments) {
+                    // Enough lines for two batches, with a short last strip when allowed
+                    const u16 lines = alignment == BlockAlignment::Linear ? 146 : 144;
+                    ConversionConfiguration cvt =
+                        MakeConversion(input_format, output_format, rotation, alignment, 40, lines);
+                    for (size_t i = 0; i < 8; ++i) {
+                        cvt.coefficients[i] = static_cast<s16>(
+                            input_format == InputFormat::YUV422_Indiv8 ? any_coefficient(rng)
+                                                                       : small_coefficient(rng));
+                    }
+
+                    INFO("input " << static_cast<int>(input_format) << " output "
+                                  << static_cast<int>(output_format) << " rotation "
+                                  << static_cast<int>(rotation) << " alignment "
+                                  << static_cast<int>(alignment));
+                    CheckConversion(memory, cvt);
+                }
+            }
+        }
+    }
+
+    // Converting in place must behave as if strips were processed one after the other
+    ConversionConfiguration in_place =
+        MakeConversion(InputFormat::YUYV422_Interleaved, OutputFormat::RGB565, Rotation::None,
+                       BlockAlignment::Linear, 64, 64);
+    in_place.coefficients = {{0x100, 0x166, 0xB6, 0x58, 0x1C5, -0x166F, 0x10EE, -0x1C5B}};
+    in_place.dst = in_place.src_YUYV;
+    CheckConversion(memory, in_place);
+
+    Memory::UnmapRegion(BASE_ADDRESS, MEMORY_SIZE);
+}
+
+} // namespace Y2R
+} // namespace HW
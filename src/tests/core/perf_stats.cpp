@@ -0,0 +1,82 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <chrono>
+#include <catch.hpp>
+#include "core/perf_stats.h"
+
+namespace Core {
+
+using std::chrono::microseconds;
+using Stage = PerfStats::Stage;
+
+static PerfStats::FrameTimes MakeFrame(long long emulation, long long present, long long wait) {
+    return {{microseconds(emulation), microseconds(present), microseconds(wait)}};
+}
+
+TEST_CASE("PerfStats - Histograms and averages", "[core]") {
+    PerfStats stats;
+    REQUIRE(stats.GetNumFrames() == 0);
+    REQUIRE(stats.GetPercentile(Stage::Emulation, 0.99) == microseconds::zero());
+
+    stats.AddFrame(MakeFrame(100, 2000, 0));
+    stats.AddFrame(MakeFrame(700, 2000, 1000000));
+    stats.AddFrame(MakeFrame(1000, 2000, 0));
+    stats.AddFrame(MakeFrame(1400, 2000, 0));
+    REQUIRE(stats.GetNumFrames() == 4);
+
+    const auto emulation = stats.GetHistogram(Stage::Emulation);
+    REQUIRE(emulation[0] == 1);
+    REQUIRE(emulation[1] == 1);
+    REQUIRE(emulation[2] == 2);
+
+    // Durations beyond the last bucket are counted in it
+    REQUIRE(stats.GetHistogram(Stage::Wait)[PerfStats::NUM_BUCKETS - 1] == 1);
+
+    const auto averages = stats.GetAverageFrameTimes();
+    REQUIRE(averages[static_cast<size_t>(Stage::Emulation)] == microseconds(800));
+    REQUIRE(averages[static_cast<size_t>(Stage::Present)] == microseconds(2000));
+
+    REQUIRE(stats.GetPercentile(Stage::Emulation, 0.0) == microseconds(500));
+    REQUIRE(stats.GetPercentile(Stage::Emulation, 0.5) == microseconds(1000));
+    REQUIRE(stats.GetPercentile(Stage::Emulation, 0.99) == microseconds(1500));
+}
+
+TEST_CASE("PerfStats - Rolling window drops old frames", "[core]") {
+    PerfStats stats;
+    stats.AddFrame(MakeFrame(10000, 0, 0));
+    for (size_t i = 0; i < PerfStats::HISTORY_SIZE; ++i)
+        stats.AddFrame(MakeFrame(100, 0, 0));
+
+    REQUIRE(stats.GetNumFrames() == PerfStats::HISTORY_SIZE);
+    REQUIRE(stats.GetHistogram(Stage::Emulation)[0] == PerfStats::HISTORY_SIZE);
+    REQUIRE(stats.GetHistogram(Stage::Emulation)[20] == 0);
+    REQUIRE(stats.GetAverageFrameTimes()[0] == microseconds(100));
+
+    stats.Reset();
+    REQUIRE(stats.GetNumFrames() == 0);
+    REQUIRE(stats.GetHistogram(Stage::Emulation)[0] == 0);
+}
+
+TEST_CASE("FrameLimiter - Paces frames to the target speed", "[core]") {
+    using Clock = std::chrono::steady_clock;
+    FrameLimiter limiter;
+
+    // Start a deadline, then pace a few frames at double speed
+    limiter.DoFrameLimiting(2.0);
+    const auto start = Clock::now();
+    for (int i = 0; i < 4; ++i)
+        limiter.DoFrameLimiting(2.0);
+    const auto elapsed = Clock::now() - start;
+    // Four frames at double speed take two native frames, minus however late the timer started
+    REQUIRE(elapsed >= FrameLimiter::NATIVE_FRAME_TIME * 3 / 2);
+
+    // Unlimited speed doesn't wait at all
+    const auto unlimited_start = Clock::now();
+    for (int i = 0; i < 100; ++i)
+        limiter.DoFrameLimiting(0.0);
+    REQUIRE(Clock::now() - unlimited_start < FrameLimiter::NATIVE_FRAME_TIME);
+}
+
+} // namespace Core
@@ -0,0 +1,111 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <cstring>
+#include <string>
+#include <vector>
+#include <catch.hpp>
+#include "common/file_util.h"
+#include "core/tracer/reader.h"
+#include "core/tracer/recorder.h"
+
+namespace CiTrace {
+
+static const std::string test_filename = "citrace_reader_test.ctf";
+
+TEST_CASE("Reader - Loads recorded traces", "[core][tracer]") {
+    Recorder::InitialState state;
+    state.gpu_registers = {0x10, 0x20};
+    state.pica_registers = {1, 2, 3, 4};
+    state.vs_program_binary = {0xDEADBEEF};
+
+    const std::vector<u8> memory = {5, 6, 7, 8, 9};
+    {
+        Recorder recorder(state, test_filename);
+        recorder.MemoryAccessed(memory.data(), 5, 0x18000000);
+        recorder.RegisterWritten<u32>(0x104018F0, 1);
+        recorder.FrameFinished();
+        recorder.Finish();
+    }
+
+    Reader reader;
+    REQUIRE(reader.Load(test_filename));
+    REQUIRE(reader.GetHeader().version == CTHeader::ExpectedVersion());
+    REQUIRE(reader.GetInitialState().gpu_registers == state.gpu_registers);
+    REQUIRE(reader.GetInitialState().pica_registers == state.pica_registers);
+    REQUIRE(reader.GetInitialState().vs_program_binary == state.vs_program_binary);
+    REQUIRE(reader.GetInitialState().lcd_registers.empty());
+
+    const auto& stream = reader.GetStream();
+    REQUIRE(stream.size() == 3);
+    REQUIRE(stream[0].type == MemoryLoad);
+    REQUIRE(std::memcmp(reader.GetMemoryData(stream[0].memory_load), memory.data(), 5) == 0);
+    REQUIRE(stream[1].type == RegisterWrite);
+    REQUIRE(stream[1].register_write.physical_address == 0x104018F0);
+    REQUIRE(stream[2].type == FrameMarker);
+
+    FileUtil::Delete(test_filename);
+}
+
+TEST_CASE("Reader - Loads version 1 traces", "[core][tracer]") {
+    // Version 1 stores all memory contents before a single array of stream elements
+    const u32 memory = 0x12345678;
+    CTHeader header = {};
+    std::memcpy(header.magic, CTHeader::ExpectedMagicWord(), 4);
+    header.version = 1;
+    header.header_size = sizeof(CTHeader);
+    header.initial_state_offsets.pica_registers = sizeof(CTHeader);
+    header.initial_state_offsets.pica_registers_size = 1;
+    header.stream_offset = sizeof(CTHeader) + 2 * sizeof(u32);
+    header.stream_size = 2;
+
+    CTStreamElement elements[2] = {};
+    elements[0].type = MemoryLoad;
+    elements[0].memory_load.file_offset = sizeof(CTHeader) + sizeof(u32);
+    elements[0].memory_load.size = sizeof(u32);
+    elements[1].type = FrameMarker;
+
+    {
+        FileUtil::IOFile file(test_filename, "wb");
+        const u32 pica_register = 42;
+        file.WriteObject(header);
+        file.WriteObject(pica_register);
+        file.WriteObject(memory);
+        file.WriteArray(elements, 2);
+    }
+
+    Reader reader;
+    REQUIRE(reader.Load(test_filename));
+    REQUIRE(reader.GetInitialState().pica_registers == std::vector<u32>{42});
+    REQUIRE(reader.GetStream().size() == 2);
+    REQUIRE(std::memcmp(reader.GetMemoryData(reader.GetStream()[0].memory_load), &memory, 4) == 0);
+    REQUIRE(reader.GetStream()[1].type == FrameMarker);
+
+    // Memory loads outside of the file are rejected
+    elements[0].memory_load.file_offset = 0x10000;
+    {
+        FileUtil::IOFile file(test_filename, "r+b");
+        file.Seek(header.stream_offset, SEEK_SET);
+        file.WriteArray(elements, 2);
+    }
+    REQUIRE(!reader.Load(test_filename));
+
+    FileUtil::Delete(test_filename);
+}
+
+TEST_CASE("Reader - Rejects files which are not CiTraces", "[core][tracer]") {
+    {
+        FileUtil::IOFile file(test_filename, "wb");
+        const std::vector<u8> garbage(sizeof(CTHeader) + 16, 0xAB);
+        file.WriteBytes(garbage.data(), garbage.size());
+    }
+
+    Reader reader;
+    REQUIRE(!reader.Load(test_filename));
+    FileUtil::Delete(test_filename);
+
+    REQUIRE(!reader.Load(test_filename));
+}
+
+} // namespace CiTrace
@@ -0,0 +1,140 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <cstring>
+#include <string>
+#include <vector>
+#include <catch.hpp>
+#include "common/file_util.h"
+#include "core/tracer/recorder.h"
+
+namespace CiTrace {
+
+static const std::string test_filename = "citrace_recorder_test.ctf";
+
+/// Parsed contents of a CiTrace file
+struct Trace {
+    CTHeader header;
+    std::vector<u32> pica_registers;
+    std::vector<CTStreamElement> stream;
+    size_t num_chunks = 0;
+    std::vector<u8> file_data;
+};
+
+static Trace ReadTrace(const std::string& filename) {
+    Trace trace;
+    FileUtil::IOFile file(filename, "rb");
+    REQUIRE(file.IsOpen());
+    trace.file_data.resize(file.GetSize());
+    REQUIRE(file.ReadBytes(trace.file_data.data(), trace.file_data.size()) ==
+            trace.file_data.size());
+
+    const u8* data = trace.file_data.data();
+    std::memcpy(&trace.header, data, sizeof(CTHeader));
+
+    const auto& initial = trace.header.initial_state_offsets;
+    trace.pica_registers.resize(initial.pica_registers_size);
+    std::memcpy(trace.pica_registers.data(), data + initial.pica_registers,
+                initial.pica_registers_size * sizeof(u32));
+
+    size_t offset = trace.header.stream_offset;
+    while (offset < trace.file_data.size()) {
+        CTStreamChunk chunk;
+        std::memcpy(&chunk, data + offset, sizeof(chunk));
+        offset += sizeof(chunk) + chunk.data_size;
+
+        for (u32 i = 0; i < chunk.num_elements; ++i) {
+            CTStreamElement element;
+            std::memcpy(&element, data + offset, sizeof(element));
+            trace.stream.push_back(element);
+            offset += sizeof(element);
+        }
+        trace.num_chunks++;
+    }
+    REQUIRE(offset == trace.file_data.size());
+    return trace;
+}
+
+static std::vector<u8> GetMemory(const Trace& trace, const CTMemoryLoad& load) {
+    REQUIRE(load.file_offset + load.size <= trace.file_data.size());
+    const u8* begin = trace.file_data.data() + load.file_offset;
+    return std::vector<u8>(begin, begin + load.size);
+}
+
+TEST_CASE("Recorder - Streams and deduplicates memory loads", "[core][tracer]") {
+    Recorder::InitialState state;
+    state.pica_registers = {1, 2, 3};
+
+    const std::vector<u8> memory_a = {1, 2, 3, 4, 5, 6, 7, 8};
+    const std::vector<u8> memory_b = {9, 10, 11};
+    {
+        Recorder recorder(state, test_filename);
+        recorder.MemoryAccessed(memory_a.data(), 8, 0x18000000);
+        recorder.RegisterWritten<u32>(0x1EF01000, 0x12345678);
+        recorder.FrameFinished();
+        recorder.MemoryAccessed(memory_a.data(), 8, 0x18001000);
+        recorder.MemoryAccessed(memory_b.data(), 3, 0x18002000);
+        recorder.Finish();
+    }
+
+    const Trace trace = ReadTrace(test_filename);
+    REQUIRE(std::memcmp(trace.header.magic, CTHeader::ExpectedMagicWord(), 4) == 0);
+    REQUIRE(trace.header.version == CTHeader::ExpectedVersion());
+    REQUIRE(trace.pica_registers == state.pica_registers);
+    REQUIRE(trace.header.stream_size == 5);
+    REQUIRE(trace.stream.size() == 5);
+
+    REQUIRE(trace.stream[0].type == MemoryLoad);
+    REQUIRE(trace.stream[0].memory_load.physical_address == 0x18000000);
+    REQUIRE(GetMemory(trace, trace.stream[0].memory_load) == memory_a);
+
+    REQUIRE(trace.stream[1].type == RegisterWrite);
+    REQUIRE(trace.stream[1].register_write.size == CTRegisterWrite::SIZE_32);
+    REQUIRE(trace.stream[1].register_write.value == 0x12345678);
+
+    REQUIRE(trace.stream[2].type == FrameMarker);
+
+    // Identical memory contents are only stored once
+    REQUIRE(trace.stream[3].memory_load.physical_address == 0x18001000);
+    REQUIRE(trace.stream[3].memory_load.file_offset == trace.stream[0].memory_load.file_offset);
+    REQUIRE(GetMemory(trace, trace.stream[4].memory_load) == memory_b);
+
+    FileUtil::Delete(test_filename);
+}
+
+TEST_CASE("Recorder - Refers to memory stored in earlier chunks", "[core][tracer]") {
+    const std::vector<u8> memory = {0xAA, 0xBB, 0xCC, 0xDD};
+    const u32 num_register_writes = 100000;
+    {
+        Recorder recorder({}, test_filename);
+        recorder.MemoryAccessed(memory.data(), 4, 0x18000000);
+        for (u32 i = 0; i < num_register_writes; ++i)
+            recorder.RegisterWritten<u32>(0x1EF01000, i);
+        recorder.MemoryAccessed(memory.data(), 4, 0x18000000);
+        recorder.Finish();
+    }
+
+    const Trace trace = ReadTrace(test_filename);
+    REQUIRE(trace.num_chunks > 1);
+    REQUIRE(trace.header.stream_size == num_register_writes + 2);
+    REQUIRE(trace.stream.size() == num_register_writes + 2);
+    REQUIRE(trace.stream[num_register_writes].register_write.value == num_register_writes - 1);
+
+    const auto& last_load = trace.stream.back().memory_load;
+    REQUIRE(last_load.file_offset == trace.stream.front().memory_load.file_offset);
+    REQUIRE(GetMemory(trace, last_load) == memory);
+
+    FileUtil::Delete(test_filename);
+}
+
+TEST_CASE("Recorder - Deletes unfinished recordings", "[core][tracer]") {
+    {
+        Recorder recorder({}, test_filename);
+        recorder.FrameFinished();
+        REQUIRE(FileUtil::Exists(test_filename));
+    }
+    REQUIRE(!FileUtil::Exists(test_filename));
+}
+
+} // namespace CiTrace
@@ -0,0 +1,120 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <cstring>
+#include <random>
+#include <vector>
+#include <catch.hpp>
+#include "video_core/morton.h"
+
+namespace VideoCore {
+
+/// Position of a pixel in its tile, computed bit by bit instead of using the lookup table
+static u32 ReferenceMortonIndex(u32 x, u32 y) {
+    u32 index = 0;
+    for (u32 bit = 0; bit < 3; ++bit) {
+        index |= ((x >> bit) & 1) << (2 * bit);
+        index |= ((y >> bit) & 1) << (2 * bit + 1);
+    }
+    return index;
+}
+
+enum class Format { Plain, D24S8, D24 };
+
+/// Pixel by pixel conversion, like the texture paths did before the tiling module existed
+static void ReferenceMortonCopy(Format format, u32 bytes_per_pixel, u32 width, u32 height,
+                                u8* tiled, u8* linear, ptrdiff_t linear_stride, bool to_linear) {
+    const u32 linear_bytes_per_pixel = format == Format::D24 ? 4 : bytes_per_pixel;
+    for (u32 y = 0; y < height; ++y) {
+        for (u32 x = 0; x < width; ++x) {
+            const u32 tiled_offset =
+                ((y & ~7) * width + (x & ~7) * 8 + ReferenceMortonIndex(x & 7, y & 7)) *
+                bytes_per_pixel;
+            u8* tiled_pixel = tiled + tiled_offset;
+            u8* linear_pixel = linear + y * linear_stride + x * linear_bytes_per_pixel;
+
+            if (format == Format::D24S8) {
+                u32 value;
+                std::memcpy(&value, to_linear ? tiled_pixel : linear_pixel, 4);
+                value = to_linear ? (value << 8) | (value >> 24) : (value << 24) | (value >> 8);
+                std::memcpy(to_linear ? linear_pixel : tiled_pixel, &value, 4);
+            } else if (format == Format::D24) {
+                if (to_linear) {
+                    linear_pixel[0] = 0;
+                    std::memcpy(linear_pixel + 1, tiled_pixel, 3);
+                } else {
+                    std::memcpy(tiled_pixel, linear_pixel + 1, 3);
+                }
+            } else if (to_linear) {
+                std::memcpy(linear_pixel, tiled_pixel, bytes_per_pixel);
+            } else {
+                std::memcpy(tiled_pixel, linear_pixel, bytes_per_pixel);
+            }
+        }
+    }
+}
+
+template <typename CopyFunction>
+static void TestMortonCopy(u32 width, u32 height, u32 bytes_per_pixel, bool to_linear,
+                           bool bottom_up, Format format, CopyFunction copy) {
+    const u32 linear_bytes_per_pixel = format == Format::D24 ? 4 : bytes_per_pixel;
+    std::mt19937 rng(width * 1000 + height);
+    std::uniform_int_distribution<int> byte(0, 255);
+
+    // Partial tiles are addressed as if they were complete
+    std::vector<u8> tiled(((width + 7) & ~7) * ((height + 7) & ~7) * bytes_per_pixel);
+    std::vector<u8> linear(width * height * linear_bytes_per_pixel);
+    for (auto& value : to_linear ? tiled : linear)
+        value = static_cast<u8>(byte(rng));
+    std::vector<u8> expected_tiled = tiled;
+    std::vector<u8> expected_linear = linear;
+
+    ptrdiff_t stride = width * linear_bytes_per_pixel;
+    ptrdiff_t first_line = bottom_up ? (height - 1) * stride : 0;
+    if (bottom_up)
+        stride = -stride;
+
+    ReferenceMortonCopy(format, bytes_per_pixel, width, height, expected_tiled.data(),
+                        expected_linear.data() + first_line, stride, to_linear);
+    copy(tiled.data(), linear.data() + first_line, stride);
+
+    REQUIRE(tiled == expected_tiled);
+    REQUIRE(linear == expected_linear);
+}
+
+TEST_CASE("Morton - Lookup table matches the bit interleaving", "[video_core]") {
+    for (u32 y = 0; y < 8; ++y) {
+        for (u32 x = 0; x < 8; ++x)
+            REQUIRE(morton_lut[y * 8 + x] == ReferenceMortonIndex(x, y));
+    }
+}
+
+TEST_CASE("Morton - Copies match the per-pixel conversion", "[video_core]") {
+    const u32 sizes[][2] = {{8, 8}, {64, 32}, {24, 40}, {20, 13}, {3, 5}};
+    for (const auto& size : sizes) {
+        const u32 width = size[0];
+        const u32 height = size[1];
+        for (bool to_linear : {false, true}) {
+            for (bool bottom_up : {false, true}) {
+                for (u32 bytes_per_pixel = 1; bytes_per_pixel <= 4; ++bytes_per_pixel) {
+                    TestMortonCopy(width, height, bytes_per_pixel, to_linear, bottom_up,
+                                   Format::Plain, [&](u8* tiled, u8* linear, ptrdiff_t stride) {
+                                       MortonCopy(bytes_per_pixel, width, height, tiled, linear,
+                                                  stride, to_linear);
+                                   });
+                }
+                TestMortonCopy(width, height, 4, to_linear, bottom_up, Format::D24S8,
+                               [&](u8* tiled, u8* linear, ptrdiff_t stride) {
+                                   MortonCopyD24S8(width, height, tiled, linear, stride, to_linear);
+                               });
+                TestMortonCopy(width, height, 3, to_linear, bottom_up, Format::D24,
+                               [&](u8* tiled, u8* linear, ptrdiff_t stride) {
+                                   MortonCopyD24(width, height, tiled, linear, stride, to_linear);
+                               });
+            }
+        }
+    }
+}
+
+} // namespace VideoCore
@@ -0,0 +1,152 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <cstring>
+#include <random>
+#include <vector>
+#include <catch.hpp>
+#include "core/memory.h"
+#include "core/memory_setup.h"
+#include "video_core/pica.h"
+#include "video_core/pica_state.h"
+#include "video_core/shader/shader.h"
+#include "video_core/swrasterizer.h"
+#include "video_core/video_core.h"
+
+namespace VideoCore {
+
+using Pica::float24;
+using Pica::Regs;
+using Pica::Shader::OutputVertex;
+
+static constexpr PAddr COLOR_BUFFER_ADDR = Memory::VRAM_PADDR;
+static constexpr PAddr DEPTH_BUFFER_ADDR = Memory::VRAM_PADDR + 0x100000;
+
+static void SetupRegisters() {
+    Pica::g_state.Reset();
+    auto& regs = Pica::g_state.regs;
+
+    // 256x256 viewport and render target
+    regs.viewport_size_x.Assign(0x460000);      // 128.0f
+    regs.viewport_size_y.Assign(0x460000);      // 128.0f
+    regs.viewport_depth_range.Assign(0x3F0000); // 1.0f
+    regs.depthmap_enable.Assign(Regs::DepthBuffering::ZBuffering);
+
+    regs.framebuffer.color_buffer_address = COLOR_BUFFER_ADDR / 8;
+    regs.framebuffer.depth_buffer_address = DEPTH_BUFFER_ADDR / 8;
+    regs.framebuffer.color_format.Assign(Regs::ColorFormat::RGBA8);
+    regs.framebuffer.depth_format = Regs::DepthFormat::D24S8;
+    regs.framebuffer.width.Assign(256);
+    regs.framebuffer.height.Assign(256);
+    regs.framebuffer.allow_color_write.Assign(0xF);
+    regs.framebuffer.allow_depth_stencil_write.Assign(0x3);
+
+    // Exercise depth, stencil and blending, which all depend on previously drawn triangles
+    auto& output_merger = regs.output_merger;
+    output_merger.depth_test_enable.Assign(1);
+    output_merger.depth_test_func.Assign(Regs::CompareFunc::GreaterThanOrEqual);
+    output_merger.depth_write_enable.Assign(1);
+    output_merger.red_enable.Assign(1);
+    output_merger.green_enable.Assign(1);
+    output_merger.blue_enable.Assign(1);
+    output_merger.alpha_enable.Assign(1);
+    output_merger.stencil_test.enable.Assign(1);
+    output_merger.stencil_test.func.Assign(Regs::CompareFunc::Always);
+    output_merger.stencil_test.write_mask.Assign(0xFF);
+    output_merger.stencil_test.action_depth_pass.Assign(Regs::StencilAction::IncrementWrap);
+    output_merger.stencil_test.action_depth_fail.Assign(Regs::StencilAction::Invert);
+    output_merger.alphablend_enable.Assign(1);
+    output_merger.alpha_blending.factor_source_rgb.Assign(Regs::BlendFactor::SourceAlpha);
+    output_merger.alpha_blending.factor_dest_rgb.Assign(Regs::BlendFactor::OneMinusSourceAlpha);
+    output_merger.alpha_blending.factor_source_a.Assign(Regs::BlendFactor::One);
+    output_merger.alpha_blending.factor_dest_a.Assign(Regs::BlendFactor::Zero);
+}
+
+static std::vector<OutputVertex> GenerateVertices(size_t count) {
+    std::mt19937 rng(1234);
+    std::uniform_real_distribution<float> position(-1.25f, 1.25f);
+    std::uniform_real_distribution<float> depth(-1.0f, 0.0f);
+    std::uniform_real_distribution<float> color(0.0f, 1.0f);
+
+    std::vector<OutputVertex> vertices(count);
+    for (auto& vertex : vertices) {
+        std::memset(&vertex, 0, sizeof(vertex));
+        vertex.pos = Math::MakeVec(float24::FromFloat32(position(rng)),
+                                   float24::FromFloat32(position(rng)),
+                                   float24::FromFloat32(depth(rng)), float24::FromFloat32(1.0f));
+        vertex.color = Math::MakeVec(
+            float24::FromFloat32(color(rng)), float24::FromFloat32(color(rng)),
+            float24::FromFloat32(color(rng)), float24::FromFloat32(color(rng)));
+    }
+    return vertices;
+}
+
+static std::vector<u8> Render(const std::vector<OutputVertex>& vertices, int num_threads,
+                              std::vector<u8>& vram) {
+    std::fill(vram.begin(), vram.end(), 0);
+    g_sw_rasterizer_threads = num_threads;
+
+    SWRasterizer rasterizer;
+    for (size_t i = 0; i + 2 < vertices.size(); i += 3) {
+        rasterizer.AddTriangle(vertices[i], vertices[i + 1], vertices[i + 2]);
+
+        // Split the triangles into several draws of varying size
+        if ((i / 3) % 97 == 0)
+            rasterizer.DrawTriangles();
+    }
+    rasterizer.DrawTriangles();
+
+    return vram;
+}
+
+TEST_CASE("SWRasterizer - Tiled output matches serial output", "[video_core]") {
+    std::vector<u8> vram(Memory::VRAM_SIZE);
+    Memory::InitMemoryMap();
+    Memory::MapMemoryRegion(Memory::VRAM_VADDR, Memory::VRAM_SIZE, vram.data());
+
+    SetupRegisters();
+    const auto vertices = GenerateVertices(3 * 1000);
+
+    const auto serial = Render(vertices, 1, vram);
+    for (int num_threads : {2, 3, 8}) {
+        REQUIRE(Render(vertices, num_threads, vram) == serial);
+    }
+
+    Memory::UnmapRegion(Memory::VRAM_VADDR, Memory::VRAM_SIZE);
+    g_sw_rasterizer_threads = 1;
+}
+
+
+TEST_CASE("SWRasterizer - Early depth test matches per-pixel depth test", "[video_core]") {
+    std::vector<u8> vram(Memory::VRAM_SIZE);
+    Memory::InitMemoryMap();
+    Memory::MapMemoryRegion(Memory::VRAM_VADDR, Memory::VRAM_SIZE, vram.data());
+
+    SetupRegisters();
+    auto& output_merger = Pica::g_state.regs.output_merger;
+    // Map depth to [0, 1] rather than clamping it to 0, so that the depth tests have work to do
+    Pica::g_state.regs.viewport_depth_range.Assign(0xBF0000); // -1.0f
+    const auto vertices = GenerateVertices(3 * 300);
+
+    for (auto func : {Regs::CompareFunc::Never, Regs::CompareFunc::Always,
+                      Regs::CompareFunc::Equal, Regs::CompareFunc::NotEqual,
+                      Regs::CompareFunc::LessThan, Regs::CompareFunc::LessThanOrEqual,
+                      Regs::CompareFunc::GreaterThan, Regs::CompareFunc::GreaterThanOrEqual}) {
+        output_merger.depth_test_func.Assign(func);
+
+        // Stencil actions which leave the stencil buffer unchanged still force the depth test to
+        // run per pixel
+        output_merger.stencil_test.enable.Assign(1);
+        output_merger.stencil_test.action_depth_pass.Assign(Regs::StencilAction::Keep);
+        output_merger.stencil_test.action_depth_fail.Assign(Regs::StencilAction::Keep);
+        const auto per_pixel = Render(vertices, 1, vram);
+
+        output_merger.stencil_test.enable.Assign(0);
+        REQUIRE(Render(vertices, 1, vram) == per_pixel);
+    }
+
+    Memory::UnmapRegion(Memory::VRAM_VADDR, Memory::VRAM_SIZE);
+}
+
+} // namespace VideoCore
@@ -0,0 +1,163 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <vector>
+#include <catch.hpp>
+#include "core/memory.h"
+#include "core/memory_setup.h"
+#include "video_core/debug_utils/debug_utils.h"
+#include "video_core/pica.h"
+#include "video_core/texture/texture_cache.h"
+
+namespace Pica {
+namespace Texture {
+
+using TextureFormat = Regs::TextureFormat;
+
+/// 32x32 RGBA8 textures, 4 KiB each both encoded and decoded
+static constexpr unsigned TEXTURE_SIZE = 32 * 32 * 4;
+
+static DebugUtils::TextureInfo MakeTextureInfo(PAddr address) {
+    DebugUtils::TextureInfo info;
+    info.physical_address = address;
+    info.width = 32;
+    info.height = 32;
+    info.format = TextureFormat::RGBA8;
+    info.stride = 32 * 4;
+    return info;
+}
+
+/// Maps VRAM for the duration of a test
+class VRAMFixture {
+public:
+    VRAMFixture() : vram(Memory::VRAM_SIZE) {
+        Memory::InitMemoryMap();
+        Memory::MapMemoryRegion(Memory::VRAM_VADDR, Memory::VRAM_SIZE, vram.data());
+    }
+
+    ~VRAMFixture() {
+        Memory::UnmapRegion(Memory::VRAM_VADDR, Memory::VRAM_SIZE);
+    }
+
+protected:
+    std::vector<u8> vram;
+};
+
+TEST_CASE_METHOD(VRAMFixture, "TextureCache - Hits and invalidation", "[video_core]") {
+    TextureCache cache(1024 * 1024);
+    const PAddr address = Memory::VRAM_PADDR;
+
+    // RGBA8 texels are stored as ABGR
+    vram[0] = 0x40;
+    vram[1] = 0x30;
+    vram[2] = 0x20;
+    vram[3] = 0x10;
+
+    const auto texture = cache.GetTexture(MakeTextureInfo(address));
+    REQUIRE(texture != nullptr);
+    REQUIRE(texture->width == 32);
+    REQUIRE(texture->height == 32);
+    REQUIRE(texture->texels.size() == 32 * 32);
+    REQUIRE(texture->texels[0].r() == 0x10);
+    REQUIRE(texture->texels[0].a() == 0x40);
+
+    REQUIRE(cache.GetTexture(MakeTextureInfo(address)) == texture);
+    REQUIRE(cache.GetNumTextures() == 1);
+    REQUIRE(cache.GetSize() == 32 * 32 * sizeof(Math::Vec4<u8>));
+
+    // Same address, different format
+    auto info = MakeTextureInfo(address);
+    info.format = TextureFormat::RGBA4;
+    info.stride = 32 * 2;
+    REQUIRE(cache.GetTexture(info) != texture);
+    REQUIRE(cache.GetNumTextures() == 2);
+
+    // Regions right before or after the texture don't affect it
+    cache.InvalidateRegion(address + TEXTURE_SIZE, 0x1000);
+    cache.InvalidateRegion(address - 0x1000, 0x1000);
+    REQUIRE(cache.GetTexture(MakeTextureInfo(address)) == texture);
+
+    vram[3] = 0x11;
+    cache.InvalidateRegion(address + TEXTURE_SIZE - 1, 1);
+    REQUIRE(cache.GetNumTextures() == 1);
+
+    const auto reloaded = cache.GetTexture(MakeTextureInfo(address));
+    REQUIRE(reloaded != texture);
+    REQUIRE(reloaded->texels[0].r() == 0x11);
+
+    // The evicted texture is still usable by whoever holds on to it
+    REQUIRE(texture->texels[0].r() == 0x10);
+
+    cache.Clear();
+    REQUIRE(cache.GetNumTextures() == 0);
+    REQUIRE(cache.GetSize() == 0);
+}
+
+TEST_CASE_METHOD(VRAMFixture, "TextureCache - Evicts least recently used textures",
+                 "[video_core]") {
+    const size_t decoded_size = 32 * 32 * sizeof(Math::Vec4<u8>);
+    TextureCache cache(2 * decoded_size);
+
+    const auto a = cache.GetTexture(MakeTextureInfo(Memory::VRAM_PADDR));
+    const auto b = cache.GetTexture(MakeTextureInfo(Memory::VRAM_PADDR + TEXTURE_SIZE));
+    REQUIRE(cache.GetTexture(MakeTextureInfo(Memory::VRAM_PADDR)) == a);
+
+    const auto c = cache.GetTexture(MakeTextureInfo(Memory::VRAM_PADDR + 2 * TEXTURE_SIZE));
+    REQUIRE(cache.GetNumTextures() == 2);
+    REQUIRE(cache.GetSize() == 2 * decoded_size);
+    REQUIRE(cache.GetTexture(MakeTextureInfo(Memory::VRAM_PADDR)) == a);
+    REQUIRE(cache.GetTexture(MakeTextureInfo(Memory::VRAM_PADDR + 2 * TEXTURE_SIZE)) == c);
+    REQUIRE(cache.GetTexture(MakeTextureInfo(Memory::VRAM_PADDR + TEXTURE_SIZE)) != b);
+
+    cache.SetBudget(decoded_size);
+    REQUIRE(cache.GetNumTextures() == 1);
+
+    // Without a budget, textures are still decoded but not kept
+    cache.SetBudget(0);
+    REQUIRE(cache.GetNumTextures() == 0);
+    const auto uncached = cache.GetTexture(MakeTextureInfo(Memory::VRAM_PADDR));
+    REQUIRE(uncached != nullptr);
+    REQUIRE(uncached->texels.size() == 32 * 32);
+    REQUIRE(cache.GetNumTextures() == 0);
+    REQUIRE(cache.GetSize() == 0);
+}
+
+TEST_CASE("TextureCache - Textures running into unmapped memory", "[video_core]") {
+    // Only the first half of VRAM is mapped. The host memory after the mapping is filled with a
+    // different value, which would show up in the texture if it was read.
+    std::vector<u8> vram(Memory::VRAM_SIZE, 0xFF);
+    std::fill(vram.begin(), vram.begin() + Memory::VRAM_SIZE / 2, 0xAA);
+    Memory::InitMemoryMap();
+    Memory::MapMemoryRegion(Memory::VRAM_VADDR, Memory::VRAM_SIZE / 2, vram.data());
+
+    // The second half of this texture, i.e. the tiles from line 16 on, lies in the first unmapped
+    // page. Those texels are left transparent black.
+    TextureCache cache(1024 * 1024);
+    const PAddr address = Memory::VRAM_PADDR + Memory::VRAM_SIZE / 2 - TEXTURE_SIZE / 2;
+    const auto texture = cache.GetTexture(MakeTextureInfo(address));
+    REQUIRE(texture != nullptr);
+    REQUIRE(cache.GetNumTextures() == 1);
+    for (unsigned y = 0; y < 32; ++y) {
+        const u8 expected = y < 16 ? 0xAA : 0x00;
+        for (unsigned x = 0; x < 32; ++x) {
+            const auto& texel = texture->texels[y * 32 + x];
+            REQUIRE(texel.r() == expected);
+            REQUIRE(texel.a() == expected);
+        }
+    }
+
+    cache.InvalidateRegion(address + TEXTURE_SIZE - 1, 1);
+    REQUIRE(cache.GetNumTextures() == 0);
+    REQUIRE(Memory::IsValidPhysicalAddress(address));
+
+    // Textures starting in unmapped memory aren't decoded at all
+    REQUIRE(cache.GetTexture(MakeTextureInfo(address + TEXTURE_SIZE)) == nullptr);
+    REQUIRE(cache.GetNumTextures() == 0);
+
+    Memory::UnmapRegion(Memory::VRAM_VADDR, Memory::VRAM_SIZE / 2);
+}
+
+} // namespace Texture
+} // namespace Pica
@@ -0,0 +1,87 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <random>
+#include <vector>
+#include <catch.hpp>
+#include "common/vector_math.h"
+#include "video_core/debug_utils/debug_utils.h"
+#include "video_core/pica.h"
+#include "video_core/texture/texture_decoder.h"
+
+namespace Pica {
+namespace Texture {
+
+using TextureFormat = Regs::TextureFormat;
+
+static const TextureFormat all_formats[] = {
+    TextureFormat::RGBA8, TextureFormat::RGB8, TextureFormat::RGB5A1, TextureFormat::RGB565,
+    TextureFormat::RGBA4, TextureFormat::IA8,  TextureFormat::RG8,    TextureFormat::I8,
+    TextureFormat::A8,    TextureFormat::IA4,  TextureFormat::I4,     TextureFormat::A4,
+    TextureFormat::ETC1,  TextureFormat::ETC1A4,
+};
+
+/// Packs a texel into a single value for comparisons
+static u32 Pack(const Math::Vec4<u8>& texel) {
+    return texel.r() | texel.g() << 8 | texel.b() << 16 | texel.a() << 24;
+}
+
+static DebugUtils::TextureInfo MakeTextureInfo(TextureFormat format, int width, int height) {
+    DebugUtils::TextureInfo info;
+    info.physical_address = 0;
+    info.width = width;
+    info.height = height;
+    info.format = format;
+    info.stride = Regs::NibblesPerPixel(format) * width / 2;
+    return info;
+}
+
+static std::vector<u8> MakeRandomTexture(const DebugUtils::TextureInfo& info, u32 seed) {
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<int> byte(0, 255);
+    std::vector<u8> data(GetTileSize(info.format) * (info.width / 8) * (info.height / 8));
+    for (auto& value : data)
+        value = static_cast<u8>(byte(rng));
+    return data;
+}
+
+TEST_CASE("TextureDecoder - Matches LookupTexture for all formats", "[video_core]") {
+    for (TextureFormat format : all_formats) {
+        const auto info = MakeTextureInfo(format, 32, 16);
+        const std::vector<u8> data = MakeRandomTexture(info, static_cast<u32>(format));
+
+        std::vector<Math::Vec4<u8>> decoded(info.width * info.height);
+        DecodeTexture(info, data.data(), decoded.data(), info.width);
+
+        for (int y = 0; y < info.height; ++y) {
+            for (int x = 0; x < info.width; ++x) {
+                const Math::Vec4<u8> expected = DebugUtils::LookupTexture(data.data(), x, y, info);
+                const Math::Vec4<u8> actual = decoded[y * info.width + x];
+                INFO("format " << static_cast<int>(format) << " texel " << x << "," << y);
+                REQUIRE(Pack(actual) == Pack(expected));
+            }
+        }
+    }
+}
+
+TEST_CASE("TextureDecoder - Bottom-up output", "[video_core]") {
+    const auto info = MakeTextureInfo(TextureFormat::RGBA4, 16, 16);
+    const std::vector<u8> data = MakeRandomTexture(info, 1);
+
+    std::vector<Math::Vec4<u8>> top_down(info.width * info.height);
+    std::vector<Math::Vec4<u8>> bottom_up(info.width * info.height);
+    DecodeTexture(info, data.data(), top_down.data(), info.width);
+    DecodeTexture(info, data.data(), bottom_up.data() + (info.height - 1) * info.width,
+                  -info.width);
+
+    for (int y = 0; y < info.height; ++y) {
+        for (int x = 0; x < info.width; ++x) {
+            REQUIRE(Pack(top_down[y * info.width + x]) ==
+                    Pack(bottom_up[(info.height - 1 - y) * info.width + x]));
+        }
+    }
+}
+
+} // namespace Texture
+} // namespace Pica
@@ -0,0 +1,50 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <vector>
+#include <catch.hpp>
+#include "video_core/vertex_cache.h"
+
+namespace Pica {
+
+TEST_CASE("VertexCache - Deduplicates 8-bit indices", "[video_core]") {
+    VertexCache cache;
+    const std::vector<u8> indices = {5, 7, 5, 200, 7, 7, 0};
+    cache.Build(indices.data(), false, static_cast<u32>(indices.size()));
+
+    REQUIRE(cache.GetUniqueVertices() == std::vector<u32>({5, 7, 200, 0}));
+    REQUIRE(cache.GetSlots() == std::vector<u32>({0, 1, 0, 2, 1, 1, 3}));
+
+    const auto& stats = cache.GetStats();
+    REQUIRE(stats.num_indices == 7);
+    REQUIRE(stats.num_unique_vertices == 4);
+    REQUIRE(stats.GetHitRate() == Approx(3.0 / 7.0));
+}
+
+TEST_CASE("VertexCache - Deduplicates 16-bit indices across draws", "[video_core]") {
+    VertexCache cache;
+    const std::vector<u16> first = {0xFFFF, 0x1234, 0xFFFF, 3};
+    cache.Build(reinterpret_cast<const u8*>(first.data()), true, static_cast<u32>(first.size()));
+    REQUIRE(cache.GetUniqueVertices() == std::vector<u32>({0xFFFF, 0x1234, 3}));
+    REQUIRE(cache.GetSlots() == std::vector<u32>({0, 1, 0, 2}));
+
+    // Vertices of the previous draw must not leak into the next one
+    const std::vector<u16> second = {3, 0x1234, 3};
+    cache.Build(reinterpret_cast<const u8*>(second.data()), true, static_cast<u32>(second.size()));
+    REQUIRE(cache.GetUniqueVertices() == std::vector<u32>({3, 0x1234}));
+    REQUIRE(cache.GetSlots() == std::vector<u32>({0, 1, 0}));
+
+    REQUIRE(cache.GetStats().num_indices == 7);
+    REQUIRE(cache.GetStats().num_unique_vertices == 5);
+
+    cache.Build(nullptr, true, 0);
+    REQUIRE(cache.GetUniqueVertices().empty());
+    REQUIRE(cache.GetSlots().empty());
+
+    cache.ResetStats();
+    REQUIRE(cache.GetStats().num_indices == 0);
+    REQUIRE(cache.GetStats().GetHitRate() == 0.0);
+}
+
+} // namespace Pica
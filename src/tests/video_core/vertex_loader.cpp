@@ -0,0 +1,185 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <cstring>
+#include <random>
+#include <vector>
+#include <catch.hpp>
+#include "common/alignment.h"
+#include "core/memory.h"
+#include "core/memory_setup.h"
+#include "video_core/debug_utils/debug_utils.h"
+#include "video_core/pica.h"
+#include "video_core/pica_state.h"
+#include "video_core/shader/shader.h"
+#include "video_core/vertex_loader.h"
+
+namespace Pica {
+
+using Format = Regs::VertexAttributeFormat;
+
+static constexpr PAddr BASE_ADDRESS = Memory::VRAM_PADDR;
+
+/**
+ * Loads a vertex the way VertexLoader did before attributes were compiled in Setup: the format of
+ * each attribute is dispatched on per vertex and the source pointer is looked up every time.
+ */
+static void ReferenceLoadVertex(const Regs& regs, const std::array<u32, 16>& sources, u32 vertex,
+                                Shader::InputVertex& input) {
+    const auto& attribute_config = regs.vertex_attributes;
+    for (int i = 0; i < attribute_config.GetNumTotalAttributes(); ++i) {
+        if (attribute_config.IsDefaultAttribute(i)) {
+            input.attr[i] = g_state.vs_default_attributes[i];
+            continue;
+        }
+
+        const int loader = i < 6 ? 0 : 1;
+        const u32 source_addr = BASE_ADDRESS + sources[i] +
+                                attribute_config.attribute_loaders[loader].byte_count * vertex;
+        const u8* source = Memory::GetPhysicalPointer(source_addr);
+        const int elements = attribute_config.GetNumElements(i);
+        for (int comp = 0; comp < elements; ++comp) {
+            float value = 0.0f;
+            switch (attribute_config.GetFormat(i)) {
+            case Format::BYTE:
+                value = reinterpret_cast<const s8*>(source)[comp];
+                break;
+            case Format::UBYTE:
+                value = source[comp];
+                break;
+            case Format::SHORT: {
+                s16 component;
+                std::memcpy(&component, source + comp * 2, sizeof(component));
+                value = component;
+                break;
+            }
+            case Format::FLOAT:
+                std::memcpy(&value, source + comp * 4, sizeof(value));
+                break;
+            }
+            input.attr[i][comp] = float24::FromFloat32(value);
+        }
+        for (int comp = elements; comp < 4; ++comp)
+            input.attr[i][comp] = float24::FromFloat32(comp == 3 ? 1.0f : 0.0f);
+    }
+}
+
+/**
+ * Sets up 12 array attributes, split across two loaders with some padding in between, plus a
+ * default attribute. Attribute i uses format i % 4 and `elements(i)` components.
+ * @returns The offset of each array attribute from the base address
+ */
+template <typename ElementsFunc>
+static std::array<u32, 16> SetupAttributes(Regs& regs, ElementsFunc elements) {
+    // The attribute descriptors are 64-bit fields spanning two registers
+    const auto write_u64 = [&regs](size_t index, u64 value) {
+        regs[static_cast<int>(index)] = static_cast<u32>(value);
+        regs[static_cast<int>(index + 1)] = static_cast<u32>(value >> 32);
+    };
+
+    std::memset(&regs, 0, sizeof(regs));
+    regs.vertex_attributes.base_address.Assign(BASE_ADDRESS / 8);
+    u64 formats = u64{12} << 60; // 13 attributes
+
+    std::array<u32, 16> sources{};
+    for (int loader = 0; loader < 2; ++loader) {
+        auto& loader_config = regs.vertex_attributes.attribute_loaders[loader];
+        loader_config.data_offset = loader * 0x40;
+
+        u32 offset = 0;
+        u64 components = 0;
+        int component_count = 0;
+        for (int i = loader * 6; i < loader * 6 + 6; ++i) {
+            const u64 format = i % 4;
+            const u64 size = elements(i) - 1;
+            formats |= format << (i * 4) | size << (i * 4 + 2);
+
+            const u32 element_size = format == 3 ? 4 : format == 2 ? 2 : 1;
+            offset = Common::AlignUp(offset, element_size);
+            sources[i] = loader_config.data_offset + offset;
+            offset += element_size * elements(i);
+            components |= static_cast<u64>(i) << (component_count++ * 4);
+
+            if (i == loader * 6 + 2) {
+                // 4 bytes of padding
+                offset = Common::AlignUp(offset, 4) + 4;
+                components |= u64{12} << (component_count++ * 4);
+            }
+        }
+        write_u64(PICA_REG_INDEX(vertex_attributes.attribute_loaders) + loader * 3 + 1,
+                  components | u64{Common::AlignUp(offset, 4)} << 48 |
+                      static_cast<u64>(component_count) << 60);
+    }
+    write_u64(PICA_REG_INDEX(vertex_attributes) + 1, formats);
+    return sources;
+}
+
+static std::vector<u8> MakeRandomVRAM() {
+    std::mt19937 rng(1234);
+    std::uniform_int_distribution<int> byte(0, 255);
+    std::uniform_real_distribution<float> real(-1000.0f, 1000.0f);
+    std::vector<u8> vram(Memory::VRAM_SIZE);
+    // Random floats rather than random bytes, so that comparisons aren't disturbed by NaNs
+    for (size_t i = 0; i < 0x100000; i += 4) {
+        const float value = real(rng);
+        std::memcpy(&vram[i], &value, sizeof(value));
+        vram[i] ^= static_cast<u8>(byte(rng)) & 0x0F;
+    }
+    return vram;
+}
+
+static bool Equal(const Shader::InputVertex& a, const Shader::InputVertex& b) {
+    return std::memcmp(&a, &b, sizeof(a)) == 0;
+}
+
+TEST_CASE("VertexLoader - Matches per-attribute loading", "[video_core]") {
+    std::vector<u8> vram = MakeRandomVRAM();
+    Memory::InitMemoryMap();
+    Memory::MapMemoryRegion(Memory::VRAM_VADDR, Memory::VRAM_SIZE, vram.data());
+    g_state.vs_default_attributes[12] = Math::MakeVec(
+        float24::FromFloat32(1.0f), float24::FromFloat32(2.0f), float24::FromFloat32(3.0f),
+        float24::FromFloat32(4.0f));
+
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<u32> vertex_id(0, 1000);
+    std::vector<u32> vertices(100);
+    for (auto& vertex : vertices)
+        vertex = vertex_id(rng);
+
+    // Together, these cover each format with 1 to 4 elements
+    const auto few_elements = [](int i) { return i / 4 + 1; };
+    const auto many_elements = [](int i) { return 4 - i / 4; };
+    for (int config = 0; config < 2; ++config) {
+        Regs& regs = g_state.regs;
+        const auto sources = config == 0 ? SetupAttributes(regs, few_elements)
+                                         : SetupAttributes(regs, many_elements);
+
+        VertexLoader loader(regs);
+        REQUIRE(loader.GetNumTotalAttributes() == 13);
+
+        DebugUtils::MemoryAccessTracker memory_accesses;
+        std::vector<Shader::InputVertex> inputs(vertices.size());
+        std::memset(inputs.data(), 0, inputs.size() * sizeof(inputs[0]));
+        loader.LoadVertices(regs.vertex_attributes.GetPhysicalBaseAddress(), vertices.data(),
+                            vertices.size(), inputs.data(), memory_accesses);
+
+        for (size_t i = 0; i < vertices.size(); ++i) {
+            Shader::InputVertex expected;
+            std::memset(&expected, 0, sizeof(expected));
+            ReferenceLoadVertex(regs, sources, vertices[i], expected);
+            INFO("config " << config << " vertex " << vertices[i]);
+            REQUIRE(Equal(inputs[i], expected));
+
+            Shader::InputVertex single;
+            std::memset(&single, 0, sizeof(single));
+            loader.LoadVertex(regs.vertex_attributes.GetPhysicalBaseAddress(), static_cast<int>(i),
+                              vertices[i], single, memory_accesses);
+            REQUIRE(Equal(single, expected));
+        }
+    }
+
+    Memory::UnmapRegion(Memory::VRAM_VADDR, Memory::VRAM_SIZE);
+}
+
+} // namespace Pica
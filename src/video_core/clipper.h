@@ -4,6 +4,8 @@
 
 #pragma once
 
+#include <functional>
+
 namespace Pica {
 
 namespace Shader {
@@ -14,7 +16,12 @@ namespace Clipper {
 
 using Shader::OutputVertex;
 
-void ProcessTriangle(const OutputVertex& v0, const OutputVertex& v1, const OutputVertex& v2);
+using TriangleHandler =
+    std::function<void(const OutputVertex& v0, const OutputVertex& v1, const OutputVertex& v2)>;
+
+/// Clips the given triangle and calls triangle_handler for each resulting triangle
+void ProcessTriangle(const OutputVertex& v0, const OutputVertex& v1, const OutputVertex& v2,
+                     const TriangleHandler& triangle_handler);
 
 } // namespace
 
@@ -2,13 +2,18 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include <array>
+#include <chrono>
 #include <cstddef>
 #include <memory>
+#include <thread>
 #include <utility>
+#include <vector>
 #include "common/assert.h"
 #include "common/logging/log.h"
 #include "common/microprofile.h"
+#include "common/thread_pool.h"
 #include "common/vector_math.h"
 #include "core/hle/service/gsp_gpu.h"
 #include "core/hw/gpu.h"
@@ -23,6 +28,7 @@
 #include "video_core/rasterizer_interface.h"
 #include "video_core/renderer_base.h"
 #include "video_core/shader/shader.h"
+#include "video_core/vertex_cache.h"
 #include "video_core/vertex_loader.h"
 #include "video_core/video_core.h"
 
@@ -38,6 +44,53 @@ static int default_attr_counter = 0;
 
 static u32 default_attr_write_buffer[3];
 
+/// Number of vertices loaded and shaded at once by a thread
+static constexpr unsigned int VERTEX_BATCH_SIZE = 32;
+
+/// Vertex shading is only split across threads if each of them gets at least this many vertices
+static constexpr size_t MIN_VERTICES_PER_THREAD = 256;
+
+/// Number of vertices of a non-indexed draw that are shaded before being assembled into triangles
+static constexpr unsigned int VERTEX_CHUNK_SIZE = 4096;
+
+/// Inputs and shader units of a batch of vertices, too large to be kept on the stack
+struct VertexBatch {
+    std::array<Shader::InputVertex, VERTEX_BATCH_SIZE> inputs;
+    std::array<Shader::UnitState, VERTEX_BATCH_SIZE> shader_units;
+};
+
+/// One vertex batch for each thread shading vertices
+static std::vector<VertexBatch> vertex_batches(1);
+static std::unique_ptr<Common::ThreadPool> vertex_thread_pool;
+
+static VertexCache vertex_cache;
+
+static DrawStats draw_stats;
+static bool draw_stats_enabled = false;
+
+/// Adds the time spent in the enclosing scope to the draw statistics, if they are enabled
+class ScopedDrawTimer {
+public:
+    ScopedDrawTimer() : enabled(draw_stats_enabled) {
+        if (enabled)
+            start = std::chrono::steady_clock::now();
+    }
+    ~ScopedDrawTimer() {
+        if (!enabled)
+            return;
+        draw_stats.num_draws++;
+        draw_stats.total_time += std::chrono::steady_clock::now() - start;
+    }
+
+private:
+    bool enabled;
+    std::chrono::steady_clock::time_point start;
+};
+
+/// Output of the vertices shaded by the current draw, indexed by vertex cache slot for indexed
+/// draws and by position in the current chunk otherwise
+static std::vector<Shader::OutputVertex> shaded_vertices;
+
 // Expand a 4-bit mask to 4-byte mask, e.g. 0b0101 -> 0x00FF00FF
 static const u32 expand_bits_to_bytes[] = {
     0x00000000, 0x000000ff, 0x0000ff00, 0x0000ffff, 0x00ff0000, 0x00ff00ff, 0x00ffff00, 0x00ffffff,
@@ -46,6 +99,77 @@ static const u32 expand_bits_to_bytes[] = {
 
 MICROPROFILE_DEFINE(GPU_Drawing, "GPU", "Drawing", MP_RGB(50, 50, 240));
 
+/**
+ * Loads and shades vertices on the calling thread, in batches of VERTEX_BATCH_SIZE
+ * @param debug_context Debug context to report vertex shader invocations to, if any
+ */
+static void ShadeVertices(VertexLoader& loader, u32 base_address, const u32* vertices,
+                          size_t count, Shader::OutputVertex* outputs, VertexBatch& batch,
+                          DebugUtils::MemoryAccessTracker& memory_accesses,
+                          DebugContext* debug_context) {
+    const auto& regs = g_state.regs;
+    for (size_t batch_start = 0; batch_start < count; batch_start += VERTEX_BATCH_SIZE) {
+        const size_t batch_size = std::min<size_t>(VERTEX_BATCH_SIZE, count - batch_start);
+
+        loader.LoadVertices(base_address, vertices + batch_start, batch_size,
+                            batch.inputs.data(), memory_accesses);
+
+        if (debug_context) {
+            for (size_t i = 0; i < batch_size; ++i)
+                debug_context->OnEvent(DebugContext::Event::VertexShaderInvocation,
+                                       (void*)&batch.inputs[i]);
+        }
+        g_state.vs.RunBatch(batch.shader_units.data(), batch.inputs.data(), batch_size,
+                            loader.GetNumTotalAttributes());
+
+        for (size_t i = 0; i < batch_size; ++i)
+            outputs[batch_start + i] = batch.shader_units[i].output_registers.ToVertex(regs.vs);
+    }
+}
+
+/**
+ * Loads and shades vertices, splitting them across up to g_vertex_shader_threads threads if there
+ * are enough of them.
+ * Each thread works on its own contiguous range of vertices with its own shader units, so the
+ * outputs end up in the same order as the input vertices either way.
+ * @param vertices Indices into the attribute arrays of the vertices to shade
+ * @param outputs Receives the shaded vertices, one per entry of `vertices`
+ */
+static void ShadeVerticesParallel(VertexLoader& loader, u32 base_address, const u32* vertices,
+                                  size_t count, Shader::OutputVertex* outputs,
+                                  DebugUtils::MemoryAccessTracker& memory_accesses) {
+    int num_threads_setting = VideoCore::g_vertex_shader_threads;
+    if (num_threads_setting <= 0)
+        num_threads_setting = static_cast<int>(std::thread::hardware_concurrency());
+    const size_t num_threads = std::min<size_t>(std::max(num_threads_setting, 1),
+                                                count / MIN_VERTICES_PER_THREAD);
+
+    // Trace recording and vertex shader breakpoints expect vertices to be processed in order, on
+    // this thread. The debugger being open doesn't require that by itself.
+    const int vs_invocation = (int)DebugContext::Event::VertexShaderInvocation;
+    const bool needs_serial_shading =
+        g_debug_context && (g_debug_context->recorder ||
+                            g_debug_context->breakpoints[vs_invocation].enabled);
+    if (num_threads <= 1 || needs_serial_shading) {
+        ShadeVertices(loader, base_address, vertices, count, outputs, vertex_batches[0],
+                      memory_accesses, g_debug_context.get());
+        return;
+    }
+
+    if (vertex_thread_pool == nullptr || vertex_thread_pool->GetNumThreads() < num_threads)
+        vertex_thread_pool = std::make_unique<Common::ThreadPool>(num_threads - 1);
+    if (vertex_batches.size() < num_threads)
+        vertex_batches.resize(num_threads);
+
+    vertex_thread_pool->ParallelFor(num_threads, [&](size_t thread) {
+        const size_t start = count * thread / num_threads;
+        const size_t end = count * (thread + 1) / num_threads;
+        DebugUtils::MemoryAccessTracker unused_memory_accesses;
+        ShadeVertices(loader, base_address, vertices + start, end - start, outputs + start,
+                      vertex_batches[thread], unused_memory_accesses, nullptr);
+    });
+}
+
 static void WritePicaReg(u32 id, u32 value, u32 mask) {
     auto& regs = g_state.regs;
 
@@ -194,6 +318,7 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
     case PICA_REG_INDEX(trigger_draw):
     case PICA_REG_INDEX(trigger_draw_indexed): {
         MICROPROFILE_SCOPE(GPU_Drawing);
+        ScopedDrawTimer draw_timer;
 
 #if PICA_LOG_TEV
         DebugUtils::DumpTevStageConfig(regs.GetTevStages());
@@ -212,7 +337,6 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
 
         const auto& index_info = regs.index_array;
         const u8* index_address_8 = Memory::GetPhysicalPointer(base_address + index_info.offset);
-        const u16* index_address_16 = reinterpret_cast<const u16*>(index_address_8);
         bool index_u16 = index_info.format != 0;
 
         PrimitiveAssembler<Shader::OutputVertex>& primitive_assembler = g_state.primitive_assembler;
@@ -233,76 +357,58 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
 
         DebugUtils::MemoryAccessTracker memory_accesses;
 
-        // Simple circular-replacement vertex cache
-        // The size has been tuned for optimal balance between hit-rate and the cost of lookup
-        const size_t VERTEX_CACHE_SIZE = 32;
-        std::array<u16, VERTEX_CACHE_SIZE> vertex_cache_ids;
-        std::array<Shader::OutputVertex, VERTEX_CACHE_SIZE> vertex_cache;
-        Shader::OutputVertex output_vertex;
-
-        unsigned int vertex_cache_pos = 0;
-        vertex_cache_ids.fill(-1);
-
-        Shader::UnitState shader_unit;
         g_state.vs.Setup();
 
-        for (unsigned int index = 0; index < regs.num_vertices; ++index) {
-            // Indexed rendering doesn't use the start offset
-            unsigned int vertex =
-                is_indexed ? (index_u16 ? index_address_16[index] : index_address_8[index])
-                           : (index + regs.vertex_offset);
+        using Pica::Shader::OutputVertex;
+        auto AddTriangle = [](const OutputVertex& v0, const OutputVertex& v1,
+                              const OutputVertex& v2) {
+            VideoCore::g_renderer->Rasterizer()->AddTriangle(v0, v1, v2);
+        };
 
-            // -1 is a common special value used for primitive restart. Since it's unknown if
-            // the PICA supports it, and it would mess up the caching, guard against it here.
-            ASSERT(vertex != -1);
-
-            bool vertex_cache_hit = false;
-
-            if (is_indexed) {
-                if (g_debug_context && Pica::g_debug_context->recorder) {
-                    int size = index_u16 ? 2 : 1;
-                    memory_accesses.AddAccess(base_address + index_info.offset + size * index,
-                                              size);
-                }
-
-                for (unsigned int i = 0; i < VERTEX_CACHE_SIZE; ++i) {
-                    if (vertex == vertex_cache_ids[i]) {
-                        output_vertex = vertex_cache[i];
-                        vertex_cache_hit = true;
-                        break;
-                    }
-                }
+        if (is_indexed) {
+            if (g_debug_context && Pica::g_debug_context->recorder) {
+                memory_accesses.AddAccess(base_address + index_info.offset,
+                                          (index_u16 ? 2 : 1) * regs.num_vertices);
             }
 
-            if (!vertex_cache_hit) {
-                // Initialize data for the current vertex
-                Shader::InputVertex input;
-                loader.LoadVertex(base_address, index, vertex, input, memory_accesses);
-
-                // Send to vertex shader
-                if (g_debug_context)
-                    g_debug_context->OnEvent(DebugContext::Event::VertexShaderInvocation,
-                                             (void*)&input);
-                g_state.vs.Run(shader_unit, input, loader.GetNumTotalAttributes());
-
-                // Retrieve vertex from register data
-                output_vertex = shader_unit.output_registers.ToVertex(regs.vs);
-
-                if (is_indexed) {
-                    vertex_cache[vertex_cache_pos] = output_vertex;
-                    vertex_cache_ids[vertex_cache_pos] = vertex;
-                    vertex_cache_pos = (vertex_cache_pos + 1) % VERTEX_CACHE_SIZE;
-                }
+            // Indexed rendering doesn't use the start offset. Each vertex referenced by the index
+            // buffer is shaded once, then triangles are assembled from the shaded vertices.
+            vertex_cache.Build(index_address_8, index_u16, regs.num_vertices);
+            const auto& unique_vertices = vertex_cache.GetUniqueVertices();
+            shaded_vertices.resize(std::max(shaded_vertices.size(), unique_vertices.size()));
+            ShadeVerticesParallel(loader, base_address, unique_vertices.data(),
+                                  unique_vertices.size(), shaded_vertices.data(), memory_accesses);
+
+            LOG_TRACE(HW_GPU, "Shaded %zu unique vertices for %u indices (%.1f%% hit rate overall)",
+                      unique_vertices.size(), regs.num_vertices,
+                      vertex_cache.GetStats().GetHitRate() * 100.0);
+
+            OutputVertex output_vertex;
+            for (u32 slot : vertex_cache.GetSlots()) {
+                output_vertex = shaded_vertices[slot];
+                primitive_assembler.SubmitVertex(output_vertex, AddTriangle);
             }
+        }
 
-            // Send to renderer
-            using Pica::Shader::OutputVertex;
-            auto AddTriangle = [](const OutputVertex& v0, const OutputVertex& v1,
-                                  const OutputVertex& v2) {
-                VideoCore::g_renderer->Rasterizer()->AddTriangle(v0, v1, v2);
-            };
-
-            primitive_assembler.SubmitVertex(output_vertex, AddTriangle);
+        // Vertices of non-indexed draws are never reused, so they are shaded in order, one chunk
+        // at a time to bound the memory needed for the shaded vertices
+        const unsigned num_chunked_vertices = is_indexed ? 0 : regs.num_vertices;
+        std::vector<u32> vertices;
+        for (unsigned int chunk_start = 0; chunk_start < num_chunked_vertices;
+             chunk_start += VERTEX_CHUNK_SIZE) {
+            const unsigned int chunk_size =
+                std::min(VERTEX_CHUNK_SIZE, num_chunked_vertices - chunk_start);
+
+            vertices.resize(chunk_size);
+            for (unsigned int i = 0; i < chunk_size; ++i)
+                vertices[i] = chunk_start + i + regs.vertex_offset;
+
+            shaded_vertices.resize(std::max<size_t>(shaded_vertices.size(), chunk_size));
+            ShadeVerticesParallel(loader, base_address, vertices.data(), chunk_size,
+                                  shaded_vertices.data(), memory_accesses);
+
+            for (unsigned int i = 0; i < chunk_size; ++i)
+                primitive_assembler.SubmitVertex(shaded_vertices[i], AddTriangle);
         }
 
         for (auto& range : memory_accesses.ranges) {
@@ -474,6 +580,22 @@ void ProcessCommandList(const u32* list, u32 size) {
     }
 }
 
+VertexCache::Stats GetVertexCacheStats() {
+    return vertex_cache.GetStats();
+}
+
+DrawStats GetDrawStats() {
+    return draw_stats;
+}
+
+void EnableDrawStats(bool enable) {
+    draw_stats_enabled = enable;
+}
+
+void ResetDrawStats() {
+    draw_stats = {};
+}
+
 } // namespace
 
 } // namespace
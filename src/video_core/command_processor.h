@@ -4,9 +4,11 @@
 
 #pragma once
 
+#include <chrono>
 #include <type_traits>
 #include "common/bit_field.h"
 #include "common/common_types.h"
+#include "video_core/vertex_cache.h"
 
 namespace Pica {
 
@@ -36,6 +38,27 @@ static_assert(sizeof(CommandHeader) == sizeof(u32), "CommandHeader has incorrect
 
 void ProcessCommandList(const u32* list, u32 size);
 
+/// Returns the hit-rate statistics of the vertex cache, accumulated over all indexed draws
+VertexCache::Stats GetVertexCacheStats();
+
+/// Host time spent processing draw calls, for benchmarking
+struct DrawStats {
+    u64 num_draws = 0;
+    std::chrono::nanoseconds total_time{0};
+};
+
+/**
+ * Enables or disables timing draws for the draw statistics. They are disabled by default, since
+ * reading the clock twice per draw isn't free.
+ */
+void EnableDrawStats(bool enable);
+
+/// Returns the timing statistics of the draws timed since the last call to ResetDrawStats
+DrawStats GetDrawStats();
+
+/// Clears the draw timing statistics
+void ResetDrawStats();
+
 } // namespace
 
 } // namespace
@@ -0,0 +1,259 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <cstring>
+#ifdef ARCHITECTURE_x86_64
+#include <emmintrin.h>
+#endif
+#include "common/assert.h"
+#include "video_core/morton.h"
+
+namespace VideoCore {
+
+// clang-format off
+const std::array<u8, 64> morton_lut = {{
+     0,  1,  4,  5, 16, 17, 20, 21,
+     2,  3,  6,  7, 18, 19, 22, 23,
+     8,  9, 12, 13, 24, 25, 28, 29,
+    10, 11, 14, 15, 26, 27, 30, 31,
+    32, 33, 36, 37, 48, 49, 52, 53,
+    34, 35, 38, 39, 50, 51, 54, 55,
+    40, 41, 44, 45, 56, 57, 60, 61,
+    42, 43, 46, 47, 58, 59, 62, 63,
+}};
+// clang-format on
+
+/// Value conversion applied to each pixel while copying
+enum class Conversion {
+    None,
+    /// Rotates the stencil byte of D24S8 values to the bottom (to_linear) or back to the top
+    D24S8,
+    /// Expands 24-bit depth values to 32 bits with the depth in the upper bits (to_linear)
+    D24,
+};
+
+template <size_t bytes_per_pixel, Conversion conversion>
+struct LinearPixelSize {
+    static constexpr size_t value = conversion == Conversion::D24 ? 4 : bytes_per_pixel;
+};
+
+static u32 SwapDepthStencil(u32 value, bool to_linear) {
+    return to_linear ? (value << 8) | (value >> 24) : (value << 24) | (value >> 8);
+}
+
+template <size_t bytes_per_pixel, Conversion conversion, bool to_linear>
+static void CopyPixel(u8* tiled_pixel, u8* linear_pixel) {
+    switch (conversion) {
+    case Conversion::None:
+        if (to_linear) {
+            std::memcpy(linear_pixel, tiled_pixel, bytes_per_pixel);
+        } else {
+            std::memcpy(tiled_pixel, linear_pixel, bytes_per_pixel);
+        }
+        break;
+    case Conversion::D24S8: {
+        u32 value;
+        std::memcpy(&value, to_linear ? tiled_pixel : linear_pixel, sizeof(u32));
+        value = SwapDepthStencil(value, to_linear);
+        std::memcpy(to_linear ? linear_pixel : tiled_pixel, &value, sizeof(u32));
+        break;
+    }
+    case Conversion::D24:
+        if (to_linear) {
+            linear_pixel[0] = 0;
+            std::memcpy(linear_pixel + 1, tiled_pixel, 3);
+        } else {
+            std::memcpy(tiled_pixel, linear_pixel + 1, 3);
+        }
+        break;
+    }
+}
+
+/**
+ * Converts a full tile using the lookup table. The two pixels of each pair of columns (0-1, 2-3,
+ * ...) are stored next to each other in the tile, so they are copied together when no conversion
+ * is needed.
+ */
+template <size_t bytes_per_pixel, Conversion conversion, bool to_linear>
+static void CopyTileGeneric(u8* tile, u8* linear, ptrdiff_t linear_stride) {
+    constexpr size_t linear_bytes_per_pixel = LinearPixelSize<bytes_per_pixel, conversion>::value;
+
+    for (u32 y = 0; y < 8; ++y) {
+        u8* line = linear + y * linear_stride;
+        for (u32 x = 0; x < 8; x += 2) {
+            u8* tiled_pixels = tile + morton_lut[y * 8 + x] * bytes_per_pixel;
+            u8* linear_pixels = line + x * linear_bytes_per_pixel;
+            if (conversion != Conversion::None) {
+                CopyPixel<bytes_per_pixel, conversion, to_linear>(tiled_pixels, linear_pixels);
+                CopyPixel<bytes_per_pixel, conversion, to_linear>(
+                    tiled_pixels + bytes_per_pixel, linear_pixels + linear_bytes_per_pixel);
+            } else if (to_linear) {
+                std::memcpy(linear_pixels, tiled_pixels, 2 * bytes_per_pixel);
+            } else {
+                std::memcpy(tiled_pixels, linear_pixels, 2 * bytes_per_pixel);
+            }
+        }
+    }
+}
+
+#ifdef ARCHITECTURE_x86_64
+
+static __m128i SwapDepthStencil(__m128i value, bool to_linear) {
+    return to_linear ? _mm_or_si128(_mm_slli_epi32(value, 8), _mm_srli_epi32(value, 24))
+                     : _mm_or_si128(_mm_slli_epi32(value, 24), _mm_srli_epi32(value, 8));
+}
+
+/**
+ * Converts a full tile of 32-bit pixels. Every 16 bytes of the tile hold a 2x2 block of pixels;
+ * the halves of two horizontally adjacent blocks are the left or right four pixels of a line.
+ */
+template <bool swap_depth_stencil, bool to_linear>
+static void CopyTile32(u8* tile, u8* linear, ptrdiff_t linear_stride) {
+    for (u32 y = 0; y < 8; y += 2) {
+        u8* line0 = linear + y * linear_stride;
+        u8* line1 = line0 + linear_stride;
+        for (u32 x = 0; x < 8; x += 4) {
+            auto block0 = reinterpret_cast<__m128i*>(tile + morton_lut[y * 8 + x] * 4);
+            auto block1 = reinterpret_cast<__m128i*>(tile + morton_lut[y * 8 + x + 2] * 4);
+            auto half_line0 = reinterpret_cast<__m128i*>(line0 + x * 4);
+            auto half_line1 = reinterpret_cast<__m128i*>(line1 + x * 4);
+
+            if (to_linear) {
+                __m128i a = _mm_loadu_si128(block0);
+                __m128i b = _mm_loadu_si128(block1);
+                if (swap_depth_stencil) {
+                    a = SwapDepthStencil(a, true);
+                    b = SwapDepthStencil(b, true);
+                }
+                _mm_storeu_si128(half_line0, _mm_unpacklo_epi64(a, b));
+                _mm_storeu_si128(half_line1, _mm_unpackhi_epi64(a, b));
+            } else {
+                __m128i a = _mm_loadu_si128(half_line0);
+                __m128i b = _mm_loadu_si128(half_line1);
+                if (swap_depth_stencil) {
+                    a = SwapDepthStencil(a, false);
+                    b = SwapDepthStencil(b, false);
+                }
+                _mm_storeu_si128(block0, _mm_unpacklo_epi64(a, b));
+                _mm_storeu_si128(block1, _mm_unpackhi_epi64(a, b));
+            }
+        }
+    }
+}
+
+/**
+ * Converts a full tile of 16-bit pixels. Every 16 bytes of the tile hold two 2x2 blocks, which
+ * are reordered into four pixels of two lines by swapping their middle 32-bit lanes.
+ */
+template <bool to_linear>
+static void CopyTile16(u8* tile, u8* linear, ptrdiff_t linear_stride) {
+    for (u32 y = 0; y < 8; y += 2) {
+        auto line0 = reinterpret_cast<__m128i*>(linear + y * linear_stride);
+        auto line1 = reinterpret_cast<__m128i*>(linear + (y + 1) * linear_stride);
+        auto blocks0 = reinterpret_cast<__m128i*>(tile + morton_lut[y * 8 + 0] * 2);
+        auto blocks1 = reinterpret_cast<__m128i*>(tile + morton_lut[y * 8 + 4] * 2);
+
+        if (to_linear) {
+            const __m128i a = _mm_shuffle_epi32(_mm_loadu_si128(blocks0), _MM_SHUFFLE(3, 1, 2, 0));
+            const __m128i b = _mm_shuffle_epi32(_mm_loadu_si128(blocks1), _MM_SHUFFLE(3, 1, 2, 0));
+            _mm_storeu_si128(line0, _mm_unpacklo_epi64(a, b));
+            _mm_storeu_si128(line1, _mm_unpackhi_epi64(a, b));
+        } else {
+            const __m128i a = _mm_loadu_si128(line0);
+            const __m128i b = _mm_loadu_si128(line1);
+            _mm_storeu_si128(blocks0,
+                             _mm_shuffle_epi32(_mm_unpacklo_epi64(a, b), _MM_SHUFFLE(3, 1, 2, 0)));
+            _mm_storeu_si128(blocks1,
+                             _mm_shuffle_epi32(_mm_unpackhi_epi64(a, b), _MM_SHUFFLE(3, 1, 2, 0)));
+        }
+    }
+}
+
+#endif // ARCHITECTURE_x86_64
+
+template <size_t bytes_per_pixel, Conversion conversion, bool to_linear>
+static void CopyTile(u8* tile, u8* linear, ptrdiff_t linear_stride) {
+#ifdef ARCHITECTURE_x86_64
+    if (bytes_per_pixel == 4 && conversion != Conversion::D24) {
+        CopyTile32<conversion == Conversion::D24S8, to_linear>(tile, linear, linear_stride);
+        return;
+    }
+    if (bytes_per_pixel == 2) {
+        CopyTile16<to_linear>(tile, linear, linear_stride);
+        return;
+    }
+#endif
+    CopyTileGeneric<bytes_per_pixel, conversion, to_linear>(tile, linear, linear_stride);
+}
+
+template <size_t bytes_per_pixel, Conversion conversion, bool to_linear>
+static void MortonCopyImpl(u32 width, u32 height, u8* tiled, u8* linear,
+                           ptrdiff_t linear_stride) {
+    constexpr size_t linear_bytes_per_pixel = LinearPixelSize<bytes_per_pixel, conversion>::value;
+    const u32 full_tiles_width = width & ~7;
+
+    for (u32 tile_y = 0; tile_y < height; tile_y += 8) {
+        u8* tile_line = tiled + tile_y * width * bytes_per_pixel;
+        u32 partial_x = 0;
+
+        if (tile_y + 8 <= height) {
+            for (u32 tile_x = 0; tile_x < full_tiles_width; tile_x += 8) {
+                CopyTile<bytes_per_pixel, conversion, to_linear>(
+                    tile_line + tile_x * 8 * bytes_per_pixel,
+                    linear + tile_y * linear_stride + tile_x * linear_bytes_per_pixel,
+                    linear_stride);
+            }
+            partial_x = full_tiles_width;
+        }
+
+        // Pixels of partial tiles at the right and bottom edges
+        for (u32 y = tile_y; y < std::min(tile_y + 8, height); ++y) {
+            for (u32 x = partial_x; x < width; ++x) {
+                const u32 tiled_index = (x & ~7) * 8 + morton_lut[(y & 7) * 8 + (x & 7)];
+                CopyPixel<bytes_per_pixel, conversion, to_linear>(
+                    tile_line + tiled_index * bytes_per_pixel,
+                    linear + y * linear_stride + x * linear_bytes_per_pixel);
+            }
+        }
+    }
+}
+
+void MortonCopy(u32 bytes_per_pixel, u32 width, u32 height, u8* tiled, u8* linear,
+                ptrdiff_t linear_stride, bool to_linear) {
+    using CopyFunction = void (*)(u32, u32, u8*, u8*, ptrdiff_t);
+    static const CopyFunction copy_functions[2][4] = {
+        {
+            MortonCopyImpl<1, Conversion::None, false>, MortonCopyImpl<2, Conversion::None, false>,
+            MortonCopyImpl<3, Conversion::None, false>, MortonCopyImpl<4, Conversion::None, false>,
+        },
+        {
+            MortonCopyImpl<1, Conversion::None, true>, MortonCopyImpl<2, Conversion::None, true>,
+            MortonCopyImpl<3, Conversion::None, true>, MortonCopyImpl<4, Conversion::None, true>,
+        },
+    };
+
+    ASSERT(bytes_per_pixel >= 1 && bytes_per_pixel <= 4);
+    copy_functions[to_linear][bytes_per_pixel - 1](width, height, tiled, linear, linear_stride);
+}
+
+void MortonCopyD24S8(u32 width, u32 height, u8* tiled, u8* linear, ptrdiff_t linear_stride,
+                     bool to_linear) {
+    if (to_linear) {
+        MortonCopyImpl<4, Conversion::D24S8, true>(width, height, tiled, linear, linear_stride);
+    } else {
+        MortonCopyImpl<4, Conversion::D24S8, false>(width, height, tiled, linear, linear_stride);
+    }
+}
+
+void MortonCopyD24(u32 width, u32 height, u8* tiled, u8* linear, ptrdiff_t linear_stride,
+                   bool to_linear) {
+    if (to_linear) {
+        MortonCopyImpl<3, Conversion::D24, true>(width, height, tiled, linear, linear_stride);
+    } else {
+        MortonCopyImpl<3, Conversion::D24, false>(width, height, tiled, linear, linear_stride);
+    }
+}
+
+} // namespace VideoCore
@@ -0,0 +1,56 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include "common/common_types.h"
+
+namespace VideoCore {
+
+/**
+ * Position of each pixel of an 8x8 tile in Morton order, indexed by `y * 8 + x`. See
+ * GetMortonOffset for a description of the layout.
+ */
+extern const std::array<u8, 64> morton_lut;
+
+/**
+ * Copies an image between the tiled layout used by the PICA and a linear layout, converting
+ * whole 8x8 tiles at once.
+ *
+ * The tiled image is addressed like GetMortonOffset does: each line of tiles is
+ * `width * 8 * bytes_per_pixel` bytes long, with the tiles of a line stored one after another.
+ * Dimensions that are not a multiple of 8 are supported, the partial tiles are converted pixel by
+ * pixel.
+ *
+ * @param bytes_per_pixel Size of a pixel, from 1 to 4 bytes
+ * @param width Width of the image in pixels
+ * @param height Height of the image in pixels
+ * @param tiled Start of the tiled image
+ * @param linear Start of the line with y = 0 of the linear image
+ * @param linear_stride Distance in bytes between two lines of the linear image, negative if the
+ *                      linear image is stored bottom-up
+ * @param to_linear True to copy from the tiled to the linear image, false for the opposite
+ */
+void MortonCopy(u32 bytes_per_pixel, u32 width, u32 height, u8* tiled, u8* linear,
+                ptrdiff_t linear_stride, bool to_linear);
+
+/**
+ * Like MortonCopy for 32-bit depth-stencil images, additionally converting between the PICA's
+ * D24S8 layout (stencil in the most significant byte) and the layout with the stencil in the
+ * least significant byte that OpenGL expects.
+ */
+void MortonCopyD24S8(u32 width, u32 height, u8* tiled, u8* linear, ptrdiff_t linear_stride,
+                     bool to_linear);
+
+/**
+ * Like MortonCopy for 24-bit depth images, additionally converting between the PICA's packed
+ * 3-byte values and 4-byte values with the depth in the upper 24 bits, as used with
+ * GL_UNSIGNED_INT. `linear_stride` refers to the 4-byte values.
+ */
+void MortonCopyD24(u32 width, u32 height, u8* tiled, u8* linear, ptrdiff_t linear_stride,
+                   bool to_linear);
+
+} // namespace VideoCore
@@ -0,0 +1,899 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include "common/assert.h"
+#include "common/logging/log.h"
+#include "common/math_util.h"
+#include "video_core/pica_state.h"
+#include "video_core/pixel_pipeline.h"
+
+namespace Pica {
+
+namespace Rasterizer {
+
+using Source = Regs::TevStageConfig::Source;
+using ColorModifier = Regs::TevStageConfig::ColorModifier;
+using AlphaModifier = Regs::TevStageConfig::AlphaModifier;
+using Operation = Regs::TevStageConfig::Operation;
+
+PixelPipelineConfig PixelPipelineConfig::CurrentConfig() {
+    PixelPipelineConfig res;
+
+    auto& state = res.state;
+    std::memset(&state, 0, sizeof(PixelPipelineConfig::State));
+
+    const auto& regs = g_state.regs;
+
+    // Constant colors are read per triangle rather than baked into the pipeline
+    const auto& tev_stages = regs.GetTevStages();
+    for (size_t i = 0; i < tev_stages.size(); i++) {
+        const auto& tev_stage = tev_stages[i];
+        state.tev_stages[i].sources_raw = tev_stage.sources_raw;
+        state.tev_stages[i].modifiers_raw = tev_stage.modifiers_raw;
+        state.tev_stages[i].ops_raw = tev_stage.ops_raw;
+        state.tev_stages[i].scales_raw = tev_stage.scales_raw;
+    }
+    state.combiner_buffer_input = regs.tev_combiner_buffer_input.update_mask_rgb.Value() |
+                                  regs.tev_combiner_buffer_input.update_mask_a.Value() << 4;
+
+    const auto& output_merger = regs.output_merger;
+    state.alpha_test_func = output_merger.alpha_test.enable ? output_merger.alpha_test.func.Value()
+                                                            : Regs::CompareFunc::Always;
+
+    state.fog_mode = regs.fog_mode;
+    state.fog_flip = regs.fog_flip != 0;
+
+    const auto& stencil_test = output_merger.stencil_test;
+    state.stencil_action_enable =
+        stencil_test.enable && regs.framebuffer.depth_format == Regs::DepthFormat::D24S8;
+    if (state.stencil_action_enable) {
+        state.stencil_test_func = stencil_test.func;
+        state.stencil_fail_action = stencil_test.action_stencil_fail;
+        state.depth_fail_action = stencil_test.action_depth_fail;
+        state.depth_pass_action = stencil_test.action_depth_pass;
+    }
+    state.stencil_write_enable = regs.framebuffer.allow_depth_stencil_write != 0;
+
+    state.depth_test_enable = output_merger.depth_test_enable != 0;
+    if (state.depth_test_enable)
+        state.depth_test_func = output_merger.depth_test_func;
+    state.depth_format = regs.framebuffer.depth_format;
+    state.depth_write_enable =
+        regs.framebuffer.allow_depth_stencil_write != 0 && output_merger.depth_write_enable;
+
+    state.alphablend_enable = output_merger.alphablend_enable != 0;
+    if (state.alphablend_enable) {
+        const auto& params = output_merger.alpha_blending;
+        state.blend_equation_rgb = params.blend_equation_rgb;
+        state.blend_equation_a = params.blend_equation_a;
+        state.factor_source_rgb = params.factor_source_rgb;
+        state.factor_dest_rgb = params.factor_dest_rgb;
+        state.factor_source_a = params.factor_source_a;
+        state.factor_dest_a = params.factor_dest_a;
+    } else {
+        state.logic_op = output_merger.logic_op;
+    }
+
+    return res;
+}
+
+static Math::Vec3<u8> GetColorModifier(ColorModifier factor, const Math::Vec4<u8>& values) {
+    switch (factor) {
+    case ColorModifier::SourceColor:
+        return values.rgb();
+
+    case ColorModifier::OneMinusSourceColor:
+        return (Math::Vec3<u8>(255, 255, 255) - values.rgb()).Cast<u8>();
+
+    case ColorModifier::SourceAlpha:
+        return values.aaa();
+
+    case ColorModifier::OneMinusSourceAlpha:
+        return (Math::Vec3<u8>(255, 255, 255) - values.aaa()).Cast<u8>();
+
+    case ColorModifier::SourceRed:
+        return values.rrr();
+
+    case ColorModifier::OneMinusSourceRed:
+        return (Math::Vec3<u8>(255, 255, 255) - values.rrr()).Cast<u8>();
+
+    case ColorModifier::SourceGreen:
+        return values.ggg();
+
+    case ColorModifier::OneMinusSourceGreen:
+        return (Math::Vec3<u8>(255, 255, 255) - values.ggg()).Cast<u8>();
+
+    case ColorModifier::SourceBlue:
+        return values.bbb();
+
+    case ColorModifier::OneMinusSourceBlue:
+        return (Math::Vec3<u8>(255, 255, 255) - values.bbb()).Cast<u8>();
+
+    default:
+        // Rejected by CheckColorModifier when the pipeline is built
+        return values.rgb();
+    }
+}
+
+/// Returns the given modifier, or SourceColor (after logging an error) if it is invalid
+static ColorModifier CheckColorModifier(ColorModifier factor) {
+    switch (factor) {
+    case ColorModifier::SourceColor:
+    case ColorModifier::OneMinusSourceColor:
+    case ColorModifier::SourceAlpha:
+    case ColorModifier::OneMinusSourceAlpha:
+    case ColorModifier::SourceRed:
+    case ColorModifier::OneMinusSourceRed:
+    case ColorModifier::SourceGreen:
+    case ColorModifier::OneMinusSourceGreen:
+    case ColorModifier::SourceBlue:
+    case ColorModifier::OneMinusSourceBlue:
+        return factor;
+    default:
+        LOG_ERROR(HW_GPU, "Unknown color modifier %d", (int)factor);
+        UNIMPLEMENTED();
+        return ColorModifier::SourceColor;
+    }
+}
+
+static u8 GetAlphaModifier(AlphaModifier factor, const Math::Vec4<u8>& values) {
+    // The register field is only three bits wide, so all values are covered
+    switch (factor) {
+    case AlphaModifier::SourceAlpha:
+        return values.a();
+
+    case AlphaModifier::OneMinusSourceAlpha:
+        return 255 - values.a();
+
+    case AlphaModifier::SourceRed:
+        return values.r();
+
+    case AlphaModifier::OneMinusSourceRed:
+        return 255 - values.r();
+
+    case AlphaModifier::SourceGreen:
+        return values.g();
+
+    case AlphaModifier::OneMinusSourceGreen:
+        return 255 - values.g();
+
+    case AlphaModifier::SourceBlue:
+        return values.b();
+
+    case AlphaModifier::OneMinusSourceBlue:
+        return 255 - values.b();
+    }
+}
+
+/// Returns how many of the three combiner operands the given operation reads
+static constexpr unsigned NumOperands(Operation op) {
+    return op == Operation::Replace
+               ? 1
+               : (op == Operation::Lerp || op == Operation::MultiplyThenAdd ||
+                  op == Operation::AddThenMultiply)
+                     ? 3
+                     : 2;
+}
+
+template <Operation op>
+static Math::Vec3<u8> ColorCombine(const Math::Vec3<u8> input[3]) {
+    switch (op) {
+    case Operation::Replace:
+        return input[0];
+
+    case Operation::Modulate:
+        return ((input[0] * input[1]) / 255).Cast<u8>();
+
+    case Operation::Add: {
+        auto result = input[0] + input[1];
+        result.r() = std::min(255, result.r());
+        result.g() = std::min(255, result.g());
+        result.b() = std::min(255, result.b());
+        return result.Cast<u8>();
+    }
+
+    case Operation::AddSigned: {
+        // TODO(bunnei): Verify that the color conversion from (float) 0.5f to
+        // (byte) 128 is correct
+        auto result =
+            input[0].Cast<int>() + input[1].Cast<int>() - Math::MakeVec<int>(128, 128, 128);
+        result.r() = MathUtil::Clamp<int>(result.r(), 0, 255);
+        result.g() = MathUtil::Clamp<int>(result.g(), 0, 255);
+        result.b() = MathUtil::Clamp<int>(result.b(), 0, 255);
+        return result.Cast<u8>();
+    }
+
+    case Operation::Lerp:
+        return ((input[0] * input[2] +
+                 input[1] * (Math::MakeVec<u8>(255, 255, 255) - input[2]).Cast<u8>()) /
+                255)
+            .Cast<u8>();
+
+    case Operation::Subtract: {
+        auto result = input[0].Cast<int>() - input[1].Cast<int>();
+        result.r() = std::max(0, result.r());
+        result.g() = std::max(0, result.g());
+        result.b() = std::max(0, result.b());
+        return result.Cast<u8>();
+    }
+
+    case Operation::MultiplyThenAdd: {
+        auto result = (input[0] * input[1] + 255 * input[2].Cast<int>()) / 255;
+        result.r() = std::min(255, result.r());
+        result.g() = std::min(255, result.g());
+        result.b() = std::min(255, result.b());
+        return result.Cast<u8>();
+    }
+
+    case Operation::AddThenMultiply: {
+        auto result = input[0] + input[1];
+        result.r() = std::min(255, result.r());
+        result.g() = std::min(255, result.g());
+        result.b() = std::min(255, result.b());
+        result = (result * input[2].Cast<int>()) / 255;
+        return result.Cast<u8>();
+    }
+    case Operation::Dot3_RGB: {
+        // Not fully accurate.
+        // Worst case scenario seems to yield a +/-3 error
+        // Some HW results indicate that the per-component computation can't have a
+        // higher precision than 1/256,
+        // while dot3_rgb( (0x80,g0,b0),(0x7F,g1,b1) ) and dot3_rgb(
+        // (0x80,g0,b0),(0x80,g1,b1) ) give different results
+        int result = ((input[0].r() * 2 - 255) * (input[1].r() * 2 - 255) + 128) / 256 +
+                     ((input[0].g() * 2 - 255) * (input[1].g() * 2 - 255) + 128) / 256 +
+                     ((input[0].b() * 2 - 255) * (input[1].b() * 2 - 255) + 128) / 256;
+        result = std::max(0, std::min(255, result));
+        return {(u8)result, (u8)result, (u8)result};
+    }
+    default:
+        return {0, 0, 0};
+    }
+}
+
+/// Modifies the operands read by the color combiner of a stage and combines them
+template <Operation op>
+static Math::Vec3<u8> CombineColor(const PixelPipeline::TevStage& stage,
+                                   const PixelPipeline::TevInputs& inputs) {
+    Math::Vec3<u8> operands[3];
+    for (unsigned i = 0; i < NumOperands(op); ++i)
+        operands[i] = GetColorModifier(stage.color_modifiers[i], inputs[stage.color_inputs[i]]);
+    return ColorCombine<op>(operands);
+}
+
+static PixelPipeline::ColorCombineFunction GetColorCombineFunction(Operation op) {
+    switch (op) {
+    case Operation::Replace:
+        return CombineColor<Operation::Replace>;
+    case Operation::Modulate:
+        return CombineColor<Operation::Modulate>;
+    case Operation::Add:
+        return CombineColor<Operation::Add>;
+    case Operation::AddSigned:
+        return CombineColor<Operation::AddSigned>;
+    case Operation::Lerp:
+        return CombineColor<Operation::Lerp>;
+    case Operation::Subtract:
+        return CombineColor<Operation::Subtract>;
+    case Operation::MultiplyThenAdd:
+        return CombineColor<Operation::MultiplyThenAdd>;
+    case Operation::AddThenMultiply:
+        return CombineColor<Operation::AddThenMultiply>;
+    case Operation::Dot3_RGB:
+        return CombineColor<Operation::Dot3_RGB>;
+    default:
+        LOG_ERROR(HW_GPU, "Unknown color combiner operation %d", (int)op);
+        UNIMPLEMENTED();
+        return [](const PixelPipeline::TevStage&,
+                  const PixelPipeline::TevInputs&) -> Math::Vec3<u8> { return {0, 0, 0}; };
+    }
+}
+
+template <Operation op>
+static u8 AlphaCombine(const std::array<u8, 3>& input) {
+    switch (op) {
+    case Operation::Replace:
+        return input[0];
+
+    case Operation::Modulate:
+        return input[0] * input[1] / 255;
+
+    case Operation::Add:
+        return std::min(255, input[0] + input[1]);
+
+    case Operation::AddSigned: {
+        // TODO(bunnei): Verify that the color conversion from (float) 0.5f to
+        // (byte) 128 is correct
+        auto result = static_cast<int>(input[0]) + static_cast<int>(input[1]) - 128;
+        return static_cast<u8>(MathUtil::Clamp<int>(result, 0, 255));
+    }
+
+    case Operation::Lerp:
+        return (input[0] * input[2] + input[1] * (255 - input[2])) / 255;
+
+    case Operation::Subtract:
+        return std::max(0, (int)input[0] - (int)input[1]);
+
+    case Operation::MultiplyThenAdd:
+        return std::min(255, (input[0] * input[1] + 255 * input[2]) / 255);
+
+    case Operation::AddThenMultiply:
+        return (std::min(255, (input[0] + input[1])) * input[2]) / 255;
+
+    default:
+        return 0;
+    }
+}
+
+/// Modifies the operands read by the alpha combiner of a stage and combines them
+template <Operation op>
+static u8 CombineAlpha(const PixelPipeline::TevStage& stage,
+                       const PixelPipeline::TevInputs& inputs) {
+    std::array<u8, 3> operands;
+    for (unsigned i = 0; i < NumOperands(op); ++i)
+        operands[i] = GetAlphaModifier(stage.alpha_modifiers[i], inputs[stage.alpha_inputs[i]]);
+    return AlphaCombine<op>(operands);
+}
+
+static PixelPipeline::AlphaCombineFunction GetAlphaCombineFunction(Operation op) {
+    switch (op) {
+    case Operation::Replace:
+        return CombineAlpha<Operation::Replace>;
+    case Operation::Modulate:
+        return CombineAlpha<Operation::Modulate>;
+    case Operation::Add:
+        return CombineAlpha<Operation::Add>;
+    case Operation::AddSigned:
+        return CombineAlpha<Operation::AddSigned>;
+    case Operation::Lerp:
+        return CombineAlpha<Operation::Lerp>;
+    case Operation::Subtract:
+        return CombineAlpha<Operation::Subtract>;
+    case Operation::MultiplyThenAdd:
+        return CombineAlpha<Operation::MultiplyThenAdd>;
+    case Operation::AddThenMultiply:
+        return CombineAlpha<Operation::AddThenMultiply>;
+    default:
+        LOG_ERROR(HW_GPU, "Unknown alpha combiner operation %d", (int)op);
+        UNIMPLEMENTED();
+        return CombineAlpha<Operation::Dot3_RGB>; // Yields 0
+    }
+}
+
+static PixelPipeline::TevInput GetTevInput(Source source) {
+    switch (source) {
+    case Source::PrimaryColor:
+
+    // HACK: Until we implement fragment lighting, use primary_color
+    case Source::PrimaryFragmentColor:
+        return PixelPipeline::PrimaryColor;
+
+    // HACK: Until we implement fragment lighting, use zero
+    case Source::SecondaryFragmentColor:
+        return PixelPipeline::Zero;
+
+    case Source::Texture0:
+        return PixelPipeline::Texture0;
+
+    case Source::Texture1:
+        return PixelPipeline::Texture1;
+
+    case Source::Texture2:
+        return PixelPipeline::Texture2;
+
+    case Source::PreviousBuffer:
+        return PixelPipeline::PreviousBuffer;
+
+    case Source::Constant:
+        return PixelPipeline::Constant;
+
+    case Source::Previous:
+        return PixelPipeline::Previous;
+
+    default:
+        LOG_ERROR(HW_GPU, "Unknown color combiner source %d", (int)source);
+        UNIMPLEMENTED();
+        return PixelPipeline::Zero;
+    }
+}
+
+template <Regs::CompareFunc func>
+static bool Compare(u32 a, u32 b) {
+    switch (func) {
+    case Regs::CompareFunc::Never:
+        return false;
+
+    case Regs::CompareFunc::Always:
+        return true;
+
+    case Regs::CompareFunc::Equal:
+        return a == b;
+
+    case Regs::CompareFunc::NotEqual:
+        return a != b;
+
+    case Regs::CompareFunc::LessThan:
+        return a < b;
+
+    case Regs::CompareFunc::LessThanOrEqual:
+        return a <= b;
+
+    case Regs::CompareFunc::GreaterThan:
+        return a > b;
+
+    case Regs::CompareFunc::GreaterThanOrEqual:
+        return a >= b;
+    }
+}
+
+static PixelPipeline::CompareFunction GetCompareFunction(Regs::CompareFunc func) {
+    // The register fields are only three bits wide, so all values are covered
+    switch (func) {
+    case Regs::CompareFunc::Never:
+        return Compare<Regs::CompareFunc::Never>;
+    case Regs::CompareFunc::Always:
+        return Compare<Regs::CompareFunc::Always>;
+    case Regs::CompareFunc::Equal:
+        return Compare<Regs::CompareFunc::Equal>;
+    case Regs::CompareFunc::NotEqual:
+        return Compare<Regs::CompareFunc::NotEqual>;
+    case Regs::CompareFunc::LessThan:
+        return Compare<Regs::CompareFunc::LessThan>;
+    case Regs::CompareFunc::LessThanOrEqual:
+        return Compare<Regs::CompareFunc::LessThanOrEqual>;
+    case Regs::CompareFunc::GreaterThan:
+        return Compare<Regs::CompareFunc::GreaterThan>;
+    case Regs::CompareFunc::GreaterThanOrEqual:
+    default:
+        return Compare<Regs::CompareFunc::GreaterThanOrEqual>;
+    }
+}
+
+template <Regs::StencilAction action>
+static u8 PerformStencilAction(u8 old_stencil, u8 ref) {
+    switch (action) {
+    case Regs::StencilAction::Keep:
+        return old_stencil;
+
+    case Regs::StencilAction::Zero:
+        return 0;
+
+    case Regs::StencilAction::Replace:
+        return ref;
+
+    case Regs::StencilAction::Increment:
+        // Saturated increment
+        return std::min<u8>(old_stencil, 254) + 1;
+
+    case Regs::StencilAction::Decrement:
+        // Saturated decrement
+        return std::max<u8>(old_stencil, 1) - 1;
+
+    case Regs::StencilAction::Invert:
+        return ~old_stencil;
+
+    case Regs::StencilAction::IncrementWrap:
+        return old_stencil + 1;
+
+    case Regs::StencilAction::DecrementWrap:
+        return old_stencil - 1;
+    }
+}
+
+static PixelPipeline::StencilActionFunction GetStencilActionFunction(
+    Regs::StencilAction action) {
+    // The register fields are only three bits wide, so all values are covered
+    switch (action) {
+    case Regs::StencilAction::Keep:
+        return PerformStencilAction<Regs::StencilAction::Keep>;
+    case Regs::StencilAction::Zero:
+        return PerformStencilAction<Regs::StencilAction::Zero>;
+    case Regs::StencilAction::Replace:
+        return PerformStencilAction<Regs::StencilAction::Replace>;
+    case Regs::StencilAction::Increment:
+        return PerformStencilAction<Regs::StencilAction::Increment>;
+    case Regs::StencilAction::Decrement:
+        return PerformStencilAction<Regs::StencilAction::Decrement>;
+    case Regs::StencilAction::Invert:
+        return PerformStencilAction<Regs::StencilAction::Invert>;
+    case Regs::StencilAction::IncrementWrap:
+        return PerformStencilAction<Regs::StencilAction::IncrementWrap>;
+    case Regs::StencilAction::DecrementWrap:
+    default:
+        return PerformStencilAction<Regs::StencilAction::DecrementWrap>;
+    }
+}
+
+template <Regs::BlendFactor factor>
+static u8 LookupFactor(unsigned channel, const Math::Vec4<u8>& source, const Math::Vec4<u8>& dest,
+                       const Math::Vec4<u8>& blend_const) {
+    DEBUG_ASSERT(channel < 4);
+
+    switch (factor) {
+    case Regs::BlendFactor::Zero:
+        return 0;
+
+    case Regs::BlendFactor::One:
+        return 255;
+
+    case Regs::BlendFactor::SourceColor:
+        return source[channel];
+
+    case Regs::BlendFactor::OneMinusSourceColor:
+        return 255 - source[channel];
+
+    case Regs::BlendFactor::DestColor:
+        return dest[channel];
+
+    case Regs::BlendFactor::OneMinusDestColor:
+        return 255 - dest[channel];
+
+    case Regs::BlendFactor::SourceAlpha:
+        return source.a();
+
+    case Regs::BlendFactor::OneMinusSourceAlpha:
+        return 255 - source.a();
+
+    case Regs::BlendFactor::DestAlpha:
+        return dest.a();
+
+    case Regs::BlendFactor::OneMinusDestAlpha:
+        return 255 - dest.a();
+
+    case Regs::BlendFactor::ConstantColor:
+        return blend_const[channel];
+
+    case Regs::BlendFactor::OneMinusConstantColor:
+        return 255 - blend_const[channel];
+
+    case Regs::BlendFactor::ConstantAlpha:
+        return blend_const.a();
+
+    case Regs::BlendFactor::OneMinusConstantAlpha:
+        return 255 - blend_const.a();
+
+    case Regs::BlendFactor::SourceAlphaSaturate:
+        // Returns 1.0 for the alpha channel
+        if (channel == 3)
+            return 255;
+        return std::min(source.a(), static_cast<u8>(255 - dest.a()));
+    }
+}
+
+static PixelPipeline::BlendFactorFunction GetBlendFactorFunction(Regs::BlendFactor factor) {
+    switch (factor) {
+    case Regs::BlendFactor::Zero:
+        return LookupFactor<Regs::BlendFactor::Zero>;
+    case Regs::BlendFactor::One:
+        return LookupFactor<Regs::BlendFactor::One>;
+    case Regs::BlendFactor::SourceColor:
+        return LookupFactor<Regs::BlendFactor::SourceColor>;
+    case Regs::BlendFactor::OneMinusSourceColor:
+        return LookupFactor<Regs::BlendFactor::OneMinusSourceColor>;
+    case Regs::BlendFactor::DestColor:
+        return LookupFactor<Regs::BlendFactor::DestColor>;
+    case Regs::BlendFactor::OneMinusDestColor:
+        return LookupFactor<Regs::BlendFactor::OneMinusDestColor>;
+    case Regs::BlendFactor::SourceAlpha:
+        return LookupFactor<Regs::BlendFactor::SourceAlpha>;
+    case Regs::BlendFactor::OneMinusSourceAlpha:
+        return LookupFactor<Regs::BlendFactor::OneMinusSourceAlpha>;
+    case Regs::BlendFactor::DestAlpha:
+        return LookupFactor<Regs::BlendFactor::DestAlpha>;
+    case Regs::BlendFactor::OneMinusDestAlpha:
+        return LookupFactor<Regs::BlendFactor::OneMinusDestAlpha>;
+    case Regs::BlendFactor::ConstantColor:
+        return LookupFactor<Regs::BlendFactor::ConstantColor>;
+    case Regs::BlendFactor::OneMinusConstantColor:
+        return LookupFactor<Regs::BlendFactor::OneMinusConstantColor>;
+    case Regs::BlendFactor::ConstantAlpha:
+        return LookupFactor<Regs::BlendFactor::ConstantAlpha>;
+    case Regs::BlendFactor::OneMinusConstantAlpha:
+        return LookupFactor<Regs::BlendFactor::OneMinusConstantAlpha>;
+    case Regs::BlendFactor::SourceAlphaSaturate:
+        return LookupFactor<Regs::BlendFactor::SourceAlphaSaturate>;
+    default:
+        LOG_CRITICAL(HW_GPU, "Unknown blend factor %x", factor);
+        UNIMPLEMENTED();
+        return LookupFactor<Regs::BlendFactor::SourceColor>;
+    }
+}
+
+template <Regs::BlendEquation equation>
+static Math::Vec4<u8> EvaluateBlendEquation(const Math::Vec4<u8>& src,
+                                            const Math::Vec4<u8>& srcfactor,
+                                            const Math::Vec4<u8>& dest,
+                                            const Math::Vec4<u8>& destfactor) {
+    Math::Vec4<int> result;
+
+    auto src_result = (src * srcfactor).Cast<int>();
+    auto dst_result = (dest * destfactor).Cast<int>();
+
+    switch (equation) {
+    case Regs::BlendEquation::Add:
+        result = (src_result + dst_result) / 255;
+        break;
+
+    case Regs::BlendEquation::Subtract:
+        result = (src_result - dst_result) / 255;
+        break;
+
+    case Regs::BlendEquation::ReverseSubtract:
+        result = (dst_result - src_result) / 255;
+        break;
+
+    // TODO: How do these two actually work?
+    //       OpenGL doesn't include the blend factors in the min/max computations,
+    //       but is this what the 3DS actually does?
+    case Regs::BlendEquation::Min:
+        result.r() = std::min(src.r(), dest.r());
+        result.g() = std::min(src.g(), dest.g());
+        result.b() = std::min(src.b(), dest.b());
+        result.a() = std::min(src.a(), dest.a());
+        break;
+
+    case Regs::BlendEquation::Max:
+        result.r() = std::max(src.r(), dest.r());
+        result.g() = std::max(src.g(), dest.g());
+        result.b() = std::max(src.b(), dest.b());
+        result.a() = std::max(src.a(), dest.a());
+        break;
+    }
+
+    return Math::Vec4<u8>(MathUtil::Clamp(result.r(), 0, 255), MathUtil::Clamp(result.g(), 0, 255),
+                          MathUtil::Clamp(result.b(), 0, 255), MathUtil::Clamp(result.a(), 0, 255));
+}
+
+static PixelPipeline::BlendEquationFunction GetBlendEquationFunction(
+    Regs::BlendEquation equation) {
+    switch (equation) {
+    case Regs::BlendEquation::Add:
+        return EvaluateBlendEquation<Regs::BlendEquation::Add>;
+    case Regs::BlendEquation::Subtract:
+        return EvaluateBlendEquation<Regs::BlendEquation::Subtract>;
+    case Regs::BlendEquation::ReverseSubtract:
+        return EvaluateBlendEquation<Regs::BlendEquation::ReverseSubtract>;
+    case Regs::BlendEquation::Min:
+        return EvaluateBlendEquation<Regs::BlendEquation::Min>;
+    case Regs::BlendEquation::Max:
+        return EvaluateBlendEquation<Regs::BlendEquation::Max>;
+    default:
+        LOG_CRITICAL(HW_GPU, "Unknown RGB blend equation %x", equation);
+        UNIMPLEMENTED();
+        return EvaluateBlendEquation<Regs::BlendEquation::Add>;
+    }
+}
+
+template <Regs::LogicOp op>
+static u8 LogicOp(u8 src, u8 dest) {
+    switch (op) {
+    case Regs::LogicOp::Clear:
+        return 0;
+
+    case Regs::LogicOp::And:
+        return src & dest;
+
+    case Regs::LogicOp::AndReverse:
+        return src & ~dest;
+
+    case Regs::LogicOp::Copy:
+        return src;
+
+    case Regs::LogicOp::Set:
+        return 255;
+
+    case Regs::LogicOp::CopyInverted:
+        return ~src;
+
+    case Regs::LogicOp::NoOp:
+        return dest;
+
+    case Regs::LogicOp::Invert:
+        return ~dest;
+
+    case Regs::LogicOp::Nand:
+        return ~(src & dest);
+
+    case Regs::LogicOp::Or:
+        return src | dest;
+
+    case Regs::LogicOp::Nor:
+        return ~(src | dest);
+
+    case Regs::LogicOp::Xor:
+        return src ^ dest;
+
+    case Regs::LogicOp::Equiv:
+        return ~(src ^ dest);
+
+    case Regs::LogicOp::AndInverted:
+        return ~src & dest;
+
+    case Regs::LogicOp::OrReverse:
+        return src | ~dest;
+
+    case Regs::LogicOp::OrInverted:
+        return ~src | dest;
+    }
+}
+
+static PixelPipeline::LogicOpFunction GetLogicOpFunction(Regs::LogicOp op) {
+    // The register field is only four bits wide, so all values are covered
+    switch (op) {
+    case Regs::LogicOp::Clear:
+        return LogicOp<Regs::LogicOp::Clear>;
+    case Regs::LogicOp::And:
+        return LogicOp<Regs::LogicOp::And>;
+    case Regs::LogicOp::AndReverse:
+        return LogicOp<Regs::LogicOp::AndReverse>;
+    case Regs::LogicOp::Copy:
+        return LogicOp<Regs::LogicOp::Copy>;
+    case Regs::LogicOp::Set:
+        return LogicOp<Regs::LogicOp::Set>;
+    case Regs::LogicOp::CopyInverted:
+        return LogicOp<Regs::LogicOp::CopyInverted>;
+    case Regs::LogicOp::NoOp:
+        return LogicOp<Regs::LogicOp::NoOp>;
+    case Regs::LogicOp::Invert:
+        return LogicOp<Regs::LogicOp::Invert>;
+    case Regs::LogicOp::Nand:
+        return LogicOp<Regs::LogicOp::Nand>;
+    case Regs::LogicOp::Or:
+        return LogicOp<Regs::LogicOp::Or>;
+    case Regs::LogicOp::Nor:
+        return LogicOp<Regs::LogicOp::Nor>;
+    case Regs::LogicOp::Xor:
+        return LogicOp<Regs::LogicOp::Xor>;
+    case Regs::LogicOp::Equiv:
+        return LogicOp<Regs::LogicOp::Equiv>;
+    case Regs::LogicOp::AndInverted:
+        return LogicOp<Regs::LogicOp::AndInverted>;
+    case Regs::LogicOp::OrReverse:
+        return LogicOp<Regs::LogicOp::OrReverse>;
+    case Regs::LogicOp::OrInverted:
+    default:
+        return LogicOp<Regs::LogicOp::OrInverted>;
+    }
+}
+
+/// Returns true if the given combiner stage outputs the previous stage's result unmodified
+static bool IsPassthroughTevStage(const Regs::TevStageConfig& stage) {
+    return stage.color_source1 == Source::Previous &&
+           stage.color_modifier1 == ColorModifier::SourceColor &&
+           stage.color_op == Operation::Replace && stage.GetColorMultiplier() == 1 &&
+           stage.alpha_source1 == Source::Previous &&
+           stage.alpha_modifier1 == AlphaModifier::SourceAlpha &&
+           stage.alpha_op == Operation::Replace && stage.GetAlphaMultiplier() == 1;
+}
+
+PixelPipeline::PixelPipeline(const PixelPipelineConfig& config) {
+    const auto& state = config.state;
+
+    // Stage 0 reads zero from PreviousBuffer, but stage 1 already reads the initial buffer color,
+    // so the buffer behaves as if it had been updated right before stage 0. This keeps stage 0
+    // from being dropped, which would make stage 1 read zero.
+    bool previous_updates_buffer = true;
+    for (unsigned index = 0; index < state.tev_stages.size(); ++index) {
+        Regs::TevStageConfig stage{};
+        stage.sources_raw = state.tev_stages[index].sources_raw;
+        stage.modifiers_raw = state.tev_stages[index].modifiers_raw;
+        stage.ops_raw = state.tev_stages[index].ops_raw;
+        stage.scales_raw = state.tev_stages[index].scales_raw;
+
+        const bool updates_buffer_color =
+            index < 4 && (state.combiner_buffer_input & (1 << index)) != 0;
+        const bool updates_buffer_alpha =
+            index < 4 && ((state.combiner_buffer_input >> 4) & (1 << index)) != 0;
+        const bool updates_buffer = updates_buffer_color || updates_buffer_alpha;
+
+        // Each stage copies the combiner buffer contents from before the previous stage's update
+        // to its PreviousBuffer input. Dropping a stage would skip one of these delays, so that's
+        // only done if neither the dropped stage nor the one before it updates the buffer.
+        const bool removable =
+            IsPassthroughTevStage(stage) && !updates_buffer && !previous_updates_buffer;
+        previous_updates_buffer = updates_buffer;
+        if (removable)
+            continue;
+
+        auto& tev_stage = tev_stages[num_tev_stages++];
+        tev_stage.index = index;
+
+        tev_stage.color_inputs = {GetTevInput(stage.color_source1),
+                                  GetTevInput(stage.color_source2),
+                                  GetTevInput(stage.color_source3)};
+        tev_stage.color_modifiers = {CheckColorModifier(stage.color_modifier1),
+                                     CheckColorModifier(stage.color_modifier2),
+                                     CheckColorModifier(stage.color_modifier3)};
+        tev_stage.color_op = GetColorCombineFunction(stage.color_op);
+        tev_stage.color_multiplier = stage.GetColorMultiplier();
+
+        tev_stage.alpha_inputs = {GetTevInput(stage.alpha_source1),
+                                  GetTevInput(stage.alpha_source2),
+                                  GetTevInput(stage.alpha_source3)};
+        tev_stage.alpha_modifiers = {stage.alpha_modifier1, stage.alpha_modifier2,
+                                     stage.alpha_modifier3};
+        tev_stage.alpha_op = GetAlphaCombineFunction(stage.alpha_op);
+        tev_stage.alpha_multiplier = stage.GetAlphaMultiplier();
+
+        tev_stage.updates_buffer_color = updates_buffer_color;
+        tev_stage.updates_buffer_alpha = updates_buffer_alpha;
+    }
+
+    alpha_test = state.alpha_test_func == Regs::CompareFunc::Always
+                     ? nullptr
+                     : GetCompareFunction(state.alpha_test_func);
+
+    fog_enable = state.fog_mode == Regs::FogMode::Fog;
+    fog_flip = state.fog_flip;
+
+    stencil_action_enable = state.stencil_action_enable;
+    stencil_test = GetCompareFunction(state.stencil_test_func);
+    stencil_fail_action = GetStencilActionFunction(state.stencil_fail_action);
+    depth_fail_action = GetStencilActionFunction(state.depth_fail_action);
+    depth_pass_action = GetStencilActionFunction(state.depth_pass_action);
+    stencil_write_enable = state.stencil_write_enable;
+
+    depth_test = state.depth_test_enable ? GetCompareFunction(state.depth_test_func) : nullptr;
+    depth_test_func = state.depth_test_func;
+    depth_max = (1 << Regs::DepthBitsPerPixel(state.depth_format)) - 1;
+    depth_write_enable = state.depth_write_enable;
+
+    alphablend_enable = state.alphablend_enable;
+    factor_source_rgb = GetBlendFactorFunction(state.factor_source_rgb);
+    factor_dest_rgb = GetBlendFactorFunction(state.factor_dest_rgb);
+    factor_source_a = GetBlendFactorFunction(state.factor_source_a);
+    factor_dest_a = GetBlendFactorFunction(state.factor_dest_a);
+    blend_equation_rgb = GetBlendEquationFunction(state.blend_equation_rgb);
+    blend_equation_a = GetBlendEquationFunction(state.blend_equation_a);
+    logic_op = GetLogicOpFunction(state.logic_op);
+}
+
+Math::Vec4<u8> PixelPipeline::CombineTextures(TevInputs& inputs,
+                                              const std::array<Math::Vec4<u8>, 6>& const_colors,
+                                              const Math::Vec4<u8>& buffer_color) const {
+    inputs[Zero] = {0, 0, 0, 0};
+    inputs[PreviousBuffer] = {0, 0, 0, 0};
+    inputs[Previous] = {0, 0, 0, 0};
+    Math::Vec4<u8>& combiner_output = inputs[Previous];
+    Math::Vec4<u8> next_combiner_buffer = buffer_color;
+
+    for (unsigned stage_index = 0; stage_index < num_tev_stages; ++stage_index) {
+        const auto& tev_stage = tev_stages[stage_index];
+        inputs[Constant] = const_colors[tev_stage.index];
+
+        // color combiner
+        // NOTE: Not sure if the alpha combiner might use the color output of the previous
+        //       stage as input. Hence, we currently don't directly write the result to
+        //       combiner_output.rgb(), but instead store it in a temporary variable until
+        //       alpha combining has been done.
+        const auto color_output = tev_stage.color_op(tev_stage, inputs);
+
+        // alpha combiner
+        const auto alpha_output = tev_stage.alpha_op(tev_stage, inputs);
+
+        combiner_output[0] = std::min((unsigned)255, color_output.r() * tev_stage.color_multiplier);
+        combiner_output[1] = std::min((unsigned)255, color_output.g() * tev_stage.color_multiplier);
+        combiner_output[2] = std::min((unsigned)255, color_output.b() * tev_stage.color_multiplier);
+        combiner_output[3] = std::min((unsigned)255, alpha_output * tev_stage.alpha_multiplier);
+
+        inputs[PreviousBuffer] = next_combiner_buffer;
+
+        if (tev_stage.updates_buffer_color) {
+            next_combiner_buffer.r() = combiner_output.r();
+            next_combiner_buffer.g() = combiner_output.g();
+            next_combiner_buffer.b() = combiner_output.b();
+        }
+
+        if (tev_stage.updates_buffer_alpha) {
+            next_combiner_buffer.a() = combiner_output.a();
+        }
+    }
+
+    return combiner_output;
+}
+
+} // namespace Rasterizer
+
+} // namespace Pica
@@ -0,0 +1,202 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+#include "common/common_types.h"
+#include "common/hash.h"
+#include "common/vector_math.h"
+#include "video_core/pica.h"
+
+namespace Pica {
+
+namespace Rasterizer {
+
+/**
+ * Register state that determines which operations the software rasterizer performs per pixel.
+ * Values which don't change the structure of the pipeline (e.g. constant colors or reference
+ * values) are excluded, so that they don't cause redundant pipelines to be built.
+ *
+ * Like PicaShaderConfig, this is a union so that copies include the padding bytes, which are part
+ * of the hash and comparison.
+ */
+union PixelPipelineConfig {
+    /// Construct a PixelPipelineConfig with the current Pica register configuration.
+    static PixelPipelineConfig CurrentConfig();
+
+    bool operator==(const PixelPipelineConfig& o) const {
+        return std::memcmp(&state, &o.state, sizeof(PixelPipelineConfig::State)) == 0;
+    }
+
+    struct TevStageConfigRaw {
+        u32 sources_raw;
+        u32 modifiers_raw;
+        u32 ops_raw;
+        u32 scales_raw;
+    };
+
+    struct State {
+        std::array<TevStageConfigRaw, 6> tev_stages;
+        u8 combiner_buffer_input;
+
+        Regs::CompareFunc alpha_test_func;
+
+        Regs::FogMode fog_mode;
+        bool fog_flip;
+
+        bool stencil_action_enable;
+        Regs::CompareFunc stencil_test_func;
+        Regs::StencilAction stencil_fail_action;
+        Regs::StencilAction depth_fail_action;
+        Regs::StencilAction depth_pass_action;
+        bool stencil_write_enable;
+
+        bool depth_test_enable;
+        Regs::CompareFunc depth_test_func;
+        Regs::DepthFormat depth_format;
+        bool depth_write_enable;
+
+        bool alphablend_enable;
+        Regs::BlendEquation blend_equation_rgb;
+        Regs::BlendEquation blend_equation_a;
+        Regs::BlendFactor factor_source_rgb;
+        Regs::BlendFactor factor_dest_rgb;
+        Regs::BlendFactor factor_source_a;
+        Regs::BlendFactor factor_dest_a;
+        Regs::LogicOp logic_op;
+    } state;
+};
+#if (__GNUC__ >= 5) || defined(__clang__) || defined(_MSC_VER)
+static_assert(std::is_trivially_copyable<PixelPipelineConfig::State>::value,
+              "PixelPipelineConfig::State must be trivially copyable");
+#endif
+
+/**
+ * Per-pixel operations of the software rasterizer (texture combiners, alpha, stencil and depth
+ * tests, blending) specialized for one PixelPipelineConfig. All register decoding happens when
+ * the pipeline is built; per pixel, only calls to the matching template instantiations remain,
+ * one per color and alpha combiner of each stage. Texture combiner stages which pass their input
+ * through unchanged are dropped.
+ */
+class PixelPipeline {
+public:
+    explicit PixelPipeline(const PixelPipelineConfig& config);
+
+    /// Combiner inputs, indexing the array passed to CombineTextures
+    enum TevInput : u8 {
+        PrimaryColor,
+        Zero,
+        Texture0,
+        Texture1,
+        Texture2,
+        PreviousBuffer,
+        Constant,
+        Previous,
+        NumTevInputs,
+    };
+    using TevInputs = std::array<Math::Vec4<u8>, NumTevInputs>;
+
+    struct TevStage;
+
+    /// Applies the operand modifiers and the operation of a stage's color combiner
+    using ColorCombineFunction = Math::Vec3<u8> (*)(const TevStage& stage, const TevInputs& inputs);
+    /// Applies the operand modifiers and the operation of a stage's alpha combiner
+    using AlphaCombineFunction = u8 (*)(const TevStage& stage, const TevInputs& inputs);
+    using CompareFunction = bool (*)(u32 a, u32 b);
+    using StencilActionFunction = u8 (*)(u8 old_stencil, u8 ref);
+    using BlendFactorFunction = u8 (*)(unsigned channel, const Math::Vec4<u8>& source,
+                                       const Math::Vec4<u8>& dest,
+                                       const Math::Vec4<u8>& blend_const);
+    using BlendEquationFunction = Math::Vec4<u8> (*)(const Math::Vec4<u8>& src,
+                                                     const Math::Vec4<u8>& srcfactor,
+                                                     const Math::Vec4<u8>& dest,
+                                                     const Math::Vec4<u8>& destfactor);
+    using LogicOpFunction = u8 (*)(u8 src, u8 dest);
+
+    /**
+     * Runs the texture combiner stages.
+     * @param inputs Combiner inputs; PrimaryColor and Texture0-2 must be set by the caller, the
+     *               remaining entries are used as scratch space
+     * @param const_colors Constant colors of all six combiner stages
+     * @param buffer_color Initial value of the combiner buffer
+     * @returns Output of the last combiner stage
+     */
+    Math::Vec4<u8> CombineTextures(TevInputs& inputs,
+                                   const std::array<Math::Vec4<u8>, 6>& const_colors,
+                                   const Math::Vec4<u8>& buffer_color) const;
+
+    /// Alpha test comparing fragment alpha against the reference, or nullptr if it always passes
+    CompareFunction alpha_test;
+
+    bool fog_enable;
+    bool fog_flip;
+
+    bool stencil_action_enable;
+    /// Stencil test comparing the masked reference against the masked stored value
+    CompareFunction stencil_test;
+    StencilActionFunction stencil_fail_action;
+    StencilActionFunction depth_fail_action;
+    StencilActionFunction depth_pass_action;
+    bool stencil_write_enable;
+
+    /// Depth test comparing the fragment depth against the stored one, or nullptr if disabled
+    CompareFunction depth_test;
+    /// Comparison performed by depth_test, for testing several pixels at once
+    Regs::CompareFunc depth_test_func;
+    /// Largest depth value representable by the depth buffer format
+    u32 depth_max;
+    bool depth_write_enable;
+
+    bool alphablend_enable;
+    BlendFactorFunction factor_source_rgb;
+    BlendFactorFunction factor_dest_rgb;
+    BlendFactorFunction factor_source_a;
+    BlendFactorFunction factor_dest_a;
+    BlendEquationFunction blend_equation_rgb;
+    BlendEquationFunction blend_equation_a;
+    LogicOpFunction logic_op;
+
+    /// Decoded combiner stage, handed to its combine functions
+    struct TevStage {
+        /// Index of the stage in the register file
+        unsigned index;
+
+        std::array<TevInput, 3> color_inputs;
+        std::array<Regs::TevStageConfig::ColorModifier, 3> color_modifiers;
+        ColorCombineFunction color_op;
+        unsigned color_multiplier;
+
+        std::array<TevInput, 3> alpha_inputs;
+        std::array<Regs::TevStageConfig::AlphaModifier, 3> alpha_modifiers;
+        AlphaCombineFunction alpha_op;
+        unsigned alpha_multiplier;
+
+        bool updates_buffer_color;
+        bool updates_buffer_alpha;
+    };
+
+private:
+    std::array<TevStage, 6> tev_stages;
+    unsigned num_tev_stages = 0;
+};
+
+} // namespace Rasterizer
+
+} // namespace Pica
+
+namespace std {
+
+template <>
+struct hash<Pica::Rasterizer::PixelPipelineConfig> {
+    size_t operator()(const Pica::Rasterizer::PixelPipelineConfig& k) const {
+        return Common::ComputeHash64(&k.state,
+                                     sizeof(Pica::Rasterizer::PixelPipelineConfig::State));
+    }
+};
+
+} // namespace std
@@ -5,6 +5,9 @@
 #include <algorithm>
 #include <array>
 #include <cmath>
+#ifdef ARCHITECTURE_x86_64
+#include <emmintrin.h>
+#endif
 #include "common/assert.h"
 #include "common/bit_field.h"
 #include "common/color.h"
@@ -19,8 +22,10 @@
 #include "video_core/pica.h"
 #include "video_core/pica_state.h"
 #include "video_core/pica_types.h"
+#include "video_core/pixel_pipeline.h"
 #include "video_core/rasterizer.h"
 #include "video_core/shader/shader.h"
+#include "video_core/texture/texture_cache.h"
 #include "video_core/utils.h"
 
 namespace Pica {
@@ -228,41 +233,6 @@ static void SetStencil(int x, int y, u8 value) {
     }
 }
 
-static u8 PerformStencilAction(Regs::StencilAction action, u8 old_stencil, u8 ref) {
-    switch (action) {
-    case Regs::StencilAction::Keep:
-        return old_stencil;
-
-    case Regs::StencilAction::Zero:
-        return 0;
-
-    case Regs::StencilAction::Replace:
-        return ref;
-
-    case Regs::StencilAction::Increment:
-        // Saturated increment
-        return std::min<u8>(old_stencil, 254) + 1;
-
-    case Regs::StencilAction::Decrement:
-        // Saturated decrement
-        return std::max<u8>(old_stencil, 1) - 1;
-
-    case Regs::StencilAction::Invert:
-        return ~old_stencil;
-
-    case Regs::StencilAction::IncrementWrap:
-        return old_stencil + 1;
-
-    case Regs::StencilAction::DecrementWrap:
-        return old_stencil - 1;
-
-    default:
-        LOG_CRITICAL(HW_GPU, "Unknown stencil action %x", (int)action);
-        UNIMPLEMENTED();
-        return 0;
-    }
-}
-
 // NOTE: Assuming that rasterizer coordinates are 12.4 fixed-point values
 struct Fix12P4 {
     Fix12P4() {}
@@ -303,25 +273,210 @@ static int SignedArea(const Math::Vec2<Fix12P4>& vtx1, const Math::Vec2<Fix12P4>
 
 MICROPROFILE_DEFINE(GPU_Rasterization, "GPU", "Rasterization", MP_RGB(50, 50, 240));
 
+// vertex positions in rasterizer coordinates
+static Fix12P4 FloatToFix(float24 flt) {
+    // TODO: Rounding here is necessary to prevent garbage pixels at
+    //       triangle borders. Is it that the correct solution, though?
+    return Fix12P4(static_cast<unsigned short>(round(flt.ToFloat32() * 16.0f)));
+}
+
+static Math::Vec3<Fix12P4> ScreenToRasterizerCoordinates(const Math::Vec3<float24>& vec) {
+    return Math::Vec3<Fix12P4>{FloatToFix(vec.x), FloatToFix(vec.y), FloatToFix(vec.z)};
+}
+
+/// Number of horizontally adjacent pixels whose coverage and depth are evaluated at once
+static constexpr unsigned SPAN_SIZE = 4;
+
+/// Per-triangle constants needed to evaluate a span of pixels
+struct SpanSetup {
+    /// Change of each edge function when moving one pixel to the right
+    std::array<int, 3> w_step;
+    /// Edge function offsets of each pixel of a span relative to its first pixel
+    std::array<std::array<int, SPAN_SIZE>, 3> w_offset;
+    Math::Vec3<float24> w_inverse;
+    /// Screen space z coordinates of the vertices
+    std::array<float, 3> z;
+    float depth_scale;
+    float depth_offset;
+    bool w_buffering;
+};
+
+/// Coverage and interpolated values of up to SPAN_SIZE consecutive pixels of a row
+struct Span {
+    /// Bit i is set if pixel i of the span is covered by the triangle
+    unsigned coverage_mask;
+    std::array<std::array<int, SPAN_SIZE>, 3> w;
+    std::array<float24, SPAN_SIZE> interpolated_w_inverse;
+    std::array<float, SPAN_SIZE> depth;
+};
+
+/**
+ * Evaluates edge functions, perspective divisor and depth of the pixels of a span. The results
+ * are bit-identical to evaluating each pixel separately; in particular, float24 multiplication
+ * semantics and the order of floating point operations are preserved.
+ * @param w_start Edge function values (including fill rule biases) at the first pixel
+ * @param num_pixels Number of pixels within the span which are inside the bounding box
+ * @param span Output span data. Values of uncovered pixels are unspecified.
+ */
+static void EvaluateSpan(const SpanSetup& setup, const std::array<int, 3>& w_start,
+                         unsigned num_pixels, Span& span) {
+#ifdef ARCHITECTURE_x86_64
+    std::array<__m128i, 3> w;
+    for (unsigned i = 0; i < 3; ++i) {
+        const __m128i offset =
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(setup.w_offset[i].data()));
+        w[i] = _mm_add_epi32(_mm_set1_epi32(w_start[i]), offset);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(span.w[i].data()), w[i]);
+    }
+
+    // A pixel is covered if none of the edge functions is negative
+    const __m128i any_negative = _mm_or_si128(_mm_or_si128(w[0], w[1]), w[2]);
+    span.coverage_mask = ~static_cast<unsigned>(_mm_movemask_ps(_mm_castsi128_ps(any_negative))) &
+                         ((1u << std::min(num_pixels, SPAN_SIZE)) - 1);
+    if (span.coverage_mask == 0)
+        return;
+
+    // float24 multiplication yields +0 if either factor is zero and the other one isn't NaN
+    const auto MultiplyFloat24 = [](__m128 a, __m128 b) {
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 a_zero = _mm_and_ps(_mm_cmpeq_ps(a, zero), _mm_cmpord_ps(b, b));
+        const __m128 b_zero = _mm_and_ps(_mm_cmpeq_ps(b, zero), _mm_cmpord_ps(a, a));
+        return _mm_andnot_ps(_mm_or_ps(a_zero, b_zero), _mm_mul_ps(a, b));
+    };
+
+    const __m128 w0 = _mm_cvtepi32_ps(w[0]);
+    const __m128 w1 = _mm_cvtepi32_ps(w[1]);
+    const __m128 w2 = _mm_cvtepi32_ps(w[2]);
+    const __m128 wsum = _mm_cvtepi32_ps(_mm_add_epi32(_mm_add_epi32(w[0], w[1]), w[2]));
+
+    const __m128 dot = _mm_add_ps(
+        _mm_add_ps(MultiplyFloat24(_mm_set1_ps(setup.w_inverse.x.ToFloat32()), w0),
+                   MultiplyFloat24(_mm_set1_ps(setup.w_inverse.y.ToFloat32()), w1)),
+        MultiplyFloat24(_mm_set1_ps(setup.w_inverse.z.ToFloat32()), w2));
+    const __m128 interpolated_w_inverse = _mm_div_ps(_mm_set1_ps(1.0f), dot);
+
+    const __m128 interpolated_z_over_w =
+        _mm_div_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(setup.z[0]), w0),
+                                         _mm_mul_ps(_mm_set1_ps(setup.z[1]), w1)),
+                              _mm_mul_ps(_mm_set1_ps(setup.z[2]), w2)),
+                   wsum);
+    __m128 depth = _mm_add_ps(_mm_mul_ps(interpolated_z_over_w, _mm_set1_ps(setup.depth_scale)),
+                              _mm_set1_ps(setup.depth_offset));
+    if (setup.w_buffering)
+        depth = _mm_mul_ps(depth, _mm_mul_ps(interpolated_w_inverse, wsum));
+
+    // Same operand order as MathUtil::Clamp, which matters for NaN inputs
+    depth = _mm_max_ps(_mm_min_ps(depth, _mm_set1_ps(1.0f)), _mm_setzero_ps());
+
+    std::array<float, SPAN_SIZE> w_inverse;
+    _mm_storeu_ps(w_inverse.data(), interpolated_w_inverse);
+    _mm_storeu_ps(span.depth.data(), depth);
+    for (unsigned i = 0; i < SPAN_SIZE; ++i)
+        span.interpolated_w_inverse[i] = float24::FromFloat32(w_inverse[i]);
+#else
+    span.coverage_mask = 0;
+    for (unsigned i = 0; i < std::min(num_pixels, SPAN_SIZE); ++i) {
+        const int w0 = span.w[0][i] = w_start[0] + setup.w_offset[0][i];
+        const int w1 = span.w[1][i] = w_start[1] + setup.w_offset[1][i];
+        const int w2 = span.w[2][i] = w_start[2] + setup.w_offset[2][i];
+        if (w0 < 0 || w1 < 0 || w2 < 0)
+            continue;
+
+        span.coverage_mask |= 1u << i;
+
+        const int wsum = w0 + w1 + w2;
+        const auto baricentric_coordinates =
+            Math::MakeVec(float24::FromFloat32(static_cast<float>(w0)),
+                          float24::FromFloat32(static_cast<float>(w1)),
+                          float24::FromFloat32(static_cast<float>(w2)));
+        const float24 interpolated_w_inverse =
+            float24::FromFloat32(1.0f) / Math::Dot(setup.w_inverse, baricentric_coordinates);
+        span.interpolated_w_inverse[i] = interpolated_w_inverse;
+
+        const float interpolated_z_over_w =
+            (setup.z[0] * w0 + setup.z[1] * w1 + setup.z[2] * w2) / wsum;
+        float depth = interpolated_z_over_w * setup.depth_scale + setup.depth_offset;
+        if (setup.w_buffering)
+            depth *= interpolated_w_inverse.ToFloat32() * wsum;
+        span.depth[i] = MathUtil::Clamp(depth, 0.0f, 1.0f);
+    }
+#endif
+}
+
+/**
+ * Runs the depth test for all covered pixels of a span at once and removes the failing pixels
+ * from its coverage mask, so that they are rejected before texturing and texture combining. This
+ * is only valid if failing the depth test has no side effects, i.e. without stencil actions.
+ * @param x Rasterizer x coordinate of the first pixel of the span
+ * @param y Rasterizer y coordinate of the row
+ */
+static void TestSpanDepth(const PixelPipeline& pipeline, u16 x, u16 y, Span& span) {
+    std::array<u32, SPAN_SIZE> ref_z{};
+    for (unsigned i = 0; i < SPAN_SIZE; ++i) {
+        if (span.coverage_mask & (1u << i))
+            ref_z[i] = GetDepth((x >> 4) + i, y >> 4);
+    }
+
+#ifdef ARCHITECTURE_x86_64
+    // Depth values have at most 24 bits, so signed comparisons give the same results. Uncovered
+    // pixels may convert to arbitrary values, but are masked out below.
+    const __m128i z = _mm_cvttps_epi32(_mm_mul_ps(
+        _mm_loadu_ps(span.depth.data()), _mm_set1_ps(static_cast<float>(pipeline.depth_max))));
+    const __m128i ref = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ref_z.data()));
+    const __m128i all = _mm_set1_epi32(-1);
+
+    __m128i pass;
+    switch (pipeline.depth_test_func) {
+    case Regs::CompareFunc::Never:
+        pass = _mm_setzero_si128();
+        break;
+    case Regs::CompareFunc::Always:
+        pass = all;
+        break;
+    case Regs::CompareFunc::Equal:
+        pass = _mm_cmpeq_epi32(z, ref);
+        break;
+    case Regs::CompareFunc::NotEqual:
+        pass = _mm_xor_si128(_mm_cmpeq_epi32(z, ref), all);
+        break;
+    case Regs::CompareFunc::LessThan:
+        pass = _mm_cmplt_epi32(z, ref);
+        break;
+    case Regs::CompareFunc::LessThanOrEqual:
+        pass = _mm_xor_si128(_mm_cmpgt_epi32(z, ref), all);
+        break;
+    case Regs::CompareFunc::GreaterThan:
+        pass = _mm_cmpgt_epi32(z, ref);
+        break;
+    case Regs::CompareFunc::GreaterThanOrEqual:
+    default:
+        pass = _mm_xor_si128(_mm_cmplt_epi32(z, ref), all);
+        break;
+    }
+    span.coverage_mask &= static_cast<unsigned>(_mm_movemask_ps(_mm_castsi128_ps(pass)));
+#else
+    for (unsigned i = 0; i < SPAN_SIZE; ++i) {
+        if ((span.coverage_mask & (1u << i)) == 0)
+            continue;
+        const u32 z = static_cast<u32>(span.depth[i] * pipeline.depth_max);
+        if (!pipeline.depth_test(z, ref_z[i]))
+            span.coverage_mask &= ~(1u << i);
+    }
+#endif
+}
+
 /**
  * Helper function for ProcessTriangle with the "reversed" flag to allow for implementing
  * culling via recursion.
  */
 static void ProcessTriangleInternal(const Shader::OutputVertex& v0, const Shader::OutputVertex& v1,
-                                    const Shader::OutputVertex& v2, bool reversed = false) {
+                                    const Shader::OutputVertex& v2, const PixelPipeline& pipeline,
+                                    const TextureUnits& texture_units,
+                                    const MathUtil::Rectangle<unsigned>& region,
+                                    bool reversed = false) {
     const auto& regs = g_state.regs;
     MICROPROFILE_SCOPE(GPU_Rasterization);
 
-    // vertex positions in rasterizer coordinates
-    static auto FloatToFix = [](float24 flt) {
-        // TODO: Rounding here is necessary to prevent garbage pixels at
-        //       triangle borders. Is it that the correct solution, though?
-        return Fix12P4(static_cast<unsigned short>(round(flt.ToFloat32() * 16.0f)));
-    };
-    static auto ScreenToRasterizerCoordinates = [](const Math::Vec3<float24>& vec) {
-        return Math::Vec3<Fix12P4>{FloatToFix(vec.x), FloatToFix(vec.y), FloatToFix(vec.z)};
-    };
-
     Math::Vec3<Fix12P4> vtxpos[3]{ScreenToRasterizerCoordinates(v0.screenpos),
                                   ScreenToRasterizerCoordinates(v1.screenpos),
                                   ScreenToRasterizerCoordinates(v2.screenpos)};
@@ -329,13 +484,13 @@ static void ProcessTriangleInternal(const Shader::OutputVertex& v0, const Shader
     if (regs.cull_mode == Regs::CullMode::KeepAll) {
         // Make sure we always end up with a triangle wound counter-clockwise
         if (!reversed && SignedArea(vtxpos[0].xy(), vtxpos[1].xy(), vtxpos[2].xy()) <= 0) {
-            ProcessTriangleInternal(v0, v2, v1, true);
+            ProcessTriangleInternal(v0, v2, v1, pipeline, texture_units, region, true);
             return;
         }
     } else {
         if (!reversed && regs.cull_mode == Regs::CullMode::KeepClockWise) {
             // Reverse vertex order and use the CCW code path.
-            ProcessTriangleInternal(v0, v2, v1, true);
+            ProcessTriangleInternal(v0, v2, v1, pipeline, texture_units, region, true);
             return;
         }
 
@@ -369,6 +524,12 @@ static void ProcessTriangleInternal(const Shader::OutputVertex& v0, const Shader
     max_x = ((max_x + Fix12P4::FracMask()) & Fix12P4::IntMask());
     max_y = ((max_y + Fix12P4::FracMask()) & Fix12P4::IntMask());
 
+    // Only touch pixels inside the requested region (e.g. a single tile of the render target)
+    min_x = static_cast<u16>(std::max<unsigned>(min_x, region.left << 4));
+    min_y = static_cast<u16>(std::max<unsigned>(min_y, region.top << 4));
+    max_x = static_cast<u16>(std::min<unsigned>(max_x, region.right << 4));
+    max_y = static_cast<u16>(std::min<unsigned>(max_y, region.bottom << 4));
+
     // Triangle filling rules: Pixels on the right-sided edge or on flat bottom edges are not
     // drawn. Pixels on any other triangle border are drawn. This is implemented with three bias
     // values which are added to the barycentric coordinates w0, w1 and w2, respectively.
@@ -397,16 +558,80 @@ static void ProcessTriangleInternal(const Shader::OutputVertex& v0, const Shader
     auto w_inverse = Math::MakeVec(v0.pos.w, v1.pos.w, v2.pos.w);
 
     auto textures = regs.GetTextures();
-    auto tev_stages = regs.GetTevStages();
 
-    bool stencil_action_enable = g_state.regs.output_merger.stencil_test.enable &&
-                                 g_state.regs.framebuffer.depth_format == Regs::DepthFormat::D24S8;
-    const auto stencil_test = g_state.regs.output_merger.stencil_test;
+    // Values which aren't part of the pipeline configuration
+    std::array<Math::Vec4<u8>, 6> tev_const_colors;
+    const auto tev_stages = regs.GetTevStages();
+    for (unsigned i = 0; i < tev_stages.size(); ++i) {
+        tev_const_colors[i] = {static_cast<u8>(tev_stages[i].const_r),
+                               static_cast<u8>(tev_stages[i].const_g),
+                               static_cast<u8>(tev_stages[i].const_b),
+                               static_cast<u8>(tev_stages[i].const_a)};
+    }
+    const Math::Vec4<u8> tev_buffer_color = {
+        static_cast<u8>(regs.tev_combiner_buffer_color.r),
+        static_cast<u8>(regs.tev_combiner_buffer_color.g),
+        static_cast<u8>(regs.tev_combiner_buffer_color.b),
+        static_cast<u8>(regs.tev_combiner_buffer_color.a),
+    };
+    const Math::Vec4<u8> blend_const = {
+        static_cast<u8>(regs.output_merger.blend_const.r),
+        static_cast<u8>(regs.output_merger.blend_const.g),
+        static_cast<u8>(regs.output_merger.blend_const.b),
+        static_cast<u8>(regs.output_merger.blend_const.a),
+    };
+    const auto stencil_test = regs.output_merger.stencil_test;
+
+    // Edge functions are linear, so moving one pixel (16 subpixels) to the right changes them by
+    // a constant amount
+    SpanSetup span_setup;
+    span_setup.w_step = {-16 * (vtxpos[2].y - vtxpos[1].y), -16 * (vtxpos[0].y - vtxpos[2].y),
+                         -16 * (vtxpos[1].y - vtxpos[0].y)};
+    for (unsigned i = 0; i < 3; ++i) {
+        for (unsigned j = 0; j < SPAN_SIZE; ++j)
+            span_setup.w_offset[i][j] = static_cast<int>(j) * span_setup.w_step[i];
+    }
+    span_setup.w_inverse = w_inverse;
+    span_setup.z = {v0.screenpos[2].ToFloat32(), v1.screenpos[2].ToFloat32(),
+                    v2.screenpos[2].ToFloat32()};
+    // Not fully accurate. About 3 bits in precision are missing.
+    // Z-Buffer (z / w * scale + offset)
+    span_setup.depth_scale = float24::FromRaw(regs.viewport_depth_range).ToFloat32();
+    span_setup.depth_offset = float24::FromRaw(regs.viewport_depth_near_plane).ToFloat32();
+    // W-Buffer (z * scale + w * offset = (z / w * scale + offset) * w)
+    span_setup.w_buffering = regs.depthmap_enable == Pica::Regs::DepthBuffering::WBuffering;
+
+    // Without stencil actions, pixels failing the depth test have no effect at all, so the test
+    // can be moved ahead of the per-pixel work
+    const bool early_depth_test = pipeline.depth_test != nullptr && !pipeline.stencil_action_enable;
 
     // Enter rasterization loop, starting at the center of the topleft bounding box corner.
     // TODO: Not sure if looping through x first might be faster
     for (u16 y = min_y + 8; y < max_y; y += 0x10) {
+        // Calculate the barycentric coordinates w0, w1 and w2 at the start of the row; the
+        // remaining pixels are evaluated a span at a time by stepping from there
+        const Math::Vec2<Fix12P4> row_start{static_cast<u16>(min_x + 8), y};
+        const std::array<int, 3> row_w = {
+            bias0 + SignedArea(vtxpos[1].xy(), vtxpos[2].xy(), row_start),
+            bias1 + SignedArea(vtxpos[2].xy(), vtxpos[0].xy(), row_start),
+            bias2 + SignedArea(vtxpos[0].xy(), vtxpos[1].xy(), row_start)};
+        Span span;
+
         for (u16 x = min_x + 8; x < max_x; x += 0x10) {
+            const int pixel_index = (x - min_x - 8) >> 4;
+            const unsigned span_index = pixel_index % SPAN_SIZE;
+            if (span_index == 0) {
+                const std::array<int, 3> span_w = {row_w[0] + pixel_index * span_setup.w_step[0],
+                                                   row_w[1] + pixel_index * span_setup.w_step[1],
+                                                   row_w[2] + pixel_index * span_setup.w_step[2]};
+                EvaluateSpan(span_setup, span_w, (max_x - x + 0xF) >> 4, span);
+                if (early_depth_test && span.coverage_mask != 0)
+                    TestSpanDepth(pipeline, x, y, span);
+            }
+
+            // If current pixel is not covered by the current primitive
+            if ((span.coverage_mask & (1u << span_index)) == 0)
+                continue;
 
             // Do not process the pixel if it's inside the scissor box and the scissor mode is set
             // to Exclude
@@ -415,43 +640,16 @@ static void ProcessTriangleInternal(const Shader::OutputVertex& v0, const Shader
                     continue;
             }
 
-            // Calculate the barycentric coordinates w0, w1 and w2
-            int w0 = bias0 + SignedArea(vtxpos[1].xy(), vtxpos[2].xy(), {x, y});
-            int w1 = bias1 + SignedArea(vtxpos[2].xy(), vtxpos[0].xy(), {x, y});
-            int w2 = bias2 + SignedArea(vtxpos[0].xy(), vtxpos[1].xy(), {x, y});
-            int wsum = w0 + w1 + w2;
-
-            // If current pixel is not covered by the current primitive
-            if (w0 < 0 || w1 < 0 || w2 < 0)
-                continue;
+            const int w0 = span.w[0][span_index];
+            const int w1 = span.w[1][span_index];
+            const int w2 = span.w[2][span_index];
 
             auto baricentric_coordinates =
                 Math::MakeVec(float24::FromFloat32(static_cast<float>(w0)),
                               float24::FromFloat32(static_cast<float>(w1)),
                               float24::FromFloat32(static_cast<float>(w2)));
-            float24 interpolated_w_inverse =
-                float24::FromFloat32(1.0f) / Math::Dot(w_inverse, baricentric_coordinates);
-
-            // interpolated_z = z / w
-            float interpolated_z_over_w =
-                (v0.screenpos[2].ToFloat32() * w0 + v1.screenpos[2].ToFloat32() * w1 +
-                 v2.screenpos[2].ToFloat32() * w2) /
-                wsum;
-
-            // Not fully accurate. About 3 bits in precision are missing.
-            // Z-Buffer (z / w * scale + offset)
-            float depth_scale = float24::FromRaw(regs.viewport_depth_range).ToFloat32();
-            float depth_offset = float24::FromRaw(regs.viewport_depth_near_plane).ToFloat32();
-            float depth = interpolated_z_over_w * depth_scale + depth_offset;
-
-            // Potentially switch to W-Buffer
-            if (regs.depthmap_enable == Pica::Regs::DepthBuffering::WBuffering) {
-                // W-Buffer (z * scale + w * offset = (z / w * scale + offset) * w)
-                depth *= interpolated_w_inverse.ToFloat32() * wsum;
-            }
-
-            // Clamp the result
-            depth = MathUtil::Clamp(depth, 0.0f, 1.0f);
+            const float24 interpolated_w_inverse = span.interpolated_w_inverse[span_index];
+            const float depth = span.depth[span_index];
 
             // Perspective correct attribute interpolation:
             // Attribute values cannot be calculated by simple linear interpolation since
@@ -576,15 +774,16 @@ static void ProcessTriangleInternal(const Shader::OutputVertex& v0, const Shader
                     t = texture.config.height - 1 -
                         GetWrappedTexCoord(texture.config.wrap_t, t, texture.config.height);
 
-                    u8* texture_data =
-                        Memory::GetPhysicalPointer(texture.config.GetPhysicalAddress());
-                    auto info =
-                        DebugUtils::TextureInfo::FromPicaRegister(texture.config, texture.format);
+                    const Texture::DecodedTexture* decoded_texture = texture_units[i];
+                    if (decoded_texture == nullptr)
+                        continue;
 
                     // TODO: Apply the min and mag filters to the texture
-                    texture_color[i] = DebugUtils::LookupTexture(texture_data, s, t, info);
+                    texture_color[i] = decoded_texture->texels[t * decoded_texture->width + s];
 #if PICA_DUMP_TEXTURES
-                    DebugUtils::DumpTexture(texture.config, texture_data);
+                    DebugUtils::DumpTexture(
+                        texture.config,
+                        Memory::GetPhysicalPointer(texture.config.GetPhysicalAddress()));
 #endif
                 }
             }
@@ -596,332 +795,26 @@ static void ProcessTriangleInternal(const Shader::OutputVertex& v0, const Shader
             // operations on each of them (e.g. inversion) and then calculate the output color
             // with some basic arithmetic. Alpha combiners can be configured separately but work
             // analogously.
-            Math::Vec4<u8> combiner_output;
-            Math::Vec4<u8> combiner_buffer = {0, 0, 0, 0};
-            Math::Vec4<u8> next_combiner_buffer = {
-                regs.tev_combiner_buffer_color.r, regs.tev_combiner_buffer_color.g,
-                regs.tev_combiner_buffer_color.b, regs.tev_combiner_buffer_color.a,
-            };
-
-            for (unsigned tev_stage_index = 0; tev_stage_index < tev_stages.size();
-                 ++tev_stage_index) {
-                const auto& tev_stage = tev_stages[tev_stage_index];
-                using Source = Regs::TevStageConfig::Source;
-                using ColorModifier = Regs::TevStageConfig::ColorModifier;
-                using AlphaModifier = Regs::TevStageConfig::AlphaModifier;
-                using Operation = Regs::TevStageConfig::Operation;
-
-                auto GetSource = [&](Source source) -> Math::Vec4<u8> {
-                    switch (source) {
-                    case Source::PrimaryColor:
-
-                    // HACK: Until we implement fragment lighting, use primary_color
-                    case Source::PrimaryFragmentColor:
-                        return primary_color;
-
-                    // HACK: Until we implement fragment lighting, use zero
-                    case Source::SecondaryFragmentColor:
-                        return {0, 0, 0, 0};
-
-                    case Source::Texture0:
-                        return texture_color[0];
-
-                    case Source::Texture1:
-                        return texture_color[1];
-
-                    case Source::Texture2:
-                        return texture_color[2];
-
-                    case Source::PreviousBuffer:
-                        return combiner_buffer;
-
-                    case Source::Constant:
-                        return {tev_stage.const_r, tev_stage.const_g, tev_stage.const_b,
-                                tev_stage.const_a};
-
-                    case Source::Previous:
-                        return combiner_output;
-
-                    default:
-                        LOG_ERROR(HW_GPU, "Unknown color combiner source %d", (int)source);
-                        UNIMPLEMENTED();
-                        return {0, 0, 0, 0};
-                    }
-                };
-
-                static auto GetColorModifier = [](ColorModifier factor,
-                                                  const Math::Vec4<u8>& values) -> Math::Vec3<u8> {
-                    switch (factor) {
-                    case ColorModifier::SourceColor:
-                        return values.rgb();
-
-                    case ColorModifier::OneMinusSourceColor:
-                        return (Math::Vec3<u8>(255, 255, 255) - values.rgb()).Cast<u8>();
-
-                    case ColorModifier::SourceAlpha:
-                        return values.aaa();
-
-                    case ColorModifier::OneMinusSourceAlpha:
-                        return (Math::Vec3<u8>(255, 255, 255) - values.aaa()).Cast<u8>();
-
-                    case ColorModifier::SourceRed:
-                        return values.rrr();
-
-                    case ColorModifier::OneMinusSourceRed:
-                        return (Math::Vec3<u8>(255, 255, 255) - values.rrr()).Cast<u8>();
-
-                    case ColorModifier::SourceGreen:
-                        return values.ggg();
-
-                    case ColorModifier::OneMinusSourceGreen:
-                        return (Math::Vec3<u8>(255, 255, 255) - values.ggg()).Cast<u8>();
-
-                    case ColorModifier::SourceBlue:
-                        return values.bbb();
-
-                    case ColorModifier::OneMinusSourceBlue:
-                        return (Math::Vec3<u8>(255, 255, 255) - values.bbb()).Cast<u8>();
-                    }
-                };
-
-                static auto GetAlphaModifier = [](AlphaModifier factor,
-                                                  const Math::Vec4<u8>& values) -> u8 {
-                    switch (factor) {
-                    case AlphaModifier::SourceAlpha:
-                        return values.a();
-
-                    case AlphaModifier::OneMinusSourceAlpha:
-                        return 255 - values.a();
-
-                    case AlphaModifier::SourceRed:
-                        return values.r();
-
-                    case AlphaModifier::OneMinusSourceRed:
-                        return 255 - values.r();
-
-                    case AlphaModifier::SourceGreen:
-                        return values.g();
-
-                    case AlphaModifier::OneMinusSourceGreen:
-                        return 255 - values.g();
-
-                    case AlphaModifier::SourceBlue:
-                        return values.b();
-
-                    case AlphaModifier::OneMinusSourceBlue:
-                        return 255 - values.b();
-                    }
-                };
-
-                static auto ColorCombine = [](Operation op,
-                                              const Math::Vec3<u8> input[3]) -> Math::Vec3<u8> {
-                    switch (op) {
-                    case Operation::Replace:
-                        return input[0];
-
-                    case Operation::Modulate:
-                        return ((input[0] * input[1]) / 255).Cast<u8>();
-
-                    case Operation::Add: {
-                        auto result = input[0] + input[1];
-                        result.r() = std::min(255, result.r());
-                        result.g() = std::min(255, result.g());
-                        result.b() = std::min(255, result.b());
-                        return result.Cast<u8>();
-                    }
-
-                    case Operation::AddSigned: {
-                        // TODO(bunnei): Verify that the color conversion from (float) 0.5f to
-                        // (byte) 128 is correct
-                        auto result = input[0].Cast<int>() + input[1].Cast<int>() -
-                                      Math::MakeVec<int>(128, 128, 128);
-                        result.r() = MathUtil::Clamp<int>(result.r(), 0, 255);
-                        result.g() = MathUtil::Clamp<int>(result.g(), 0, 255);
-                        result.b() = MathUtil::Clamp<int>(result.b(), 0, 255);
-                        return result.Cast<u8>();
-                    }
-
-                    case Operation::Lerp:
-                        return ((input[0] * input[2] +
-                                 input[1] *
-                                     (Math::MakeVec<u8>(255, 255, 255) - input[2]).Cast<u8>()) /
-                                255)
-                            .Cast<u8>();
-
-                    case Operation::Subtract: {
-                        auto result = input[0].Cast<int>() - input[1].Cast<int>();
-                        result.r() = std::max(0, result.r());
-                        result.g() = std::max(0, result.g());
-                        result.b() = std::max(0, result.b());
-                        return result.Cast<u8>();
-                    }
-
-                    case Operation::MultiplyThenAdd: {
-                        auto result = (input[0] * input[1] + 255 * input[2].Cast<int>()) / 255;
-                        result.r() = std::min(255, result.r());
-                        result.g() = std::min(255, result.g());
-                        result.b() = std::min(255, result.b());
-                        return result.Cast<u8>();
-                    }
-
-                    case Operation::AddThenMultiply: {
-                        auto result = input[0] + input[1];
-                        result.r() = std::min(255, result.r());
-                        result.g() = std::min(255, result.g());
-                        result.b() = std::min(255, result.b());
-                        result = (result * input[2].Cast<int>()) / 255;
-                        return result.Cast<u8>();
-                    }
-                    case Operation::Dot3_RGB: {
-                        // Not fully accurate.
-                        // Worst case scenario seems to yield a +/-3 error
-                        // Some HW results indicate that the per-component computation can't have a
-                        // higher precision than 1/256,
-                        // while dot3_rgb( (0x80,g0,b0),(0x7F,g1,b1) ) and dot3_rgb(
-                        // (0x80,g0,b0),(0x80,g1,b1) ) give different results
-                        int result =
-                            ((input[0].r() * 2 - 255) * (input[1].r() * 2 - 255) + 128) / 256 +
-                            ((input[0].g() * 2 - 255) * (input[1].g() * 2 - 255) + 128) / 256 +
-                            ((input[0].b() * 2 - 255) * (input[1].b() * 2 - 255) + 128) / 256;
-                        result = std::max(0, std::min(255, result));
-                        return {(u8)result, (u8)result, (u8)result};
-                    }
-                    default:
-                        LOG_ERROR(HW_GPU, "Unknown color combiner operation %d", (int)op);
-                        UNIMPLEMENTED();
-                        return {0, 0, 0};
-                    }
-                };
-
-                static auto AlphaCombine = [](Operation op, const std::array<u8, 3>& input) -> u8 {
-                    switch (op) {
-                    case Operation::Replace:
-                        return input[0];
-
-                    case Operation::Modulate:
-                        return input[0] * input[1] / 255;
-
-                    case Operation::Add:
-                        return std::min(255, input[0] + input[1]);
-
-                    case Operation::AddSigned: {
-                        // TODO(bunnei): Verify that the color conversion from (float) 0.5f to
-                        // (byte) 128 is correct
-                        auto result = static_cast<int>(input[0]) + static_cast<int>(input[1]) - 128;
-                        return static_cast<u8>(MathUtil::Clamp<int>(result, 0, 255));
-                    }
-
-                    case Operation::Lerp:
-                        return (input[0] * input[2] + input[1] * (255 - input[2])) / 255;
-
-                    case Operation::Subtract:
-                        return std::max(0, (int)input[0] - (int)input[1]);
-
-                    case Operation::MultiplyThenAdd:
-                        return std::min(255, (input[0] * input[1] + 255 * input[2]) / 255);
-
-                    case Operation::AddThenMultiply:
-                        return (std::min(255, (input[0] + input[1])) * input[2]) / 255;
-
-                    default:
-                        LOG_ERROR(HW_GPU, "Unknown alpha combiner operation %d", (int)op);
-                        UNIMPLEMENTED();
-                        return 0;
-                    }
-                };
-
-                // color combiner
-                // NOTE: Not sure if the alpha combiner might use the color output of the previous
-                //       stage as input. Hence, we currently don't directly write the result to
-                //       combiner_output.rgb(), but instead store it in a temporary variable until
-                //       alpha combining has been done.
-                Math::Vec3<u8> color_result[3] = {
-                    GetColorModifier(tev_stage.color_modifier1, GetSource(tev_stage.color_source1)),
-                    GetColorModifier(tev_stage.color_modifier2, GetSource(tev_stage.color_source2)),
-                    GetColorModifier(tev_stage.color_modifier3, GetSource(tev_stage.color_source3)),
-                };
-                auto color_output = ColorCombine(tev_stage.color_op, color_result);
-
-                // alpha combiner
-                std::array<u8, 3> alpha_result = {{
-                    GetAlphaModifier(tev_stage.alpha_modifier1, GetSource(tev_stage.alpha_source1)),
-                    GetAlphaModifier(tev_stage.alpha_modifier2, GetSource(tev_stage.alpha_source2)),
-                    GetAlphaModifier(tev_stage.alpha_modifier3, GetSource(tev_stage.alpha_source3)),
-                }};
-                auto alpha_output = AlphaCombine(tev_stage.alpha_op, alpha_result);
-
-                combiner_output[0] =
-                    std::min((unsigned)255, color_output.r() * tev_stage.GetColorMultiplier());
-                combiner_output[1] =
-                    std::min((unsigned)255, color_output.g() * tev_stage.GetColorMultiplier());
-                combiner_output[2] =
-                    std::min((unsigned)255, color_output.b() * tev_stage.GetColorMultiplier());
-                combiner_output[3] =
-                    std::min((unsigned)255, alpha_output * tev_stage.GetAlphaMultiplier());
-
-                combiner_buffer = next_combiner_buffer;
-
-                if (regs.tev_combiner_buffer_input.TevStageUpdatesCombinerBufferColor(
-                        tev_stage_index)) {
-                    next_combiner_buffer.r() = combiner_output.r();
-                    next_combiner_buffer.g() = combiner_output.g();
-                    next_combiner_buffer.b() = combiner_output.b();
-                }
-
-                if (regs.tev_combiner_buffer_input.TevStageUpdatesCombinerBufferAlpha(
-                        tev_stage_index)) {
-                    next_combiner_buffer.a() = combiner_output.a();
-                }
-            }
+            PixelPipeline::TevInputs tev_inputs;
+            tev_inputs[PixelPipeline::PrimaryColor] = primary_color;
+            tev_inputs[PixelPipeline::Texture0] = texture_color[0];
+            tev_inputs[PixelPipeline::Texture1] = texture_color[1];
+            tev_inputs[PixelPipeline::Texture2] = texture_color[2];
+            Math::Vec4<u8> combiner_output =
+                pipeline.CombineTextures(tev_inputs, tev_const_colors, tev_buffer_color);
 
             const auto& output_merger = regs.output_merger;
             // TODO: Does alpha testing happen before or after stencil?
-            if (output_merger.alpha_test.enable) {
-                bool pass = false;
-
-                switch (output_merger.alpha_test.func) {
-                case Regs::CompareFunc::Never:
-                    pass = false;
-                    break;
-
-                case Regs::CompareFunc::Always:
-                    pass = true;
-                    break;
-
-                case Regs::CompareFunc::Equal:
-                    pass = combiner_output.a() == output_merger.alpha_test.ref;
-                    break;
-
-                case Regs::CompareFunc::NotEqual:
-                    pass = combiner_output.a() != output_merger.alpha_test.ref;
-                    break;
-
-                case Regs::CompareFunc::LessThan:
-                    pass = combiner_output.a() < output_merger.alpha_test.ref;
-                    break;
-
-                case Regs::CompareFunc::LessThanOrEqual:
-                    pass = combiner_output.a() <= output_merger.alpha_test.ref;
-                    break;
-
-                case Regs::CompareFunc::GreaterThan:
-                    pass = combiner_output.a() > output_merger.alpha_test.ref;
-                    break;
-
-                case Regs::CompareFunc::GreaterThanOrEqual:
-                    pass = combiner_output.a() >= output_merger.alpha_test.ref;
-                    break;
-                }
-
-                if (!pass)
-                    continue;
+            if (pipeline.alpha_test != nullptr &&
+                !pipeline.alpha_test(combiner_output.a(), output_merger.alpha_test.ref)) {
+                continue;
             }
 
             // Apply fog combiner
             // Not fully accurate. We'd have to know what data type is used to
             // store the depth etc. Using float for now until we know more
             // about Pica datatypes
-            if (regs.fog_mode == Regs::FogMode::Fog) {
+            if (pipeline.fog_enable) {
                 const Math::Vec3<u8> fog_color = {
                     static_cast<u8>(regs.fog_color.r.Value()),
                     static_cast<u8>(regs.fog_color.g.Value()),
@@ -930,7 +823,7 @@ static void ProcessTriangleInternal(const Shader::OutputVertex& v0, const Shader
 
                 // Get index into fog LUT
                 float fog_index;
-                if (g_state.regs.fog_flip) {
+                if (pipeline.fog_flip) {
                     fog_index = (1.0f - depth) * 128.0f;
                 } else {
                     fog_index = depth * 128.0f;
@@ -953,314 +846,70 @@ static void ProcessTriangleInternal(const Shader::OutputVertex& v0, const Shader
 
             u8 old_stencil = 0;
 
-            auto UpdateStencil = [stencil_test, x, y,
-                                  &old_stencil](Pica::Regs::StencilAction action) {
-                u8 new_stencil =
-                    PerformStencilAction(action, old_stencil, stencil_test.reference_value);
-                if (g_state.regs.framebuffer.allow_depth_stencil_write != 0)
+            auto UpdateStencil = [&pipeline, stencil_test, x, y,
+                                  &old_stencil](PixelPipeline::StencilActionFunction action) {
+                u8 new_stencil = action(old_stencil, stencil_test.reference_value);
+                if (pipeline.stencil_write_enable)
                     SetStencil(x >> 4, y >> 4, (new_stencil & stencil_test.write_mask) |
                                                    (old_stencil & ~stencil_test.write_mask));
             };
 
-            if (stencil_action_enable) {
+            if (pipeline.stencil_action_enable) {
                 old_stencil = GetStencil(x >> 4, y >> 4);
                 u8 dest = old_stencil & stencil_test.input_mask;
                 u8 ref = stencil_test.reference_value & stencil_test.input_mask;
 
-                bool pass = false;
-                switch (stencil_test.func) {
-                case Regs::CompareFunc::Never:
-                    pass = false;
-                    break;
-
-                case Regs::CompareFunc::Always:
-                    pass = true;
-                    break;
-
-                case Regs::CompareFunc::Equal:
-                    pass = (ref == dest);
-                    break;
-
-                case Regs::CompareFunc::NotEqual:
-                    pass = (ref != dest);
-                    break;
-
-                case Regs::CompareFunc::LessThan:
-                    pass = (ref < dest);
-                    break;
-
-                case Regs::CompareFunc::LessThanOrEqual:
-                    pass = (ref <= dest);
-                    break;
-
-                case Regs::CompareFunc::GreaterThan:
-                    pass = (ref > dest);
-                    break;
-
-                case Regs::CompareFunc::GreaterThanOrEqual:
-                    pass = (ref >= dest);
-                    break;
-                }
-
-                if (!pass) {
-                    UpdateStencil(stencil_test.action_stencil_fail);
+                if (!pipeline.stencil_test(ref, dest)) {
+                    UpdateStencil(pipeline.stencil_fail_action);
                     continue;
                 }
             }
 
             // Convert float to integer
-            unsigned num_bits = Regs::DepthBitsPerPixel(regs.framebuffer.depth_format);
-            u32 z = (u32)(depth * ((1 << num_bits) - 1));
+            u32 z = (u32)(depth * pipeline.depth_max);
 
-            if (output_merger.depth_test_enable) {
+            if (pipeline.depth_test != nullptr && !early_depth_test) {
                 u32 ref_z = GetDepth(x >> 4, y >> 4);
 
-                bool pass = false;
-
-                switch (output_merger.depth_test_func) {
-                case Regs::CompareFunc::Never:
-                    pass = false;
-                    break;
-
-                case Regs::CompareFunc::Always:
-                    pass = true;
-                    break;
-
-                case Regs::CompareFunc::Equal:
-                    pass = z == ref_z;
-                    break;
-
-                case Regs::CompareFunc::NotEqual:
-                    pass = z != ref_z;
-                    break;
-
-                case Regs::CompareFunc::LessThan:
-                    pass = z < ref_z;
-                    break;
-
-                case Regs::CompareFunc::LessThanOrEqual:
-                    pass = z <= ref_z;
-                    break;
-
-                case Regs::CompareFunc::GreaterThan:
-                    pass = z > ref_z;
-                    break;
-
-                case Regs::CompareFunc::GreaterThanOrEqual:
-                    pass = z >= ref_z;
-                    break;
-                }
-
-                if (!pass) {
-                    if (stencil_action_enable)
-                        UpdateStencil(stencil_test.action_depth_fail);
+                if (!pipeline.depth_test(z, ref_z)) {
+                    if (pipeline.stencil_action_enable)
+                        UpdateStencil(pipeline.depth_fail_action);
                     continue;
                 }
             }
 
-            if (regs.framebuffer.allow_depth_stencil_write != 0 && output_merger.depth_write_enable)
+            if (pipeline.depth_write_enable)
                 SetDepth(x >> 4, y >> 4, z);
 
             // The stencil depth_pass action is executed even if depth testing is disabled
-            if (stencil_action_enable)
-                UpdateStencil(stencil_test.action_depth_pass);
+            if (pipeline.stencil_action_enable)
+                UpdateStencil(pipeline.depth_pass_action);
 
             auto dest = GetPixel(x >> 4, y >> 4);
             Math::Vec4<u8> blend_output = combiner_output;
 
-            if (output_merger.alphablend_enable) {
-                auto params = output_merger.alpha_blending;
-
-                auto LookupFactor = [&](unsigned channel, Regs::BlendFactor factor) -> u8 {
-                    DEBUG_ASSERT(channel < 4);
-
-                    const Math::Vec4<u8> blend_const = {
-                        static_cast<u8>(output_merger.blend_const.r),
-                        static_cast<u8>(output_merger.blend_const.g),
-                        static_cast<u8>(output_merger.blend_const.b),
-                        static_cast<u8>(output_merger.blend_const.a),
-                    };
-
-                    switch (factor) {
-                    case Regs::BlendFactor::Zero:
-                        return 0;
-
-                    case Regs::BlendFactor::One:
-                        return 255;
-
-                    case Regs::BlendFactor::SourceColor:
-                        return combiner_output[channel];
-
-                    case Regs::BlendFactor::OneMinusSourceColor:
-                        return 255 - combiner_output[channel];
-
-                    case Regs::BlendFactor::DestColor:
-                        return dest[channel];
-
-                    case Regs::BlendFactor::OneMinusDestColor:
-                        return 255 - dest[channel];
-
-                    case Regs::BlendFactor::SourceAlpha:
-                        return combiner_output.a();
-
-                    case Regs::BlendFactor::OneMinusSourceAlpha:
-                        return 255 - combiner_output.a();
-
-                    case Regs::BlendFactor::DestAlpha:
-                        return dest.a();
+            if (pipeline.alphablend_enable) {
+                auto srcfactor = Math::MakeVec(
+                    pipeline.factor_source_rgb(0, combiner_output, dest, blend_const),
+                    pipeline.factor_source_rgb(1, combiner_output, dest, blend_const),
+                    pipeline.factor_source_rgb(2, combiner_output, dest, blend_const),
+                    pipeline.factor_source_a(3, combiner_output, dest, blend_const));
 
-                    case Regs::BlendFactor::OneMinusDestAlpha:
-                        return 255 - dest.a();
-
-                    case Regs::BlendFactor::ConstantColor:
-                        return blend_const[channel];
-
-                    case Regs::BlendFactor::OneMinusConstantColor:
-                        return 255 - blend_const[channel];
-
-                    case Regs::BlendFactor::ConstantAlpha:
-                        return blend_const.a();
-
-                    case Regs::BlendFactor::OneMinusConstantAlpha:
-                        return 255 - blend_const.a();
-
-                    case Regs::BlendFactor::SourceAlphaSaturate:
-                        // Returns 1.0 for the alpha channel
-                        if (channel == 3)
-                            return 255;
-                        return std::min(combiner_output.a(), static_cast<u8>(255 - dest.a()));
-
-                    default:
-                        LOG_CRITICAL(HW_GPU, "Unknown blend factor %x", factor);
-                        UNIMPLEMENTED();
-                        break;
-                    }
-
-                    return combiner_output[channel];
-                };
-
-                static auto EvaluateBlendEquation = [](
-                    const Math::Vec4<u8>& src, const Math::Vec4<u8>& srcfactor,
-                    const Math::Vec4<u8>& dest, const Math::Vec4<u8>& destfactor,
-                    Regs::BlendEquation equation) {
-                    Math::Vec4<int> result;
-
-                    auto src_result = (src * srcfactor).Cast<int>();
-                    auto dst_result = (dest * destfactor).Cast<int>();
-
-                    switch (equation) {
-                    case Regs::BlendEquation::Add:
-                        result = (src_result + dst_result) / 255;
-                        break;
-
-                    case Regs::BlendEquation::Subtract:
-                        result = (src_result - dst_result) / 255;
-                        break;
-
-                    case Regs::BlendEquation::ReverseSubtract:
-                        result = (dst_result - src_result) / 255;
-                        break;
-
-                    // TODO: How do these two actually work?
-                    //       OpenGL doesn't include the blend factors in the min/max computations,
-                    //       but is this what the 3DS actually does?
-                    case Regs::BlendEquation::Min:
-                        result.r() = std::min(src.r(), dest.r());
-                        result.g() = std::min(src.g(), dest.g());
-                        result.b() = std::min(src.b(), dest.b());
-                        result.a() = std::min(src.a(), dest.a());
-                        break;
-
-                    case Regs::BlendEquation::Max:
-                        result.r() = std::max(src.r(), dest.r());
-                        result.g() = std::max(src.g(), dest.g());
-                        result.b() = std::max(src.b(), dest.b());
-                        result.a() = std::max(src.a(), dest.a());
-                        break;
-
-                    default:
-                        LOG_CRITICAL(HW_GPU, "Unknown RGB blend equation %x", equation);
-                        UNIMPLEMENTED();
-                    }
-
-                    return Math::Vec4<u8>(
-                        MathUtil::Clamp(result.r(), 0, 255), MathUtil::Clamp(result.g(), 0, 255),
-                        MathUtil::Clamp(result.b(), 0, 255), MathUtil::Clamp(result.a(), 0, 255));
-                };
-
-                auto srcfactor = Math::MakeVec(LookupFactor(0, params.factor_source_rgb),
-                                               LookupFactor(1, params.factor_source_rgb),
-                                               LookupFactor(2, params.factor_source_rgb),
-                                               LookupFactor(3, params.factor_source_a));
-
-                auto dstfactor = Math::MakeVec(LookupFactor(0, params.factor_dest_rgb),
-                                               LookupFactor(1, params.factor_dest_rgb),
-                                               LookupFactor(2, params.factor_dest_rgb),
-                                               LookupFactor(3, params.factor_dest_a));
-
-                blend_output = EvaluateBlendEquation(combiner_output, srcfactor, dest, dstfactor,
-                                                     params.blend_equation_rgb);
-                blend_output.a() = EvaluateBlendEquation(combiner_output, srcfactor, dest,
-                                                         dstfactor, params.blend_equation_a)
-                                       .a();
-            } else {
-                static auto LogicOp = [](u8 src, u8 dest, Regs::LogicOp op) -> u8 {
-                    switch (op) {
-                    case Regs::LogicOp::Clear:
-                        return 0;
-
-                    case Regs::LogicOp::And:
-                        return src & dest;
-
-                    case Regs::LogicOp::AndReverse:
-                        return src & ~dest;
-
-                    case Regs::LogicOp::Copy:
-                        return src;
-
-                    case Regs::LogicOp::Set:
-                        return 255;
-
-                    case Regs::LogicOp::CopyInverted:
-                        return ~src;
-
-                    case Regs::LogicOp::NoOp:
-                        return dest;
-
-                    case Regs::LogicOp::Invert:
-                        return ~dest;
-
-                    case Regs::LogicOp::Nand:
-                        return ~(src & dest);
-
-                    case Regs::LogicOp::Or:
-                        return src | dest;
-
-                    case Regs::LogicOp::Nor:
-                        return ~(src | dest);
-
-                    case Regs::LogicOp::Xor:
-                        return src ^ dest;
-
-                    case Regs::LogicOp::Equiv:
-                        return ~(src ^ dest);
-
-                    case Regs::LogicOp::AndInverted:
-                        return ~src & dest;
-
-                    case Regs::LogicOp::OrReverse:
-                        return src | ~dest;
-
-                    case Regs::LogicOp::OrInverted:
-                        return ~src | dest;
-                    }
-                };
+                auto dstfactor = Math::MakeVec(
+                    pipeline.factor_dest_rgb(0, combiner_output, dest, blend_const),
+                    pipeline.factor_dest_rgb(1, combiner_output, dest, blend_const),
+                    pipeline.factor_dest_rgb(2, combiner_output, dest, blend_const),
+                    pipeline.factor_dest_a(3, combiner_output, dest, blend_const));
 
                 blend_output =
-                    Math::MakeVec(LogicOp(combiner_output.r(), dest.r(), output_merger.logic_op),
-                                  LogicOp(combiner_output.g(), dest.g(), output_merger.logic_op),
-                                  LogicOp(combiner_output.b(), dest.b(), output_merger.logic_op),
-                                  LogicOp(combiner_output.a(), dest.a(), output_merger.logic_op));
+                    pipeline.blend_equation_rgb(combiner_output, srcfactor, dest, dstfactor);
+                blend_output.a() =
+                    pipeline.blend_equation_a(combiner_output, srcfactor, dest, dstfactor).a();
+            } else {
+                blend_output = Math::MakeVec(pipeline.logic_op(combiner_output.r(), dest.r()),
+                                             pipeline.logic_op(combiner_output.g(), dest.g()),
+                                             pipeline.logic_op(combiner_output.b(), dest.b()),
+                                             pipeline.logic_op(combiner_output.a(), dest.a()));
             }
 
             const Math::Vec4<u8> result = {
@@ -1277,8 +926,27 @@ static void ProcessTriangleInternal(const Shader::OutputVertex& v0, const Shader
 }
 
 void ProcessTriangle(const Shader::OutputVertex& v0, const Shader::OutputVertex& v1,
-                     const Shader::OutputVertex& v2) {
-    ProcessTriangleInternal(v0, v1, v2);
+                     const Shader::OutputVertex& v2, const PixelPipeline& pipeline,
+                     const TextureUnits& texture_units,
+                     const MathUtil::Rectangle<unsigned>& region) {
+    ProcessTriangleInternal(v0, v1, v2, pipeline, texture_units, region);
+}
+
+MathUtil::Rectangle<unsigned> GetTriangleBounds(const Shader::OutputVertex& v0,
+                                                const Shader::OutputVertex& v1,
+                                                const Shader::OutputVertex& v2) {
+    Math::Vec3<Fix12P4> vtxpos[3]{ScreenToRasterizerCoordinates(v0.screenpos),
+                                  ScreenToRasterizerCoordinates(v1.screenpos),
+                                  ScreenToRasterizerCoordinates(v2.screenpos)};
+
+    u16 min_x = std::min({vtxpos[0].x, vtxpos[1].x, vtxpos[2].x});
+    u16 min_y = std::min({vtxpos[0].y, vtxpos[1].y, vtxpos[2].y});
+    u16 max_x = std::max({vtxpos[0].x, vtxpos[1].x, vtxpos[2].x});
+    u16 max_y = std::max({vtxpos[0].y, vtxpos[1].y, vtxpos[2].y});
+
+    return {static_cast<unsigned>(min_x >> 4), static_cast<unsigned>(min_y >> 4),
+            (static_cast<unsigned>(max_x) + Fix12P4::FracMask()) >> 4,
+            (static_cast<unsigned>(max_y) + Fix12P4::FracMask()) >> 4};
 }
 
 } // namespace Rasterizer
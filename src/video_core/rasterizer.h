@@ -4,16 +4,47 @@
 
 #pragma once
 
+#include <array>
+#include "common/math_util.h"
+
 namespace Pica {
 
 namespace Shader {
 struct OutputVertex;
 }
 
+namespace Texture {
+struct DecodedTexture;
+}
+
 namespace Rasterizer {
 
+class PixelPipeline;
+
+/// Decoded textures bound to the three texture units, nullptr for disabled units
+using TextureUnits = std::array<const Texture::DecodedTexture*, 3>;
+
+/**
+ * Rasterizes the given triangle with the current register configuration, but only touches pixels
+ * within the given region. SWRasterizer keeps the pipeline and the decoded textures around between
+ * draws.
+ * @param pipeline Pixel pipeline built for the current register configuration
+ * @param texture_units Textures bound in the current register configuration
+ * @param region Half-open pixel range in rasterizer coordinates (i.e. before the vertical flip
+ *               applied when addressing the framebuffer)
+ */
 void ProcessTriangle(const Shader::OutputVertex& v0, const Shader::OutputVertex& v1,
-                     const Shader::OutputVertex& v2);
+                     const Shader::OutputVertex& v2, const PixelPipeline& pipeline,
+                     const TextureUnits& texture_units,
+                     const MathUtil::Rectangle<unsigned>& region);
+
+/**
+ * Returns a conservative, half-open pixel range in rasterizer coordinates that contains every
+ * pixel the given triangle may cover.
+ */
+MathUtil::Rectangle<unsigned> GetTriangleBounds(const Shader::OutputVertex& v0,
+                                                const Shader::OutputVertex& v1,
+                                                const Shader::OutputVertex& v2);
 
 } // namespace Rasterizer
 
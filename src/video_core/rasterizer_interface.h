@@ -63,5 +63,8 @@ public:
                                    ScreenInfo& screen_info) {
         return false;
     }
+
+    /// Load shaders cached on disk for the title with the given program ID
+    virtual void LoadShaderCache(u64 program_id) {}
 };
 }
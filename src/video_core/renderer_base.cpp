@@ -19,5 +19,14 @@ void RendererBase::RefreshRasterizerSetting() {
         } else {
             rasterizer = std::make_unique<VideoCore::SWRasterizer>();
         }
+
+        if (shader_cache_program_id)
+            rasterizer->LoadShaderCache(*shader_cache_program_id);
     }
 }
+
+void RendererBase::LoadShaderCache(u64 program_id) {
+    shader_cache_program_id = program_id;
+    if (rasterizer != nullptr)
+        rasterizer->LoadShaderCache(program_id);
+}
@@ -5,6 +5,7 @@
 #pragma once
 
 #include <memory>
+#include <boost/optional.hpp>
 #include "common/common_types.h"
 #include "video_core/rasterizer_interface.h"
 
@@ -49,6 +50,10 @@ public:
 
     void RefreshRasterizerSetting();
 
+    /// Load shaders cached on disk for the title with the given program ID, also when the
+    /// rasterizer is recreated later
+    void LoadShaderCache(u64 program_id);
+
 protected:
     std::unique_ptr<VideoCore::RasterizerInterface> rasterizer;
     f32 m_current_fps = 0.0f; ///< Current framerate, should be set by the renderer
@@ -56,4 +61,5 @@ protected:
 
 private:
     bool opengl_rasterizer_active = false;
+    boost::optional<u64> shader_cache_program_id;
 };
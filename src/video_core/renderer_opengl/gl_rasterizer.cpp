@@ -2,6 +2,9 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <cinttypes>
+#include <cstddef>
+#include <cstring>
 #include <memory>
 #include <string>
 #include <tuple>
@@ -9,11 +12,15 @@
 #include <glad/glad.h>
 #include "common/assert.h"
 #include "common/color.h"
+#include "common/common_paths.h"
+#include "common/file_util.h"
 #include "common/logging/log.h"
 #include "common/math_util.h"
 #include "common/microprofile.h"
+#include "common/string_util.h"
 #include "common/vector_math.h"
 #include "core/hw/gpu.h"
+#include "core/memory.h"
 #include "video_core/pica.h"
 #include "video_core/pica_state.h"
 #include "video_core/renderer_opengl/gl_rasterizer.h"
@@ -295,10 +302,12 @@ void RasterizerOpenGL::DrawTriangles() {
     // TODO: Restrict invalidation area to the viewport
     if (color_surface != nullptr) {
         color_surface->dirty = true;
+        Memory::RasterizerMarkRegionDirty(color_surface->addr, color_surface->size);
         res_cache.FlushRegion(color_surface->addr, color_surface->size, color_surface, true);
     }
     if (depth_surface != nullptr) {
         depth_surface->dirty = true;
+        Memory::RasterizerMarkRegionDirty(depth_surface->addr, depth_surface->size);
         res_cache.FlushRegion(depth_surface->addr, depth_surface->size, depth_surface, true);
     }
 
@@ -778,6 +787,7 @@ bool RasterizerOpenGL::AccelerateDisplayTransfer(const GPU::Regs::DisplayTransfe
     u32 dst_size = dst_params.width * dst_params.height *
                    CachedSurface::GetFormatBpp(dst_params.pixel_format) / 8;
     dst_surface->dirty = true;
+    Memory::RasterizerMarkRegionDirty(dst_surface->addr, dst_surface->size);
     res_cache.FlushRegion(config.GetPhysicalOutputAddress(), dst_size, dst_surface, true);
     return true;
 }
@@ -927,6 +937,7 @@ bool RasterizerOpenGL::AccelerateFill(const GPU::Regs::MemoryFillConfig& config)
     cur_state.Apply();
 
     dst_surface->dirty = true;
+    Memory::RasterizerMarkRegionDirty(dst_surface->addr, dst_surface->size);
     res_cache.FlushRegion(dst_surface->addr, dst_surface->size, dst_surface, true);
     return true;
 }
@@ -1007,9 +1018,197 @@ void RasterizerOpenGL::SamplerInfo::SyncWithConfig(const Pica::Regs::TextureConf
     }
 }
 
+/**
+ * Identifies the driver and shader generator that produced cached program binaries. Binaries are
+ * only reused if both match.
+ */
+static u64 GetProgramBinaryTag() {
+    std::string tag = Common::StringFromFormat("%u", GLShader::SHADER_GENERATOR_VERSION);
+    for (GLenum name : {GL_VENDOR, GL_RENDERER, GL_VERSION}) {
+        const GLubyte* value = glGetString(name);
+        tag += '\n';
+        if (value != nullptr)
+            tag += reinterpret_cast<const char*>(value);
+    }
+    return Common::ComputeHash64(tag.data(), tag.size());
+}
+
+/// Header of the program binaries stored in the shader disk cache, followed by the binary itself
+struct ProgramBinaryHeader {
+    u64 tag;
+    GLenum format;
+};
+
+class RasterizerOpenGL::ShaderDiskCacheReader
+    : public LinearDiskCacheReader<PicaShaderConfig::State, u8> {
+public:
+    ShaderDiskCacheReader(RasterizerOpenGL& rasterizer, u64 tag)
+        : rasterizer(rasterizer), tag(tag) {}
+
+    void Read(const PicaShaderConfig::State& key, const u8* value, u32 value_size) override {
+        ProgramBinaryHeader header;
+        if (value_size < sizeof(header)) {
+            ++num_rejected;
+            return;
+        }
+        std::memcpy(&header, value, sizeof(header));
+        if (header.tag != tag) {
+            ++num_rejected;
+            return;
+        }
+
+        PicaShaderConfig config;
+        std::memcpy(&config.state, &key, sizeof(PicaShaderConfig::State));
+        if (rasterizer.shader_cache.count(config) != 0)
+            return;
+
+        auto shader = std::make_unique<PicaShader>();
+        if (!shader->shader.CreateFromBinary(header.format, value + sizeof(header),
+                                             static_cast<GLsizei>(value_size - sizeof(header)))) {
+            ++num_rejected;
+            return;
+        }
+
+        rasterizer.InitShader(*shader);
+        rasterizer.shader_cache.emplace(config, std::move(shader));
+        ++num_loaded;
+    }
+
+    u32 num_loaded = 0;
+    u32 num_rejected = 0;
+
+private:
+    RasterizerOpenGL& rasterizer;
+    u64 tag;
+};
+
+void RasterizerOpenGL::LoadShaderCache(u64 program_id) {
+    shader_disk_cache.Close();
+    shader_disk_cache_open = false;
+
+    if (!GLAD_GL_ARB_get_program_binary) {
+        LOG_INFO(Render_OpenGL, "Program binaries not supported, not caching shaders on disk");
+        return;
+    }
+
+    GLint num_binary_formats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &num_binary_formats);
+    if (num_binary_formats == 0) {
+        LOG_INFO(Render_OpenGL,
+                 "Driver has no program binary formats, not caching shaders on disk");
+        return;
+    }
+
+    const std::string dir = FileUtil::GetUserPath(D_CACHE_IDX) + "shaders" DIR_SEP;
+    if (!FileUtil::CreateFullPath(dir)) {
+        LOG_ERROR(Render_OpenGL, "Failed to create shader cache directory %s", dir.c_str());
+        return;
+    }
+    const std::string filename =
+        dir + Common::StringFromFormat("gl_%016" PRIX64 ".bin", program_id);
+
+    // Link all cached programs now, so that they are ready by the time the game uses them
+    program_binary_tag = GetProgramBinaryTag();
+    ShaderDiskCacheReader reader(*this, program_binary_tag);
+    const u32 num_entries = shader_disk_cache.OpenAndRead(filename.c_str(), reader);
+    if (reader.num_rejected != 0) {
+        // Binaries of another driver or shader generator version will never be usable again
+        LOG_INFO(Render_OpenGL, "Discarding %u outdated program binaries", reader.num_rejected);
+        shader_disk_cache.Close();
+        FileUtil::Delete(filename);
+        shader_disk_cache.OpenAndRead(filename.c_str(), reader);
+    }
+    shader_disk_cache_open = true;
+    LOG_INFO(Render_OpenGL, "Loaded %u of %u cached shader programs", reader.num_loaded,
+             num_entries);
+
+    state.draw.shader_program = current_shader != nullptr ? current_shader->shader.handle : 0;
+    state.Apply();
+}
+
+void RasterizerOpenGL::SaveShaderBinary(const PicaShaderConfig& config, const PicaShader& shader) {
+    if (!shader_disk_cache_open)
+        return;
+
+    GLint binary_length = 0;
+    glGetProgramiv(shader.shader.handle, GL_PROGRAM_BINARY_LENGTH, &binary_length);
+    if (binary_length <= 0)
+        return;
+
+    // The fields are copied one by one, so that the header's padding stays zeroed
+    std::vector<u8> data(sizeof(ProgramBinaryHeader) + binary_length);
+    GLenum format;
+    glGetProgramBinary(shader.shader.handle, binary_length, nullptr, &format,
+                       data.data() + sizeof(ProgramBinaryHeader));
+    std::memcpy(data.data() + offsetof(ProgramBinaryHeader, tag), &program_binary_tag,
+                sizeof(program_binary_tag));
+    std::memcpy(data.data() + offsetof(ProgramBinaryHeader, format), &format, sizeof(format));
+
+    // Appended entries are buffered and written out in batches, or when the cache is closed
+    shader_disk_cache.Append(config.state, data.data(), static_cast<u32>(data.size()));
+}
+
+void RasterizerOpenGL::InitShader(const PicaShader& shader) {
+    state.draw.shader_program = shader.shader.handle;
+    state.Apply();
+
+    // Set the texture samplers to correspond to different texture units
+    GLuint uniform_tex = glGetUniformLocation(shader.shader.handle, "tex[0]");
+    if (uniform_tex != -1) {
+        glUniform1i(uniform_tex, 0);
+    }
+    uniform_tex = glGetUniformLocation(shader.shader.handle, "tex[1]");
+    if (uniform_tex != -1) {
+        glUniform1i(uniform_tex, 1);
+    }
+    uniform_tex = glGetUniformLocation(shader.shader.handle, "tex[2]");
+    if (uniform_tex != -1) {
+        glUniform1i(uniform_tex, 2);
+    }
+
+    // Set the texture samplers to correspond to different lookup table texture units
+    GLuint uniform_lut = glGetUniformLocation(shader.shader.handle, "lut[0]");
+    if (uniform_lut != -1) {
+        glUniform1i(uniform_lut, 3);
+    }
+    uniform_lut = glGetUniformLocation(shader.shader.handle, "lut[1]");
+    if (uniform_lut != -1) {
+        glUniform1i(uniform_lut, 4);
+    }
+    uniform_lut = glGetUniformLocation(shader.shader.handle, "lut[2]");
+    if (uniform_lut != -1) {
+        glUniform1i(uniform_lut, 5);
+    }
+    uniform_lut = glGetUniformLocation(shader.shader.handle, "lut[3]");
+    if (uniform_lut != -1) {
+        glUniform1i(uniform_lut, 6);
+    }
+    uniform_lut = glGetUniformLocation(shader.shader.handle, "lut[4]");
+    if (uniform_lut != -1) {
+        glUniform1i(uniform_lut, 7);
+    }
+    uniform_lut = glGetUniformLocation(shader.shader.handle, "lut[5]");
+    if (uniform_lut != -1) {
+        glUniform1i(uniform_lut, 8);
+    }
+
+    GLuint uniform_fog_lut = glGetUniformLocation(shader.shader.handle, "fog_lut");
+    if (uniform_fog_lut != -1) {
+        glUniform1i(uniform_fog_lut, 9);
+    }
+
+    unsigned int block_index = glGetUniformBlockIndex(shader.shader.handle, "shader_data");
+    GLint block_size;
+    glGetActiveUniformBlockiv(shader.shader.handle, block_index, GL_UNIFORM_BLOCK_DATA_SIZE,
+                              &block_size);
+    ASSERT_MSG(block_size == sizeof(UniformData),
+               "Uniform block size did not match! Got %d, expected %zu",
+               static_cast<int>(block_size), sizeof(UniformData));
+    glUniformBlockBinding(shader.shader.handle, block_index, 0);
+}
+
 void RasterizerOpenGL::SetShader() {
     PicaShaderConfig config = PicaShaderConfig::CurrentConfig();
-    std::unique_ptr<PicaShader> shader = std::make_unique<PicaShader>();
 
     // Find (or generate) the GLSL shader for the current TEV state
     auto cached_shader = shader_cache.find(config);
@@ -1021,69 +1220,14 @@ void RasterizerOpenGL::SetShader() {
     } else {
         LOG_DEBUG(Render_OpenGL, "Creating new shader");
 
+        std::unique_ptr<PicaShader> shader = std::make_unique<PicaShader>();
         shader->shader.Create(GLShader::GenerateVertexShader().c_str(),
                               GLShader::GenerateFragmentShader(config).c_str());
 
-        state.draw.shader_program = shader->shader.handle;
-        state.Apply();
-
-        // Set the texture samplers to correspond to different texture units
-        GLuint uniform_tex = glGetUniformLocation(shader->shader.handle, "tex[0]");
-        if (uniform_tex != -1) {
-            glUniform1i(uniform_tex, 0);
-        }
-        uniform_tex = glGetUniformLocation(shader->shader.handle, "tex[1]");
-        if (uniform_tex != -1) {
-            glUniform1i(uniform_tex, 1);
-        }
-        uniform_tex = glGetUniformLocation(shader->shader.handle, "tex[2]");
-        if (uniform_tex != -1) {
-            glUniform1i(uniform_tex, 2);
-        }
-
-        // Set the texture samplers to correspond to different lookup table texture units
-        GLuint uniform_lut = glGetUniformLocation(shader->shader.handle, "lut[0]");
-        if (uniform_lut != -1) {
-            glUniform1i(uniform_lut, 3);
-        }
-        uniform_lut = glGetUniformLocation(shader->shader.handle, "lut[1]");
-        if (uniform_lut != -1) {
-            glUniform1i(uniform_lut, 4);
-        }
-        uniform_lut = glGetUniformLocation(shader->shader.handle, "lut[2]");
-        if (uniform_lut != -1) {
-            glUniform1i(uniform_lut, 5);
-        }
-        uniform_lut = glGetUniformLocation(shader->shader.handle, "lut[3]");
-        if (uniform_lut != -1) {
-            glUniform1i(uniform_lut, 6);
-        }
-        uniform_lut = glGetUniformLocation(shader->shader.handle, "lut[4]");
-        if (uniform_lut != -1) {
-            glUniform1i(uniform_lut, 7);
-        }
-        uniform_lut = glGetUniformLocation(shader->shader.handle, "lut[5]");
-        if (uniform_lut != -1) {
-            glUniform1i(uniform_lut, 8);
-        }
-
-        GLuint uniform_fog_lut = glGetUniformLocation(shader->shader.handle, "fog_lut");
-        if (uniform_fog_lut != -1) {
-            glUniform1i(uniform_fog_lut, 9);
-        }
-
+        SaveShaderBinary(config, *shader);
+        InitShader(*shader);
         current_shader = shader_cache.emplace(config, std::move(shader)).first->second.get();
 
-        unsigned int block_index =
-            glGetUniformBlockIndex(current_shader->shader.handle, "shader_data");
-        GLint block_size;
-        glGetActiveUniformBlockiv(current_shader->shader.handle, block_index,
-                                  GL_UNIFORM_BLOCK_DATA_SIZE, &block_size);
-        ASSERT_MSG(block_size == sizeof(UniformData),
-                   "Uniform block size did not match! Got %d, expected %zu",
-                   static_cast<int>(block_size), sizeof(UniformData));
-        glUniformBlockBinding(current_shader->shader.handle, block_index, 0);
-
         // Update uniforms
         SyncDepthScale();
         SyncDepthOffset();
@@ -13,7 +13,9 @@
 #include <glad/glad.h>
 #include "common/bit_field.h"
 #include "common/common_types.h"
+#include "common/file_util.h"
 #include "common/hash.h"
+#include "common/linear_disk_cache.h"
 #include "common/vector_math.h"
 #include "core/hw/gpu.h"
 #include "video_core/pica.h"
@@ -242,6 +244,7 @@ public:
     bool AccelerateFill(const GPU::Regs::MemoryFillConfig& config) override;
     bool AccelerateDisplay(const GPU::Regs::FramebufferConfig& config, PAddr framebuffer_addr,
                            u32 pixel_stride, ScreenInfo& screen_info) override;
+    void LoadShaderCache(u64 program_id) override;
 
     /// OpenGL shader generated for a given Pica register state
     struct PicaShader {
@@ -351,6 +354,12 @@ private:
     /// Sets the OpenGL shader in accordance with the current PICA register state
     void SetShader();
 
+    /// Binds the texture units and the uniform block of a newly created shader program
+    void InitShader(const PicaShader& shader);
+
+    /// Stores the program binary of a newly created shader in the disk cache, if it's open
+    void SaveShaderBinary(const PicaShaderConfig& config, const PicaShader& shader);
+
     /// Syncs the cull mode to match the PICA register
     void SyncCullMode();
 
@@ -437,6 +446,13 @@ private:
     const PicaShader* current_shader = nullptr;
     bool shader_dirty;
 
+    /// Program binaries of the running title, persisted across runs
+    class ShaderDiskCacheReader;
+    LinearDiskCache<PicaShaderConfig::State, u8> shader_disk_cache;
+    bool shader_disk_cache_open = false;
+    /// Identifies the driver and shader generator version, computed when the cache is opened
+    u64 program_binary_tag = 0;
+
     struct {
         UniformData data;
         bool lut_dirty[6];
@@ -18,10 +18,11 @@
 #include "core/frontend/emu_window.h"
 #include "core/memory.h"
 #include "video_core/debug_utils/debug_utils.h"
+#include "video_core/morton.h"
 #include "video_core/pica_state.h"
 #include "video_core/renderer_opengl/gl_rasterizer_cache.h"
 #include "video_core/renderer_opengl/gl_state.h"
-#include "video_core/utils.h"
+#include "video_core/texture/texture_decoder.h"
 #include "video_core/video_core.h"
 
 struct FormatTuple {
@@ -59,47 +60,23 @@ static void MortonCopyPixels(CachedSurface::PixelFormat pixel_format, u32 width,
                              u8* gl_data, bool morton_to_gl) {
     using PixelFormat = CachedSurface::PixelFormat;
 
-    u8* data_ptrs[2];
-    u32 depth_stencil_shifts[2] = {24, 8};
+    if (width == 0 || height == 0)
+        return;
 
-    if (morton_to_gl) {
-        std::swap(depth_stencil_shifts[0], depth_stencil_shifts[1]);
-    }
+    // OpenGL images are stored bottom-up
+    const ptrdiff_t gl_stride = static_cast<ptrdiff_t>(width * gl_bytes_per_pixel);
+    u8* gl_top_line = gl_data + (height - 1) * gl_stride;
 
     if (pixel_format == PixelFormat::D24S8) {
-        for (unsigned y = 0; y < height; ++y) {
-            for (unsigned x = 0; x < width; ++x) {
-                const u32 coarse_y = y & ~7;
-                u32 morton_offset = VideoCore::GetMortonOffset(x, y, bytes_per_pixel) +
-                                    coarse_y * width * bytes_per_pixel;
-                u32 gl_pixel_index = (x + (height - 1 - y) * width) * gl_bytes_per_pixel;
-
-                data_ptrs[morton_to_gl] = morton_data + morton_offset;
-                data_ptrs[!morton_to_gl] = &gl_data[gl_pixel_index];
-
-                // Swap depth and stencil value ordering since 3DS does not match OpenGL
-                u32 depth_stencil;
-                memcpy(&depth_stencil, data_ptrs[1], sizeof(u32));
-                depth_stencil = (depth_stencil << depth_stencil_shifts[0]) |
-                                (depth_stencil >> depth_stencil_shifts[1]);
-
-                memcpy(data_ptrs[0], &depth_stencil, sizeof(u32));
-            }
-        }
+        // Swap depth and stencil value ordering since 3DS does not match OpenGL
+        VideoCore::MortonCopyD24S8(width, height, morton_data, gl_top_line, -gl_stride,
+                                   morton_to_gl);
+    } else if (pixel_format == PixelFormat::D24) {
+        VideoCore::MortonCopyD24(width, height, morton_data, gl_top_line, -gl_stride,
+                                 morton_to_gl);
     } else {
-        for (unsigned y = 0; y < height; ++y) {
-            for (unsigned x = 0; x < width; ++x) {
-                const u32 coarse_y = y & ~7;
-                u32 morton_offset = VideoCore::GetMortonOffset(x, y, bytes_per_pixel) +
-                                    coarse_y * width * bytes_per_pixel;
-                u32 gl_pixel_index = (x + (height - 1 - y) * width) * gl_bytes_per_pixel;
-
-                data_ptrs[morton_to_gl] = morton_data + morton_offset;
-                data_ptrs[!morton_to_gl] = &gl_data[gl_pixel_index];
-
-                memcpy(data_ptrs[0], data_ptrs[1], bytes_per_pixel);
-            }
-        }
+        VideoCore::MortonCopy(bytes_per_pixel, width, height, morton_data, gl_top_line, -gl_stride,
+                              morton_to_gl);
     }
 }
 
@@ -348,12 +325,10 @@ CachedSurface* RasterizerCacheOpenGL::GetSurface(const CachedSurface& params, bo
                 tex_info.format = (Pica::Regs::TextureFormat)params.pixel_format;
                 tex_info.physical_address = params.addr;
 
-                for (unsigned y = 0; y < params.height; ++y) {
-                    for (unsigned x = 0; x < params.width; ++x) {
-                        tex_buffer[x + params.width * y] = Pica::DebugUtils::LookupTexture(
-                            texture_src_data, x, params.height - 1 - y, tex_info);
-                    }
-                }
+                // OpenGL textures are stored bottom-up
+                Pica::Texture::DecodeTexture(tex_info, texture_src_data,
+                                             &tex_buffer[(params.height - 1) * params.width],
+                                             -static_cast<ptrdiff_t>(params.width));
 
                 glTexImage2D(GL_TEXTURE_2D, 0, tuple.internal_format, params.width, params.height,
                              0, GL_RGBA, GL_UNSIGNED_BYTE, tex_buffer.data());
@@ -374,11 +349,8 @@ CachedSurface* RasterizerCacheOpenGL::GetSurface(const CachedSurface& params, bo
                 std::vector<u8> temp_fb_depth_buffer(params.width * params.height *
                                                      gl_bytes_per_pixel);
 
-                u8* temp_fb_depth_buffer_ptr =
-                    use_4bpp ? temp_fb_depth_buffer.data() + 1 : temp_fb_depth_buffer.data();
-
                 MortonCopyPixels(params.pixel_format, params.width, params.height, bytes_per_pixel,
-                                 gl_bytes_per_pixel, texture_src_data, temp_fb_depth_buffer_ptr,
+                                 gl_bytes_per_pixel, texture_src_data, temp_fb_depth_buffer.data(),
                                  true);
 
                 glTexImage2D(GL_TEXTURE_2D, 0, tuple.internal_format, params.width, params.height,
@@ -744,10 +716,8 @@ void RasterizerCacheOpenGL::FlushSurface(CachedSurface* surface) {
 
             glGetTexImage(GL_TEXTURE_2D, 0, tuple.format, tuple.type, temp_gl_buffer.data());
 
-            u8* temp_gl_buffer_ptr = use_4bpp ? temp_gl_buffer.data() + 1 : temp_gl_buffer.data();
-
             MortonCopyPixels(surface->pixel_format, surface->width, surface->height,
-                             bytes_per_pixel, gl_bytes_per_pixel, dst_buffer, temp_gl_buffer_ptr,
+                             bytes_per_pixel, gl_bytes_per_pixel, dst_buffer, temp_gl_buffer.data(),
                              false);
         }
     }
@@ -97,6 +97,25 @@ public:
         handle = GLShader::LoadProgram(vert_shader, frag_shader);
     }
 
+    /**
+     * Creates a new internal OpenGL resource from a program binary returned by glGetProgramBinary
+     * @returns False if the driver rejected the binary, in which case no resource is created
+     */
+    bool CreateFromBinary(GLenum format, const void* binary, GLsizei length) {
+        if (handle != 0)
+            return true;
+        handle = glCreateProgram();
+        glProgramBinary(handle, format, binary, length);
+
+        GLint link_status = GL_FALSE;
+        glGetProgramiv(handle, GL_LINK_STATUS, &link_status);
+        if (link_status != GL_TRUE) {
+            Release();
+            return false;
+        }
+        return true;
+    }
+
     /// Deletes the internal OpenGL resource
     void Release() {
         if (handle == 0)
@@ -5,11 +5,18 @@
 #pragma once
 
 #include <string>
+#include "common/common_types.h"
 
 union PicaShaderConfig;
 
 namespace GLShader {
 
+/**
+ * Version of the generated shaders. Must be incremented whenever the generator output changes, so
+ * that program binaries cached on disk get invalidated.
+ */
+constexpr u32 SHADER_GENERATOR_VERSION = 1;
+
 /**
  * Generates the GLSL vertex shader program source code for the current Pica state
  * @returns String of the shader source code
@@ -3,15 +3,21 @@
 // Refer to the license.txt file included.
 
 #include <atomic>
+#include <cinttypes>
 #include <cmath>
 #include <cstring>
+#include <string>
 #include <unordered_map>
 #include <utility>
 #include <boost/range/algorithm/fill.hpp>
 #include "common/bit_field.h"
+#include "common/common_paths.h"
+#include "common/file_util.h"
 #include "common/hash.h"
+#include "common/linear_disk_cache.h"
 #include "common/logging/log.h"
 #include "common/microprofile.h"
+#include "common/string_util.h"
 #include "video_core/pica.h"
 #include "video_core/pica_state.h"
 #include "video_core/shader/shader.h"
@@ -79,11 +85,65 @@ OutputVertex OutputRegisters::ToVertex(const Regs::ShaderConfig& config) const {
 #ifdef ARCHITECTURE_x86_64
 static std::unordered_map<u64, std::unique_ptr<JitShader>> shader_map;
 static const JitShader* jit_shader;
+
+/// Compiled shaders of the running title, persisted across runs
+static LinearDiskCache<u64, u8> disk_cache;
+static bool disk_cache_open = false;
+
+class DiskCacheReader : public LinearDiskCacheReader<u64, u8> {
+public:
+    void Read(const u64& key, const u8* value, u32 value_size) override {
+        auto shader = std::make_unique<JitShader>();
+        if (shader->Deserialize(value, value_size)) {
+            shader_map[key] = std::move(shader);
+            ++num_loaded;
+        }
+    }
+
+    u32 num_loaded = 0;
+};
 #endif // ARCHITECTURE_x86_64
 
 void ClearCache() {
 #ifdef ARCHITECTURE_x86_64
     shader_map.clear();
+    disk_cache.Close();
+    disk_cache_open = false;
+#endif // ARCHITECTURE_x86_64
+}
+
+void LoadDiskCache(u64 program_id) {
+#ifdef ARCHITECTURE_x86_64
+    if (!VideoCore::g_shader_jit_enabled)
+        return;
+
+    const std::string dir = FileUtil::GetUserPath(D_CACHE_IDX) + "shaders" DIR_SEP;
+    if (!FileUtil::CreateFullPath(dir)) {
+        LOG_ERROR(HW_GPU, "Failed to create shader cache directory %s", dir.c_str());
+        return;
+    }
+    const std::string filename =
+        dir + Common::StringFromFormat("vs_jit_%016" PRIX64 ".bin", program_id);
+
+    // Loading relocates all cached shaders up front, so that none of them has to be compiled or
+    // loaded while the game is running
+    DiskCacheReader reader;
+    const u32 num_entries = disk_cache.OpenAndRead(filename.c_str(), reader);
+    if (reader.num_loaded != num_entries) {
+        // Shaders which failed to load would be compiled and appended again on every run, so the
+        // file is rewritten with only the shaders that did load
+        LOG_INFO(HW_GPU, "Discarding %u unusable cached vertex shaders",
+                 num_entries - reader.num_loaded);
+        disk_cache.Close();
+        FileUtil::Delete(filename);
+        disk_cache.OpenAndRead(filename.c_str(), reader);
+        for (const auto& entry : shader_map) {
+            const std::vector<u8> data = entry.second->Serialize();
+            disk_cache.Append(entry.first, data.data(), static_cast<u32>(data.size()));
+        }
+    }
+    disk_cache_open = true;
+    LOG_INFO(HW_GPU, "Loaded %u of %u cached vertex shaders", reader.num_loaded, num_entries);
 #endif // ARCHITECTURE_x86_64
 }
 
@@ -101,6 +161,14 @@ void ShaderSetup::Setup() {
             auto shader = std::make_unique<JitShader>();
             shader->Compile();
             jit_shader = shader.get();
+
+            // Appended entries are buffered and written out in batches, or when ClearCache closes
+            // the file at shutdown
+            if (disk_cache_open) {
+                const std::vector<u8> data = shader->Serialize();
+                disk_cache.Append(cache_key, data.data(), static_cast<u32>(data.size()));
+            }
+
             shader_map[cache_key] = std::move(shader);
         }
     }
@@ -109,13 +177,9 @@ void ShaderSetup::Setup() {
 
 MICROPROFILE_DEFINE(GPU_Shader, "GPU", "Shader", MP_RGB(50, 50, 240));
 
-void ShaderSetup::Run(UnitState& state, const InputVertex& input, int num_attributes) {
-    auto& config = g_state.regs.vs;
-    auto& setup = g_state.vs;
-
-    MICROPROFILE_SCOPE(GPU_Shader);
-
-    // Setup input register table
+/// Loads the input registers of the unit and resets its conditional codes
+static void SetupUnitState(UnitState& state, const InputVertex& input, int num_attributes,
+                           const Regs::ShaderConfig& config) {
     const auto& attribute_register_map = config.input_register_map;
 
     for (unsigned i = 0; i < num_attributes; i++)
@@ -123,6 +187,15 @@ void ShaderSetup::Run(UnitState& state, const InputVertex& input, int num_attrib
 
     state.conditional_code[0] = false;
     state.conditional_code[1] = false;
+}
+
+void ShaderSetup::Run(UnitState& state, const InputVertex& input, int num_attributes) {
+    auto& config = g_state.regs.vs;
+    auto& setup = g_state.vs;
+
+    MICROPROFILE_SCOPE(GPU_Shader);
+
+    SetupUnitState(state, input, num_attributes, config);
 
 #ifdef ARCHITECTURE_x86_64
     if (VideoCore::g_shader_jit_enabled) {
@@ -137,6 +210,28 @@ void ShaderSetup::Run(UnitState& state, const InputVertex& input, int num_attrib
 #endif // ARCHITECTURE_x86_64
 }
 
+void ShaderSetup::RunBatch(UnitState* states, const InputVertex* inputs, size_t count,
+                           int num_attributes) {
+    auto& config = g_state.regs.vs;
+    auto& setup = g_state.vs;
+
+    MICROPROFILE_SCOPE(GPU_Shader);
+
+    for (size_t i = 0; i < count; ++i)
+        SetupUnitState(states[i], inputs[i], num_attributes, config);
+
+#ifdef ARCHITECTURE_x86_64
+    if (VideoCore::g_shader_jit_enabled) {
+        jit_shader->RunBatch(setup, states, count, config.main_offset);
+        return;
+    }
+#endif // ARCHITECTURE_x86_64
+
+    DebugData<false> dummy_debug_data;
+    for (size_t i = 0; i < count; ++i)
+        RunInterpreter(setup, states[i], dummy_debug_data, config.main_offset);
+}
+
 DebugData<true> ShaderSetup::ProduceDebugInfo(const InputVertex& input, int num_attributes,
                                               const Regs::ShaderConfig& config,
                                               const ShaderSetup& setup) {
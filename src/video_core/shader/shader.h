@@ -147,6 +147,12 @@ struct UnitState {
 /// Clears the shader cache
 void ClearCache();
 
+/**
+ * Loads the compiled shaders cached on disk for the given title, and persists shaders compiled
+ * from now on until the cache is cleared.
+ */
+void LoadDiskCache(u64 program_id);
+
 struct ShaderSetup {
 
     struct {
@@ -187,6 +193,16 @@ struct ShaderSetup {
      */
     void Run(UnitState& state, const InputVertex& input, int num_attributes);
 
+    /**
+     * Runs the currently setup shader for a batch of vertices. With the JIT, this enters the
+     * compiled code only once for the whole batch.
+     * @param states Shader unit states, one per vertex
+     * @param inputs Input vertices into the shader
+     * @param count Number of vertices in the batch
+     * @param num_attributes The number of vertex shader attributes
+     */
+    void RunBatch(UnitState* states, const InputVertex* inputs, size_t count, int num_attributes);
+
     /**
      * Produce debug information based on the given shader and input vertex
      * @param input Input vertex into the shader
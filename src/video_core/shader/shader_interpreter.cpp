@@ -77,8 +77,9 @@ void RunInterpreter(const ShaderSetup& setup, UnitState& state, DebugData<Debug>
     const auto& swizzle_data = g_state.vs.swizzle_data;
     const auto& program_code = g_state.vs.program_code;
 
-    // Placeholder for invalid inputs
-    static float24 dummy_vec4_float24[4];
+    // Placeholder for invalid inputs. Not static, since vertices may be shaded on several threads
+    float24 dummy_vec4_float24[4] = {float24::Zero(), float24::Zero(), float24::Zero(),
+                                     float24::Zero()};
 
     unsigned iteration = 0;
     bool exit_loop = false;
@@ -5,10 +5,13 @@
 #include <algorithm>
 #include <cmath>
 #include <cstdint>
+#include <cstring>
+#include <limits>
 #include <nihstro/shader_bytecode.h>
 #include <smmintrin.h>
 #include <xmmintrin.h>
 #include "common/assert.h"
+#include "common/common_funcs.h"
 #include "common/logging/log.h"
 #include "common/vector_math.h"
 #include "common/x64/cpu_detect.h"
@@ -120,6 +123,10 @@ static const Reg64 COND0 = r13;
 static const Reg64 COND1 = r14;
 /// Pointer to the UnitState instance for the current VS unit
 static const Reg64 STATE = r15;
+/// Number of vertices left to process by a batched invocation
+static const Reg64 BATCH_COUNT = rbx;
+/// Address of the shader code batched invocations start at for each vertex
+static const Reg64 BATCH_START = rbp;
 /// SIMD scratch register
 static const Xmm SCRATCH = xmm0;
 /// Loaded with the first swizzled source register, otherwise can be used as a scratch register
@@ -164,10 +171,73 @@ static void LogCritical(const char* msg) {
     LOG_CRITICAL(HW_GPU, "%s", msg);
 }
 
+/// Used to set a register to one
+static const __m128 one = {1.f, 1.f, 1.f, 1.f};
+/// Used to negate registers
+static const __m128 neg = {-0.f, -0.f, -0.f, -0.f};
+
+static const char backwards_if_msg[] = "Backwards if-statements not supported";
+static const char backwards_loop_msg[] = "Backwards loops not supported";
+static const char nested_loop_msg[] = "Nested loops not supported";
+
+/**
+ * Host addresses that compiled shaders may refer to. Serialized shaders store indices into this
+ * table instead of the addresses themselves, since those change between runs.
+ */
+static const void* const host_addresses[] = {
+    reinterpret_cast<const void*>(&LogCritical),
+    reinterpret_cast<const void*>(&exp2f),
+    reinterpret_cast<const void*>(&log2f),
+    &one,
+    &neg,
+    backwards_if_msg,
+    backwards_loop_msg,
+    nested_loop_msg,
+};
+
+/// Version of the format produced by JitShader::Serialize, to be bumped when it changes
+constexpr u32 SERIALIZED_SHADER_VERSION = 2;
+
+struct SerializedShaderHeader {
+    u32 version;
+    /// Host CPU features the code was compiled for
+    u32 cpu_features;
+    u32 code_size;
+    u32 num_relocations;
+    /// Offset of the batched entry point; the single-vertex one is at the start of the code
+    u32 batch_entry_offset;
+    /// Offset of the code for each instruction, or UINT32_MAX if it has no entry point
+    std::array<u32, 1024> entry_offsets;
+};
+
+static u32 GetCPUFeatures() {
+    return Common::GetCPUCaps().sse4_1 ? 1 : 0;
+}
+
+void JitShader::Compile_LoadHostAddress(const Xbyak::Reg& dest, const void* address) {
+    auto it = std::find(std::begin(host_addresses), std::end(host_addresses), address);
+    ASSERT_MSG(it != std::end(host_addresses), "Host address missing from host_addresses");
+
+    // Encode `mov dest, imm64` by hand: Xbyak picks a shorter encoding for small immediates, but
+    // relocated addresses need all 8 bytes
+    db(0x48 | (dest.getIdx() >= 8 ? 0x01 : 0x00)); // REX.W, REX.B for r8-r15
+    db(0xB8 | (dest.getIdx() & 7));
+    dq(reinterpret_cast<uintptr_t>(address));
+    relocations.push_back({static_cast<u32>(getSize() - sizeof(u64)),
+                           static_cast<u32>(it - std::begin(host_addresses))});
+}
+
+void JitShader::Compile_CallHostFunction(const void* function) {
+    // Always call through a register, since relative calls would depend on the code's location
+    // ABI_RETURN is a safe temp register to use before a call
+    Compile_LoadHostAddress(ABI_RETURN, function);
+    call(ABI_RETURN);
+}
+
 void JitShader::Compile_Assert(bool condition, const char* msg) {
     if (!condition) {
-        mov(ABI_PARAM1, reinterpret_cast<size_t>(msg));
-        CallFarFunction(*this, LogCritical);
+        Compile_LoadHostAddress(ABI_PARAM1, msg);
+        Compile_CallHostFunction(reinterpret_cast<const void*>(&LogCritical));
     }
 }
 
@@ -434,7 +504,7 @@ void JitShader::Compile_EX2(Instruction instr) {
     movss(xmm0, SRC1); // ABI_PARAM1
 
     ABI_PushRegistersAndAdjustStack(*this, PersistentCallerSavedRegs(), 0);
-    CallFarFunction(*this, exp2f);
+    Compile_CallHostFunction(reinterpret_cast<const void*>(&exp2f));
     ABI_PopRegistersAndAdjustStack(*this, PersistentCallerSavedRegs(), 0);
 
     shufps(xmm0, xmm0, _MM_SHUFFLE(0, 0, 0, 0)); // ABI_RETURN
@@ -447,7 +517,7 @@ void JitShader::Compile_LG2(Instruction instr) {
     movss(xmm0, SRC1); // ABI_PARAM1
 
     ABI_PushRegistersAndAdjustStack(*this, PersistentCallerSavedRegs(), 0);
-    CallFarFunction(*this, log2f);
+    Compile_CallHostFunction(reinterpret_cast<const void*>(&log2f));
     ABI_PopRegistersAndAdjustStack(*this, PersistentCallerSavedRegs(), 0);
 
     shufps(xmm0, xmm0, _MM_SHUFFLE(0, 0, 0, 0)); // ABI_RETURN
@@ -596,7 +666,7 @@ void JitShader::Compile_RSQ(Instruction instr) {
 void JitShader::Compile_NOP(Instruction instr) {}
 
 void JitShader::Compile_END(Instruction instr) {
-    ABI_PopRegistersAndAdjustStack(*this, ABI_ALL_CALLEE_SAVED, 8);
+    // Return to the entry point that called into the program
     ret();
 }
 
@@ -688,8 +758,7 @@ void JitShader::Compile_MAD(Instruction instr) {
 }
 
 void JitShader::Compile_IF(Instruction instr) {
-    Compile_Assert(instr.flow_control.dest_offset >= program_counter,
-                   "Backwards if-statements not supported");
+    Compile_Assert(instr.flow_control.dest_offset >= program_counter, backwards_if_msg);
     Label l_else, l_endif;
 
     // Evaluate the "IF" condition
@@ -720,9 +789,8 @@ void JitShader::Compile_IF(Instruction instr) {
 }
 
 void JitShader::Compile_LOOP(Instruction instr) {
-    Compile_Assert(instr.flow_control.dest_offset >= program_counter,
-                   "Backwards loops not supported");
-    Compile_Assert(!looping, "Nested loops not supported");
+    Compile_Assert(instr.flow_control.dest_offset >= program_counter, backwards_loop_msg);
+    Compile_Assert(!looping, nested_loop_msg);
 
     looping = true;
 
@@ -789,6 +857,30 @@ void JitShader::Compile_Return() {
     L(b);
 }
 
+void JitShader::Compile_LoadConstants() {
+    Compile_LoadHostAddress(rax, &one);
+    movaps(ONE, xword[rax]);
+
+    Compile_LoadHostAddress(rax, &neg);
+    movaps(NEGBIT, xword[rax]);
+}
+
+void JitShader::Compile_ResetVertexState() {
+    // Zero address/loop registers
+    xor(ADDROFFS_REG_0.cvt32(), ADDROFFS_REG_0.cvt32());
+    xor(ADDROFFS_REG_1.cvt32(), ADDROFFS_REG_1.cvt32());
+    xor(LOOPCOUNT_REG, LOOPCOUNT_REG);
+}
+
+void JitShader::Compile_CallProgram(const Xbyak::Reg& start) {
+    // Push a return offset that matches no instruction, so that Compile_Return never returns from
+    // the top level of the program. Together with the return address pushed by the call, this also
+    // keeps the stack pointer 16-byte aligned inside the program, as it is after the prologue.
+    push(qword, 0xFFFFFFFF);
+    call(start);
+    add(rsp, 8);
+}
+
 void JitShader::Compile_NextInstr() {
     if (std::binary_search(return_offsets.begin(), return_offsets.end(), program_counter)) {
         Compile_Return();
@@ -839,33 +931,44 @@ void JitShader::Compile() {
     program_counter = 0;
     looping = false;
     instruction_labels.fill(Xbyak::Label());
+    relocations.clear();
 
     // Find all `CALL` instructions and identify return locations
     FindReturnOffsets();
 
+    // Entry point for a single vertex
     // The stack pointer is 8 modulo 16 at the entry of a procedure
     ABI_PushRegistersAndAdjustStack(*this, ABI_ALL_CALLEE_SAVED, 8);
-
     mov(SETUP, ABI_PARAM1);
     mov(STATE, ABI_PARAM2);
+    Compile_LoadConstants();
+    Compile_ResetVertexState();
+    Compile_CallProgram(ABI_PARAM3);
+    ABI_PopRegistersAndAdjustStack(*this, ABI_ALL_CALLEE_SAVED, 8);
+    ret();
 
-    // Zero address/loop  registers
-    xor(ADDROFFS_REG_0.cvt32(), ADDROFFS_REG_0.cvt32());
-    xor(ADDROFFS_REG_1.cvt32(), ADDROFFS_REG_1.cvt32());
-    xor(LOOPCOUNT_REG, LOOPCOUNT_REG);
-
-    // Used to set a register to one
-    static const __m128 one = {1.f, 1.f, 1.f, 1.f};
-    mov(rax, reinterpret_cast<size_t>(&one));
-    movaps(ONE, xword[rax]);
-
-    // Used to negate registers
-    static const __m128 neg = {-0.f, -0.f, -0.f, -0.f};
-    mov(rax, reinterpret_cast<size_t>(&neg));
-    movaps(NEGBIT, xword[rax]);
-
-    // Jump to start of the shader program
-    jmp(ABI_PARAM3);
+    // Entry point for a batch of vertices, running the program for each UnitState in turn
+    batch_program = (CompiledBatchShader*)getCurr();
+    ABI_PushRegistersAndAdjustStack(*this, ABI_ALL_CALLEE_SAVED, 8);
+    // ABI_PARAM4 is the same register as SETUP on Windows, so it needs to be moved first
+    mov(BATCH_START, ABI_PARAM4);
+    mov(BATCH_COUNT, ABI_PARAM3);
+    mov(STATE, ABI_PARAM2);
+    mov(SETUP, ABI_PARAM1);
+    Compile_LoadConstants();
+
+    Label batch_loop, batch_end;
+    test(BATCH_COUNT, BATCH_COUNT);
+    jz(batch_end);
+    L(batch_loop);
+    Compile_ResetVertexState();
+    Compile_CallProgram(BATCH_START);
+    add(STATE, static_cast<u32>(sizeof(UnitState)));
+    dec(BATCH_COUNT);
+    jnz(batch_loop);
+    L(batch_end);
+    ABI_PopRegistersAndAdjustStack(*this, ABI_ALL_CALLEE_SAVED, 8);
+    ret();
 
     // Compile entire program
     Compile_Block(static_cast<unsigned>(g_state.vs.program_code.size()));
@@ -876,11 +979,93 @@ void JitShader::Compile() {
 
     ready();
 
+    for (size_t i = 0; i < instruction_labels.size(); ++i)
+        entry_points[i] = instruction_labels[i].getAddress();
+
     uintptr_t size = reinterpret_cast<uintptr_t>(getCurr()) - reinterpret_cast<uintptr_t>(program);
     ASSERT_MSG(size <= MAX_SHADER_SIZE, "Compiled a shader that exceeds the allocated size!");
     LOG_DEBUG(HW_GPU, "Compiled shader size=%lu", size);
 }
 
+std::vector<u8> JitShader::Serialize() const {
+    const u8* code = getCode();
+    const size_t code_size = getSize();
+
+    SerializedShaderHeader header;
+    header.version = SERIALIZED_SHADER_VERSION;
+    header.cpu_features = GetCPUFeatures();
+    header.code_size = static_cast<u32>(code_size);
+    header.num_relocations = static_cast<u32>(relocations.size());
+    header.batch_entry_offset = static_cast<u32>(reinterpret_cast<const u8*>(batch_program) - code);
+    for (size_t i = 0; i < entry_points.size(); ++i) {
+        header.entry_offsets[i] = entry_points[i] != nullptr
+                                      ? static_cast<u32>(entry_points[i] - code)
+                                      : std::numeric_limits<u32>::max();
+    }
+
+    const size_t relocations_size = relocations.size() * sizeof(Relocation);
+    std::vector<u8> data(sizeof(header) + relocations_size + code_size);
+    std::memcpy(data.data(), &header, sizeof(header));
+    std::memcpy(data.data() + sizeof(header), relocations.data(), relocations_size);
+    std::memcpy(data.data() + sizeof(header) + relocations_size, code, code_size);
+
+    // Host addresses are meaningless in other runs; they get patched in again when loading
+    for (const Relocation& relocation : relocations) {
+        std::memset(data.data() + sizeof(header) + relocations_size + relocation.code_offset, 0,
+                    sizeof(u64));
+    }
+    return data;
+}
+
+bool JitShader::Deserialize(const u8* data, size_t size) {
+    SerializedShaderHeader header;
+    if (size < sizeof(header))
+        return false;
+    std::memcpy(&header, data, sizeof(header));
+
+    if (header.version != SERIALIZED_SHADER_VERSION || header.cpu_features != GetCPUFeatures() ||
+        header.code_size > MAX_SHADER_SIZE || header.batch_entry_offset >= header.code_size)
+        return false;
+
+    const size_t relocations_size = header.num_relocations * sizeof(Relocation);
+    if (size != sizeof(header) + relocations_size + header.code_size)
+        return false;
+
+    std::vector<Relocation> loaded_relocations(header.num_relocations);
+    std::memcpy(loaded_relocations.data(), data + sizeof(header), relocations_size);
+
+    std::vector<u8> code(data + sizeof(header) + relocations_size, data + size);
+    for (const Relocation& relocation : loaded_relocations) {
+        if (relocation.code_offset + sizeof(u64) > code.size() ||
+            relocation.address_index >= ARRAY_SIZE(host_addresses))
+            return false;
+
+        const u64 address = reinterpret_cast<uintptr_t>(host_addresses[relocation.address_index]);
+        std::memcpy(&code[relocation.code_offset], &address, sizeof(u64));
+    }
+
+    for (size_t i = 0; i < entry_points.size(); ++i) {
+        if (header.entry_offsets[i] != std::numeric_limits<u32>::max() &&
+            header.entry_offsets[i] >= code.size())
+            return false;
+    }
+
+    reset();
+    program = (CompiledShader*)getCurr();
+    batch_program = (CompiledBatchShader*)(getCurr() + header.batch_entry_offset);
+    for (u8 byte : code)
+        db(byte);
+    ready();
+
+    for (size_t i = 0; i < entry_points.size(); ++i) {
+        entry_points[i] = header.entry_offsets[i] != std::numeric_limits<u32>::max()
+                              ? getCode() + header.entry_offsets[i]
+                              : nullptr;
+    }
+    relocations = std::move(loaded_relocations);
+    return true;
+}
+
 JitShader::JitShader() : Xbyak::CodeGenerator(MAX_SHADER_SIZE) {}
 
 } // namespace Shader
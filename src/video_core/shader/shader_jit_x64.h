@@ -35,11 +35,32 @@ public:
     JitShader();
 
     void Run(const ShaderSetup& setup, UnitState& state, unsigned offset) const {
-        program(&setup, &state, instruction_labels[offset].getAddress());
+        program(&setup, &state, entry_points[offset]);
+    }
+
+    /**
+     * Runs the shader for each of `count` consecutive UnitStates, without returning from the
+     * compiled code in between vertices.
+     */
+    void RunBatch(const ShaderSetup& setup, UnitState* states, size_t count,
+                  unsigned offset) const {
+        batch_program(&setup, states, count, entry_points[offset]);
     }
 
     void Compile();
 
+    /**
+     * Serializes the compiled code, so that it can be loaded again in a later run without
+     * recompiling. Host addresses embedded in the code are stored as relocations.
+     */
+    std::vector<u8> Serialize() const;
+
+    /**
+     * Loads code produced by Serialize, replacing any code generated before.
+     * @returns False if the data is invalid or was produced for a different host CPU
+     */
+    bool Deserialize(const u8* data, size_t size);
+
     void Compile_ADD(Instruction instr);
     void Compile_DP3(Instruction instr);
     void Compile_DP4(Instruction instr);
@@ -91,12 +112,30 @@ private:
 
     BitSet32 PersistentCallerSavedRegs();
 
+    /// Loads the constant vectors kept in registers while the program runs
+    void Compile_LoadConstants();
+
+    /// Resets the address and loop registers before running the program for a vertex
+    void Compile_ResetVertexState();
+
+    /// Calls into the program at the code address held by `start`; END returns from the call
+    void Compile_CallProgram(const Xbyak::Reg& start);
+
     /**
      * Assertion evaluated at compile-time, but only triggered if executed at runtime.
      * @param msg Message to be logged if the assertion fails.
      */
     void Compile_Assert(bool condition, const char* msg);
 
+    /**
+     * Loads a host address into a register, recording a relocation for it. The address must be
+     * listed in the host address table of the JIT.
+     */
+    void Compile_LoadHostAddress(const Xbyak::Reg& dest, const void* address);
+
+    /// Calls a host function through its absolute address, so that the code stays relocatable
+    void Compile_CallHostFunction(const void* function);
+
     /**
      * Analyzes the entire shader program for `CALL` instructions before emitting any code,
      * identifying the locations where a return needs to be inserted.
@@ -106,6 +145,18 @@ private:
     /// Mapping of Pica VS instructions to pointers in the emitted code
     std::array<Xbyak::Label, 1024> instruction_labels;
 
+    /// Code pointers for starting execution at each Pica VS instruction
+    std::array<const u8*, 1024> entry_points{};
+
+    struct Relocation {
+        /// Offset in the code of the 64-bit immediate holding the address
+        u32 code_offset;
+        /// Index into the host address table
+        u32 address_index;
+    };
+    /// Host addresses embedded in the compiled code
+    std::vector<Relocation> relocations;
+
     /// Offsets in code where a return needs to be inserted
     std::vector<unsigned> return_offsets;
 
@@ -114,6 +165,10 @@ private:
 
     using CompiledShader = void(const void* setup, void* state, const u8* start_addr);
     CompiledShader* program = nullptr;
+
+    using CompiledBatchShader = void(const void* setup, void* states, size_t count,
+                                     const u8* start_addr);
+    CompiledBatchShader* batch_program = nullptr;
 };
 
 } // Shader
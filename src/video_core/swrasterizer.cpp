@@ -2,14 +2,252 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <thread>
+#include "common/microprofile.h"
+#include "common/thread_pool.h"
 #include "video_core/clipper.h"
+#include "video_core/debug_utils/debug_utils.h"
+#include "video_core/pica_state.h"
+#include "video_core/rasterizer.h"
 #include "video_core/swrasterizer.h"
+#include "video_core/video_core.h"
 
 namespace VideoCore {
 
+/// Region covering every pixel addressable by the rasterizer
+static const MathUtil::Rectangle<unsigned> full_region{0, 0, 0x1000, 0x1000};
+
+/// Width and height in pixels of the tiles the render target is split into when binning
+static constexpr unsigned TILE_SIZE = 32;
+
+static unsigned GetNumRasterizerThreads() {
+    int num_threads = g_sw_rasterizer_threads;
+    if (num_threads <= 0)
+        num_threads = static_cast<int>(std::thread::hardware_concurrency());
+    return static_cast<unsigned>(std::max(num_threads, 1));
+}
+
+/// Maximum number of pixel pipelines kept around. The cache is cleared when this is exceeded.
+static constexpr size_t MAX_CACHED_PIPELINES = 256;
+
+/// Returns whether writing the given register may change the PixelPipelineConfig
+static bool AffectsPixelPipeline(u32 id) {
+    switch (id) {
+    case PICA_REG_INDEX(tev_stage0.sources_raw):
+    case PICA_REG_INDEX(tev_stage0.modifiers_raw):
+    case PICA_REG_INDEX(tev_stage0.ops_raw):
+    case PICA_REG_INDEX(tev_stage0.scales_raw):
+    case PICA_REG_INDEX(tev_stage1.sources_raw):
+    case PICA_REG_INDEX(tev_stage1.modifiers_raw):
+    case PICA_REG_INDEX(tev_stage1.ops_raw):
+    case PICA_REG_INDEX(tev_stage1.scales_raw):
+    case PICA_REG_INDEX(tev_stage2.sources_raw):
+    case PICA_REG_INDEX(tev_stage2.modifiers_raw):
+    case PICA_REG_INDEX(tev_stage2.ops_raw):
+    case PICA_REG_INDEX(tev_stage2.scales_raw):
+    case PICA_REG_INDEX(tev_stage3.sources_raw):
+    case PICA_REG_INDEX(tev_stage3.modifiers_raw):
+    case PICA_REG_INDEX(tev_stage3.ops_raw):
+    case PICA_REG_INDEX(tev_stage3.scales_raw):
+    case PICA_REG_INDEX(tev_stage4.sources_raw):
+    case PICA_REG_INDEX(tev_stage4.modifiers_raw):
+    case PICA_REG_INDEX(tev_stage4.ops_raw):
+    case PICA_REG_INDEX(tev_stage4.scales_raw):
+    case PICA_REG_INDEX(tev_stage5.sources_raw):
+    case PICA_REG_INDEX(tev_stage5.modifiers_raw):
+    case PICA_REG_INDEX(tev_stage5.ops_raw):
+    case PICA_REG_INDEX(tev_stage5.scales_raw):
+    // Also holds the fog mode
+    case PICA_REG_INDEX(tev_combiner_buffer_input):
+    case PICA_REG_INDEX(output_merger.alphablend_enable):
+    case PICA_REG_INDEX(output_merger.alpha_blending):
+    case PICA_REG_INDEX(output_merger.logic_op):
+    case PICA_REG_INDEX(output_merger.alpha_test):
+    case PICA_REG_INDEX(output_merger.stencil_test.raw_func):
+    case PICA_REG_INDEX(output_merger.stencil_test.raw_op):
+    case PICA_REG_INDEX(output_merger.depth_test_enable):
+    case PICA_REG_INDEX(framebuffer.allow_depth_stencil_write):
+    case PICA_REG_INDEX(framebuffer.depth_format):
+        return true;
+    default:
+        return false;
+    }
+}
+
+static size_t GetTextureCacheBudget() {
+    return static_cast<size_t>(std::max<int>(g_sw_texture_cache_size, 0)) * 1024 * 1024;
+}
+
+SWRasterizer::SWRasterizer() : texture_cache(GetTextureCacheBudget()) {}
+
+SWRasterizer::~SWRasterizer() = default;
+
 void SWRasterizer::AddTriangle(const Pica::Shader::OutputVertex& v0,
                                const Pica::Shader::OutputVertex& v1,
                                const Pica::Shader::OutputVertex& v2) {
-    Pica::Clipper::ProcessTriangle(v0, v1, v2);
+    if (GetNumRasterizerThreads() == 1 && triangles.empty()) {
+        const auto& pipeline = GetPixelPipeline();
+        const auto& texture_units = GetTextureUnits();
+        const auto rasterize = [&pipeline, &texture_units](const Pica::Shader::OutputVertex& v0,
+                                                           const Pica::Shader::OutputVertex& v1,
+                                                           const Pica::Shader::OutputVertex& v2) {
+            Pica::Rasterizer::ProcessTriangle(v0, v1, v2, pipeline, texture_units, full_region);
+        };
+        Pica::Clipper::ProcessTriangle(v0, v1, v2, rasterize);
+        return;
+    }
+
+    Pica::Clipper::ProcessTriangle(v0, v1, v2, [this](const Pica::Shader::OutputVertex& v0,
+                                                      const Pica::Shader::OutputVertex& v1,
+                                                      const Pica::Shader::OutputVertex& v2) {
+        triangles.push_back({v0, v1, v2});
+    });
+}
+
+void SWRasterizer::DrawTriangles() {
+    FlushTriangles();
+}
+
+void SWRasterizer::NotifyPicaRegisterChanged(u32 id) {
+    // Triangles are only ever queued while processing a single register write (i.e. a draw
+    // trigger or an immediate-mode attribute), so flushing here guarantees they are rasterized
+    // with the register state they were submitted under.
+    FlushTriangles();
+    if (AffectsPixelPipeline(id))
+        current_pipeline = nullptr;
+    texture_units_valid = false;
+}
+
+void SWRasterizer::FlushAll() {
+    FlushTriangles();
+}
+
+void SWRasterizer::FlushRegion(PAddr addr, u32 size) {
+    FlushTriangles();
+}
+
+void SWRasterizer::FlushAndInvalidateRegion(PAddr addr, u32 size) {
+    FlushTriangles();
+    texture_cache.InvalidateRegion(addr, size);
+    texture_units_valid = false;
+}
+
+MICROPROFILE_DEFINE(GPU_Binning, "GPU", "Triangle Binning", MP_RGB(50, 50, 240));
+
+void SWRasterizer::FlushTriangles() {
+    if (triangles.empty())
+        return;
+
+    const unsigned num_threads = GetNumRasterizerThreads();
+    if (thread_pool == nullptr || thread_pool->GetNumThreads() != num_threads)
+        thread_pool = std::make_unique<Common::ThreadPool>(num_threads - 1);
+
+    std::vector<MathUtil::Rectangle<unsigned>> bounds;
+    unsigned num_tiles_x = 0;
+    unsigned num_tiles_y = 0;
+    {
+        MICROPROFILE_SCOPE(GPU_Binning);
+
+        bounds.reserve(triangles.size());
+        for (const auto& triangle : triangles) {
+            bounds.push_back(Pica::Rasterizer::GetTriangleBounds(triangle.v0, triangle.v1,
+                                                                 triangle.v2));
+            num_tiles_x = std::max(num_tiles_x, (bounds.back().right + TILE_SIZE - 1) / TILE_SIZE);
+            num_tiles_y = std::max(num_tiles_y, (bounds.back().bottom + TILE_SIZE - 1) / TILE_SIZE);
+        }
+
+        bins.resize(std::max<size_t>(bins.size(), num_tiles_x * num_tiles_y));
+        for (auto& bin : bins)
+            bin.clear();
+
+        for (u32 index = 0; index < triangles.size(); ++index) {
+            const auto& bound = bounds[index];
+            for (unsigned tile_y = bound.top / TILE_SIZE; tile_y * TILE_SIZE < bound.bottom;
+                 ++tile_y) {
+                for (unsigned tile_x = bound.left / TILE_SIZE; tile_x * TILE_SIZE < bound.right;
+                     ++tile_x) {
+                    bins[tile_y * num_tiles_x + tile_x].push_back(index);
+                }
+            }
+        }
+    }
+
+    const auto& pipeline = GetPixelPipeline();
+    const auto& texture_units = GetTextureUnits();
+
+    // Tiles don't share any pixels, hence they can be shaded independently
+    thread_pool->ParallelFor(num_tiles_x * num_tiles_y, [&](size_t tile_index) {
+        const auto& bin = bins[tile_index];
+        if (bin.empty())
+            return;
+
+        const unsigned tile_x = static_cast<unsigned>(tile_index % num_tiles_x) * TILE_SIZE;
+        const unsigned tile_y = static_cast<unsigned>(tile_index / num_tiles_x) * TILE_SIZE;
+        const MathUtil::Rectangle<unsigned> region{tile_x, tile_y, tile_x + TILE_SIZE,
+                                                   tile_y + TILE_SIZE};
+
+        for (u32 index : bin) {
+            const auto& triangle = triangles[index];
+            Pica::Rasterizer::ProcessTriangle(triangle.v0, triangle.v1, triangle.v2, pipeline,
+                                              texture_units, region);
+        }
+    });
+
+    triangles.clear();
+}
+
+const Pica::Rasterizer::PixelPipeline& SWRasterizer::GetPixelPipeline() {
+    if (current_pipeline != nullptr)
+        return *current_pipeline;
+
+    const auto config = Pica::Rasterizer::PixelPipelineConfig::CurrentConfig();
+    if (pipeline_cache.size() >= MAX_CACHED_PIPELINES && pipeline_cache.count(config) == 0)
+        pipeline_cache.clear();
+
+    auto& cached_pipeline = pipeline_cache[config];
+    if (cached_pipeline == nullptr)
+        cached_pipeline = std::make_unique<Pica::Rasterizer::PixelPipeline>(config);
+
+    current_pipeline = cached_pipeline.get();
+    return *current_pipeline;
+}
+
+const Pica::Rasterizer::TextureUnits& SWRasterizer::GetTextureUnits() {
+    if (texture_units_valid)
+        return current_texture_units;
+
+    const auto& regs = Pica::g_state.regs;
+
+    texture_cache.SetBudget(GetTextureCacheBudget());
+    const auto textures = regs.GetTextures();
+    for (unsigned i = 0; i < textures.size(); ++i) {
+        if (textures[i].enabled) {
+            current_textures[i] =
+                texture_cache.GetTexture(Pica::DebugUtils::TextureInfo::FromPicaRegister(
+                    textures[i].config, textures[i].format));
+        } else {
+            current_textures[i] = nullptr;
+        }
+        current_texture_units[i] = current_textures[i].get();
+    }
+
+    // Pixel writes don't go through the memory hooks, so drop the render targets from the cache
+    // before drawing to them. Textures looked up from now on are decoded from the new contents.
+    const auto& framebuffer = regs.framebuffer;
+    const u32 num_pixels = framebuffer.GetWidth() * framebuffer.GetHeight();
+    if (framebuffer.allow_color_write != 0) {
+        texture_cache.InvalidateRegion(
+            framebuffer.GetColorBufferPhysicalAddress(),
+            num_pixels * Pica::Regs::BytesPerColorPixel(framebuffer.color_format));
+    }
+    if (framebuffer.allow_depth_stencil_write != 0) {
+        texture_cache.InvalidateRegion(
+            framebuffer.GetDepthBufferPhysicalAddress(),
+            num_pixels * Pica::Regs::BytesPerDepthPixel(framebuffer.depth_format));
+    }
+
+    texture_units_valid = true;
+    return current_texture_units;
 }
 }
@@ -4,24 +4,83 @@
 
 #pragma once
 
+#include <array>
+#include <memory>
+#include <unordered_map>
+#include <vector>
 #include "common/common_types.h"
+#include "video_core/pixel_pipeline.h"
+#include "video_core/rasterizer.h"
 #include "video_core/rasterizer_interface.h"
+#include "video_core/shader/shader.h"
+#include "video_core/texture/texture_cache.h"
 
-namespace Pica {
-namespace Shader {
-struct OutputVertex;
-}
+namespace Common {
+class ThreadPool;
 }
 
 namespace VideoCore {
 
 class SWRasterizer : public RasterizerInterface {
+public:
+    SWRasterizer();
+    ~SWRasterizer() override;
+
     void AddTriangle(const Pica::Shader::OutputVertex& v0, const Pica::Shader::OutputVertex& v1,
                      const Pica::Shader::OutputVertex& v2) override;
-    void DrawTriangles() override {}
-    void NotifyPicaRegisterChanged(u32 id) override {}
-    void FlushAll() override {}
-    void FlushRegion(PAddr addr, u32 size) override {}
-    void FlushAndInvalidateRegion(PAddr addr, u32 size) override {}
+    void DrawTriangles() override;
+    void NotifyPicaRegisterChanged(u32 id) override;
+    void FlushAll() override;
+    void FlushRegion(PAddr addr, u32 size) override;
+    void FlushAndInvalidateRegion(PAddr addr, u32 size) override;
+
+private:
+    struct Triangle {
+        Pica::Shader::OutputVertex v0;
+        Pica::Shader::OutputVertex v1;
+        Pica::Shader::OutputVertex v2;
+    };
+
+    /**
+     * Rasterizes all queued triangles. The render target is split into tiles which are shaded in
+     * parallel; within a tile, triangles are processed in submission order, so the result is
+     * identical to rasterizing them one after another.
+     */
+    void FlushTriangles();
+
+    /// Returns the pixel pipeline for the current register configuration, building it if needed
+    const Pica::Rasterizer::PixelPipeline& GetPixelPipeline();
+
+    /**
+     * Returns the decoded textures for the current register configuration, decoding them if
+     * needed. Cached copies of the current render targets are dropped at the same time, since
+     * the triangles drawn with these textures are about to overwrite them.
+     */
+    const Pica::Rasterizer::TextureUnits& GetTextureUnits();
+
+    /// Triangles (after clipping) that haven't been rasterized yet
+    std::vector<Triangle> triangles;
+
+    /// Indices into `triangles` of the triangles touching each tile
+    std::vector<std::vector<u32>> bins;
+
+    std::unique_ptr<Common::ThreadPool> thread_pool;
+
+    /// Pipelines built so far, dropped altogether when there are too many of them
+    std::unordered_map<Pica::Rasterizer::PixelPipelineConfig,
+                       std::unique_ptr<Pica::Rasterizer::PixelPipeline>>
+        pipeline_cache;
+
+    /// Pipeline matching the current registers, or nullptr if registers changed since lookup
+    const Pica::Rasterizer::PixelPipeline* current_pipeline = nullptr;
+
+    Pica::Texture::TextureCache texture_cache;
+
+    /// Textures referenced by `current_texture_units`, kept alive in case they get evicted
+    std::array<std::shared_ptr<const Pica::Texture::DecodedTexture>, 3> current_textures;
+    Pica::Rasterizer::TextureUnits current_texture_units{};
+
+    /// Whether `current_texture_units` matches the current registers and memory contents
+    bool texture_units_valid = false;
 };
 }
@@ -0,0 +1,112 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <iterator>
+#include "common/microprofile.h"
+#include "core/memory.h"
+#include "video_core/debug_utils/debug_utils.h"
+#include "video_core/texture/texture_cache.h"
+#include "video_core/texture/texture_decoder.h"
+
+namespace Pica {
+
+namespace Texture {
+
+MICROPROFILE_DEFINE(GPU_TextureDecode, "GPU", "Texture Decoding", MP_RGB(200, 100, 250));
+
+/**
+ * Returns the size of the leading part of the given region that lies in valid memory. Only those
+ * pages can be marked as cached in the page table.
+ */
+static u32 GetMappedSize(PAddr addr, u32 size) {
+    u32 mapped_size = 0;
+    while (mapped_size < size && Memory::IsValidPhysicalAddress(addr + mapped_size))
+        mapped_size = ((addr + mapped_size) & ~Memory::PAGE_MASK) + Memory::PAGE_SIZE - addr;
+    return std::min(mapped_size, size);
+}
+
+TextureCache::TextureCache(size_t budget) : budget(budget) {}
+
+TextureCache::~TextureCache() {
+    Clear();
+}
+
+void TextureCache::SetBudget(size_t new_budget) {
+    budget = new_budget;
+    EvictOverBudget();
+}
+
+std::shared_ptr<const DecodedTexture> TextureCache::GetTexture(
+    const DebugUtils::TextureInfo& info) {
+    const Key key{info.physical_address, info.format, static_cast<unsigned>(info.width),
+                  static_cast<unsigned>(info.height)};
+
+    auto it = lookup.find(key);
+    if (it != lookup.end()) {
+        entries.splice(entries.begin(), entries, it->second);
+        return it->second->texture;
+    }
+
+    const u32 encoded_size =
+        static_cast<u32>(GetTileSize(info.format) * ((key.width + 7) / 8) * ((key.height + 7) / 8));
+    const u32 cached_size = GetMappedSize(key.address, encoded_size);
+    if (cached_size == 0)
+        return nullptr;
+
+    const u8* source = Memory::GetPhysicalPointer(info.physical_address);
+    if (source == nullptr)
+        return nullptr;
+
+    // Tiles past the end of mapped memory aren't decoded and stay transparent black
+    auto texture = std::make_shared<DecodedTexture>();
+    texture->width = key.width;
+    texture->height = key.height;
+    texture->texels.resize(key.width * key.height);
+    {
+        MICROPROFILE_SCOPE(GPU_TextureDecode);
+        DecodeTexture(info, source, texture->texels.data(), key.width, cached_size);
+    }
+
+    entries.push_front({key, encoded_size, cached_size, texture});
+    lookup.emplace(key, entries.begin());
+    size += DecodedSize(entries.front());
+    Memory::RasterizerMarkRegionCached(key.address, cached_size, 1);
+
+    EvictOverBudget();
+    return texture;
+}
+
+void TextureCache::InvalidateRegion(PAddr addr, u32 region_size) {
+    for (auto it = entries.begin(); it != entries.end();) {
+        if (it->key.address < addr + region_size && addr < it->key.address + it->encoded_size) {
+            it = Erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void TextureCache::Clear() {
+    while (!entries.empty())
+        Erase(entries.begin());
+}
+
+TextureCache::EntryList::iterator TextureCache::Erase(EntryList::iterator it) {
+    Memory::RasterizerMarkRegionCached(it->key.address, it->cached_size, -1);
+    size -= DecodedSize(*it);
+    lookup.erase(it->key);
+    return entries.erase(it);
+}
+
+void TextureCache::EvictOverBudget() {
+    // This may also evict the texture that was just decoded if it alone exceeds the budget, which
+    // is fine since callers hold on to it while they need it
+    while (size > budget)
+        Erase(std::prev(entries.end()));
+}
+
+} // namespace Texture
+
+} // namespace Pica
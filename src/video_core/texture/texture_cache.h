@@ -0,0 +1,127 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <list>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include "common/common_types.h"
+#include "common/vector_math.h"
+#include "video_core/pica.h"
+
+namespace Pica {
+
+namespace DebugUtils {
+struct TextureInfo;
+}
+
+namespace Texture {
+
+/// A texture decoded to RGBA8 texels
+struct DecodedTexture {
+    unsigned width;
+    unsigned height;
+
+    /// Texel (x, y), with the coordinates used by DebugUtils::LookupTexture, is stored at
+    /// texels[y * width + x]
+    std::vector<Math::Vec4<u8>> texels;
+};
+
+/**
+ * Least-recently-used cache of fully decoded textures, keyed by address, format and dimensions.
+ *
+ * The memory backing each cached texture is marked as cached in the page table, so that CPU writes
+ * to it end up in the rasterizer's FlushAndInvalidateRegion, which should call InvalidateRegion.
+ * Writes by the GPU itself (e.g. rendering to a texture) need to be reported the same way.
+ */
+class TextureCache : NonCopyable {
+public:
+    /// @param budget Maximum total size in bytes of the decoded textures kept in the cache
+    explicit TextureCache(size_t budget);
+    ~TextureCache();
+
+    /// Changes the memory budget, evicting textures if the cache is now over budget
+    void SetBudget(size_t budget);
+
+    /**
+     * Returns the decoded texture described by `info`, decoding it if it isn't cached. The
+     * returned texture stays valid even if it is evicted from the cache afterwards.
+     * @returns The decoded texture, or nullptr if the texture isn't in addressable memory
+     */
+    std::shared_ptr<const DecodedTexture> GetTexture(const DebugUtils::TextureInfo& info);
+
+    /// Drops all textures whose encoded data overlaps the given physical memory region
+    void InvalidateRegion(PAddr addr, u32 size);
+
+    /// Drops all textures
+    void Clear();
+
+    /// Returns the total size in bytes of the decoded textures in the cache
+    size_t GetSize() const {
+        return size;
+    }
+
+    /// Returns the number of textures in the cache
+    size_t GetNumTextures() const {
+        return entries.size();
+    }
+
+private:
+    struct Key {
+        PAddr address;
+        Regs::TextureFormat format;
+        unsigned width;
+        unsigned height;
+
+        bool operator==(const Key& other) const {
+            return address == other.address && format == other.format && width == other.width &&
+                   height == other.height;
+        }
+    };
+
+    struct KeyHash {
+        size_t operator()(const Key& key) const {
+            return std::hash<u64>()(static_cast<u64>(key.address) << 32 |
+                                    static_cast<u64>(key.format) << 24 | key.width << 12 |
+                                    key.height);
+        }
+    };
+
+    struct Entry {
+        Key key;
+        /// Size in bytes of the encoded texture data
+        u32 encoded_size;
+        /// Size in bytes of the leading part of the encoded data that is marked as cached, which
+        /// stops at the first page not backed by memory
+        u32 cached_size;
+        std::shared_ptr<const DecodedTexture> texture;
+    };
+
+    using EntryList = std::list<Entry>;
+
+    static size_t DecodedSize(const Entry& entry) {
+        return entry.texture->texels.size() * sizeof(Math::Vec4<u8>);
+    }
+
+    /// Removes the entry from the cache and unmarks its memory region
+    EntryList::iterator Erase(EntryList::iterator it);
+
+    /// Evicts least recently used textures until the cache fits into its budget
+    void EvictOverBudget();
+
+    /// Cached textures, most recently used first
+    EntryList entries;
+    std::unordered_map<Key, EntryList::iterator, KeyHash> lookup;
+
+    size_t budget;
+    size_t size = 0;
+};
+
+} // namespace Texture
+
+} // namespace Pica
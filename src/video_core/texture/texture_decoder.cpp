@@ -0,0 +1,422 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#ifdef ARCHITECTURE_x86_64
+#include <emmintrin.h>
+#endif
+#include "common/assert.h"
+#include "common/color.h"
+#include "common/logging/log.h"
+#include "video_core/debug_utils/debug_utils.h"
+#include "video_core/morton.h"
+#include "video_core/texture/texture_decoder.h"
+
+namespace Pica {
+
+namespace Texture {
+
+using TextureFormat = Regs::TextureFormat;
+
+static_assert(sizeof(Math::Vec4<u8>) == 4, "Decoded texels must be packed RGBA8 values");
+
+size_t GetTileSize(TextureFormat format) {
+    switch (format) {
+    case TextureFormat::ETC1:
+        return 32;
+    case TextureFormat::ETC1A4:
+        return 64;
+    default:
+        return Regs::NibblesPerPixel(format) * 64 / 2;
+    }
+}
+
+size_t GetTileOffset(const DebugUtils::TextureInfo& info, unsigned x, unsigned y) {
+    const size_t tile_size = GetTileSize(info.format);
+    if (info.format == TextureFormat::ETC1 || info.format == TextureFormat::ETC1A4)
+        return ((y / 8) * (info.width / 8) + x / 8) * tile_size;
+    return (y & ~7) * info.stride + (x / 8) * tile_size;
+}
+
+static void StoreTexel(Math::Vec4<u8>* out, u32 rgba) {
+    std::memcpy(out, &rgba, sizeof(rgba));
+}
+
+#ifdef ARCHITECTURE_x86_64
+
+/// Interleaves 16 values of each component into 16 RGBA8 texels
+static void StoreTexels(Math::Vec4<u8>* out, __m128i r, __m128i g, __m128i b, __m128i a) {
+    const __m128i rg_low = _mm_unpacklo_epi8(r, g);
+    const __m128i rg_high = _mm_unpackhi_epi8(r, g);
+    const __m128i ba_low = _mm_unpacklo_epi8(b, a);
+    const __m128i ba_high = _mm_unpackhi_epi8(b, a);
+    auto dest = reinterpret_cast<__m128i*>(out);
+    _mm_storeu_si128(dest + 0, _mm_unpacklo_epi16(rg_low, ba_low));
+    _mm_storeu_si128(dest + 1, _mm_unpackhi_epi16(rg_low, ba_low));
+    _mm_storeu_si128(dest + 2, _mm_unpacklo_epi16(rg_high, ba_high));
+    _mm_storeu_si128(dest + 3, _mm_unpackhi_epi16(rg_high, ba_high));
+}
+
+/// Expands 4-bit values to 8 bits, like Color::Convert4To8
+static __m128i Expand4To8(__m128i value) {
+    return _mm_or_si128(value, _mm_slli_epi16(value, 4));
+}
+
+/// Expands 5-bit values in 16-bit lanes to 8 bits, like Color::Convert5To8
+static __m128i Expand5To8(__m128i value) {
+    return _mm_or_si128(_mm_slli_epi16(value, 3), _mm_srli_epi16(value, 2));
+}
+
+/// Expands 6-bit values in 16-bit lanes to 8 bits, like Color::Convert6To8
+static __m128i Expand6To8(__m128i value) {
+    return _mm_or_si128(_mm_slli_epi16(value, 2), _mm_srli_epi16(value, 4));
+}
+
+/// Decodes 16-bit texels, 16 at a time. Each component is extracted into 16-bit lanes first.
+template <TextureFormat format>
+static void Decode16BitTexels(const u8* source, Math::Vec4<u8>* out) {
+    for (unsigned i = 0; i < 64; i += 16) {
+        __m128i components[2][4];
+        for (unsigned half = 0; half < 2; ++half) {
+            const __m128i value =
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + (i + half * 8) * 2));
+            __m128i* c = components[half];
+            switch (format) {
+            case TextureFormat::RGBA4: {
+                const __m128i mask = _mm_set1_epi16(0xF);
+                c[0] = Expand4To8(_mm_srli_epi16(value, 12));
+                c[1] = Expand4To8(_mm_and_si128(_mm_srli_epi16(value, 8), mask));
+                c[2] = Expand4To8(_mm_and_si128(_mm_srli_epi16(value, 4), mask));
+                c[3] = Expand4To8(_mm_and_si128(value, mask));
+                break;
+            }
+            case TextureFormat::RGB5A1: {
+                const __m128i mask = _mm_set1_epi16(0x1F);
+                c[0] = Expand5To8(_mm_srli_epi16(value, 11));
+                c[1] = Expand5To8(_mm_and_si128(_mm_srli_epi16(value, 6), mask));
+                c[2] = Expand5To8(_mm_and_si128(_mm_srli_epi16(value, 1), mask));
+                c[3] = _mm_and_si128(_mm_sub_epi16(_mm_setzero_si128(),
+                                                   _mm_and_si128(value, _mm_set1_epi16(1))),
+                                     _mm_set1_epi16(0xFF));
+                break;
+            }
+            case TextureFormat::RGB565:
+                c[0] = Expand5To8(_mm_srli_epi16(value, 11));
+                c[1] = Expand6To8(_mm_and_si128(_mm_srli_epi16(value, 5), _mm_set1_epi16(0x3F)));
+                c[2] = Expand5To8(_mm_and_si128(value, _mm_set1_epi16(0x1F)));
+                c[3] = _mm_set1_epi16(0xFF);
+                break;
+            default:
+                UNREACHABLE();
+            }
+        }
+
+        StoreTexels(out + i, _mm_packus_epi16(components[0][0], components[1][0]),
+                    _mm_packus_epi16(components[0][1], components[1][1]),
+                    _mm_packus_epi16(components[0][2], components[1][2]),
+                    _mm_packus_epi16(components[0][3], components[1][3]));
+    }
+}
+
+/// Decodes IA4 texels, 16 at a time
+static void DecodeIA4Texels(const u8* source, Math::Vec4<u8>* out) {
+    const __m128i mask = _mm_set1_epi8(0xF);
+    for (unsigned i = 0; i < 64; i += 16) {
+        const __m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i));
+        const __m128i intensity = Expand4To8(_mm_and_si128(_mm_srli_epi16(value, 4), mask));
+        const __m128i alpha = Expand4To8(_mm_and_si128(value, mask));
+        StoreTexels(out + i, intensity, intensity, intensity, alpha);
+    }
+}
+
+/// Decodes I4 or A4 texels, 32 at a time. The lower nibble of each byte is the first texel.
+template <TextureFormat format>
+static void Decode4BitTexels(const u8* source, Math::Vec4<u8>* out) {
+    const __m128i mask = _mm_set1_epi8(0xF);
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i opaque = _mm_set1_epi8(static_cast<char>(0xFF));
+    for (unsigned i = 0; i < 64; i += 32) {
+        const __m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i / 2));
+        const __m128i low = _mm_and_si128(value, mask);
+        const __m128i high = _mm_and_si128(_mm_srli_epi16(value, 4), mask);
+        const __m128i texels[2] = {Expand4To8(_mm_unpacklo_epi8(low, high)),
+                                   Expand4To8(_mm_unpackhi_epi8(low, high))};
+        for (unsigned half = 0; half < 2; ++half) {
+            if (format == TextureFormat::I4) {
+                StoreTexels(out + i + half * 16, texels[half], texels[half], texels[half], opaque);
+            } else {
+                StoreTexels(out + i + half * 16, zero, zero, zero, texels[half]);
+            }
+        }
+    }
+}
+
+#endif // ARCHITECTURE_x86_64
+
+/// Decodes the 64 texels of a tile of a Morton-ordered format, keeping them in Morton order
+static void DecodeMortonTexels(TextureFormat format, const u8* source, Math::Vec4<u8>* out) {
+    switch (format) {
+    case TextureFormat::RGBA8:
+        for (unsigned i = 0; i < 64; ++i)
+            out[i] = Color::DecodeRGBA8(source + i * 4);
+        break;
+
+    case TextureFormat::RGB8:
+        for (unsigned i = 0; i < 64; ++i)
+            out[i] = Color::DecodeRGB8(source + i * 3);
+        break;
+
+#ifdef ARCHITECTURE_x86_64
+    case TextureFormat::RGB5A1:
+        Decode16BitTexels<TextureFormat::RGB5A1>(source, out);
+        break;
+
+    case TextureFormat::RGB565:
+        Decode16BitTexels<TextureFormat::RGB565>(source, out);
+        break;
+
+    case TextureFormat::RGBA4:
+        Decode16BitTexels<TextureFormat::RGBA4>(source, out);
+        break;
+#else
+    case TextureFormat::RGB5A1:
+        for (unsigned i = 0; i < 64; ++i)
+            out[i] = Color::DecodeRGB5A1(source + i * 2);
+        break;
+
+    case TextureFormat::RGB565:
+        for (unsigned i = 0; i < 64; ++i)
+            out[i] = Color::DecodeRGB565(source + i * 2);
+        break;
+
+    case TextureFormat::RGBA4:
+        for (unsigned i = 0; i < 64; ++i)
+            out[i] = Color::DecodeRGBA4(source + i * 2);
+        break;
+#endif
+
+    case TextureFormat::IA8:
+        for (unsigned i = 0; i < 64; ++i)
+            out[i] = {source[i * 2 + 1], source[i * 2 + 1], source[i * 2 + 1], source[i * 2]};
+        break;
+
+    case TextureFormat::RG8:
+        for (unsigned i = 0; i < 64; ++i)
+            out[i] = Color::DecodeRG8(source + i * 2);
+        break;
+
+    case TextureFormat::I8:
+        for (unsigned i = 0; i < 64; ++i)
+            out[i] = {source[i], source[i], source[i], 255};
+        break;
+
+    case TextureFormat::A8:
+        for (unsigned i = 0; i < 64; ++i)
+            out[i] = {0, 0, 0, source[i]};
+        break;
+
+#ifdef ARCHITECTURE_x86_64
+    case TextureFormat::IA4:
+        DecodeIA4Texels(source, out);
+        break;
+
+    case TextureFormat::I4:
+        Decode4BitTexels<TextureFormat::I4>(source, out);
+        break;
+
+    case TextureFormat::A4:
+        Decode4BitTexels<TextureFormat::A4>(source, out);
+        break;
+#else
+    case TextureFormat::IA4:
+        for (unsigned i = 0; i < 64; ++i) {
+            const u8 intensity = Color::Convert4To8(source[i] >> 4);
+            out[i] = {intensity, intensity, intensity, Color::Convert4To8(source[i] & 0xF)};
+        }
+        break;
+
+    case TextureFormat::I4:
+        for (unsigned i = 0; i < 64; ++i) {
+            const u8 intensity = Color::Convert4To8((source[i / 2] >> (4 * (i % 2))) & 0xF);
+            out[i] = {intensity, intensity, intensity, 255};
+        }
+        break;
+
+    case TextureFormat::A4:
+        for (unsigned i = 0; i < 64; ++i)
+            out[i] = {0, 0, 0, Color::Convert4To8((source[i / 2] >> (4 * (i % 2))) & 0xF)};
+        break;
+#endif
+
+    default:
+        LOG_ERROR(HW_GPU, "Unknown texture format: %x", static_cast<u32>(format));
+        DEBUG_ASSERT(false);
+        std::fill(out, out + 64, Math::Vec4<u8>{});
+        break;
+    }
+}
+
+/**
+ * Builds the eight colors an ETC1 block can use: for each half of the block, its base color plus
+ * and minus both modifiers of its table. Palette index is `negate * 4 + half * 2 + table_subindex`.
+ * The alpha component of the colors is left zero.
+ */
+static void BuildETC1Palette(u64 block, std::array<u32, 8>& palette) {
+    static constexpr std::array<std::array<u8, 2>, 8> etc1_modifier_table = {{
+        {{2, 8}},
+        {{5, 17}},
+        {{9, 29}},
+        {{13, 42}},
+        {{18, 60}},
+        {{24, 80}},
+        {{33, 106}},
+        {{47, 183}},
+    }};
+
+    const auto Field = [block](unsigned position, unsigned bits) {
+        return static_cast<u32>(block >> position) & ((1 << bits) - 1);
+    };
+    // Sign-extends the 3-bit deltas of the differential mode
+    const auto Delta = [&Field](unsigned position) {
+        return static_cast<int>(Field(position, 3) ^ 4) - 4;
+    };
+
+    std::array<u32, 2> base_colors;
+    if (Field(33, 1)) {
+        // Differential mode: 5-bit base color, plus a 3-bit delta for the second half
+        const int r = Field(59, 5), g = Field(51, 5), b = Field(43, 5);
+        const int r2 = r + Delta(56), g2 = g + Delta(48), b2 = b + Delta(40);
+        base_colors[0] = Color::Convert5To8(r) | Color::Convert5To8(g) << 8 |
+                         Color::Convert5To8(b) << 16;
+        base_colors[1] = Color::Convert5To8(static_cast<u8>(r2)) |
+                         Color::Convert5To8(static_cast<u8>(g2)) << 8 |
+                         Color::Convert5To8(static_cast<u8>(b2)) << 16;
+    } else {
+        // Separate mode: two independent 4-bit colors
+        base_colors[0] = Color::Convert4To8(Field(60, 4)) | Color::Convert4To8(Field(52, 4)) << 8 |
+                         Color::Convert4To8(Field(44, 4)) << 16;
+        base_colors[1] = Color::Convert4To8(Field(56, 4)) | Color::Convert4To8(Field(48, 4)) << 8 |
+                         Color::Convert4To8(Field(40, 4)) << 16;
+    }
+
+    const std::array<unsigned, 2> table_indices = {{Field(37, 3), Field(34, 3)}};
+    std::array<u32, 4> bases, modifiers;
+    for (unsigned i = 0; i < 4; ++i) {
+        const u32 modifier = etc1_modifier_table[table_indices[i / 2]][i % 2];
+        bases[i] = base_colors[i / 2];
+        modifiers[i] = modifier * 0x010101;
+    }
+
+#ifdef ARCHITECTURE_x86_64
+    // Saturating byte arithmetic clamps each component to [0, 255]
+    const __m128i base = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bases.data()));
+    const __m128i modifier = _mm_loadu_si128(reinterpret_cast<const __m128i*>(modifiers.data()));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(&palette[0]), _mm_adds_epu8(base, modifier));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(&palette[4]), _mm_subs_epu8(base, modifier));
+#else
+    for (unsigned i = 0; i < 4; ++i) {
+        u32 plus = 0, minus = 0;
+        for (unsigned shift = 0; shift < 24; shift += 8) {
+            const int component = (bases[i] >> shift) & 0xFF;
+            const int delta = (modifiers[i] >> shift) & 0xFF;
+            plus |= static_cast<u32>(std::min(component + delta, 255)) << shift;
+            minus |= static_cast<u32>(std::max(component - delta, 0)) << shift;
+        }
+        palette[i] = plus;
+        palette[i + 4] = minus;
+    }
+#endif
+}
+
+/// Decodes an ETC1 4x4 block. Texels are indexed column by column in the block's bit fields.
+static void DecodeETC1Block(u64 block, u64 alpha, Math::Vec4<u8>* out, ptrdiff_t stride) {
+    std::array<u32, 8> palette;
+    BuildETC1Palette(block, palette);
+    const bool flip = (block >> 32) & 1;
+
+    for (unsigned x = 0; x < 4; ++x) {
+        for (unsigned y = 0; y < 4; ++y) {
+            const unsigned texel = x * 4 + y;
+            const unsigned half = flip ? (y >= 2) : (x >= 2);
+            const unsigned index = ((block >> (texel + 16)) & 1) * 4 + half * 2 +
+                                   ((block >> texel) & 1);
+            const u32 texel_alpha = Color::Convert4To8((alpha >> (texel * 4)) & 0xF);
+            StoreTexel(out + y * stride + x, palette[index] | texel_alpha << 24);
+        }
+    }
+}
+
+/// Decodes an ETC1 tile, which consists of four blocks covering its 4x4 quadrants
+template <bool has_alpha>
+static void DecodeETC1Tile(const u8* tile, Math::Vec4<u8>* out, ptrdiff_t stride) {
+    constexpr size_t block_size = has_alpha ? 16 : 8;
+    for (unsigned block_index = 0; block_index < 4; ++block_index) {
+        const u8* source = tile + block_index * block_size;
+        u64 alpha = ~0ull;
+        if (has_alpha) {
+            std::memcpy(&alpha, source, sizeof(u64));
+            source += sizeof(u64);
+        }
+        u64 block;
+        std::memcpy(&block, source, sizeof(u64));
+
+        DecodeETC1Block(block, alpha, out + (block_index & 1) * 4 + (block_index >> 1) * 4 * stride,
+                        stride);
+    }
+}
+
+void DecodeTile(TextureFormat format, const u8* tile, Math::Vec4<u8>* out, ptrdiff_t stride) {
+    switch (format) {
+    case TextureFormat::ETC1:
+        DecodeETC1Tile<false>(tile, out, stride);
+        break;
+
+    case TextureFormat::ETC1A4:
+        DecodeETC1Tile<true>(tile, out, stride);
+        break;
+
+    default: {
+        std::array<Math::Vec4<u8>, 64> texels;
+        DecodeMortonTexels(format, tile, texels.data());
+        VideoCore::MortonCopy(4, 8, 8, reinterpret_cast<u8*>(texels.data()),
+                              reinterpret_cast<u8*>(out), stride * 4, true);
+        break;
+    }
+    }
+}
+
+void DecodeTexture(const DebugUtils::TextureInfo& info, const u8* source, Math::Vec4<u8>* out,
+                   ptrdiff_t stride, size_t source_size) {
+    const size_t tile_size = GetTileSize(info.format);
+    for (int y = 0; y < info.height; y += 8) {
+        for (int x = 0; x < info.width; x += 8) {
+            const size_t tile_offset = GetTileOffset(info, x, y);
+            if (tile_offset + tile_size > source_size)
+                continue;
+
+            const u8* tile = source + tile_offset;
+            Math::Vec4<u8>* tile_out = out + y * stride + x;
+
+            if (x + 8 <= info.width && y + 8 <= info.height) {
+                DecodeTile(info.format, tile, tile_out, stride);
+                continue;
+            }
+
+            // Partial tile at the right or bottom edge
+            std::array<Math::Vec4<u8>, 64> texels;
+            DecodeTile(info.format, tile, texels.data(), 8);
+            const int tile_width = std::min(8, info.width - x);
+            for (int tile_y = 0; tile_y < std::min(8, info.height - y); ++tile_y) {
+                std::copy_n(texels.begin() + tile_y * 8, tile_width,
+                            tile_out + tile_y * stride);
+            }
+        }
+    }
+}
+
+} // namespace Texture
+
+} // namespace Pica
@@ -0,0 +1,53 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <cstddef>
+#include <limits>
+#include "common/common_types.h"
+#include "common/vector_math.h"
+#include "video_core/pica.h"
+
+namespace Pica {
+
+namespace DebugUtils {
+struct TextureInfo;
+}
+
+namespace Texture {
+
+/// Returns the size in bytes of an 8x8 tile of a texture with the given format
+size_t GetTileSize(Regs::TextureFormat format);
+
+/// Returns the offset in bytes of the tile containing texel (x, y) from the start of the texture
+size_t GetTileOffset(const DebugUtils::TextureInfo& info, unsigned x, unsigned y);
+
+/**
+ * Decodes a whole 8x8 tile to RGBA8 texels. The results are the same as the ones of
+ * DebugUtils::LookupTexture with disable_alpha unset.
+ * @param format Format of the tile
+ * @param tile Pointer to the encoded tile
+ * @param out Destination of texel (0, 0) of the tile; texel (x, y) is stored at out[y * stride + x]
+ * @param stride Distance in texels between two lines of the output, may be negative
+ */
+void DecodeTile(Regs::TextureFormat format, const u8* tile, Math::Vec4<u8>* out,
+                ptrdiff_t stride);
+
+/**
+ * Decodes a whole texture to RGBA8 texels, tile by tile. Texel (x, y), with the coordinates used
+ * by DebugUtils::LookupTexture, is stored at out[y * stride + x].
+ * @param info Description of the texture
+ * @param source Pointer to the encoded texture
+ * @param out Destination of texel (0, 0)
+ * @param stride Distance in texels between two lines of the output, may be negative
+ * @param source_size Number of readable bytes at source. Tiles that don't lie entirely within them
+ *                    are skipped, leaving their texels in out untouched.
+ */
+void DecodeTexture(const DebugUtils::TextureInfo& info, const u8* source, Math::Vec4<u8>* out,
+                   ptrdiff_t stride, size_t source_size = std::numeric_limits<size_t>::max());
+
+} // namespace Texture
+
+} // namespace Pica
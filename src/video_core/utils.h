@@ -5,20 +5,17 @@
 #pragma once
 
 #include "common/common_types.h"
+#include "video_core/morton.h"
 
 namespace VideoCore {
 
 /**
  * Interleave the lower 3 bits of each coordinate to get the intra-block offsets, which are
- * arranged in a Z-order curve. More details on the bit manipulation at:
- * https://fgiesen.wordpress.com/2009/12/13/decoding-morton-codes/
+ * arranged in a Z-order curve. The result is looked up from a table shared with the tiling code
+ * in morton.h.
  */
 static inline u32 MortonInterleave(u32 x, u32 y) {
-    u32 i = (x & 7) | ((y & 7) << 8); // ---- -210
-    i = (i ^ (i << 2)) & 0x1313;      // ---2 --10
-    i = (i ^ (i << 1)) & 0x1515;      // ---2 -1-0
-    i = (i | (i >> 7)) & 0x3F;
-    return i;
+    return morton_lut[(y & 7) * 8 + (x & 7)];
 }
 
 /**
@@ -0,0 +1,43 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include "video_core/vertex_cache.h"
+
+namespace Pica {
+
+constexpr u32 VertexCache::INVALID_SLOT;
+
+// Indices are at most 16 bits wide, so every vertex a draw can reference has its own table entry
+VertexCache::VertexCache() : vertex_slots(0x10000, INVALID_SLOT) {}
+
+void VertexCache::Build(const u8* indices, bool index_u16, u32 num_indices) {
+    for (u32 vertex : unique_vertices)
+        vertex_slots[vertex] = INVALID_SLOT;
+    unique_vertices.clear();
+    slots.resize(num_indices);
+
+    if (index_u16) {
+        ScanIndices(reinterpret_cast<const u16*>(indices), num_indices);
+    } else {
+        ScanIndices(indices, num_indices);
+    }
+
+    stats.num_indices += num_indices;
+    stats.num_unique_vertices += unique_vertices.size();
+}
+
+template <typename IndexType>
+void VertexCache::ScanIndices(const IndexType* indices, u32 num_indices) {
+    for (u32 index = 0; index < num_indices; ++index) {
+        const u32 vertex = indices[index];
+        u32& slot = vertex_slots[vertex];
+        if (slot == INVALID_SLOT) {
+            slot = static_cast<u32>(unique_vertices.size());
+            unique_vertices.push_back(vertex);
+        }
+        slots[index] = slot;
+    }
+}
+
+} // namespace Pica
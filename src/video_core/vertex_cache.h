@@ -0,0 +1,75 @@
+// Copyright 2016 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <vector>
+#include "common/common_types.h"
+
+namespace Pica {
+
+/**
+ * Post-transform vertex cache spanning a whole indexed draw. Before anything is shaded, the index
+ * buffer is scanned once to find the distinct vertices it references, so that each of them is
+ * loaded and shaded exactly once no matter how far apart its uses are. Primitive assembly then
+ * looks up the shaded vertex of each index through its slot.
+ */
+class VertexCache {
+public:
+    /// Statistics accumulated over all draws since the last call to ResetStats
+    struct Stats {
+        u64 num_indices = 0;
+        u64 num_unique_vertices = 0;
+
+        /// Returns the fraction of indices that reused an already shaded vertex
+        double GetHitRate() const {
+            return num_indices == 0 ? 0.0
+                                    : static_cast<double>(num_indices - num_unique_vertices) /
+                                          num_indices;
+        }
+    };
+
+    VertexCache();
+
+    /**
+     * Scans the index buffer of a draw, replacing the results of the previous one.
+     * @param indices Index buffer, made of 8-bit or 16-bit indices
+     * @param index_u16 Whether the indices are 16 bits wide
+     * @param num_indices Number of indices in the draw
+     */
+    void Build(const u8* indices, bool index_u16, u32 num_indices);
+
+    /// Returns the vertices referenced by the last draw, in order of first use
+    const std::vector<u32>& GetUniqueVertices() const {
+        return unique_vertices;
+    }
+
+    /// Returns, for each index of the last draw, the position of its vertex in GetUniqueVertices
+    const std::vector<u32>& GetSlots() const {
+        return slots;
+    }
+
+    const Stats& GetStats() const {
+        return stats;
+    }
+
+    void ResetStats() {
+        stats = {};
+    }
+
+private:
+    static constexpr u32 INVALID_SLOT = 0xFFFFFFFF;
+
+    template <typename IndexType>
+    void ScanIndices(const IndexType* indices, u32 num_indices);
+
+    /// Slot of each possible vertex index. Only the entries used by a draw are reset afterwards.
+    std::vector<u32> vertex_slots;
+
+    std::vector<u32> unique_vertices;
+    std::vector<u32> slots;
+    Stats stats;
+};
+
+} // namespace Pica
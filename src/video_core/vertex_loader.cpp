@@ -1,4 +1,10 @@
+#include <array>
+#include <cstring>
 #include <memory>
+#include <type_traits>
+#ifdef ARCHITECTURE_x86_64
+#include <emmintrin.h>
+#endif
 #include <boost/range/algorithm/fill.hpp>
 #include "common/alignment.h"
 #include "common/assert.h"
@@ -16,6 +22,81 @@
 
 namespace Pica {
 
+/**
+ * Converts an attribute with `elements` components of the given format to float24. Components
+ * missing from the array are set to (0, 0, 0, 1); this is *not* carried over from the default
+ * attribute settings even if they're enabled for this attribute.
+ */
+template <Regs::VertexAttributeFormat format, unsigned elements>
+static void LoadAttribute(const u8* source, Math::Vec4<float24>& attribute) {
+    using Format = Regs::VertexAttributeFormat;
+    using ComponentType = typename std::conditional<
+        format == Format::BYTE, s8,
+        typename std::conditional<format == Format::UBYTE, u8,
+                                  typename std::conditional<format == Format::SHORT, s16,
+                                                            float>::type>::type>::type;
+
+    // Only read the components that are part of the attribute, since it may be the last one in
+    // mapped memory
+    ComponentType components[4] = {};
+    std::memcpy(components, source, elements * sizeof(ComponentType));
+
+#ifdef ARCHITECTURE_x86_64
+    __m128 result;
+    if (format == Format::FLOAT) {
+        result = _mm_loadu_ps(reinterpret_cast<const float*>(components));
+    } else {
+        __m128i values;
+        if (format == Format::SHORT) {
+            // Sign-extend by moving each value to the upper half of a lane and shifting it back
+            values = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(components));
+            values = _mm_srai_epi32(_mm_unpacklo_epi16(values, values), 16);
+        } else {
+            s32 packed;
+            std::memcpy(&packed, components, sizeof(packed));
+            values = _mm_cvtsi32_si128(packed);
+            if (format == Format::BYTE) {
+                values = _mm_unpacklo_epi8(values, values);
+                values = _mm_srai_epi32(_mm_unpacklo_epi16(values, values), 24);
+            } else {
+                const __m128i zero = _mm_setzero_si128();
+                values = _mm_unpacklo_epi16(_mm_unpacklo_epi8(values, zero), zero);
+            }
+        }
+        result = _mm_cvtepi32_ps(values);
+    }
+    // Missing components were zero-initialized above, only the w component may need to become 1
+    if (elements < 4)
+        result = _mm_or_ps(result, _mm_set_ps(1.0f, 0.0f, 0.0f, 0.0f));
+    static_assert(sizeof(attribute) == sizeof(result), "float24 must be backed by a float");
+    _mm_storeu_ps(reinterpret_cast<float*>(&attribute), result);
+#else
+    for (unsigned comp = 0; comp < elements; ++comp)
+        attribute[comp] = float24::FromFloat32(static_cast<float>(components[comp]));
+    for (unsigned comp = elements; comp < 4; ++comp)
+        attribute[comp] = comp == 3 ? float24::FromFloat32(1.0f) : float24::FromFloat32(0.0f);
+#endif
+}
+
+using LoadFunctionArray = std::array<void (*)(const u8*, Math::Vec4<float24>&), 4>;
+
+template <Regs::VertexAttributeFormat format>
+static constexpr LoadFunctionArray LoadFunctionsFor() {
+    return {{LoadAttribute<format, 1>, LoadAttribute<format, 2>, LoadAttribute<format, 3>,
+             LoadAttribute<format, 4>}};
+}
+
+/// Conversion routines, indexed by attribute format and number of elements minus one
+static const std::array<LoadFunctionArray, 4> load_functions = {{
+    LoadFunctionsFor<Regs::VertexAttributeFormat::BYTE>(),
+    LoadFunctionsFor<Regs::VertexAttributeFormat::UBYTE>(),
+    LoadFunctionsFor<Regs::VertexAttributeFormat::SHORT>(),
+    LoadFunctionsFor<Regs::VertexAttributeFormat::FLOAT>(),
+}};
+
+/// Size in bytes of a component, indexed by attribute format
+static constexpr std::array<u32, 4> format_sizes = {{1, 1, 2, 4}};
+
 void VertexLoader::Setup(const Pica::Regs& regs) {
     ASSERT_MSG(!is_setup, "VertexLoader is not intended to be setup more than once.");
 
@@ -67,91 +148,82 @@ void VertexLoader::Setup(const Pica::Regs& regs) {
         }
     }
 
+    CompileAttributes();
     is_setup = true;
 }
 
-void VertexLoader::LoadVertex(u32 base_address, int index, int vertex, Shader::InputVertex& input,
-                              DebugUtils::MemoryAccessTracker& memory_accesses) {
-    ASSERT_MSG(is_setup, "A VertexLoader needs to be setup before loading vertices.");
+void VertexLoader::CompileAttributes() {
+    num_array_attributes = 0;
+    num_default_attributes = 0;
 
     for (int i = 0; i < num_total_attributes; ++i) {
         if (vertex_attribute_elements[i] != 0) {
-            // Load per-vertex data from the loader arrays
-            u32 source_addr =
-                base_address + vertex_attribute_sources[i] + vertex_attribute_strides[i] * vertex;
-
-            if (g_debug_context && Pica::g_debug_context->recorder) {
-                memory_accesses.AddAccess(
-                    source_addr,
-                    vertex_attribute_elements[i] *
-                        ((vertex_attribute_formats[i] == Regs::VertexAttributeFormat::FLOAT)
-                             ? 4
-                             : (vertex_attribute_formats[i] == Regs::VertexAttributeFormat::SHORT)
-                                   ? 2
-                                   : 1));
-            }
+            const auto format = static_cast<size_t>(vertex_attribute_formats[i]);
+            const u32 elements = vertex_attribute_elements[i];
+            array_attributes[num_array_attributes++] = {
+                load_functions[format][elements - 1], static_cast<u32>(i),
+                vertex_attribute_sources[i], vertex_attribute_strides[i],
+                elements * format_sizes[format]};
+        } else if (vertex_attribute_is_default[i]) {
+            default_attributes[num_default_attributes++] = static_cast<u32>(i);
+        }
+        // TODO(yuriks): Otherwise, no data gets loaded and the vertex remains with the last value
+        // it had. This isn't currently maintained as global state, however, and so won't work in
+        // Citra yet.
+    }
+}
 
-            switch (vertex_attribute_formats[i]) {
-            case Regs::VertexAttributeFormat::BYTE: {
-                const s8* srcdata =
-                    reinterpret_cast<const s8*>(Memory::GetPhysicalPointer(source_addr));
-                for (unsigned int comp = 0; comp < vertex_attribute_elements[i]; ++comp) {
-                    input.attr[i][comp] = float24::FromFloat32(srcdata[comp]);
-                }
-                break;
-            }
-            case Regs::VertexAttributeFormat::UBYTE: {
-                const u8* srcdata =
-                    reinterpret_cast<const u8*>(Memory::GetPhysicalPointer(source_addr));
-                for (unsigned int comp = 0; comp < vertex_attribute_elements[i]; ++comp) {
-                    input.attr[i][comp] = float24::FromFloat32(srcdata[comp]);
-                }
-                break;
-            }
-            case Regs::VertexAttributeFormat::SHORT: {
-                const s16* srcdata =
-                    reinterpret_cast<const s16*>(Memory::GetPhysicalPointer(source_addr));
-                for (unsigned int comp = 0; comp < vertex_attribute_elements[i]; ++comp) {
-                    input.attr[i][comp] = float24::FromFloat32(srcdata[comp]);
-                }
-                break;
-            }
-            case Regs::VertexAttributeFormat::FLOAT: {
-                const float* srcdata =
-                    reinterpret_cast<const float*>(Memory::GetPhysicalPointer(source_addr));
-                for (unsigned int comp = 0; comp < vertex_attribute_elements[i]; ++comp) {
-                    input.attr[i][comp] = float24::FromFloat32(srcdata[comp]);
-                }
-                break;
-            }
-            }
+void VertexLoader::LoadVertex(u32 base_address, int index, int vertex, Shader::InputVertex& input,
+                              DebugUtils::MemoryAccessTracker& memory_accesses) {
+    const u32 vertex_id = static_cast<u32>(vertex);
+    LoadVertices(base_address, &vertex_id, 1, &input, memory_accesses);
+
+    for (int i = 0; i < num_array_attributes; ++i) {
+        const auto& attribute = array_attributes[i];
+        const auto& value = input.attr[attribute.index];
+        LOG_TRACE(HW_GPU, "Loaded %d components of attribute %x for vertex %x (index %x) from "
+                          "0x%08x + 0x%08x + 0x%04x: %f %f %f %f",
+                  vertex_attribute_elements[attribute.index], attribute.index, vertex, index,
+                  base_address, attribute.source, attribute.stride * vertex,
+                  value[0].ToFloat32(), value[1].ToFloat32(), value[2].ToFloat32(),
+                  value[3].ToFloat32());
+    }
+    for (int i = 0; i < num_default_attributes; ++i) {
+        const auto& value = input.attr[default_attributes[i]];
+        LOG_TRACE(HW_GPU,
+                  "Loaded default attribute %x for vertex %x (index %x): (%f, %f, %f, %f)",
+                  default_attributes[i], vertex, index, value[0].ToFloat32(),
+                  value[1].ToFloat32(), value[2].ToFloat32(), value[3].ToFloat32());
+    }
+}
 
-            // Default attribute values set if array elements have < 4 components. This
-            // is *not* carried over from the default attribute settings even if they're
-            // enabled for this attribute.
-            for (unsigned int comp = vertex_attribute_elements[i]; comp < 4; ++comp) {
-                input.attr[i][comp] =
-                    comp == 3 ? float24::FromFloat32(1.0f) : float24::FromFloat32(0.0f);
-            }
+void VertexLoader::LoadVertices(u32 base_address, const u32* vertices, size_t count,
+                                Shader::InputVertex* inputs,
+                                DebugUtils::MemoryAccessTracker& memory_accesses) {
+    ASSERT_MSG(is_setup, "A VertexLoader needs to be setup before loading vertices.");
 
-            LOG_TRACE(HW_GPU, "Loaded %d components of attribute %x for vertex %x (index %x) from "
-                              "0x%08x + 0x%08x + 0x%04x: %f %f %f %f",
-                      vertex_attribute_elements[i], i, vertex, index, base_address,
-                      vertex_attribute_sources[i], vertex_attribute_strides[i] * vertex,
-                      input.attr[i][0].ToFloat32(), input.attr[i][1].ToFloat32(),
-                      input.attr[i][2].ToFloat32(), input.attr[i][3].ToFloat32());
-        } else if (vertex_attribute_is_default[i]) {
-            // Load the default attribute if we're configured to do so
-            input.attr[i] = g_state.vs_default_attributes[i];
-            LOG_TRACE(HW_GPU,
-                      "Loaded default attribute %x for vertex %x (index %x): (%f, %f, %f, %f)", i,
-                      vertex, index, input.attr[i][0].ToFloat32(), input.attr[i][1].ToFloat32(),
-                      input.attr[i][2].ToFloat32(), input.attr[i][3].ToFloat32());
-        } else {
-            // TODO(yuriks): In this case, no data gets loaded and the vertex
-            // remains with the last value it had. This isn't currently maintained
-            // as global state, however, and so won't work in Citra yet.
+    for (int i = 0; i < num_array_attributes; ++i) {
+        const auto& attribute = array_attributes[i];
+        const u32 source_addr = base_address + attribute.source;
+
+        if (g_debug_context && Pica::g_debug_context->recorder) {
+            for (size_t v = 0; v < count; ++v)
+                memory_accesses.AddAccess(source_addr + attribute.stride * vertices[v],
+                                          attribute.size);
         }
+
+        // Physical memory regions are contiguous, so the pointer only needs to be looked up once
+        const u8* source = Memory::GetPhysicalPointer(source_addr);
+        for (size_t v = 0; v < count; ++v) {
+            attribute.load(source + attribute.stride * vertices[v],
+                           inputs[v].attr[attribute.index]);
+        }
+    }
+
+    for (int i = 0; i < num_default_attributes; ++i) {
+        const u32 index = default_attributes[i];
+        for (size_t v = 0; v < count; ++v)
+            inputs[v].attr[index] = g_state.vs_default_attributes[index];
     }
 }
 
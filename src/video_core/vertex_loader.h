@@ -1,8 +1,11 @@
 #pragma once
 
 #include <array>
+#include <cstddef>
 #include "common/common_types.h"
+#include "common/vector_math.h"
 #include "video_core/pica.h"
+#include "video_core/pica_types.h"
 
 namespace Pica {
 
@@ -25,11 +28,45 @@ public:
     void LoadVertex(u32 base_address, int index, int vertex, Shader::InputVertex& input,
                     DebugUtils::MemoryAccessTracker& memory_accesses);
 
+    /**
+     * Loads a batch of vertices. Each attribute is loaded for all vertices at once, using the
+     * conversion routine picked for it in Setup.
+     * @param vertices Indices into the attribute arrays of the vertices to load
+     * @param count Number of vertices to load
+     * @param inputs Receives the loaded vertices, one per entry of `vertices`
+     */
+    void LoadVertices(u32 base_address, const u32* vertices, size_t count,
+                      Shader::InputVertex* inputs,
+                      DebugUtils::MemoryAccessTracker& memory_accesses);
+
     int GetNumTotalAttributes() const {
         return num_total_attributes;
     }
 
 private:
+    /// Converts a single attribute from its array format, filling missing components
+    using AttributeLoadFunction = void (*)(const u8* source, Math::Vec4<float24>& attribute);
+
+    /// An attribute loaded from the attribute arrays
+    struct ArrayAttribute {
+        AttributeLoadFunction load;
+        u32 index;
+        u32 source;
+        u32 stride;
+        /// Size in bytes of the attribute in its array
+        u32 size;
+    };
+
+    /// Builds the lists of array and default attributes from the attribute configuration
+    void CompileAttributes();
+
+    std::array<ArrayAttribute, 16> array_attributes;
+    int num_array_attributes = 0;
+
+    /// Indices of the attributes loaded from the default attribute values
+    std::array<u32, 16> default_attributes;
+    int num_default_attributes = 0;
+
     std::array<u32, 16> vertex_attribute_sources;
     std::array<u32, 16> vertex_attribute_strides{};
     std::array<Regs::VertexAttributeFormat, 16> vertex_attribute_formats;
@@ -7,6 +7,7 @@
 #include "video_core/pica.h"
 #include "video_core/renderer_base.h"
 #include "video_core/renderer_opengl/renderer_opengl.h"
+#include "video_core/shader/shader.h"
 #include "video_core/video_core.h"
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -21,6 +22,9 @@ std::atomic<bool> g_hw_renderer_enabled;
 std::atomic<bool> g_shader_jit_enabled;
 std::atomic<bool> g_vsync_enabled;
 std::atomic<bool> g_toggle_framelimit_enabled;
+std::atomic<int> g_sw_rasterizer_threads;
+std::atomic<int> g_vertex_shader_threads;
+std::atomic<int> g_sw_texture_cache_size;
 
 /// Initialize the video core
 bool Init(EmuWindow* emu_window) {
@@ -38,6 +42,11 @@ bool Init(EmuWindow* emu_window) {
     return true;
 }
 
+void LoadShaderCache(u64 program_id) {
+    Pica::Shader::LoadDiskCache(program_id);
+    g_renderer->LoadShaderCache(program_id);
+}
+
 /// Shutdown the video core
 void Shutdown() {
     Pica::Shutdown();
@@ -6,6 +6,7 @@
 
 #include <atomic>
 #include <memory>
+#include "common/common_types.h"
 
 class EmuWindow;
 class RendererBase;
@@ -38,6 +39,12 @@ extern EmuWindow* g_emu_window;                  ///< Emu window
 extern std::atomic<bool> g_hw_renderer_enabled;
 extern std::atomic<bool> g_shader_jit_enabled;
 extern std::atomic<bool> g_toggle_framelimit_enabled;
+/// Number of threads used by the software rasterizer (0: one per CPU core)
+extern std::atomic<int> g_sw_rasterizer_threads;
+/// Number of threads used to shade the vertices of large draws (0: one per CPU core)
+extern std::atomic<int> g_vertex_shader_threads;
+/// Memory budget in MiB of the software rasterizer's decoded texture cache
+extern std::atomic<int> g_sw_texture_cache_size;
 
 /// Start the video core
 void Start();
@@ -45,6 +52,9 @@ void Start();
 /// Initialize the video core
 bool Init(EmuWindow* emu_window);
 
+/// Load the shaders cached on disk for the title with the given program ID
+void LoadShaderCache(u64 program_id);
+
 /// Shutdown the video core
 void Shutdown();
 